@@ -0,0 +1,247 @@
+#include "jb/batch_driver.hpp"
+
+#include <jb/filetype.hpp>
+#include <jb/launch_thread.hpp>
+#include <jb/log.hpp>
+#include <jb/thread_config.hpp>
+#include <jb/usage.hpp>
+
+#include <algorithm>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include <glob.h>
+#include <sys/stat.h>
+
+namespace {
+
+/// Return the size of a file, or 0 if it cannot be determined
+std::uint64_t file_size(std::string const& filename) {
+  struct stat st;
+  if (::stat(filename.c_str(), &st) != 0) {
+    return 0;
+  }
+  return static_cast<std::uint64_t>(st.st_size);
+}
+
+/// Return the CPUs in a set, in order
+std::vector<int> cpu_list(jb::cpu_set const& s) {
+  std::vector<int> cpus;
+  for (std::size_t cpu = 0; cpu != s.capacity(); ++cpu) {
+    if (s.status(static_cast<int>(cpu))) {
+      cpus.push_back(static_cast<int>(cpu));
+    }
+  }
+  return cpus;
+}
+
+} // anonymous namespace
+
+jb::batch_driver::batch_driver(config const& cfg)
+    : workers_(cfg.workers())
+    , max_decompressors_(cfg.max_decompressors())
+    , affinity_(cfg.affinity())
+    , mu_()
+    , cv_()
+    , pending_()
+    , active_decompressors_(0)
+    , failures_(0) {
+  if (workers_ == 0) {
+    workers_ = affinity_.count() > 0
+                   ? affinity_.count()
+                   : static_cast<int>(std::thread::hardware_concurrency());
+  }
+  if (workers_ <= 0) {
+    workers_ = 1;
+  }
+}
+
+int jb::batch_driver::run(
+    std::vector<std::string> const& filenames,
+    process_function const& process) {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    pending_.clear();
+    for (auto const& f : filenames) {
+      pending_.push_back(pending_file{f, file_size(f), jb::is_gz(f)});
+    }
+    // ... start with the largest files, so the last files to finish
+    // are small and the workers finish at about the same time ...
+    std::stable_sort(
+        pending_.begin(), pending_.end(),
+        [](auto const& a, auto const& b) { return a.size > b.size; });
+    active_decompressors_ = 0;
+    failures_ = 0;
+  }
+
+  // ... each worker is pinned to one of the CPUs in the affinity set,
+  // if there are more workers than CPUs they share them ...
+  auto cpus = cpu_list(affinity_);
+  std::vector<std::thread> threads(workers_);
+  try {
+    for (int i = 0; i != workers_; ++i) {
+      auto thrcfg = thread_config().name("batch-" + std::to_string(i));
+      if (not cpus.empty()) {
+        thrcfg.affinity(jb::cpu_set().set(cpus[i % cpus.size()]));
+      }
+      jb::launch_thread(threads[i], thrcfg, [this, i, &process]() {
+        worker_loop(i, process);
+      });
+    }
+  } catch (...) {
+    // ... the workers already started must be joined before the
+    // exception destroys them, tell them to stop picking up files ...
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      pending_.clear();
+    }
+    cv_.notify_all();
+    for (auto& t : threads) {
+      if (t.joinable()) {
+        t.join();
+      }
+    }
+    throw;
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  return failures_;
+}
+
+std::vector<std::string>
+jb::batch_driver::expand(std::vector<std::string> const& patterns) {
+  std::vector<std::string> files;
+  // ... overlapping patterns may match the same file, it must be
+  // processed only once ...
+  std::set<std::string> seen;
+  for (auto const& p : patterns) {
+    glob_t g;
+    int r = ::glob(p.c_str(), 0, nullptr, &g);
+    if (r != 0) {
+      globfree(&g);
+      std::ostringstream os;
+      os << "jb::batch_driver::expand - no files match <" << p << ">";
+      throw std::runtime_error(os.str());
+    }
+    // ... glob() returns the matches sorted ...
+    for (std::size_t i = 0; i != g.gl_pathc; ++i) {
+      if (seen.insert(g.gl_pathv[i]).second) {
+        files.emplace_back(g.gl_pathv[i]);
+      }
+    }
+    globfree(&g);
+  }
+  return files;
+}
+
+void jb::batch_driver::worker_loop(
+    int worker, process_function const& process) {
+  std::unique_lock<std::mutex> lk(mu_);
+  while (not pending_.empty()) {
+    std::string filename;
+    bool compressed;
+    if (not next_file(filename, compressed)) {
+      // ... only compressed files are left, and there are too many
+      // decompressors running, wait until one finishes ...
+      cv_.wait(lk);
+      continue;
+    }
+    lk.unlock();
+    JB_LOG(info) << "worker " << worker << " processing " << filename;
+    bool failed = false;
+    try {
+      process(worker, filename);
+    } catch (std::exception const& ex) {
+      JB_LOG(error) << "worker " << worker << " error processing " << filename
+                    << ": " << ex.what();
+      failed = true;
+    } catch (...) {
+      JB_LOG(error) << "worker " << worker << " unknown error processing "
+                    << filename;
+      failed = true;
+    }
+    lk.lock();
+    failures_ += failed ? 1 : 0;
+    if (compressed) {
+      --active_decompressors_;
+      cv_.notify_all();
+    }
+  }
+}
+
+bool jb::batch_driver::next_file(std::string& filename, bool& compressed) {
+  bool const can_decompress =
+      max_decompressors_ == 0 or active_decompressors_ < max_decompressors_;
+  auto i = std::find_if(
+      pending_.begin(), pending_.end(),
+      [can_decompress](auto const& f) {
+        return can_decompress or not f.compressed;
+      });
+  if (i == pending_.end()) {
+    return false;
+  }
+  filename = std::move(i->filename);
+  compressed = i->compressed;
+  if (compressed) {
+    ++active_decompressors_;
+  }
+  pending_.erase(i);
+  return true;
+}
+
+namespace jb {
+namespace defaults {
+
+#ifndef JB_BATCH_DRIVER_DEFAULTS_workers
+#define JB_BATCH_DRIVER_DEFAULTS_workers 0
+#endif
+#ifndef JB_BATCH_DRIVER_DEFAULTS_max_decompressors
+#define JB_BATCH_DRIVER_DEFAULTS_max_decompressors 0
+#endif
+
+int batch_driver_workers = JB_BATCH_DRIVER_DEFAULTS_workers;
+int batch_driver_max_decompressors =
+    JB_BATCH_DRIVER_DEFAULTS_max_decompressors;
+
+} // namespace defaults
+} // namespace jb
+
+jb::batch_driver::config::config()
+    : workers(
+          desc("workers")
+              .help(
+                  "The number of worker threads.  Use 0 for one worker per CPU"
+                  " in the affinity set, or one per hardware thread if the"
+                  " affinity is not set."),
+          this, defaults::batch_driver_workers)
+    , max_decompressors(
+          desc("max-decompressors")
+              .help(
+                  "The maximum number of compressed files processed at the"
+                  " same time, decompression is memory bandwidth intensive."
+                  "  Use 0 for no limit."),
+          this, defaults::batch_driver_max_decompressors)
+    , affinity(
+          desc("affinity", "cpu_set")
+              .help(
+                  "The CPUs used by the workers, each worker is pinned to one"
+                  " of them.  If none is set, the workers keep the default"
+                  " affinity."),
+          this) {
+}
+
+void jb::batch_driver::config::validate() const {
+  if (workers() < 0) {
+    std::ostringstream os;
+    os << "workers must be >= 0, value=" << workers();
+    throw jb::usage(os.str(), 1);
+  }
+  if (max_decompressors() < 0) {
+    std::ostringstream os;
+    os << "max-decompressors must be >= 0, value=" << max_decompressors();
+    throw jb::usage(os.str(), 1);
+  }
+}
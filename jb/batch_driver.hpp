@@ -0,0 +1,123 @@
+#ifndef jb_batch_driver_hpp
+#define jb_batch_driver_hpp
+
+#include <jb/config_object.hpp>
+#include <jb/convert_cpu_set.hpp>
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace jb {
+
+/**
+ * Process many input files in parallel.
+ *
+ * The analytics tools process one input file (typically one day of
+ * market data) at a time, research runs process months of files.
+ * This class runs a function for each file on a pool of worker
+ * threads.  The files wait in a shared queue, largest first, and
+ * each worker takes the next file as soon as it is idle, so the
+ * workers stay busy even when the files have very different sizes.
+ *
+ * Decompressing (gzip) files is memory bandwidth intensive, so the
+ * number of compressed files processed at the same time can be
+ * limited.  A worker that cannot start another compressed file takes
+ * an uncompressed file instead, or waits until a compressed file
+ * finishes.
+ *
+ * The function receives the index of the worker, so the caller can
+ * keep separate state (handlers, statistics) for each worker, and
+ * merge it after run() returns.
+ */
+class batch_driver {
+public:
+  class config;
+
+  /// The function called for each file
+  typedef std::function<void(int worker, std::string const& filename)>
+      process_function;
+
+  /// Constructor
+  explicit batch_driver(config const& cfg);
+
+  /// The number of workers used by run()
+  int workers() const {
+    return workers_;
+  }
+
+  /**
+   * Process all the files.
+   *
+   * Errors processing a file are logged and counted, the remaining
+   * files are still processed.
+   *
+   * @param filenames the files to process
+   * @param process the function called for each file
+   * @return the number of files that could not be processed
+   */
+  int run(
+      std::vector<std::string> const& filenames,
+      process_function const& process);
+
+  /**
+   * Expand a list of filenames and glob patterns.
+   *
+   * @param patterns filenames or shell glob patterns, e.g.
+   *   "data/201710*.NASDAQ_ITCH50.gz"
+   * @return the matching files, in the order of the patterns and
+   *   sorted for each pattern, files matched by more than one
+   *   pattern are returned only once
+   * @throw std::runtime_error if a pattern does not match any file
+   */
+  static std::vector<std::string>
+  expand(std::vector<std::string> const& patterns);
+
+private:
+  /// The loop executed by each worker
+  void worker_loop(int worker, process_function const& process);
+
+  /// Pick the next file the caller can process, requires a lock
+  bool next_file(std::string& filename, bool& compressed);
+
+private:
+  /// A file waiting to be processed
+  struct pending_file {
+    std::string filename;
+    std::uint64_t size;
+    bool compressed;
+  };
+
+  int workers_;
+  int max_decompressors_;
+  jb::cpu_set affinity_;
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::vector<pending_file> pending_;
+  int active_decompressors_;
+  int failures_;
+};
+
+/**
+ * Configure a batch_driver object.
+ */
+class batch_driver::config : public jb::config_object {
+public:
+  config();
+  config_object_constructors(config);
+
+  /// Validate the configuration
+  void validate() const override;
+
+  jb::config_attribute<config, int> workers;
+  jb::config_attribute<config, int> max_decompressors;
+  jb::config_attribute<config, jb::cpu_set> affinity;
+};
+
+} // namespace jb
+
+#endif // jb_batch_driver_hpp
@@ -1,5 +1,6 @@
 #include <jb/testing/microbenchmark.hpp>
 #include <jb/testing/microbenchmark_group_main.hpp>
+#include <jb/tsc_clock.hpp>
 
 #include <chrono>
 #include <iostream>
@@ -100,6 +101,15 @@ jb::testing::microbenchmark_group<config> create_testcases() {
       {"std::chrono::system_clock_clock", test_case<system_clock>()},
       {"rdtscp", test_case<wrapped_rtdscp>()},
       {"rdtsc", test_case<wrapped_rtdsc>()},
+      {"jb::tsc_clock",
+       [](config const& cfg) {
+         // ... the clock silently falls back to steady_clock if the
+         // counter is not usable, report what is actually measured ...
+         std::cerr << "jb::tsc_clock uses_tsc=" << jb::tsc_clock::uses_tsc()
+                   << ", frequency=" << jb::tsc_clock::frequency()
+                   << std::endl;
+         test_case<jb::tsc_clock>()(cfg);
+       }},
   };
 }
 
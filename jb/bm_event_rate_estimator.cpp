@@ -0,0 +1,263 @@
+/**
+ * @file
+ *
+ * This is a benchmark for the event rate estimators used in
+ * jb::offline_feed_statistics.  It compares the time to estimate the
+ * per-second, per-millisecond and per-microsecond rates for a bursty
+ * stream of events using one jb::event_rate_histogram per resolution
+ * vs. a single jb::multi_event_rate_estimator.
+ *
+ * The events arrive in bursts, separated by gaps of a few
+ * microseconds to a few milliseconds, similar to a market data feed.
+ *
+ *   bm_event_rate_estimator --microbenchmark.test-case=single
+ *   bm_event_rate_estimator --microbenchmark.test-case=multi
+ */
+#include <jb/testing/microbenchmark.hpp>
+#include <jb/testing/microbenchmark_group_main.hpp>
+#include <jb/event_rate_histogram.hpp>
+#include <jb/log.hpp>
+#include <jb/multi_event_rate_estimator.hpp>
+#include <jb/observed_rate_histogram.hpp>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+/**
+ * Define types and functions used in this program.
+ */
+namespace {
+/// Configuration parameters for bm_event_rate_estimator
+class config : public jb::config_object {
+public:
+  config();
+  config_object_constructors(config);
+
+  void validate() const override;
+
+  jb::config_attribute<config, jb::log::config> log;
+  jb::config_attribute<config, jb::testing::microbenchmark_config>
+      microbenchmark;
+  jb::config_attribute<config, int> burst_size;
+  jb::config_attribute<config, int> max_gap_nanoseconds;
+  jb::config_attribute<config, int> seed;
+};
+
+jb::testing::microbenchmark_group<config> create_testcases();
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  auto testcases = create_testcases();
+  return jb::testing::microbenchmark_group_main(argc, argv, testcases);
+}
+
+namespace {
+namespace defaults {
+
+#ifndef JB_DEFAULTS_bm_event_rate_estimator_size
+#define JB_DEFAULTS_bm_event_rate_estimator_size 100000
+#endif // JB_DEFAULTS_bm_event_rate_estimator_size
+
+#ifndef JB_DEFAULTS_bm_event_rate_estimator_burst_size
+#define JB_DEFAULTS_bm_event_rate_estimator_burst_size 20
+#endif // JB_DEFAULTS_bm_event_rate_estimator_burst_size
+
+#ifndef JB_DEFAULTS_bm_event_rate_estimator_max_gap_nanoseconds
+#define JB_DEFAULTS_bm_event_rate_estimator_max_gap_nanoseconds 2000000
+#endif // JB_DEFAULTS_bm_event_rate_estimator_max_gap_nanoseconds
+
+#ifndef JB_DEFAULTS_bm_event_rate_estimator_seed
+#define JB_DEFAULTS_bm_event_rate_estimator_seed 20171023
+#endif // JB_DEFAULTS_bm_event_rate_estimator_seed
+
+int const size = JB_DEFAULTS_bm_event_rate_estimator_size;
+int const burst_size = JB_DEFAULTS_bm_event_rate_estimator_burst_size;
+int const max_gap_nanoseconds =
+    JB_DEFAULTS_bm_event_rate_estimator_max_gap_nanoseconds;
+int const seed = JB_DEFAULTS_bm_event_rate_estimator_seed;
+
+} // namespace defaults
+
+/// The maximum rates for the histograms, as in offline_feed_statistics
+std::uint64_t const max_per_sec = 1000000;
+std::uint64_t const max_per_msec = 10000;
+std::uint64_t const max_per_usec = 1000;
+
+/// Use one jb::event_rate_histogram per resolution
+class use_single {
+public:
+  use_single()
+      : per_sec_(
+            max_per_sec, std::chrono::seconds(1), std::chrono::milliseconds(1))
+      , per_msec_(
+            max_per_msec, std::chrono::milliseconds(1),
+            std::chrono::microseconds(1))
+      , per_usec_(
+            max_per_usec, std::chrono::microseconds(1),
+            std::chrono::nanoseconds(1)) {
+  }
+
+  void sample(std::chrono::nanoseconds ts) {
+    per_sec_.sample(ts);
+    per_msec_.sample(ts);
+    per_usec_.sample(ts);
+  }
+
+  std::uint64_t nsamples() const {
+    return per_sec_.nsamples() + per_msec_.nsamples() + per_usec_.nsamples();
+  }
+
+private:
+  typedef jb::event_rate_histogram<std::chrono::nanoseconds, std::int64_t>
+      rate_histogram;
+  rate_histogram per_sec_;
+  rate_histogram per_msec_;
+  rate_histogram per_usec_;
+};
+
+/// Use a single jb::multi_event_rate_estimator for all resolutions
+class use_multi {
+public:
+  use_multi()
+      : per_sec_(max_per_sec)
+      , per_msec_(max_per_msec)
+      , per_usec_(max_per_usec)
+      , rates_({{std::chrono::seconds(1), std::chrono::milliseconds(1)},
+                {std::chrono::milliseconds(1), std::chrono::microseconds(1)},
+                {std::chrono::microseconds(1), std::chrono::nanoseconds(1)}}) {
+  }
+
+  void sample(std::chrono::nanoseconds ts) {
+    rates_.sample(
+        ts, [this](std::size_t index, std::uint64_t rate, std::uint64_t n) {
+          switch (index) {
+          case 0:
+            per_sec_.record(rate, n);
+            break;
+          case 1:
+            per_msec_.record(rate, n);
+            break;
+          default:
+            per_usec_.record(rate, n);
+          }
+        });
+  }
+
+  std::uint64_t nsamples() const {
+    return per_sec_.nsamples() + per_msec_.nsamples() + per_usec_.nsamples();
+  }
+
+private:
+  typedef jb::observed_rate_histogram<std::int64_t> rate_histogram;
+  rate_histogram per_sec_;
+  rate_histogram per_msec_;
+  rate_histogram per_usec_;
+  jb::multi_event_rate_estimator<std::chrono::nanoseconds> rates_;
+};
+
+/**
+ * Estimate the event rates for a bursty stream of events.
+ *
+ * @tparam estimator_type how to estimate the rates
+ */
+template <typename estimator_type>
+class fixture {
+public:
+  /// Constructor with the default size
+  explicit fixture(config const& cfg)
+      : fixture(defaults::size, cfg) {
+  }
+
+  /**
+   * Construct a new fixture.
+   *
+   * @param size the number of events
+   * @param cfg the benchmark configuration
+   */
+  fixture(int size, config const& cfg)
+      : timestamps_()
+      , nsamples_(0) {
+    std::mt19937_64 generator(cfg.seed());
+    std::uniform_int_distribution<int> burst(1, 2 * cfg.burst_size());
+    std::uniform_int_distribution<std::int64_t> within(0, 200);
+    std::uniform_int_distribution<std::int64_t> gap(
+        1000, cfg.max_gap_nanoseconds());
+    // ... start at 09:30:00, like the ITCH-5.0 feeds ...
+    std::int64_t ts = 34200000000000;
+    timestamps_.reserve(size);
+    while (timestamps_.size() < std::size_t(size)) {
+      for (int i = burst(generator);
+           i != 0 and timestamps_.size() < std::size_t(size); --i) {
+        ts += within(generator);
+        timestamps_.emplace_back(ts);
+      }
+      ts += gap(generator);
+    }
+  }
+
+  /// Estimate the rates for all the events
+  int run() {
+    estimator_type estimator;
+    for (auto ts : timestamps_) {
+      estimator.sample(ts);
+    }
+    nsamples_ += estimator.nsamples();
+    return static_cast<int>(timestamps_.size());
+  }
+
+private:
+  std::vector<std::chrono::nanoseconds> timestamps_;
+  std::uint64_t nsamples_;
+};
+
+/**
+ * Run the benchmark for a given estimator.
+ *
+ * @param cfg the configuration for the benchmark
+ */
+template <typename estimator_type>
+void run_benchmark(config const& cfg) {
+  using benchmark = jb::testing::microbenchmark<fixture<estimator_type>>;
+  benchmark bm(cfg.microbenchmark());
+  auto r = bm.run(cfg);
+  bm.typical_output(r);
+}
+
+jb::testing::microbenchmark_group<config> create_testcases() {
+  return jb::testing::microbenchmark_group<config>{
+      {"single", run_benchmark<use_single>},
+      {"multi", run_benchmark<use_multi>},
+  };
+}
+
+config::config()
+    : log(desc("log", "logging"), this)
+    , microbenchmark(
+          desc("microbenchmark", "microbenchmark"), this,
+          jb::testing::microbenchmark_config().test_case("multi"))
+    , burst_size(
+          desc("burst-size")
+              .help("The average number of events in each burst."),
+          this, defaults::burst_size)
+    , max_gap_nanoseconds(
+          desc("max-gap-nanoseconds")
+              .help("The maximum time between two bursts of events."),
+          this, defaults::max_gap_nanoseconds)
+    , seed(
+          desc("seed").help("The seed for the generator of the timestamps."),
+          this, defaults::seed) {
+}
+
+void config::validate() const {
+  if (burst_size() <= 0) {
+    throw jb::usage("burst-size must be > 0", 1);
+  }
+  if (max_gap_nanoseconds() < 1000) {
+    throw jb::usage("max-gap-nanoseconds must be >= 1000", 1);
+  }
+  log().validate();
+  microbenchmark().validate();
+}
+
+} // anonymous namespace
@@ -0,0 +1,255 @@
+/**
+ * @file
+ *
+ * This is a benchmark for jb::kll_sketch.  It compares the time to
+ * record a series of latencies in a jb::kll_sketch vs. a jb::histogram
+ * with one bin per nanosecond (jb::integer_range_binning), and
+ * reports the rank error of the estimated quantiles and the memory
+ * used by each one.
+ *
+ * The latencies are read from a file, one value (in nanoseconds) per
+ * line, for example, the latencies recorded by a feed handler.  If no
+ * file is given the program generates latencies with a log-normal
+ * distribution.  Latencies larger than the histogram range are only
+ * counted in its overflow bin, so the high quantiles are not
+ * accurate in that case.
+ *
+ *   bm_kll_sketch --microbenchmark.test-case=histogram
+ *   bm_kll_sketch --microbenchmark.test-case=sketch
+ */
+#include <jb/testing/microbenchmark.hpp>
+#include <jb/testing/microbenchmark_group_main.hpp>
+#include <jb/fileio.hpp>
+#include <jb/histogram.hpp>
+#include <jb/integer_range_binning.hpp>
+#include <jb/kll_sketch.hpp>
+#include <jb/log.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * Define types and functions used in this program.
+ */
+namespace {
+/// Configuration parameters for bm_kll_sketch
+class config : public jb::config_object {
+public:
+  config();
+  config_object_constructors(config);
+
+  void validate() const override;
+
+  jb::config_attribute<config, jb::log::config> log;
+  jb::config_attribute<config, jb::testing::microbenchmark_config>
+      microbenchmark;
+  jb::config_attribute<config, std::string> input_file;
+  jb::config_attribute<config, std::int64_t> histogram_max;
+  jb::config_attribute<config, int> sketch_k;
+  jb::config_attribute<config, int> seed;
+};
+
+jb::testing::microbenchmark_group<config> create_testcases();
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  auto testcases = create_testcases();
+  return jb::testing::microbenchmark_group_main(argc, argv, testcases);
+}
+
+namespace {
+namespace defaults {
+
+#ifndef JB_DEFAULTS_bm_kll_sketch_size
+#define JB_DEFAULTS_bm_kll_sketch_size 1000000
+#endif // JB_DEFAULTS_bm_kll_sketch_size
+
+#ifndef JB_DEFAULTS_bm_kll_sketch_histogram_max
+#define JB_DEFAULTS_bm_kll_sketch_histogram_max 1000000
+#endif // JB_DEFAULTS_bm_kll_sketch_histogram_max
+
+#ifndef JB_DEFAULTS_bm_kll_sketch_seed
+#define JB_DEFAULTS_bm_kll_sketch_seed 20171101
+#endif // JB_DEFAULTS_bm_kll_sketch_seed
+
+int const size = JB_DEFAULTS_bm_kll_sketch_size;
+std::int64_t const histogram_max = JB_DEFAULTS_bm_kll_sketch_histogram_max;
+int const seed = JB_DEFAULTS_bm_kll_sketch_seed;
+
+} // namespace defaults
+
+/// Record the latencies in a histogram with one bin per nanosecond
+struct use_histogram {
+  typedef jb::histogram<jb::integer_range_binning<std::int64_t>> type;
+
+  static type create(config const& cfg) {
+    typedef jb::integer_range_binning<std::int64_t> binning;
+    return type(binning(0, cfg.histogram_max()));
+  }
+
+  static std::size_t bytes(type const&, config const& cfg) {
+    return cfg.histogram_max() * sizeof(type::counter_type);
+  }
+};
+
+/// Record the latencies in a jb::kll_sketch
+struct use_sketch {
+  typedef jb::kll_sketch<std::int64_t> type;
+
+  static type create(config const& cfg) {
+    return type(cfg.sketch_k());
+  }
+
+  static std::size_t bytes(type const& sketch, config const&) {
+    return sketch.retained() * sizeof(type::sample_type);
+  }
+};
+
+/// Load the latencies from the input file, or generate them
+std::vector<std::int64_t> load_latencies(int size, config const& cfg) {
+  std::vector<std::int64_t> latencies;
+  if (not cfg.input_file().empty()) {
+    boost::iostreams::filtering_istream in;
+    jb::open_input_file(in, cfg.input_file());
+    std::int64_t value;
+    while (in >> value and latencies.size() < std::size_t(size)) {
+      latencies.push_back(value);
+    }
+    return latencies;
+  }
+  std::mt19937_64 generator(cfg.seed());
+  std::lognormal_distribution<double> latency(8.0, 1.5);
+  for (int i = 0; i != size; ++i) {
+    latencies.push_back(static_cast<std::int64_t>(latency(generator)));
+  }
+  return latencies;
+}
+
+/**
+ * Record a series of latencies.
+ *
+ * @tparam backend how to record the latencies
+ */
+template <typename backend>
+class fixture {
+public:
+  /// Constructor with the default size
+  explicit fixture(config const& cfg)
+      : fixture(defaults::size, cfg) {
+  }
+
+  /**
+   * Construct a new fixture.
+   *
+   * @param size the number of latencies
+   * @param cfg the benchmark configuration
+   */
+  fixture(int size, config const& cfg)
+      : cfg_(cfg)
+      , latencies_(load_latencies(size, cfg))
+      , recorded_(backend::create(cfg)) {
+  }
+
+  /// Record all the latencies
+  int run() {
+    auto recorded = backend::create(cfg_);
+    for (auto v : latencies_) {
+      recorded.sample(v);
+    }
+    recorded_ = std::move(recorded);
+    return static_cast<int>(latencies_.size());
+  }
+
+  /// Report the rank error for some quantiles and the memory usage
+  void report_accuracy(std::ostream& os) const {
+    auto sorted = latencies_;
+    std::sort(sorted.begin(), sorted.end());
+    os << cfg_.microbenchmark().test_case()
+       << " bytes=" << backend::bytes(recorded_, cfg_);
+    for (double q : {0.5, 0.9, 0.99, 0.999, 0.9999}) {
+      auto estimate = recorded_.estimated_quantile(q);
+      auto i = std::upper_bound(sorted.begin(), sorted.end(), estimate);
+      double rank = double(i - sorted.begin()) / sorted.size();
+      os << ", q=" << q << ": estimate=" << estimate
+         << " rank_error=" << rank - q;
+    }
+    os << std::endl;
+  }
+
+private:
+  config const& cfg_;
+  std::vector<std::int64_t> latencies_;
+  typename backend::type recorded_;
+};
+
+/**
+ * Run the benchmark for a given backend.
+ *
+ * @param cfg the configuration for the benchmark
+ */
+template <typename backend>
+void run_benchmark(config const& cfg) {
+  using benchmark = jb::testing::microbenchmark<fixture<backend>>;
+  benchmark bm(cfg.microbenchmark());
+  auto r = bm.run(cfg);
+  bm.typical_output(r);
+
+  // ... a separate fixture to report the accuracy, the benchmark does
+  // not expose the fixture it used ...
+  fixture<backend> f(
+      cfg.microbenchmark().size() == 0 ? defaults::size
+                                       : cfg.microbenchmark().size(),
+      cfg);
+  f.run();
+  f.report_accuracy(std::cerr);
+}
+
+jb::testing::microbenchmark_group<config> create_testcases() {
+  return jb::testing::microbenchmark_group<config>{
+      {"histogram", run_benchmark<use_histogram>},
+      {"sketch", run_benchmark<use_sketch>},
+  };
+}
+
+config::config()
+    : log(desc("log", "logging"), this)
+    , microbenchmark(
+          desc("microbenchmark", "microbenchmark"), this,
+          jb::testing::microbenchmark_config().test_case("sketch"))
+    , input_file(
+          desc("input-file")
+              .help(
+                  "A file with the latencies to record, one value (in"
+                  " nanoseconds) per line.  If empty, generate the latencies"
+                  " with a log-normal distribution."),
+          this)
+    , histogram_max(
+          desc("histogram-max")
+              .help(
+                  "The range of the histogram, larger latencies are only"
+                  " counted in the overflow bin."),
+          this, defaults::histogram_max)
+    , sketch_k(
+          desc("sketch-k").help("The accuracy parameter for the sketch."),
+          this, jb::kll_sketch<std::int64_t>::default_k)
+    , seed(
+          desc("seed").help("The seed for the generator of the latencies."),
+          this, defaults::seed) {
+}
+
+void config::validate() const {
+  if (histogram_max() <= 1) {
+    throw jb::usage("histogram-max must be > 1", 1);
+  }
+  if (sketch_k() < jb::kll_sketch<std::int64_t>::min_k or
+      sketch_k() > jb::kll_sketch<std::int64_t>::max_k) {
+    throw jb::usage("sketch-k is out of range", 1);
+  }
+  log().validate();
+  microbenchmark().validate();
+}
+
+} // anonymous namespace
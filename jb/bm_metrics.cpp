@@ -0,0 +1,257 @@
+/**
+ * @file
+ *
+ * This is a benchmark for the jb::metrics encodings.  It compares the
+ * time to render a registry with many histograms (e.g. one latency
+ * histogram per security) in the Prometheus text format vs. the
+ * binary format, and the binary format when only the metrics changed
+ * since the previous scrape are requested.
+ *
+ * Before each iteration a few of the histograms receive new samples,
+ * simulating the changes between two scrapes.  In addition to the
+ * usual microbenchmark output the program reports the average size
+ * of each scrape.
+ *
+ *   bm_metrics --microbenchmark.test-case=text
+ *   bm_metrics --microbenchmark.test-case=binary
+ *   bm_metrics --microbenchmark.test-case=binary-changed
+ */
+#include <jb/testing/microbenchmark.hpp>
+#include <jb/testing/microbenchmark_group_main.hpp>
+#include <jb/explicit_cuts_binning.hpp>
+#include <jb/log.hpp>
+#include <jb/metrics.hpp>
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+/**
+ * Define types and functions used in this program.
+ */
+namespace {
+/// Configuration parameters for bm_metrics
+class config : public jb::config_object {
+public:
+  config();
+  config_object_constructors(config);
+
+  void validate() const override;
+
+  jb::config_attribute<config, jb::log::config> log;
+  jb::config_attribute<config, jb::testing::microbenchmark_config>
+      microbenchmark;
+  jb::config_attribute<config, int> changed;
+  jb::config_attribute<config, int> seed;
+};
+
+jb::testing::microbenchmark_group<config> create_testcases();
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  auto testcases = create_testcases();
+  return jb::testing::microbenchmark_group_main(argc, argv, testcases);
+}
+
+namespace {
+namespace defaults {
+
+#ifndef JB_DEFAULTS_bm_metrics_size
+#define JB_DEFAULTS_bm_metrics_size 500
+#endif // JB_DEFAULTS_bm_metrics_size
+
+#ifndef JB_DEFAULTS_bm_metrics_changed
+#define JB_DEFAULTS_bm_metrics_changed 10
+#endif // JB_DEFAULTS_bm_metrics_changed
+
+#ifndef JB_DEFAULTS_bm_metrics_seed
+#define JB_DEFAULTS_bm_metrics_seed 20170812
+#endif // JB_DEFAULTS_bm_metrics_seed
+
+int const size = JB_DEFAULTS_bm_metrics_size;
+int const changed = JB_DEFAULTS_bm_metrics_changed;
+int const seed = JB_DEFAULTS_bm_metrics_seed;
+
+} // namespace defaults
+
+/// The binning used for the histograms, 1-2-5 steps up to 10ms
+jb::explicit_cuts_binning<std::int64_t> latency_binning() {
+  std::vector<std::int64_t> cuts{0};
+  for (std::int64_t decade = 1; decade != 10000000; decade *= 10) {
+    cuts.push_back(decade);
+    cuts.push_back(2 * decade);
+    cuts.push_back(5 * decade);
+  }
+  cuts.push_back(10000000);
+  return jb::explicit_cuts_binning<std::int64_t>(cuts.begin(), cuts.end());
+}
+
+/// Render the metrics in Prometheus text format
+struct use_text {
+  static std::uint64_t
+  render(jb::metrics::registry const& r, std::string& body, std::uint64_t) {
+    r.append_text(body);
+    return 0;
+  }
+};
+
+/// Render all the metrics in binary format
+struct use_binary {
+  static std::uint64_t
+  render(jb::metrics::registry const& r, std::string& body, std::uint64_t) {
+    return r.append_binary(body, 0);
+  }
+};
+
+/// Render the metrics changed since the previous scrape in binary format
+struct use_binary_changed {
+  static std::uint64_t render(
+      jb::metrics::registry const& r, std::string& body,
+      std::uint64_t previous) {
+    return r.append_binary(body, previous);
+  }
+};
+
+/**
+ * Render a registry with many histograms.
+ *
+ * @tparam render_policy how to render the metrics
+ */
+template <typename render_policy>
+class fixture {
+public:
+  /// Constructor with the default size
+  explicit fixture(config const& cfg)
+      : fixture(defaults::size, cfg) {
+  }
+
+  /**
+   * Construct a new fixture.
+   *
+   * @param size the number of histograms in the registry
+   * @param cfg the benchmark configuration
+   */
+  fixture(int size, config const& cfg)
+      : registry_()
+      , histograms_()
+      , generator_(cfg.seed())
+      , changed_(cfg.changed())
+      , sequence_(0)
+      , body_()
+      , bytes_(0)
+      , scrapes_(0) {
+    auto binning = latency_binning();
+    for (int i = 0; i != size; ++i) {
+      auto& h = registry_.make_histogram(
+          "latency_nanoseconds", "the latency for each security", binning,
+          {{"security", std::to_string(i)}});
+      histograms_.push_back(&h);
+      for (int j = 0; j != 1000; ++j) {
+        h.sample(sample());
+      }
+    }
+    // ... the first scrape includes all the metrics, the benchmark
+    // measures the steady state ...
+    sequence_ = registry_.append_binary(body_, 0);
+  }
+
+  /// Update a few histograms, as if some time passed between scrapes
+  void iteration_setup() {
+    std::uniform_int_distribution<std::size_t> pick(
+        0, histograms_.size() - 1);
+    for (int i = 0; i != changed_; ++i) {
+      histograms_[pick(generator_)]->sample(sample());
+    }
+    body_.clear();
+  }
+
+  /// Render the metrics
+  int run() {
+    sequence_ = render_policy::render(registry_, body_, sequence_);
+    bytes_ += body_.size();
+    ++scrapes_;
+    return static_cast<int>(histograms_.size());
+  }
+
+  /// The average size of each scrape
+  double average_bytes() const {
+    return scrapes_ == 0 ? 0.0 : double(bytes_) / scrapes_;
+  }
+
+private:
+  /// Generate a sample with a long tail, like most latencies
+  std::int64_t sample() {
+    std::lognormal_distribution<double> latency(8.0, 1.0);
+    return static_cast<std::int64_t>(latency(generator_));
+  }
+
+private:
+  jb::metrics::registry registry_;
+  std::vector<jb::metrics::histogram<
+      jb::explicit_cuts_binning<std::int64_t>>*>
+      histograms_;
+  std::mt19937_64 generator_;
+  int changed_;
+  std::uint64_t sequence_;
+  std::string body_;
+  std::uint64_t bytes_;
+  std::uint64_t scrapes_;
+};
+
+/**
+ * Run the benchmark for a given render policy.
+ *
+ * @param cfg the configuration for the benchmark
+ */
+template <typename render_policy>
+void run_benchmark(config const& cfg) {
+  using benchmark = jb::testing::microbenchmark<fixture<render_policy>>;
+  benchmark bm(cfg.microbenchmark());
+  auto r = bm.run(cfg);
+  bm.typical_output(r);
+
+  // ... a separate fixture to report the size of each scrape, the
+  // benchmark does not expose the fixture it used ...
+  fixture<render_policy> f(
+      cfg.microbenchmark().size() == 0 ? defaults::size
+                                       : cfg.microbenchmark().size(),
+      cfg);
+  for (int i = 0; i != 10; ++i) {
+    f.iteration_setup();
+    f.run();
+  }
+  std::cerr << cfg.microbenchmark().test_case()
+            << " bytes/scrape=" << f.average_bytes() << std::endl;
+}
+
+jb::testing::microbenchmark_group<config> create_testcases() {
+  return jb::testing::microbenchmark_group<config>{
+      {"text", run_benchmark<use_text>},
+      {"binary", run_benchmark<use_binary>},
+      {"binary-changed", run_benchmark<use_binary_changed>},
+  };
+}
+
+config::config()
+    : log(desc("log", "logging"), this)
+    , microbenchmark(
+          desc("microbenchmark", "microbenchmark"), this,
+          jb::testing::microbenchmark_config().test_case("binary-changed"))
+    , changed(
+          desc("changed").help(
+              "The number of histograms updated between scrapes."),
+          this, defaults::changed)
+    , seed(
+          desc("seed").help("The seed for the generator of the samples."),
+          this, defaults::seed) {
+}
+
+void config::validate() const {
+  if (changed() < 0) {
+    throw jb::usage("changed must be >= 0", 1);
+  }
+  log().validate();
+  microbenchmark().validate();
+}
+
+} // anonymous namespace
@@ -36,8 +36,12 @@ void report_rate(
 } // anonymous namespace
 
 jb::book_depth_statistics::book_depth_statistics(config const& cfg)
-    : book_depth_(
-          book_depth_histogram_t::binning_strategy(0, cfg.max_book_depth())) {
+    : book_depth_(book_depth_histogram_t::binning_strategy(
+          0, cfg.max_book_depth(),
+          cfg.significant_digits() != 0
+              ? cfg.significant_digits()
+              : book_depth_histogram_t::binning_strategy::linear_digits(
+                    0, cfg.max_book_depth()))) {
 }
 
 void jb::book_depth_statistics::print_csv_header(std::ostream& os) {
@@ -68,7 +72,13 @@ namespace defaults {
 #define JB_BOOK_DEPTH_STATS_DEFAULTS_max_book_depth 8192
 #endif
 
+#ifndef JB_BOOK_DEPTH_STATS_DEFAULTS_significant_digits
+#define JB_BOOK_DEPTH_STATS_DEFAULTS_significant_digits 0
+#endif
+
 book_depth_t max_book_depth = JB_BOOK_DEPTH_STATS_DEFAULTS_max_book_depth;
+int book_depth_significant_digits =
+    JB_BOOK_DEPTH_STATS_DEFAULTS_significant_digits;
 
 } // namespace defaults
 } // namespace jb
@@ -81,7 +91,14 @@ jb::book_depth_statistics::config::config()
                   " no more than this many values"
                   "   Higher values consume more memory, but give more accurate"
                   " results for high percentiles."),
-          this, defaults::max_book_depth) {
+          this, defaults::max_book_depth)
+    , significant_digits(
+          desc("significant-digits")
+              .help(
+                  "Configure the book_depth histogram to preserve this many"
+                  " significant digits, using a log-linear binning."
+                  "  Use 0 to have one bin per value."),
+          this, defaults::book_depth_significant_digits) {
 }
 
 void jb::book_depth_statistics::config::validate() const {
@@ -90,4 +107,13 @@ void jb::book_depth_statistics::config::validate() const {
     os << "max_book_depth must be > 1, value=" << max_book_depth();
     throw jb::usage(os.str(), 1);
   }
+  if (significant_digits() < 0 or
+      significant_digits() >
+          book_depth_histogram_t::binning_strategy::max_significant_digits) {
+    std::ostringstream os;
+    os << "significant_digits must be in the [0,"
+       << book_depth_histogram_t::binning_strategy::max_significant_digits
+       << "] range, value=" << significant_digits();
+    throw jb::usage(os.str(), 1);
+  }
 }
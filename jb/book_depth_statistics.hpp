@@ -4,15 +4,20 @@
 #include <jb/config_object.hpp>
 #include <jb/event_rate_histogram.hpp>
 #include <jb/histogram.hpp>
-#include <jb/integer_range_binning.hpp>
+#include <jb/log_linear_binning.hpp>
 
 #include <iosfwd>
+#include <string>
 
 namespace jb {
 typedef unsigned long int book_depth_t;
 
 /**
  * Keep statistics about a feed and its book depth.
+ *
+ * By default the histogram has one bin per book depth value,
+ * configure the number of significant digits to cover deeper books
+ * with fewer bins.
  */
 class book_depth_statistics {
 public:
@@ -59,8 +64,45 @@ public:
    */
   void print_csv(std::string const& name, std::ostream& os) const;
 
+  /**
+   * Add the samples recorded by another object.
+   *
+   * The result is identical to a single object that recorded all the
+   * samples.  Both objects must use the same configuration.
+   *
+   * @throw std::invalid_argument if the histograms have different bins
+   */
+  void merge(book_depth_statistics const& rhs) {
+    book_depth_.merge(rhs.book_depth_);
+  }
+
+  /// Add the samples recorded by another object, see merge()
+  book_depth_statistics& operator+=(book_depth_statistics const& rhs) {
+    merge(rhs);
+    return *this;
+  }
+
+  /**
+   * Append a compact binary representation of the statistics.
+   *
+   * See jb::histogram::encode() for details.
+   */
+  void encode(std::string& buffer) const {
+    book_depth_.encode(buffer);
+  }
+
+  /**
+   * Decode statistics created by encode() and merge them.
+   *
+   * @throw std::runtime_error if the data is malformed or the
+   * histograms have different bins
+   */
+  void merge_encoded(metrics::binary::reader& r) {
+    book_depth_.merge_encoded(r);
+  }
+
 private:
-  typedef histogram<integer_range_binning<book_depth_t>> book_depth_histogram_t;
+  typedef histogram<log_linear_binning<book_depth_t>> book_depth_histogram_t;
   book_depth_histogram_t book_depth_;
 };
 
@@ -77,6 +119,9 @@ public:
 
   /// No more than this value is recorded
   jb::config_attribute<config, book_depth_t> max_book_depth;
+
+  /// The precision of the histogram, 0 means one bin per value
+  jb::config_attribute<config, int> significant_digits;
 };
 
 } // namespace jb
@@ -0,0 +1,251 @@
+#ifndef jb_conflation_queue_hpp
+#define jb_conflation_queue_hpp
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace jb {
+
+/**
+ * A queue that keeps only the latest value for each key.
+ *
+ * Market data consumers are typically interested in the current
+ * state of each security, not in every intermediate state.  When the
+ * consumer (e.g. the thread writing to a socket) falls behind the
+ * producer (e.g. the thread building the book), this queue conflates
+ * the updates: at most one value is pending for each key, and a new
+ * value for a pending key simply replaces the old one.
+ *
+ * The keys are small dense integers (e.g. the ITCH-5.x stock locate
+ * code), so the values are stored in a flat array indexed by key.
+ * The keys with a pending value are kept in an intrusive FIFO list,
+ * threaded through the array, so each key is delivered in the order
+ * it first became dirty, and the consumer never scans clean keys.
+ *
+ * The queue is thread-safe.  Producers never block for longer than it
+ * takes to copy a value, consumers can wait for new values.
+ *
+ * @tparam value_t the type of values stored in the queue, must be
+ * default constructible and copy assignable.
+ */
+template <typename value_t>
+class conflation_queue {
+public:
+  //@{
+  /**
+   * @name Type traits
+   */
+  typedef value_t value_type;
+  typedef std::size_t key_type;
+  typedef std::pair<key_type, value_type> entry_type;
+  //@}
+
+  /// Per-key counters, the ratio pushed / popped measures conflation
+  struct key_stats {
+    std::uint64_t pushed;
+    std::uint64_t popped;
+  };
+
+  /**
+   * Constructor
+   *
+   * @param capacity the number of keys, all the keys must be in the
+   * [0,capacity) range
+   */
+  explicit conflation_queue(std::size_t capacity)
+      : mu_()
+      , cv_()
+      , slots_(capacity)
+      , head_(npos)
+      , tail_(npos)
+      , dirty_count_(0)
+      , stopped_(false) {
+  }
+
+  /**
+   * Set the pending value for @a key.
+   *
+   * @returns true if the value replaced a pending value, i.e., if the
+   * update was conflated
+   * @throws std::out_of_range if @a key is not valid
+   */
+  bool push(key_type key, value_type const& value) {
+    check_key(key);
+    std::unique_lock<std::mutex> lock(mu_);
+    auto& s = slots_[key];
+    s.value = value;
+    ++s.stats.pushed;
+    if (s.dirty) {
+      return true;
+    }
+    s.dirty = true;
+    s.next = npos;
+    if (tail_ == npos) {
+      head_ = key;
+    } else {
+      slots_[tail_].next = key;
+    }
+    tail_ = key;
+    if (dirty_count_++ == 0) {
+      lock.unlock();
+      cv_.notify_one();
+    }
+    return false;
+  }
+
+  /**
+   * Remove up to @a max pending values, without blocking.
+   *
+   * @param out the values are appended to this vector
+   * @param max the maximum number of values to remove
+   * @returns the number of values removed
+   */
+  std::size_t try_pop(std::vector<entry_type>& out, std::size_t max) {
+    std::lock_guard<std::mutex> guard(mu_);
+    return pop_locked(out, max);
+  }
+
+  /**
+   * Remove up to @a max pending values, waiting if there are none.
+   *
+   * @param out the values are appended to this vector
+   * @param max the maximum number of values to remove
+   * @param timeout how long to wait for new values
+   * @returns the number of values removed, 0 if the queue is stopped
+   * or the timeout expired
+   */
+  template <typename duration_t>
+  std::size_t pop_wait(
+      std::vector<entry_type>& out, std::size_t max, duration_t timeout) {
+    std::unique_lock<std::mutex> lock(mu_);
+    cv_.wait_for(
+        lock, timeout, [this]() { return dirty_count_ != 0 or stopped_; });
+    return pop_locked(out, max);
+  }
+
+  /// Wake up any consumers, pop_wait() no longer blocks
+  void stop() {
+    {
+      std::lock_guard<std::mutex> guard(mu_);
+      stopped_ = true;
+    }
+    cv_.notify_all();
+  }
+
+  /// Return true if stop() was called
+  bool stopped() const {
+    std::lock_guard<std::mutex> guard(mu_);
+    return stopped_;
+  }
+
+  /// The number of keys with a pending value
+  std::size_t dirty_count() const {
+    std::lock_guard<std::mutex> guard(mu_);
+    return dirty_count_;
+  }
+
+  /// The counters for @a key
+  key_stats stats(key_type key) const {
+    check_key(key);
+    std::lock_guard<std::mutex> guard(mu_);
+    return slots_[key].stats;
+  }
+
+  /**
+   * Call @a f for each key that has received at least one value.
+   *
+   * The function is called with the key, its counters, and the last
+   * value pushed for it.  The queue lock is held only while copying
+   * those into a snapshot, the function is called after the lock is
+   * released, so it can be slow (e.g. formatting metrics) without
+   * blocking the producers or the consumers.
+   */
+  template <typename functor>
+  void for_each_stats(functor&& f) const {
+    std::vector<stats_entry> snapshot;
+    {
+      std::lock_guard<std::mutex> guard(mu_);
+      for (key_type key = 0; key != slots_.size(); ++key) {
+        auto const& s = slots_[key];
+        if (s.stats.pushed != 0) {
+          snapshot.push_back(stats_entry{key, s.stats, s.value});
+        }
+      }
+    }
+    for (auto const& e : snapshot) {
+      f(e.key, e.stats, e.value);
+    }
+  }
+
+private:
+  /// Raise an exception if the key is out of range
+  void check_key(key_type key) const {
+    if (key < slots_.size()) {
+      return;
+    }
+    std::ostringstream os;
+    os << "conflation_queue - key (" << key << ") out of range, capacity="
+       << slots_.size();
+    throw std::out_of_range(os.str());
+  }
+
+  /// Implement try_pop() and pop_wait(), the caller holds mu_
+  std::size_t pop_locked(std::vector<entry_type>& out, std::size_t max) {
+    std::size_t count = 0;
+    while (head_ != npos and count != max) {
+      auto key = head_;
+      auto& s = slots_[key];
+      out.emplace_back(key, s.value);
+      ++s.stats.popped;
+      s.dirty = false;
+      head_ = s.next;
+      s.next = npos;
+      --dirty_count_;
+      ++count;
+    }
+    if (head_ == npos) {
+      tail_ = npos;
+    }
+    return count;
+  }
+
+private:
+  static constexpr key_type npos = ~key_type(0);
+
+  /// The state for each key
+  struct slot {
+    value_type value = value_type();
+    key_stats stats = key_stats{0, 0};
+    key_type next = npos;
+    bool dirty = false;
+  };
+
+  /// A copy of the counters and last value for a key
+  struct stats_entry {
+    key_type key;
+    key_stats stats;
+    value_type value;
+  };
+
+  mutable std::mutex mu_;
+  std::condition_variable cv_;
+  std::vector<slot> slots_;
+  key_type head_;
+  key_type tail_;
+  std::size_t dirty_count_;
+  bool stopped_;
+};
+
+template <typename value_t>
+constexpr typename conflation_queue<value_t>::key_type
+    conflation_queue<value_t>::npos;
+
+} // namespace jb
+
+#endif // jb_conflation_queue_hpp
@@ -1,6 +1,7 @@
 #include "jb/ehs/request_dispatcher.hpp"
 #include <jb/log.hpp>
 
+#include <cstdlib>
 #include <sstream>
 
 namespace jb {
@@ -42,7 +43,10 @@ void request_dispatcher::add_handler(
 }
 
 response_type request_dispatcher::process(request_type const& req) try {
-  auto found = find_handler(req.target());
+  // ... the handlers are registered by path, the query string (if
+  // any) is for the handler to interpret ...
+  auto target = req.target();
+  auto found = find_handler(target.substr(0, target.find('?')));
   if (not found.second) {
     return not_found(req);
   }
@@ -110,6 +114,34 @@ void request_dispatcher::append_metrics(response_type& res) const {
   res.body += os.str();
 }
 
+void request_dispatcher::append_metrics(
+    response_type& res, jb::metrics::registry const& r) const {
+  append_metrics(res);
+  r.append_text(res.body);
+}
+
+void request_dispatcher::append_binary_metrics(
+    request_type const& req, response_type& res,
+    jb::metrics::registry const& r) const {
+  auto since = query_parameter(std::string(req.target()), "since");
+  res.set("content-type", "application/octet-stream");
+  r.append_binary(res.body, std::strtoull(since.c_str(), nullptr, 10));
+}
+
+std::string request_dispatcher::query_parameter(
+    std::string const& target, std::string const& name) {
+  auto q = target.find('?');
+  std::string const key = name + "=";
+  auto p = q == std::string::npos ? q : target.find(key, q);
+  for (; p != std::string::npos; p = target.find(key, p + 1)) {
+    if (target[p - 1] == '?' or target[p - 1] == '&') {
+      auto start = p + key.size();
+      return target.substr(start, target.find('&', start) - start);
+    }
+  }
+  return std::string();
+}
+
 response_type request_dispatcher::internal_error(request_type const& req) {
   response_type res;
   res.result(beast::http::status::internal_server_error);
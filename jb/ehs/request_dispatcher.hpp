@@ -2,6 +2,7 @@
 #define jb_ehs_request_dispatcher_hpp
 
 #include <jb/ehs/base_types.hpp>
+#include <jb/metrics.hpp>
 
 #include <atomic>
 #include <functional>
@@ -47,6 +48,9 @@ public:
   /**
    * Process a new request using the right handler.
    *
+   * The handler is selected using the path in the request target,
+   * ignoring any query string.
+   *
    * Returns the response to send back to the client.  The handler
    * typically creates a normal 200 response, but other responses can
    * be created by the client.  The dispatcher automatically creates
@@ -63,10 +67,9 @@ public:
   /**
    * Event counters.
    *
-   * A series of functions to count interesting events.
-   * TODO(coryan) this should really be a separate class that can
-   * count any number of metrics, including maps, histograms, rates,
-   * etc.  Look at prometheus.io for inspiration.
+   * A series of functions to count interesting events.  The
+   * application metrics should use a jb::metrics::registry instead,
+   * and report it with the append_metrics() overload.
    */
   /// Count a new connection opened
   void count_open_connection() {
@@ -175,6 +178,45 @@ public:
    */
   void append_metrics(response_type& res) const;
 
+  /**
+   * Append the internal metrics and the metrics in @a r to the body
+   * of @a res.
+   *
+   * @param res a http response where we will append the metrics.
+   * @param r the application metrics
+   */
+  void append_metrics(
+      response_type& res, jb::metrics::registry const& r) const;
+
+  /**
+   * Append the metrics in @a r to the body of @a res, in the binary
+   * format defined in jb/metrics_binary.hpp.
+   *
+   * If the request target has a "since=<sequence>" query parameter
+   * only the metrics that changed after that scrape are included.
+   *
+   * @param req the http request
+   * @param res the http response
+   * @param r the application metrics
+   */
+  void append_binary_metrics(
+      request_type const& req, response_type& res,
+      jb::metrics::registry const& r) const;
+
+  /**
+   * Return the value of a query parameter in a request target.
+   *
+   * The value is not decoded, the handlers in this project only use
+   * simple names and numbers as parameters.
+   *
+   * @param target the request target, e.g. "/path?a=1&b=2"
+   * @param name the name of the parameter
+   * @returns the value of the parameter, or an empty string if it is
+   * not present
+   */
+  static std::string
+  query_parameter(std::string const& target, std::string const& name);
+
 private:
   /**
    * Create a 500 response.
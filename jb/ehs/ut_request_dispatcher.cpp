@@ -210,3 +210,19 @@ BOOST_AUTO_TEST_CASE(request_dispatcher_append_metrics) {
   tested.append_metrics(res);
   BOOST_CHECK_NE(res.body, "");
 }
+
+/**
+ * @test Verify that jb::ehs::request_dispatcher::query_parameter works
+ * as expected.
+ */
+BOOST_AUTO_TEST_CASE(request_dispatcher_query_parameter) {
+  using jb::ehs::request_dispatcher;
+  auto const target = std::string("/replay-start?session=a&since=42");
+  BOOST_CHECK_EQUAL(
+      request_dispatcher::query_parameter(target, "session"), "a");
+  BOOST_CHECK_EQUAL(request_dispatcher::query_parameter(target, "since"), "42");
+  BOOST_CHECK_EQUAL(request_dispatcher::query_parameter(target, "ince"), "");
+  BOOST_CHECK_EQUAL(request_dispatcher::query_parameter(target, "x"), "");
+  BOOST_CHECK_EQUAL(
+      request_dispatcher::query_parameter("/replay-start", "session"), "");
+}
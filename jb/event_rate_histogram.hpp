@@ -2,8 +2,7 @@
 #define jb_event_rate_histogram_hpp
 
 #include <jb/event_rate_estimator.hpp>
-#include <jb/histogram.hpp>
-#include <jb/integer_range_binning.hpp>
+#include <jb/observed_rate_histogram.hpp>
 
 namespace jb {
 
@@ -43,7 +42,9 @@ namespace jb {
  * might be less accurate.  Memory requirements are low (the data
  * structure is basically a vector of ints), but can be an issue if
  * you create many histograms (for example, one histogram per security
- * when analyzing a market data feed).
+ * when analyzing a market data feed).  In that case, consider using
+ * fewer significant digits, the histogram then uses a log-linear
+ * binning and needs far fewer bins for the same range.
  *
  * @tparam duration_type Define the units used to measure time.  This
  *   class assumes all events are timestamped with a class compatible
@@ -65,15 +66,15 @@ namespace jb {
 template <
     typename duration_type = std::chrono::microseconds,
     typename counter_type = int, typename rate_counter_type = int>
-class event_rate_histogram
-    : private histogram<integer_range_binning<std::uint64_t>, counter_type> {
+class event_rate_histogram : public observed_rate_histogram<counter_type> {
 public:
   //@{
   /**
    * @name Type traits.
    */
-  typedef integer_range_binning<std::uint64_t> binning_strategy;
-  typedef histogram<binning_strategy, counter_type> rate_histogram;
+  typedef observed_rate_histogram<counter_type> observed_rates;
+  typedef typename observed_rates::binning_strategy binning_strategy;
+  typedef typename observed_rates::rate_histogram rate_histogram;
   //@}
 
   /**
@@ -85,47 +86,32 @@ public:
    *   rates, the high quantiles may not be very accurate.
    * @param measurement_period over what period we measure event rates.
    * @param sampling_period how often do we measure event rates.
+   * @param significant_digits the precision of the histogram, 0 means
+   *   one bin for each rate value.
    */
   event_rate_histogram(
       std::uint64_t max_expected_rate, duration_type measurement_period,
-      duration_type sampling_period = duration_type(1))
-      : rate_histogram(binning_strategy(0, max_expected_rate))
-      , rate_(measurement_period, sampling_period)
-      , last_rate_(0) {
+      duration_type sampling_period = duration_type(1),
+      int significant_digits = 0)
+      : observed_rates(max_expected_rate, significant_digits)
+      , rate_(measurement_period, sampling_period) {
   }
 
   /// Record a new sample.
   void sample(duration_type ts) {
     rate_.sample(ts, [this](std::uint64_t rate, std::uint64_t repeats) {
-      this->last_rate_ = rate;
-      this->rate_histogram::weighted_sample(rate, repeats);
+      this->record(rate, repeats);
     });
   }
 
-  /// Get the last sample, if any.
-  std::uint64_t last_rate() const {
-    if (nsamples() == 0) {
-      throw std::invalid_argument("No sample recorded yet");
-    }
-    return last_rate_;
+  /// Add the rates observed by another object, see merge()
+  event_rate_histogram& operator+=(event_rate_histogram const& rhs) {
+    this->merge(rhs);
+    return *this;
   }
 
-  //@{
-  /**
-   * @name Histogram accessors.
-   */
-  using rate_histogram::nsamples;
-  using rate_histogram::observed_min;
-  using rate_histogram::observed_max;
-  using rate_histogram::estimated_mean;
-  using rate_histogram::estimated_quantile;
-  using rate_histogram::overflow_count;
-  using rate_histogram::underflow_count;
-  //@}
-
 private:
   event_rate_estimator<duration_type, rate_counter_type> rate_;
-  std::uint64_t last_rate_;
 };
 
 } // namespace jb
@@ -0,0 +1,62 @@
+#include "jb/fast_format.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+namespace jb {
+namespace detail {
+char const digit_pairs[201] = "00010203040506070809"
+                              "10111213141516171819"
+                              "20212223242526272829"
+                              "30313233343536373839"
+                              "40414243444546474849"
+                              "50515253545556575859"
+                              "60616263646566676869"
+                              "70717273747576777879"
+                              "80818283848586878889"
+                              "90919293949596979899";
+} // namespace detail
+
+constexpr std::size_t fast_format::default_buffer_size;
+
+fast_format::fast_format(std::ostream& os, std::size_t buffer_size)
+    : os_(os)
+    , buffer_(
+          buffer_size < 2 * max_formatted_integer_size
+              ? 2 * max_formatted_integer_size
+              : buffer_size)
+    , size_(0) {
+}
+
+fast_format::~fast_format() {
+  try {
+    flush();
+  } catch (...) {
+    // ... the stream may be configured to raise exceptions, but
+    // destructors cannot raise them ...
+  }
+}
+
+void fast_format::flush() {
+  if (size_ == 0) {
+    return;
+  }
+  os_.write(buffer_.data(), size_);
+  size_ = 0;
+}
+
+fast_format& fast_format::append(char const* s, std::size_t n) {
+  while (n != 0) {
+    if (size_ == buffer_.size()) {
+      flush();
+    }
+    auto count = std::min(n, buffer_.size() - size_);
+    std::memcpy(buffer_.data() + size_, s, count);
+    size_ += count;
+    s += count;
+    n -= count;
+  }
+  return *this;
+}
+
+} // namespace jb
@@ -0,0 +1,219 @@
+#ifndef jb_fast_format_hpp
+#define jb_fast_format_hpp
+
+#include <cstdint>
+#include <cstring>
+#include <iosfwd>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace jb {
+
+namespace detail {
+/// The ASCII representation of 00, 01, ..., 99, two characters each
+extern char const digit_pairs[201];
+} // namespace detail
+
+/// The maximum number of characters produced by jb::format_integer()
+constexpr std::size_t max_formatted_integer_size = 20;
+
+/**
+ * Format an unsigned integer in decimal.
+ *
+ * The digits are generated two at a time using a lookup table,
+ * without any of the locale or formatting state used by
+ * std::ostream.
+ *
+ * @param out where to write the digits, must have room for at least
+ * jb::max_formatted_integer_size characters
+ * @param value the value to format
+ * @returns the position after the last character written
+ */
+template <typename integer_t>
+typename std::enable_if<std::is_unsigned<integer_t>::value, char*>::type
+format_integer(char* out, integer_t value) {
+  static_assert(
+      std::numeric_limits<integer_t>::digits10 < max_formatted_integer_size,
+      "integer type is too large for jb::format_integer()");
+  // ... generate the digits from the right into a temporary buffer,
+  // then copy them, counting the digits first is not any faster ...
+  char tmp[max_formatted_integer_size];
+  char* end = tmp + sizeof(tmp);
+  char* p = end;
+  while (value >= 100) {
+    auto i = static_cast<std::size_t>(value % 100) * 2;
+    value /= 100;
+    p -= 2;
+    std::memcpy(p, detail::digit_pairs + i, 2);
+  }
+  if (value >= 10) {
+    auto i = static_cast<std::size_t>(value) * 2;
+    p -= 2;
+    std::memcpy(p, detail::digit_pairs + i, 2);
+  } else {
+    *--p = static_cast<char>('0' + value);
+  }
+  std::memcpy(out, p, end - p);
+  return out + (end - p);
+}
+
+/**
+ * Format a signed integer in decimal.
+ *
+ * @param out where to write the characters, must have room for at
+ * least jb::max_formatted_integer_size characters
+ * @param value the value to format
+ * @returns the position after the last character written
+ */
+template <typename integer_t>
+typename std::enable_if<
+    std::is_integral<integer_t>::value and std::is_signed<integer_t>::value,
+    char*>::type
+format_integer(char* out, integer_t value) {
+  typedef typename std::make_unsigned<integer_t>::type unsigned_type;
+  auto u = static_cast<unsigned_type>(value);
+  if (value < 0) {
+    *out++ = '-';
+    // ... this is well defined even for the minimum value ...
+    u = unsigned_type(0) - u;
+  }
+  return format_integer(out, u);
+}
+
+/**
+ * Format a fixed-point value, e.g. a price.
+ *
+ * The value is printed as @a value / @a denom, with exactly
+ * @a decimals digits after the decimal point.  The output matches
+ * what the streaming operator for jb::itch5::price_field produces.
+ *
+ * @param out where to write the characters, must have room for at
+ * least jb::max_formatted_integer_size + 1 characters
+ * @param value the fixed-point value, as an integer
+ * @param denom the denominator for the value, a power of 10
+ * @param decimals the number of decimal digits, log10(denom)
+ * @returns the position after the last character written
+ */
+template <typename integer_t>
+char* format_fixed(char* out, integer_t value, integer_t denom, int decimals) {
+  static_assert(
+      std::is_unsigned<integer_t>::value,
+      "jb::format_fixed() requires an unsigned type");
+  out = format_integer(out, static_cast<integer_t>(value / denom));
+  *out++ = '.';
+  auto rem = value % denom;
+  for (int i = decimals - 1; i >= 0; --i) {
+    out[i] = static_cast<char>('0' + rem % 10);
+    rem /= 10;
+  }
+  return out + decimals;
+}
+
+/**
+ * Format text into a large buffer and write it to a std::ostream in
+ * bulk.
+ *
+ * The ITCH-5.0 tools produce one line per event, and formatting the
+ * numbers in those lines through std::ostream dominates their
+ * running time when the output is enabled.  This class formats the
+ * values directly into a reusable buffer, and only writes to the
+ * stream when the buffer is full, or when flush() is called.
+ *
+ * Applications must call flush() before using the stream directly,
+ * the destructor flushes any remaining data.
+ */
+class fast_format {
+public:
+  /// The default size for the buffer
+  static constexpr std::size_t default_buffer_size = 1 << 16;
+
+  /**
+   * Constructor.
+   *
+   * @param os where to write the formatted data
+   * @param buffer_size the size of the buffer, the data is written
+   * to @a os when the buffer fills up
+   */
+  explicit fast_format(
+      std::ostream& os, std::size_t buffer_size = default_buffer_size);
+
+  /// Destructor, flush any remaining data
+  ~fast_format();
+
+  fast_format(fast_format const&) = delete;
+  fast_format& operator=(fast_format const&) = delete;
+
+  /// Write the contents of the buffer to the stream
+  void flush();
+
+  /**
+   * Return a pointer to at least @a n writable characters.
+   *
+   * This is used to format values directly into the buffer, the
+   * application must call commit() to consume the characters.
+   *
+   * @param n the number of characters required, it must be smaller
+   * than the buffer size
+   */
+  char* reserve(std::size_t n) {
+    if (buffer_.size() - size_ < n) {
+      flush();
+    }
+    return buffer_.data() + size_;
+  }
+
+  /**
+   * Consume the characters formatted after a call to reserve().
+   *
+   * @param end the position after the last character formatted
+   */
+  void commit(char* end) {
+    size_ = end - buffer_.data();
+  }
+
+  /// The number of characters waiting in the buffer
+  std::size_t pending() const {
+    return size_;
+  }
+
+  /// Append @a n characters starting at @a s
+  fast_format& append(char const* s, std::size_t n);
+
+  //@{
+  /**
+   * @name Formatting operators
+   */
+  fast_format& operator<<(char c) {
+    *reserve(1) = c;
+    ++size_;
+    return *this;
+  }
+
+  fast_format& operator<<(char const* s) {
+    return append(s, std::strlen(s));
+  }
+
+  fast_format& operator<<(std::string const& s) {
+    return append(s.data(), s.size());
+  }
+
+  template <typename integer_t>
+  typename std::enable_if<std::is_integral<integer_t>::value, fast_format&>::
+      type
+      operator<<(integer_t value) {
+    commit(format_integer(reserve(max_formatted_integer_size + 1), value));
+    return *this;
+  }
+  //@}
+
+private:
+  std::ostream& os_;
+  std::vector<char> buffer_;
+  std::size_t size_;
+};
+
+} // namespace jb
+
+#endif // jb_fast_format_hpp
@@ -2,12 +2,16 @@
 #define jb_histogram_hpp
 
 #include <jb/histogram_summary.hpp>
+#include <jb/metrics_binary.hpp>
+#include <algorithm>
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <limits>
 #include <stdexcept>
+#include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace jb {
@@ -226,10 +230,160 @@ public:
     *this = std::move(fresh);
   }
 
+  /**
+   * Add the samples recorded by another histogram.
+   *
+   * Histograms filled with disjoint subsets of the samples (e.g. one
+   * per thread, per input file, or per day) can be merged, the result
+   * is identical to a histogram that recorded all the samples.
+   *
+   * @throw std::invalid_argument if the histograms have different bins
+   */
+  void merge(histogram const& rhs) {
+    bool compatible =
+        binning_.histogram_min() == rhs.binning_.histogram_min() and
+        binning_.histogram_max() == rhs.binning_.histogram_max() and
+        bins_.size() == rhs.bins_.size();
+    for (std::size_t i = 0; compatible and i != bins_.size(); ++i) {
+      compatible = binning_.bin2sample(i) == rhs.binning_.bin2sample(i);
+    }
+    if (not compatible) {
+      throw std::invalid_argument(
+          "Cannot merge histograms with different binning");
+    }
+    if (rhs.nsamples_ == 0) {
+      return;
+    }
+    for (std::size_t i = 0; i != bins_.size(); ++i) {
+      bins_[i] += rhs.bins_[i];
+    }
+    merge_totals(
+        rhs.nsamples_, rhs.observed_min_, rhs.observed_max_,
+        rhs.underflow_count_, rhs.overflow_count_);
+  }
+
+  /// Add the samples recorded by another histogram, see merge()
+  histogram& operator+=(histogram const& rhs) {
+    merge(rhs);
+    return *this;
+  }
+
+  /**
+   * Append a compact binary representation of the histogram.
+   *
+   * The encoding uses the varint and zigzag primitives from
+   * jb::metrics::binary, and only includes the non-empty bins:
+   *
+   * @code
+   * histogram := zigzag(histogram_min) zigzag(histogram_max)
+   *              varint(nbins) varint(nsamples) zigzag(observed_min)
+   *              zigzag(observed_max) varint(underflow)
+   *              varint(overflow) varint(nonempty) bin*
+   * bin := varint(index - previous_index) varint(count)
+   * @endcode
+   *
+   * The binning strategy is not encoded, the decoder must use the
+   * same strategy, only the range and number of bins are checked.
+   *
+   * @param buffer where the encoded histogram is appended
+   */
+  void encode(std::string& buffer) const {
+    static_assert(
+        std::is_integral<sample_type>::value,
+        "Only histograms of integral samples can be encoded");
+    using namespace metrics::binary;
+    put_zigzag(buffer, static_cast<std::int64_t>(binning_.histogram_min()));
+    put_zigzag(buffer, static_cast<std::int64_t>(binning_.histogram_max()));
+    put_varint(buffer, bins_.size());
+    put_varint(buffer, nsamples_);
+    put_zigzag(buffer, static_cast<std::int64_t>(observed_min_));
+    put_zigzag(buffer, static_cast<std::int64_t>(observed_max_));
+    put_varint(buffer, underflow_count_);
+    put_varint(buffer, overflow_count_);
+    std::uint64_t nonempty = 0;
+    for (auto c : bins_) {
+      nonempty += c != 0;
+    }
+    put_varint(buffer, nonempty);
+    std::size_t previous = 0;
+    for (std::size_t i = 0; i != bins_.size(); ++i) {
+      if (bins_[i] == 0) {
+        continue;
+      }
+      put_varint(buffer, i - previous);
+      put_varint(buffer, bins_[i]);
+      previous = i;
+    }
+  }
+
+  /**
+   * Decode a histogram created by encode() and merge its samples.
+   *
+   * @param r the reader positioned at the beginning of the encoded
+   * histogram, on return it is positioned after the histogram
+   * @throw std::runtime_error if the encoded histogram is malformed
+   * or has a different range or number of bins
+   */
+  void merge_encoded(metrics::binary::reader& r) {
+    static_assert(
+        std::is_integral<sample_type>::value,
+        "Only histograms of integral samples can be decoded");
+    auto h_min = static_cast<sample_type>(r.zigzag());
+    auto h_max = static_cast<sample_type>(r.zigzag());
+    auto nbins = r.varint();
+    if (h_min != binning_.histogram_min() or
+        h_max != binning_.histogram_max() or nbins != bins_.size()) {
+      throw std::runtime_error(
+          "Cannot merge encoded histogram with different binning");
+    }
+    auto n = r.varint();
+    auto o_min = static_cast<sample_type>(r.zigzag());
+    auto o_max = static_cast<sample_type>(r.zigzag());
+    auto underflow = r.varint();
+    auto overflow = r.varint();
+    auto nonempty = r.varint();
+    // ... decode all the bins before changing any counter, so a
+    // malformed histogram leaves this one unchanged ...
+    std::vector<std::pair<std::size_t, counter_type>> decoded;
+    decoded.reserve(std::min<std::uint64_t>(nonempty, bins_.size()));
+    std::uint64_t i = 0;
+    for (std::uint64_t k = 0; k != nonempty; ++k) {
+      auto delta = r.varint();
+      auto count = r.varint();
+      // ... compare before adding, a large delta could wrap around ...
+      if (delta >= bins_.size() - i) {
+        throw std::runtime_error("Invalid bin index in encoded histogram");
+      }
+      i += delta;
+      decoded.emplace_back(i, static_cast<counter_type>(count));
+    }
+    for (auto const& b : decoded) {
+      bins_[b.first] += b.second;
+    }
+    if (n != 0) {
+      merge_totals(n, o_min, o_max, underflow, overflow);
+    }
+  }
+
   /// The type used to store the bins.
   typedef std::vector<counter_type> counters;
 
 private:
+  /// Merge the counters and extremes from another histogram
+  void merge_totals(
+      std::uint64_t n, sample_type const& o_min, sample_type const& o_max,
+      std::uint64_t underflow, std::uint64_t overflow) {
+    nsamples_ += n;
+    underflow_count_ += underflow;
+    overflow_count_ += overflow;
+    if (observed_min_ > o_min) {
+      observed_min_ = o_min;
+    }
+    if (observed_max_ < o_max) {
+      observed_max_ = o_max;
+    }
+  }
+
   /// Compute the maximum number of bins that might be needed.
   std::size_t nbins() const {
     std::size_t max = binning_.sample2bin(binning_.histogram_max());
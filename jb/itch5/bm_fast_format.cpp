@@ -0,0 +1,242 @@
+/**
+ * @file
+ *
+ * This is a benchmark for jb::fast_format.  It compares the time to
+ * format the lines produced by the ITCH-5.0 tools using the iostream
+ * operators vs. using jb::fast_format.
+ *
+ * The lines are written to a boost::iostreams::filtering_ostream
+ * (the same type used by the tools) connected to a null sink, so
+ * the benchmark measures the formatting cost, not the cost to write
+ * or compress the data.  In addition to the usual microbenchmark
+ * output the program reports the number of lines per second.
+ *
+ * Compare the results for the different test cases, e.g.:
+ *
+ *   bm_fast_format --microbenchmark.test-case=iostream-inside
+ *   bm_fast_format --microbenchmark.test-case=fast-format-inside
+ */
+#include <jb/itch5/price_field.hpp>
+#include <jb/itch5/stock_field.hpp>
+#include <jb/testing/microbenchmark.hpp>
+#include <jb/testing/microbenchmark_group_main.hpp>
+#include <jb/fast_format.hpp>
+#include <jb/log.hpp>
+
+#include <boost/iostreams/device/null.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+/**
+ * Define types and functions used in this program.
+ */
+namespace {
+/// Configuration parameters for bm_fast_format
+class config : public jb::config_object {
+public:
+  config();
+  config_object_constructors(config);
+
+  void validate() const override;
+
+  jb::config_attribute<config, jb::log::config> log;
+  jb::config_attribute<config, jb::testing::microbenchmark_config>
+      microbenchmark;
+  jb::config_attribute<config, int> seed;
+};
+
+jb::testing::microbenchmark_group<config> create_testcases();
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  auto testcases = create_testcases();
+  return jb::testing::microbenchmark_group_main(argc, argv, testcases);
+}
+
+namespace {
+namespace defaults {
+
+#ifndef JB_ITCH5_DEFAULTS_bm_fast_format_size
+#define JB_ITCH5_DEFAULTS_bm_fast_format_size 10000
+#endif // JB_ITCH5_DEFAULTS_bm_fast_format_size
+
+#ifndef JB_ITCH5_DEFAULTS_bm_fast_format_seed
+#define JB_ITCH5_DEFAULTS_bm_fast_format_seed 20161018
+#endif // JB_ITCH5_DEFAULTS_bm_fast_format_seed
+
+int const size = JB_ITCH5_DEFAULTS_bm_fast_format_size;
+int const seed = JB_ITCH5_DEFAULTS_bm_fast_format_seed;
+
+} // namespace defaults
+
+/// The data in each line, a superset of the inside and trade lines
+struct line_data {
+  std::int64_t timestamp;
+  int stock_locate;
+  jb::itch5::stock_t stock;
+  std::uint64_t order_reference_number;
+  char buy_sell_indicator;
+  std::uint32_t shares;
+  jb::itch5::price4_t bid_px;
+  int bid_qty;
+  jb::itch5::price4_t offer_px;
+  int offer_qty;
+  std::uint64_t match_number;
+};
+
+/// Format lines in the same format as jb::itch5::generate_inside()
+struct inside_line {
+  template <typename output_type>
+  static void write(output_type& out, line_data const& l) {
+    out << l.timestamp << ' ' << l.stock_locate << ' ' << l.stock << ' '
+        << l.bid_px.as_integer() << ' ' << l.bid_qty << ' '
+        << l.offer_px.as_integer() << ' ' << l.offer_qty << '\n';
+  }
+};
+
+/// Format lines in the same format as the itch5trades tool
+struct trade_line {
+  template <typename output_type>
+  static void write(output_type& out, line_data const& l) {
+    out << l.timestamp << ' ' << l.order_reference_number << ' '
+        << l.buy_sell_indicator << ' ' << l.shares << ' ' << l.stock << ' '
+        << l.bid_px << ' ' << l.match_number << '\n';
+  }
+};
+
+/// Write directly to the std::ostream
+struct use_iostream {
+  template <typename line_format>
+  static void write(std::ostream& os, std::vector<line_data> const& data) {
+    for (auto const& l : data) {
+      line_format::write(os, l);
+    }
+  }
+};
+
+/// Write using a jb::fast_format buffer
+struct use_fast_format {
+  template <typename line_format>
+  static void write(std::ostream& os, std::vector<line_data> const& data) {
+    jb::fast_format out(os);
+    for (auto const& l : data) {
+      line_format::write(out, l);
+    }
+  }
+};
+
+/**
+ * Format a number of lines into a stream.
+ *
+ * @tparam output_policy how to format the lines, use_iostream or
+ * use_fast_format
+ * @tparam line_format the format for the lines, inside_line or
+ * trade_line
+ */
+template <typename output_policy, typename line_format>
+class fixture {
+public:
+  /// Constructor with the default size
+  explicit fixture(config const& cfg)
+      : fixture(defaults::size, cfg) {
+  }
+
+  /**
+   * Construct a new fixture.
+   *
+   * @param size the number of lines formatted in each iteration
+   * @param cfg the benchmark configuration
+   */
+  fixture(int size, config const& cfg)
+      : data_(size)
+      , os_() {
+    os_.push(boost::iostreams::null_sink());
+    std::mt19937_64 generator(cfg.seed());
+    std::uniform_int_distribution<int> locate(1, 8192);
+    std::uniform_int_distribution<int> qty(1, 100000);
+    std::uniform_int_distribution<std::uint32_t> px(1, 2000 * 10000);
+    std::uniform_int_distribution<std::int64_t> ts(
+        0, std::int64_t(16) * 3600 * 1000000000);
+    char const* symbols[] = {"AAPL", "MSFT", "SPY", "QQQ", "GOOG", "A"};
+    for (auto& l : data_) {
+      l.timestamp = ts(generator);
+      l.stock_locate = locate(generator);
+      l.stock = jb::itch5::stock_t(symbols[l.stock_locate % 6]);
+      l.order_reference_number = generator() >> 20;
+      l.buy_sell_indicator = l.stock_locate % 2 ? 'B' : 'S';
+      l.shares = qty(generator);
+      l.bid_px = jb::itch5::price4_t(px(generator));
+      l.bid_qty = qty(generator);
+      l.offer_px = jb::itch5::price4_t(l.bid_px.as_integer() + 100);
+      l.offer_qty = qty(generator);
+      l.match_number = generator() >> 24;
+    }
+  }
+
+  /// Format all the lines
+  int run() {
+    output_policy::template write<line_format>(os_, data_);
+    os_.flush();
+    return static_cast<int>(data_.size());
+  }
+
+private:
+  std::vector<line_data> data_;
+  boost::iostreams::filtering_ostream os_;
+};
+
+/**
+ * Run the benchmark for a given output policy and line format.
+ *
+ * @param cfg the configuration for the benchmark
+ */
+template <typename output_policy, typename line_format>
+void run_benchmark(config const& cfg) {
+  jb::testing::microbenchmark<fixture<output_policy, line_format>> bm(
+      cfg.microbenchmark());
+  auto r = bm.run(cfg);
+  bm.typical_output(r);
+
+  // ... the warmup iterations are not in the results, count only the
+  // lines in the measured iterations ...
+  std::int64_t measured = 0;
+  jb::testing::microbenchmark_base::duration elapsed(0);
+  for (auto const& i : r) {
+    measured += i.first;
+    elapsed += i.second;
+  }
+  using seconds = std::chrono::duration<double>;
+  auto s = std::chrono::duration_cast<seconds>(elapsed).count();
+  std::cerr << cfg.microbenchmark().test_case() << " lines=" << measured
+            << ", lines/s=" << (s == 0 ? 0.0 : measured / s) << std::endl;
+}
+
+jb::testing::microbenchmark_group<config> create_testcases() {
+  return jb::testing::microbenchmark_group<config>{
+      {"iostream-inside", run_benchmark<use_iostream, inside_line>},
+      {"fast-format-inside", run_benchmark<use_fast_format, inside_line>},
+      {"iostream-trades", run_benchmark<use_iostream, trade_line>},
+      {"fast-format-trades", run_benchmark<use_fast_format, trade_line>},
+  };
+}
+
+config::config()
+    : log(desc("log", "logging"), this)
+    , microbenchmark(
+          desc("microbenchmark", "microbenchmark"), this,
+          jb::testing::microbenchmark_config().test_case(
+              "fast-format-inside"))
+    , seed(
+          desc("seed").help("The seed for the generator of the lines."), this,
+          defaults::seed) {
+}
+
+void config::validate() const {
+  log().validate();
+  microbenchmark().validate();
+}
+
+} // anonymous namespace
@@ -0,0 +1,262 @@
+/**
+ * @file
+ *
+ * This is a benchmark for the MoldUDP64 gap recovery.  It measures
+ * how long it takes a jb::itch5::mold_udp_channel to recover a gap
+ * using retransmission requests to a jb::itch5::mold_rerequest_server
+ * running in the same process.
+ *
+ * Each iteration sends a single MoldUDP64 packet whose sequence number
+ * is @a size messages ahead of the channel, that triggers a gap of
+ * @a size messages, and the iteration completes when all the missing
+ * messages (and the triggering message) are delivered.  The benchmark
+ * reports the recovery time for each iteration, and the overall
+ * recovery throughput in messages per second.
+ */
+#include <jb/itch5/base_encoders.hpp>
+#include <jb/itch5/message_store.hpp>
+#include <jb/itch5/mold_rerequest_server.hpp>
+#include <jb/itch5/mold_udp_channel.hpp>
+#include <jb/itch5/mold_udp_channel_config.hpp>
+#include <jb/itch5/mold_udp_protocol_constants.hpp>
+#include <jb/itch5/udp_receiver_config.hpp>
+#include <jb/testing/microbenchmark.hpp>
+#include <jb/testing/microbenchmark_group_main.hpp>
+#include <jb/log.hpp>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/ip/udp.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+/**
+ * Define types and functions used in this program.
+ */
+namespace {
+/// Configuration parameters for bm_mold_rerequest
+class config : public jb::config_object {
+public:
+  config();
+  config_object_constructors(config);
+
+  void validate() const override;
+
+  jb::config_attribute<config, jb::log::config> log;
+  jb::config_attribute<config, jb::testing::microbenchmark_config>
+      microbenchmark;
+  jb::config_attribute<config, jb::itch5::udp_receiver_config> receiver;
+  jb::config_attribute<config, jb::itch5::mold_rerequest_config> rerequest;
+  jb::config_attribute<config, int> max_packet_size;
+  jb::config_attribute<config, int> message_size;
+};
+
+jb::testing::microbenchmark_group<config> create_testcases();
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  auto testcases = create_testcases();
+  return jb::testing::microbenchmark_group_main(argc, argv, testcases);
+}
+
+namespace {
+namespace defaults {
+
+#ifndef JB_ITCH5_DEFAULTS_bm_mold_rerequest_size
+#define JB_ITCH5_DEFAULTS_bm_mold_rerequest_size 10000
+#endif // JB_ITCH5_DEFAULTS_bm_mold_rerequest_size
+
+#ifndef JB_ITCH5_DEFAULTS_bm_mold_rerequest_port
+#define JB_ITCH5_DEFAULTS_bm_mold_rerequest_port 40124
+#endif // JB_ITCH5_DEFAULTS_bm_mold_rerequest_port
+
+#ifndef JB_ITCH5_DEFAULTS_bm_mold_rerequest_max_packet_size
+#define JB_ITCH5_DEFAULTS_bm_mold_rerequest_max_packet_size 1400
+#endif // JB_ITCH5_DEFAULTS_bm_mold_rerequest_max_packet_size
+
+#ifndef JB_ITCH5_DEFAULTS_bm_mold_rerequest_message_size
+#define JB_ITCH5_DEFAULTS_bm_mold_rerequest_message_size 36
+#endif // JB_ITCH5_DEFAULTS_bm_mold_rerequest_message_size
+
+int const size = JB_ITCH5_DEFAULTS_bm_mold_rerequest_size;
+int const port = JB_ITCH5_DEFAULTS_bm_mold_rerequest_port;
+int const max_packet_size = JB_ITCH5_DEFAULTS_bm_mold_rerequest_max_packet_size;
+int const message_size = JB_ITCH5_DEFAULTS_bm_mold_rerequest_message_size;
+
+} // namespace defaults
+
+/**
+ * Trigger gaps in a jb::itch5::mold_udp_channel and measure how long
+ * the recovery takes.
+ */
+class fixture {
+public:
+  /// Constructor with the default size
+  explicit fixture(config const& cfg)
+      : fixture(defaults::size, cfg) {
+  }
+
+  /**
+   * Construct a new fixture.
+   *
+   * @param size the number of messages lost in each iteration
+   * @param cfg the benchmark configuration
+   */
+  fixture(int size, config const& cfg)
+      : size_(size)
+      , store_()
+      , io_()
+      , server_()
+      , channel_()
+      , socket_(io_)
+      , destination_(
+            boost::asio::ip::address::from_string(cfg.receiver().address()),
+            cfg.receiver().port())
+      , delivered_(0)
+      , next_gap_(0) {
+    // ... each iteration consumes size + 1 messages from the store ...
+    auto const& mbcfg = cfg.microbenchmark();
+    auto total = static_cast<std::uint64_t>(size_ + 1) *
+        (mbcfg.warmup_iterations() + mbcfg.iterations());
+    std::vector<char> msg(cfg.message_size());
+    for (std::uint64_t i = 0; i != total; ++i) {
+      jb::itch5::encoder<true, std::uint64_t>::w(msg.size(), msg.data(), 0, i);
+      store_.append(msg.data(), msg.size());
+    }
+
+    server_.reset(new jb::itch5::mold_rerequest_server(
+        io_, store_, jb::itch5::udp_receiver_config().address(
+                         cfg.rerequest().address()),
+        cfg.max_packet_size()));
+    auto chcfg = jb::itch5::mold_udp_channel_config().rerequest(
+        jb::itch5::mold_rerequest_config(cfg.rerequest())
+            .port(server_->local_endpoint().port()));
+    channel_.reset(new jb::itch5::mold_udp_channel(
+        io_,
+        [this](
+            std::chrono::steady_clock::time_point, std::uint64_t, std::size_t,
+            char const*, std::size_t) { ++delivered_; },
+        cfg.receiver(), chcfg));
+    socket_.open(destination_.protocol());
+  }
+
+  ~fixture() {
+    JB_LOG(info) << "requests=" << server_->requests_received()
+                 << ", packets=" << server_->packets_sent()
+                 << ", messages=" << server_->messages_sent();
+  }
+
+  /// Trigger a gap of size_ messages and wait until it is recovered
+  int run() {
+    // ... the last message of the range is sent, all the previous
+    // ones are missing ...
+    auto trigger = next_gap_ + size_;
+    auto expected = delivered_ + size_ + 1;
+    send_message(trigger);
+    next_gap_ = trigger + 1;
+
+    // ... UDP can drop packets, even on the loopback interface, the
+    // client retries the requests, but if the trigger is lost we
+    // would wait forever ...
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (delivered_ < expected) {
+      if (io_.poll() == 0 and std::chrono::steady_clock::now() > deadline) {
+        JB_LOG(warning) << "gap recovery timed out, delivered="
+                        << delivered_ << ", expected=" << expected;
+        break;
+      }
+    }
+    return size_;
+  }
+
+private:
+  /// Send a packet with a single message from the store
+  void send_message(std::uint64_t seqno) {
+    namespace mold = jb::itch5::mold_udp_protocol;
+    auto msglen = store_.message_size(seqno);
+    std::vector<char> packet(mold::header_size + 2 + msglen);
+    std::memcpy(packet.data(), "BENCHMARK0", mold::session_id_size);
+    jb::itch5::encoder<true, std::uint64_t>::w(
+        packet.size(), packet.data(), mold::sequence_number_offset, seqno);
+    jb::itch5::encoder<true, std::uint16_t>::w(
+        packet.size(), packet.data(), mold::block_count_offset, 1);
+    jb::itch5::encoder<true, std::uint16_t>::w(
+        packet.size(), packet.data(), mold::header_size, msglen);
+    std::memcpy(
+        packet.data() + mold::header_size + 2, store_.message_data(seqno),
+        msglen);
+    socket_.send_to(boost::asio::buffer(packet), destination_);
+  }
+
+private:
+  int size_;
+  jb::itch5::message_store store_;
+  boost::asio::io_service io_;
+  std::unique_ptr<jb::itch5::mold_rerequest_server> server_;
+  std::unique_ptr<jb::itch5::mold_udp_channel> channel_;
+  boost::asio::ip::udp::socket socket_;
+  boost::asio::ip::udp::endpoint destination_;
+  std::uint64_t delivered_;
+  std::uint64_t next_gap_;
+};
+
+jb::testing::microbenchmark_group<config> create_testcases() {
+  return jb::testing::microbenchmark_group<config>{
+      {"rerequest",
+       [](config const& cfg) {
+         jb::testing::microbenchmark<fixture> bm(cfg.microbenchmark());
+         auto r = bm.run(cfg);
+         bm.typical_output(r);
+
+         double messages = 0;
+         double seconds = 0;
+         for (auto const& i : r) {
+           messages += i.first;
+           seconds += std::chrono::duration<double>(i.second).count();
+         }
+         std::cerr << cfg.microbenchmark().test_case()
+                   << " recovered messages/s: "
+                   << (seconds > 0 ? messages / seconds : 0) << std::endl;
+       }},
+  };
+}
+
+config::config()
+    : log(desc("log", "logging"), this)
+    , microbenchmark(
+          desc("microbenchmark", "microbenchmark"), this,
+          jb::testing::microbenchmark_config().test_case("rerequest"))
+    , receiver(
+          desc("receiver"), this, jb::itch5::udp_receiver_config()
+                                      .address("127.0.0.1")
+                                      .port(defaults::port))
+    , rerequest(
+          desc("rerequest", "mold-rerequest")
+              .help("Configure the retransmission requests, the port is "
+                    "ignored, the server always uses an ephemeral port."),
+          this)
+    , max_packet_size(
+          desc("max-packet-size")
+              .help("The maximum size of the packets sent by the server."),
+          this, defaults::max_packet_size)
+    , message_size(
+          desc("message-size").help("The size of the synthetic messages."),
+          this, defaults::message_size) {
+}
+
+void config::validate() const {
+  log().validate();
+  microbenchmark().validate();
+  receiver().validate();
+  rerequest().validate();
+  if (message_size() < 8 or message_size() > 1024) {
+    throw jb::usage("--message-size must be in the [8,1024] range", 1);
+  }
+  if (max_packet_size() < message_size() + 22 or max_packet_size() > 65000) {
+    throw jb::usage("--max-packet-size is out of range", 1);
+  }
+}
+
+} // anonymous namespace
@@ -0,0 +1,353 @@
+/**
+ * @file
+ *
+ * This is a benchmark for jb::itch5::mold_udp_channel and
+ * jb::itch5::packet_mmap_channel.  It compares the one-way latency
+ * (from send_to() to the handler callback) of the default Boost.ASIO
+ * reactor mode, the busy polling mode, and the memory mapped ring.
+ *
+ * Each iteration sends a number of MoldUDP64 packets over the
+ * loopback interface, one at a time, and waits until each one is
+ * received before sending the next.  The send timestamp is embedded
+ * in the packet, the handler computes the latency and records it in
+ * a histogram, which is printed when the benchmark completes.
+ *
+ * With --burst the packets are sent as fast as possible, and the
+ * iteration waits for all of them at the end.  In this mode the
+ * benchmark reports the packets per second that the receiver can
+ * sustain.
+ *
+ * For meaningful results in busy polling mode the poll thread should
+ * be pinned to an isolated core, e.g.:
+ *
+ *   bm_mold_udp_channel --microbenchmark.test-case=busy-poll \
+ *       --channel.poll-thread.affinity=3
+ */
+#include <jb/itch5/base_encoders.hpp>
+#include <jb/itch5/mold_udp_channel.hpp>
+#include <jb/itch5/mold_udp_channel_config.hpp>
+#include <jb/itch5/mold_udp_protocol_constants.hpp>
+#include <jb/itch5/packet_mmap_channel.hpp>
+#include <jb/itch5/udp_receiver_config.hpp>
+#include <jb/testing/microbenchmark.hpp>
+#include <jb/testing/microbenchmark_group_main.hpp>
+#include <jb/histogram.hpp>
+#include <jb/integer_range_binning.hpp>
+#include <jb/log.hpp>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/ip/udp.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+/**
+ * Define types and functions used in this program.
+ */
+namespace {
+/// Configuration parameters for bm_mold_udp_channel
+class config : public jb::config_object {
+public:
+  config();
+  config_object_constructors(config);
+
+  void validate() const override;
+
+  jb::config_attribute<config, jb::log::config> log;
+  jb::config_attribute<config, jb::testing::microbenchmark_config>
+      microbenchmark;
+  jb::config_attribute<config, jb::itch5::udp_receiver_config> receiver;
+  jb::config_attribute<config, jb::itch5::mold_udp_channel_config> channel;
+  jb::config_attribute<config, jb::itch5::packet_mmap_config> packet_mmap;
+  jb::config_attribute<config, int> max_latency_nanoseconds;
+  jb::config_attribute<config, bool> burst;
+};
+
+jb::testing::microbenchmark_group<config> create_testcases();
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  auto testcases = create_testcases();
+  return jb::testing::microbenchmark_group_main(argc, argv, testcases);
+}
+
+namespace {
+namespace defaults {
+
+#ifndef JB_ITCH5_DEFAULTS_bm_mold_udp_channel_size
+#define JB_ITCH5_DEFAULTS_bm_mold_udp_channel_size 1000
+#endif // JB_ITCH5_DEFAULTS_bm_mold_udp_channel_size
+
+#ifndef JB_ITCH5_DEFAULTS_bm_mold_udp_channel_port
+#define JB_ITCH5_DEFAULTS_bm_mold_udp_channel_port 40123
+#endif // JB_ITCH5_DEFAULTS_bm_mold_udp_channel_port
+
+#ifndef JB_ITCH5_DEFAULTS_max_latency_nanoseconds
+#define JB_ITCH5_DEFAULTS_max_latency_nanoseconds 200000
+#endif // JB_ITCH5_DEFAULTS_max_latency_nanoseconds
+
+int const size = JB_ITCH5_DEFAULTS_bm_mold_udp_channel_size;
+int const port = JB_ITCH5_DEFAULTS_bm_mold_udp_channel_port;
+int const max_latency_nanoseconds = JB_ITCH5_DEFAULTS_max_latency_nanoseconds;
+
+} // namespace defaults
+
+/// The histogram type used to capture the latencies
+using latency_histogram =
+    jb::histogram<jb::integer_range_binning<std::int64_t>>;
+
+/**
+ * Send MoldUDP64 packets to a channel and measure the latency of
+ * each one.
+ *
+ * @tparam channel_type the type of channel, jb::itch5::mold_udp_channel
+ * or jb::itch5::packet_mmap_channel
+ * @tparam channel_config the configuration for @a channel_type
+ */
+template <typename channel_type, typename channel_config>
+class fixture {
+public:
+  /// Constructor with the default size
+  fixture(
+      config const& cfg, channel_config const& chcfg,
+      latency_histogram& latency)
+      : fixture(defaults::size, cfg, chcfg, latency) {
+  }
+
+  /**
+   * Construct a new fixture.
+   *
+   * @param size the number of packets sent in each iteration
+   * @param cfg the benchmark configuration
+   * @param chcfg the configuration for the channel under test
+   * @param latency where to record the latency of each packet,
+   * samples received during the warmup iterations are discarded.
+   */
+  fixture(
+      int size, config const& cfg, channel_config const& chcfg,
+      latency_histogram& latency)
+      : size_(size)
+      , burst_(cfg.burst())
+      , warmup_iterations_(cfg.microbenchmark().warmup_iterations())
+      , iteration_(0)
+      , latency_(latency)
+      , received_(0)
+      , timeouts_(0)
+      , io_()
+      , work_(io_)
+      , channel_(
+            io_,
+            [this](
+                std::chrono::steady_clock::time_point recv_ts, std::uint64_t,
+                std::size_t, char const* msg, std::size_t msglen) {
+              on_message(recv_ts, msg, msglen);
+            },
+            cfg.receiver(), chcfg)
+      , socket_(io_)
+      , sequence_number_(0) {
+    using boost::asio::ip::udp;
+    auto address =
+        boost::asio::ip::address::from_string(cfg.receiver().address());
+    destination_ = udp::endpoint(address, cfg.receiver().port());
+    socket_.open(destination_.protocol());
+    // ... in reactor mode the io_service needs a thread to run on,
+    // in busy poll mode this thread is simply idle ...
+    io_thread_ = std::thread([this]() { io_.run(); });
+  }
+
+  ~fixture() {
+    io_.stop();
+    io_thread_.join();
+    if (timeouts_ != 0) {
+      JB_LOG(warning) << timeouts_ << " packets timed out";
+    }
+  }
+
+  /// Send size_ packets, one at a time or in a single burst
+  int run() {
+    using namespace std::chrono;
+    ++iteration_;
+    if (burst_) {
+      auto expected = received_.load(std::memory_order_acquire) + size_;
+      for (int i = 0; i != size_; ++i) {
+        send_one();
+      }
+      wait_for(expected, seconds(1));
+      return size_;
+    }
+    for (int i = 0; i != size_; ++i) {
+      auto expected = received_.load(std::memory_order_acquire) + 1;
+      send_one();
+      wait_for(expected, milliseconds(100));
+    }
+    return size_;
+  }
+
+private:
+  /// Send a single packet
+  void send_one() {
+    using namespace std::chrono;
+    namespace mold = jb::itch5::mold_udp_protocol;
+    std::size_t const size = mold::header_size + 2 + sizeof(std::int64_t);
+    char packet[size] = {0};
+    jb::itch5::encoder<true, std::uint64_t>::w(
+        size, packet, mold::sequence_number_offset, sequence_number_++);
+    jb::itch5::encoder<true, std::uint16_t>::w(
+        size, packet, mold::block_count_offset, 1);
+    jb::itch5::encoder<true, std::uint16_t>::w(
+        size, packet, mold::header_size, sizeof(std::int64_t));
+
+    std::int64_t ts = steady_clock::now().time_since_epoch().count();
+    std::memcpy(packet + mold::header_size + 2, &ts, sizeof(ts));
+    socket_.send_to(boost::asio::buffer(packet, size), destination_);
+  }
+
+  /**
+   * Wait until @a expected packets are received.
+   *
+   * UDP can drop packets, even on the loopback interface, so we do
+   * not wait forever.
+   */
+  void wait_for(int expected, std::chrono::steady_clock::duration timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (received_.load(std::memory_order_acquire) < expected) {
+      if (std::chrono::steady_clock::now() > deadline) {
+        timeouts_ += expected - received_.load(std::memory_order_acquire);
+        return;
+      }
+      // ... do not spin, the receiving thread may need this core,
+      // the latency is measured on the receiving side anyway ...
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  }
+
+  /// Record the latency for a received message
+  void on_message(
+      std::chrono::steady_clock::time_point recv_ts, char const* msg,
+      std::size_t msglen) {
+    std::int64_t ts;
+    if (msglen != sizeof(ts)) {
+      return;
+    }
+    std::memcpy(&ts, msg, sizeof(ts));
+    // ... the sender thread does not touch iteration_ until this
+    // message is acknowledged, so reading it here is safe ...
+    if (iteration_ > warmup_iterations_) {
+      latency_.sample(recv_ts.time_since_epoch().count() - ts);
+    }
+    received_.fetch_add(1, std::memory_order_release);
+  }
+
+private:
+  int size_;
+  bool burst_;
+  int warmup_iterations_;
+  int iteration_;
+  latency_histogram& latency_;
+  std::atomic<int> received_;
+  int timeouts_;
+  boost::asio::io_service io_;
+  boost::asio::io_service::work work_;
+  channel_type channel_;
+  boost::asio::ip::udp::socket socket_;
+  boost::asio::ip::udp::endpoint destination_;
+  std::uint64_t sequence_number_;
+  std::thread io_thread_;
+};
+
+/**
+ * Run the benchmark for a given channel type.
+ *
+ * @param cfg the configuration for the benchmark
+ * @param chcfg the configuration for the channel
+ */
+template <typename channel_type, typename channel_config>
+void run_benchmark(config const& cfg, channel_config const& chcfg) {
+  latency_histogram latency(
+      jb::integer_range_binning<std::int64_t>(
+          0, cfg.max_latency_nanoseconds()));
+
+  using benchmark =
+      jb::testing::microbenchmark<fixture<channel_type, channel_config>>;
+  benchmark bm(cfg.microbenchmark());
+  auto r = bm.run(cfg, chcfg, latency);
+  bm.typical_output(r);
+
+  // ... in burst mode the interesting number is the throughput, in
+  // ping-pong mode the per-packet latency distribution ...
+  if (cfg.burst()) {
+    double packets = 0;
+    double seconds = 0;
+    for (auto const& i : r) {
+      packets += i.first;
+      seconds += std::chrono::duration<double>(i.second).count();
+    }
+    std::cerr << cfg.microbenchmark().test_case()
+              << " packets/s: " << (seconds > 0 ? packets / seconds : 0)
+              << std::endl;
+  }
+  std::cerr << cfg.microbenchmark().test_case()
+            << " latency(ns) summary: " << latency.summary() << std::endl;
+}
+
+jb::testing::microbenchmark_group<config> create_testcases() {
+  using jb::itch5::mold_udp_channel;
+  using jb::itch5::packet_mmap_channel;
+  return jb::testing::microbenchmark_group<config>{
+      {"reactor",
+       [](config const& cfg) {
+         run_benchmark<mold_udp_channel>(
+             cfg, jb::itch5::mold_udp_channel_config(cfg.channel())
+                      .busy_poll(false));
+       }},
+      {"busy-poll",
+       [](config const& cfg) {
+         run_benchmark<mold_udp_channel>(
+             cfg, jb::itch5::mold_udp_channel_config(cfg.channel())
+                      .busy_poll(true));
+       }},
+      {"packet-mmap",
+       [](config const& cfg) {
+         run_benchmark<packet_mmap_channel>(cfg, cfg.packet_mmap());
+       }},
+  };
+}
+
+config::config()
+    : log(desc("log", "logging"), this)
+    , microbenchmark(
+          desc("microbenchmark", "microbenchmark"), this,
+          jb::testing::microbenchmark_config().test_case("reactor"))
+    , receiver(
+          desc("receiver"), this, jb::itch5::udp_receiver_config()
+                                      .address("127.0.0.1")
+                                      .port(defaults::port))
+    , channel(desc("channel", "mold-udp-channel"), this)
+    , packet_mmap(desc("packet-mmap", "packet-mmap"), this)
+    , max_latency_nanoseconds(
+          desc("max-latency-nanoseconds")
+              .help("The maximum latency tracked in the histogram, larger "
+                    "values are counted as overflows."),
+          this, defaults::max_latency_nanoseconds)
+    , burst(
+          desc("burst")
+              .help("If set, send all the packets in each iteration as fast "
+                    "as possible, and report the packets per second."),
+          this, false) {
+}
+
+void config::validate() const {
+  log().validate();
+  microbenchmark().validate();
+  receiver().validate();
+  channel().validate();
+  packet_mmap().validate();
+  if (max_latency_nanoseconds() <= 0) {
+    throw jb::usage("--max-latency-nanoseconds must be positive", 1);
+  }
+}
+
+} // anonymous namespace
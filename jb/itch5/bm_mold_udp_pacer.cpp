@@ -0,0 +1,251 @@
+/**
+ * @file
+ *
+ * This is a benchmark for jb::itch5::mold_udp_pacer.  It measures the
+ * maximum replay throughput, comparing the default mode (which copies
+ * each message into the packet) against the zero-copy mode (which
+ * sends a gather list pointing to the original messages).
+ *
+ * The messages are generated in a jb::itch5::message_store, as they
+ * would be for a preloaded replay, and the pacer runs unthrottled.
+ * The packets are sent to a UDP socket, use --null-sink to measure
+ * only the cost to assemble the packets.  In addition to the usual
+ * microbenchmark output the program reports the number of messages
+ * per second.
+ *
+ * Compare the results for the different test cases, e.g.:
+ *
+ *   bm_mold_udp_pacer --microbenchmark.test-case=copy
+ *   bm_mold_udp_pacer --microbenchmark.test-case=zero-copy
+ */
+#include <jb/itch5/message_store.hpp>
+#include <jb/itch5/mold_udp_pacer.hpp>
+#include <jb/itch5/testing/data.hpp>
+#include <jb/testing/microbenchmark.hpp>
+#include <jb/testing/microbenchmark_group_main.hpp>
+#include <jb/log.hpp>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/ip/udp.hpp>
+
+#include <iostream>
+
+/**
+ * Define types and functions used in this program.
+ */
+namespace {
+/// Configuration parameters for bm_mold_udp_pacer
+class config : public jb::config_object {
+public:
+  config();
+  config_object_constructors(config);
+
+  void validate() const override;
+
+  jb::config_attribute<config, jb::log::config> log;
+  jb::config_attribute<config, jb::testing::microbenchmark_config>
+      microbenchmark;
+  jb::config_attribute<config, jb::itch5::mold_udp_pacer_config> pacer;
+  jb::config_attribute<config, int> message_size;
+  jb::config_attribute<config, std::string> address;
+  jb::config_attribute<config, int> port;
+  jb::config_attribute<config, bool> null_sink;
+};
+
+jb::testing::microbenchmark_group<config> create_testcases();
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  auto testcases = create_testcases();
+  return jb::testing::microbenchmark_group_main(argc, argv, testcases);
+}
+
+namespace {
+namespace defaults {
+
+#ifndef JB_ITCH5_DEFAULTS_bm_mold_udp_pacer_size
+#define JB_ITCH5_DEFAULTS_bm_mold_udp_pacer_size 100000
+#endif // JB_ITCH5_DEFAULTS_bm_mold_udp_pacer_size
+
+/*
+ * Add Order messages are the most common messages in a typical
+ * ITCH-5.0 feed, and they are 36 bytes long.
+ */
+#ifndef JB_ITCH5_DEFAULTS_bm_mold_udp_pacer_message_size
+#define JB_ITCH5_DEFAULTS_bm_mold_udp_pacer_message_size 36
+#endif // JB_ITCH5_DEFAULTS_bm_mold_udp_pacer_message_size
+
+#ifndef JB_ITCH5_DEFAULTS_bm_mold_udp_pacer_port
+#define JB_ITCH5_DEFAULTS_bm_mold_udp_pacer_port 40140
+#endif // JB_ITCH5_DEFAULTS_bm_mold_udp_pacer_port
+
+int const size = JB_ITCH5_DEFAULTS_bm_mold_udp_pacer_size;
+int const message_size = JB_ITCH5_DEFAULTS_bm_mold_udp_pacer_message_size;
+int const port = JB_ITCH5_DEFAULTS_bm_mold_udp_pacer_port;
+
+} // namespace defaults
+
+/**
+ * Replay a jb::itch5::message_store through a jb::itch5::mold_udp_pacer.
+ */
+class fixture {
+public:
+  /// Constructor with the default size
+  fixture(config const& cfg, jb::itch5::mold_udp_pacer_config const& pcfg)
+      : fixture(defaults::size, cfg, pcfg) {
+  }
+
+  /**
+   * Construct a new fixture.
+   *
+   * @param size the number of messages replayed in each iteration
+   * @param cfg the benchmark configuration
+   * @param pcfg the configuration for the pacer under test
+   */
+  fixture(
+      int size, config const& cfg, jb::itch5::mold_udp_pacer_config const& pcfg)
+      : store_()
+      , pacer_(pcfg)
+      , null_sink_(cfg.null_sink())
+      , io_()
+      , socket_(io_)
+      , endpoint_(
+            boost::asio::ip::address::from_string(cfg.address()), cfg.port())
+      , bytes_(0)
+      , packets_(0) {
+    socket_.open(endpoint_.protocol());
+    // ... all the messages have the same timestamp, the pacer runs
+    // unthrottled anyway ...
+    auto msg = jb::itch5::testing::create_message(
+        u'A', jb::itch5::timestamp{std::chrono::hours(10)},
+        cfg.message_size());
+    for (int i = 0; i != size; ++i) {
+      store_.append(msg.data(), msg.size());
+    }
+  }
+
+  /// Replay all the messages in the store
+  int run() {
+    auto sink = [this](auto buffers) {
+      ++packets_;
+      if (null_sink_) {
+        bytes_ += boost::asio::buffer_size(buffers);
+        return;
+      }
+      // ... ignore errors, nobody needs to receive the packets ...
+      boost::system::error_code ec;
+      bytes_ += socket_.send_to(buffers, endpoint_, 0, ec);
+    };
+    auto sleeper = [](jb::itch5::mold_udp_pacer<>::duration) {};
+    auto now = std::chrono::steady_clock::now();
+    for (std::uint64_t i = 0; i != store_.size(); ++i) {
+      jb::itch5::unknown_message msg(
+          static_cast<std::uint32_t>(i), 0, store_.message_size(i),
+          store_.message_data(i));
+      pacer_.handle_message(now, msg, sink, sleeper);
+    }
+    pacer_.flush(jb::itch5::timestamp{std::chrono::hours(10)}, sink);
+    return static_cast<int>(store_.size());
+  }
+
+  /// The number of packets sent so far
+  std::uint64_t packets() const {
+    return packets_;
+  }
+
+  /// The number of bytes sent so far
+  std::uint64_t bytes() const {
+    return bytes_;
+  }
+
+private:
+  jb::itch5::message_store store_;
+  jb::itch5::mold_udp_pacer<> pacer_;
+  bool null_sink_;
+  boost::asio::io_service io_;
+  boost::asio::ip::udp::socket socket_;
+  boost::asio::ip::udp::endpoint endpoint_;
+  std::uint64_t bytes_;
+  std::uint64_t packets_;
+};
+
+/**
+ * Run the benchmark for a given pacer configuration.
+ *
+ * @param cfg the configuration for the benchmark
+ * @param pcfg the configuration for the pacer
+ */
+void run_benchmark(
+    config const& cfg, jb::itch5::mold_udp_pacer_config const& pcfg) {
+  jb::testing::microbenchmark<fixture> bm(cfg.microbenchmark());
+  auto r = bm.run(cfg, pcfg);
+  bm.typical_output(r);
+
+  // ... the warmup iterations are not in the results, count only the
+  // messages in the measured iterations ...
+  std::int64_t measured = 0;
+  jb::testing::microbenchmark_base::duration elapsed(0);
+  for (auto const& i : r) {
+    measured += i.first;
+    elapsed += i.second;
+  }
+  using seconds = std::chrono::duration<double>;
+  auto s = std::chrono::duration_cast<seconds>(elapsed).count();
+  std::cerr << cfg.microbenchmark().test_case() << " messages=" << measured
+            << ", messages/s=" << (s == 0 ? 0.0 : measured / s) << std::endl;
+}
+
+jb::testing::microbenchmark_group<config> create_testcases() {
+  using jb::itch5::mold_udp_pacer_config;
+  return jb::testing::microbenchmark_group<config>{
+      {"copy",
+       [](config const& cfg) {
+         run_benchmark(
+             cfg, mold_udp_pacer_config(cfg.pacer())
+                      .unthrottled(true)
+                      .zero_copy(false));
+       }},
+      {"zero-copy",
+       [](config const& cfg) {
+         run_benchmark(
+             cfg, mold_udp_pacer_config(cfg.pacer())
+                      .unthrottled(true)
+                      .zero_copy(true));
+       }},
+  };
+}
+
+config::config()
+    : log(desc("log", "logging"), this)
+    , microbenchmark(
+          desc("microbenchmark", "microbenchmark"), this,
+          jb::testing::microbenchmark_config().test_case("zero-copy"))
+    , pacer(
+          desc("pacer", "mold-udp-pacer"), this,
+          jb::itch5::mold_udp_pacer_config().maximum_transmission_unit(1432))
+    , message_size(
+          desc("message-size").help("The size of the ITCH-5.x messages."),
+          this, defaults::message_size)
+    , address(
+          desc("address").help("The address to send the packets to."), this,
+          "127.0.0.1")
+    , port(
+          desc("port").help("The port to send the packets to."), this,
+          defaults::port)
+    , null_sink(
+          desc("null-sink")
+              .help("Discard the packets instead of sending them, to "
+                    "measure only the cost to assemble the packets."),
+          this, false) {
+}
+
+void config::validate() const {
+  log().validate();
+  microbenchmark().validate();
+  pacer().validate();
+  if (message_size() < 11 or message_size() >= 256) {
+    throw jb::usage("--message-size must be in the [11,256) range", 1);
+  }
+}
+
+} // anonymous namespace
@@ -0,0 +1,377 @@
+/**
+ * @file
+ *
+ * This is a benchmark for jb::itch5::udp_batch_sender.  It measures
+ * the trade-off between the number of system calls and the latency
+ * when packing jb::mktdata::inside_levels_update messages into
+ * datagrams.
+ *
+ * Each iteration appends a number of messages to the sender, with an
+ * optional delay between them to simulate the message rate of a real
+ * feed.  A separate thread receives the datagrams (from the first
+ * destination) and records the latency of each message, from the
+ * moment it was appended to the moment it was received.  The
+ * benchmark reports the latency distribution and the number of
+ * sendmmsg(2) calls per message.
+ *
+ * The sending thread spins between messages, so the receiving thread
+ * needs its own core for meaningful latency results.
+ *
+ * Compare the results for different deadlines, e.g.:
+ *
+ *   bm_udp_batch_sender --microbenchmark.test-case=unbatched
+ *   bm_udp_batch_sender --microbenchmark.test-case=batched \
+ *       --output-batch.flush-deadline-microseconds=20 \
+ *       --interarrival-nanoseconds=1000
+ */
+#include <jb/itch5/make_socket_udp_recv.hpp>
+#include <jb/itch5/udp_batch_sender.hpp>
+#include <jb/itch5/udp_receiver_config.hpp>
+#include <jb/mktdata/batch_header.hpp>
+#include <jb/mktdata/inside_levels_update.hpp>
+#include <jb/testing/microbenchmark.hpp>
+#include <jb/testing/microbenchmark_group_main.hpp>
+#include <jb/histogram.hpp>
+#include <jb/integer_range_binning.hpp>
+#include <jb/log.hpp>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/ip/udp.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include <poll.h>
+
+/**
+ * Define types and functions used in this program.
+ */
+namespace {
+/// Configuration parameters for bm_udp_batch_sender
+class config : public jb::config_object {
+public:
+  config();
+  config_object_constructors(config);
+
+  void validate() const override;
+
+  jb::config_attribute<config, jb::log::config> log;
+  jb::config_attribute<config, jb::testing::microbenchmark_config>
+      microbenchmark;
+  jb::config_attribute<config, jb::itch5::udp_batch_sender_config>
+      output_batch;
+  jb::config_attribute<config, std::string> address;
+  jb::config_attribute<config, int> port;
+  jb::config_attribute<config, int> destinations;
+  jb::config_attribute<config, int> interarrival_nanoseconds;
+  jb::config_attribute<config, int> max_latency_nanoseconds;
+};
+
+jb::testing::microbenchmark_group<config> create_testcases();
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  auto testcases = create_testcases();
+  return jb::testing::microbenchmark_group_main(argc, argv, testcases);
+}
+
+namespace {
+namespace defaults {
+
+#ifndef JB_ITCH5_DEFAULTS_bm_udp_batch_sender_size
+#define JB_ITCH5_DEFAULTS_bm_udp_batch_sender_size 10000
+#endif // JB_ITCH5_DEFAULTS_bm_udp_batch_sender_size
+
+#ifndef JB_ITCH5_DEFAULTS_bm_udp_batch_sender_port
+#define JB_ITCH5_DEFAULTS_bm_udp_batch_sender_port 40130
+#endif // JB_ITCH5_DEFAULTS_bm_udp_batch_sender_port
+
+#ifndef JB_ITCH5_DEFAULTS_bm_udp_batch_sender_destinations
+#define JB_ITCH5_DEFAULTS_bm_udp_batch_sender_destinations 2
+#endif // JB_ITCH5_DEFAULTS_bm_udp_batch_sender_destinations
+
+#ifndef JB_ITCH5_DEFAULTS_interarrival_nanoseconds
+#define JB_ITCH5_DEFAULTS_interarrival_nanoseconds 1000
+#endif // JB_ITCH5_DEFAULTS_interarrival_nanoseconds
+
+#ifndef JB_ITCH5_DEFAULTS_max_latency_nanoseconds
+#define JB_ITCH5_DEFAULTS_max_latency_nanoseconds 1000000
+#endif // JB_ITCH5_DEFAULTS_max_latency_nanoseconds
+
+int const size = JB_ITCH5_DEFAULTS_bm_udp_batch_sender_size;
+int const port = JB_ITCH5_DEFAULTS_bm_udp_batch_sender_port;
+int const destinations = JB_ITCH5_DEFAULTS_bm_udp_batch_sender_destinations;
+int const interarrival_nanoseconds =
+    JB_ITCH5_DEFAULTS_interarrival_nanoseconds;
+int const max_latency_nanoseconds = JB_ITCH5_DEFAULTS_max_latency_nanoseconds;
+
+} // namespace defaults
+
+/// The histogram type used to capture the latencies
+using latency_histogram =
+    jb::histogram<jb::integer_range_binning<std::int64_t>>;
+
+/// The message type used in the benchmark
+using message_type = jb::mktdata::inside_levels_update<1>;
+
+/// Accumulate the sender counters across all the fixtures
+struct sender_counters {
+  std::uint64_t messages = 0;
+  std::uint64_t packets = 0;
+  std::uint64_t send_calls = 0;
+};
+
+/**
+ * Append messages to a jb::itch5::udp_batch_sender and measure the
+ * latency until they are received.
+ */
+class fixture {
+public:
+  /// Constructor with the default size
+  fixture(
+      config const& cfg, jb::itch5::udp_batch_sender_config const& bcfg,
+      latency_histogram& latency, sender_counters& counters)
+      : fixture(defaults::size, cfg, bcfg, latency, counters) {
+  }
+
+  /**
+   * Construct a new fixture.
+   *
+   * @param size the number of messages appended in each iteration
+   * @param cfg the benchmark configuration
+   * @param bcfg the configuration for the sender under test
+   * @param latency where to record the latency of each message
+   * @param counters where to accumulate the sender counters
+   */
+  fixture(
+      int size, config const& cfg,
+      jb::itch5::udp_batch_sender_config const& bcfg,
+      latency_histogram& latency, sender_counters& counters)
+      : size_(size)
+      , interarrival_(cfg.interarrival_nanoseconds())
+      , latency_(latency)
+      , counters_(counters)
+      , batched_(bcfg.flush_deadline_microseconds() != 0)
+      , io_()
+      , work_(io_)
+      , receivers_()
+      , sender_()
+      , stop_(false) {
+    std::vector<jb::itch5::udp_sender_config> destinations;
+    for (int i = 0; i != cfg.destinations(); ++i) {
+      auto port = cfg.port() + i;
+      // ... use a large buffer, the receiving thread may fall behind
+      // with large bursts ...
+      jb::itch5::udp_receiver_config rcfg;
+      rcfg.address(cfg.address()).port(port);
+      rcfg.receive_buffer_size(1 << 22);
+      receivers_.emplace_back(jb::itch5::make_socket_udp_recv(io_, rcfg));
+      destinations.push_back(
+          jb::itch5::udp_sender_config().address(cfg.address()).port(port));
+    }
+    sender_.reset(new jb::itch5::udp_batch_sender(io_, destinations, bcfg));
+    std::memset(&msg_, 0, sizeof(msg_));
+    msg_.message_type = message_type::mtype;
+    msg_.message_size = sizeof(msg_);
+
+    // ... the io_service only runs the deadline timer ...
+    io_thread_ = std::thread([this]() { io_.run(); });
+    receive_thread_ = std::thread([this]() { receive_loop(); });
+  }
+
+  ~fixture() {
+    sender_->flush();
+    counters_.messages += sender_->messages_sent();
+    counters_.packets += sender_->packets_sent();
+    counters_.send_calls += sender_->send_calls();
+    stop_.store(true, std::memory_order_release);
+    receive_thread_.join();
+    io_.stop();
+    io_thread_.join();
+  }
+
+  /// Append size_ messages
+  int run() {
+    using std::chrono::steady_clock;
+    auto next = steady_clock::now();
+    for (int i = 0; i != size_; ++i) {
+      // ... spin until it is time for the next message, sleeping is
+      // far too coarse for the typical interarrival times ...
+      while (steady_clock::now() < next) {
+      }
+      msg_.feedhandler_ts.nanos =
+          steady_clock::now().time_since_epoch().count();
+      sender_->append(&msg_, sizeof(msg_));
+      next += interarrival_;
+    }
+    return size_;
+  }
+
+private:
+  /// Receive datagrams from the first destination until stopped
+  void receive_loop() {
+    auto& socket = receivers_.front();
+    char buffer[1 << 16];
+    while (true) {
+      // ... once stopped, drain any remaining datagrams and exit ...
+      bool stopped = stop_.load(std::memory_order_acquire);
+      ::pollfd pfd;
+      pfd.fd = socket.native_handle();
+      pfd.events = POLLIN;
+      pfd.revents = 0;
+      if (::poll(&pfd, 1, stopped ? 0 : 10) <= 0) {
+        if (stopped) {
+          return;
+        }
+        continue;
+      }
+      boost::system::error_code ec;
+      auto n = socket.receive(boost::asio::buffer(buffer), 0, ec);
+      if (ec) {
+        continue;
+      }
+      auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+      if (batched_) {
+        process_batch(now, buffer, n);
+      } else {
+        process_message(now, buffer, n);
+      }
+    }
+  }
+
+  /// Record the latency of each message in a datagram
+  void process_batch(std::int64_t now, char const* buffer, std::size_t n) {
+    jb::mktdata::batch_header header;
+    if (n < sizeof(header)) {
+      return;
+    }
+    std::memcpy(&header, buffer, sizeof(header));
+    std::size_t offset = sizeof(header);
+    for (int i = 0; i != header.message_count.value(); ++i) {
+      if (offset + sizeof(message_type) > n) {
+        return;
+      }
+      offset += process_message(now, buffer + offset, n - offset);
+    }
+  }
+
+  /// Record the latency of a single message, return its size
+  std::size_t
+  process_message(std::int64_t now, char const* buffer, std::size_t n) {
+    message_type msg;
+    if (n < sizeof(msg)) {
+      return n;
+    }
+    std::memcpy(&msg, buffer, sizeof(msg));
+    latency_.sample(now - std::int64_t(msg.feedhandler_ts.nanos.value()));
+    return msg.message_size.value();
+  }
+
+private:
+  int size_;
+  std::chrono::nanoseconds interarrival_;
+  latency_histogram& latency_;
+  sender_counters& counters_;
+  bool batched_;
+  boost::asio::io_service io_;
+  boost::asio::io_service::work work_;
+  std::vector<boost::asio::ip::udp::socket> receivers_;
+  std::unique_ptr<jb::itch5::udp_batch_sender> sender_;
+  message_type msg_;
+  std::atomic<bool> stop_;
+  std::thread io_thread_;
+  std::thread receive_thread_;
+};
+
+/**
+ * Run the benchmark for a given sender configuration.
+ *
+ * @param cfg the configuration for the benchmark
+ * @param bcfg the configuration for the sender
+ */
+void run_benchmark(
+    config const& cfg, jb::itch5::udp_batch_sender_config const& bcfg) {
+  latency_histogram latency(
+      jb::integer_range_binning<std::int64_t>(
+          0, cfg.max_latency_nanoseconds()));
+  sender_counters counters;
+
+  jb::testing::microbenchmark<fixture> bm(cfg.microbenchmark());
+  auto r = bm.run(cfg, bcfg, latency, counters);
+  bm.typical_output(r);
+
+  auto per_message = [&counters](std::uint64_t x) {
+    return counters.messages == 0 ? 0.0 : double(x) / counters.messages;
+  };
+  std::cerr << cfg.microbenchmark().test_case()
+            << " messages=" << counters.messages
+            << ", packets/message=" << per_message(counters.packets)
+            << ", syscalls/message=" << per_message(counters.send_calls)
+            << std::endl;
+  std::cerr << cfg.microbenchmark().test_case()
+            << " latency(ns) summary: " << latency.summary() << std::endl;
+}
+
+jb::testing::microbenchmark_group<config> create_testcases() {
+  using jb::itch5::udp_batch_sender_config;
+  return jb::testing::microbenchmark_group<config>{
+      {"unbatched",
+       [](config const& cfg) {
+         run_benchmark(
+             cfg, udp_batch_sender_config(cfg.output_batch())
+                      .flush_deadline_microseconds(0));
+       }},
+      {"batched",
+       [](config const& cfg) { run_benchmark(cfg, cfg.output_batch()); }},
+  };
+}
+
+config::config()
+    : log(desc("log", "logging"), this)
+    , microbenchmark(
+          desc("microbenchmark", "microbenchmark"), this,
+          jb::testing::microbenchmark_config().test_case("batched"))
+    , output_batch(
+          desc("output-batch", "udp-batch-sender"), this,
+          jb::itch5::udp_batch_sender_config().flush_deadline_microseconds(50))
+    , address(
+          desc("address").help("The address to send the datagrams to."), this,
+          "127.0.0.1")
+    , port(
+          desc("port").help("The port of the first destination, the "
+                            "remaining destinations use consecutive ports."),
+          this, defaults::port)
+    , destinations(
+          desc("destinations").help("The number of destinations."), this,
+          defaults::destinations)
+    , interarrival_nanoseconds(
+          desc("interarrival-nanoseconds")
+              .help("The time between consecutive messages, use 0 to send "
+                    "as fast as possible."),
+          this, defaults::interarrival_nanoseconds)
+    , max_latency_nanoseconds(
+          desc("max-latency-nanoseconds")
+              .help("The maximum latency tracked in the histogram, larger "
+                    "values are counted as overflows."),
+          this, defaults::max_latency_nanoseconds) {
+}
+
+void config::validate() const {
+  log().validate();
+  microbenchmark().validate();
+  output_batch().validate();
+  if (destinations() <= 0) {
+    throw jb::usage("--destinations must be positive", 1);
+  }
+  if (interarrival_nanoseconds() < 0) {
+    throw jb::usage("--interarrival-nanoseconds must be >= 0", 1);
+  }
+  if (max_latency_nanoseconds() <= 0) {
+    throw jb::usage("--max-latency-nanoseconds must be positive", 1);
+  }
+}
+
+} // anonymous namespace
@@ -0,0 +1,70 @@
+#include "jb/itch5/clock_recalibrator.hpp"
+
+#include <jb/itch5/clock_type.hpp>
+#include <jb/usage.hpp>
+
+#include <sstream>
+
+namespace jb {
+namespace itch5 {
+namespace defaults {
+
+#ifndef JB_ITCH5_DEFAULTS_clock_recalibration_period_milliseconds
+#define JB_ITCH5_DEFAULTS_clock_recalibration_period_milliseconds 100
+#endif // JB_ITCH5_DEFAULTS_clock_recalibration_period_milliseconds
+
+int clock_recalibration_period_milliseconds =
+    JB_ITCH5_DEFAULTS_clock_recalibration_period_milliseconds;
+
+} // namespace defaults
+
+clock_recalibrator::clock_recalibrator(
+    boost::asio::io_service& io, config const& cfg)
+    : timer_(io)
+    , period_(cfg.period_milliseconds())
+    , recalibrations_(0) {
+  calibrate_clock();
+  if (period_.count() != 0) {
+    arm();
+  }
+}
+
+clock_recalibrator::~clock_recalibrator() {
+  boost::system::error_code ec;
+  timer_.cancel(ec);
+}
+
+void clock_recalibrator::arm() {
+  timer_.expires_from_now(period_);
+  timer_.async_wait(
+      [this](boost::system::error_code const& ec) { on_timer(ec); });
+}
+
+void clock_recalibrator::on_timer(boost::system::error_code const& ec) {
+  if (ec) {
+    return;
+  }
+  jb::tsc_clock::recalibrate(period_);
+  ++recalibrations_;
+  arm();
+}
+
+clock_recalibrator::config::config()
+    : period_milliseconds(
+          desc("period-milliseconds")
+              .help("How often the timestamp counter clock is recalibrated "
+                    "against CLOCK_MONOTONIC.  Set to 0 to calibrate it "
+                    "only once, at startup."),
+          this, defaults::clock_recalibration_period_milliseconds) {
+}
+
+void clock_recalibrator::config::validate() const {
+  if (period_milliseconds() < 0) {
+    std::ostringstream os;
+    os << "period-milliseconds must be >= 0, value=" << period_milliseconds();
+    throw jb::usage(os.str(), 1);
+  }
+}
+
+} // namespace itch5
+} // namespace jb
@@ -0,0 +1,81 @@
+#ifndef jb_itch5_clock_recalibrator_hpp
+#define jb_itch5_clock_recalibrator_hpp
+
+#include <jb/config_object.hpp>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <chrono>
+#include <cstdint>
+
+namespace jb {
+namespace itch5 {
+
+/**
+ * Periodically correct the drift in jb::itch5::clock_type.
+ *
+ * The feed handlers timestamp every message with clock_type, and run
+ * for the whole trading day.  When clock_type is jb::tsc_clock it is
+ * calibrated only once, so without periodic recalibration the
+ * timestamps slowly drift away from CLOCK_MONOTONIC.  This class
+ * calibrates the clock when constructed, and then uses a timer in
+ * the io_service to recalibrate it on a fixed period.  The
+ * recalibration only takes a few clock reads, so it is cheap to run
+ * in the same thread as the feed.  If clock_type is
+ * std::chrono::steady_clock the recalibrations do nothing.
+ */
+class clock_recalibrator {
+public:
+  class config;
+
+  /**
+   * Constructor, calibrate the clock and start the timer.
+   *
+   * @param io the io_service used to run the timer
+   * @param cfg the configuration
+   */
+  clock_recalibrator(boost::asio::io_service& io, config const& cfg);
+
+  /// Destructor, stop the timer
+  ~clock_recalibrator();
+
+  clock_recalibrator(clock_recalibrator const&) = delete;
+  clock_recalibrator& operator=(clock_recalibrator const&) = delete;
+
+  /// The number of times the clock was recalibrated
+  std::uint64_t recalibrations() const {
+    return recalibrations_;
+  }
+
+private:
+  /// Schedule the next recalibration
+  void arm();
+
+  /// The timer callback
+  void on_timer(boost::system::error_code const& ec);
+
+private:
+  boost::asio::steady_timer timer_;
+  std::chrono::milliseconds period_;
+  std::uint64_t recalibrations_;
+};
+
+/**
+ * Configure a clock_recalibrator object.
+ */
+class clock_recalibrator::config : public jb::config_object {
+public:
+  config();
+  config_object_constructors(config);
+
+  /// Validate the configuration
+  void validate() const override;
+
+  jb::config_attribute<config, int> period_milliseconds;
+};
+
+} // namespace itch5
+} // namespace jb
+
+#endif // jb_itch5_clock_recalibrator_hpp
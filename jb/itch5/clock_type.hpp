@@ -0,0 +1,44 @@
+#ifndef jb_itch5_clock_type_hpp
+#define jb_itch5_clock_type_hpp
+
+#include <jb/tsc_clock.hpp>
+
+#include <chrono>
+
+namespace jb {
+namespace itch5 {
+
+/**
+ * The clock used to timestamp messages in the ITCH-5.0 pipelines.
+ *
+ * By default this is std::chrono::steady_clock.  Define
+ * JB_ITCH5_USE_TSC_CLOCK (the CMake option with the same name does
+ * this) to use jb::tsc_clock, which is much cheaper to call.  Both
+ * clocks use the same time_point type, so the rest of the code does
+ * not change.
+ */
+#if defined(JB_ITCH5_USE_TSC_CLOCK)
+using clock_type = jb::tsc_clock;
+#else
+using clock_type = std::chrono::steady_clock;
+#endif // defined(JB_ITCH5_USE_TSC_CLOCK)
+
+/// A convenience alias for clock_type::time_point
+using time_point = clock_type::time_point;
+
+/**
+ * Calibrate clock_type, if needed.
+ *
+ * jb::tsc_clock must be calibrated before it is used, the programs
+ * call this function when they start.
+ */
+inline void calibrate_clock() {
+#if defined(JB_ITCH5_USE_TSC_CLOCK)
+  jb::tsc_clock::calibrate();
+#endif // defined(JB_ITCH5_USE_TSC_CLOCK)
+}
+
+} // namespace itch5
+} // namespace jb
+
+#endif // jb_itch5_clock_type_hpp
@@ -3,12 +3,14 @@
 
 #include <jb/itch5/add_order_message.hpp>
 #include <jb/itch5/add_order_mpid_message.hpp>
+#include <jb/itch5/clock_type.hpp>
 #include <jb/itch5/order_book.hpp>
 #include <jb/itch5/order_cancel_message.hpp>
 #include <jb/itch5/order_delete_message.hpp>
 #include <jb/itch5/order_executed_message.hpp>
 #include <jb/itch5/order_executed_price_message.hpp>
 #include <jb/itch5/order_replace_message.hpp>
+#include <jb/itch5/pipeline_latency.hpp>
 #include <jb/itch5/stock_directory_message.hpp>
 #include <jb/itch5/unknown_message.hpp>
 #include <jb/assert_throw.hpp>
@@ -21,12 +23,6 @@
 namespace jb {
 namespace itch5 {
 
-/// A convenience alias for clock_type
-using clock_type = std::chrono::steady_clock;
-
-/// A convenience alias for clock_type::time_point
-using time_point = clock_type::time_point;
-
 /**
  * A flat struct to represent updates to an order book.
  *
@@ -138,16 +134,28 @@ public:
       book_update const& update)>;
   //@}
 
-  /// Constructor
-  explicit compute_book(callback_type&& cb, book_type_config const& cfg)
+  /**
+   * Constructor
+   *
+   * @param cb the callback invoked on each book update
+   * @param cfg the configuration for the books
+   * @param latency if not null, record the latency of each stage of
+   * the pipeline for each message
+   */
+  explicit compute_book(
+      callback_type&& cb, book_type_config const& cfg,
+      pipeline_latency* latency = nullptr)
       : callback_(std::forward<callback_type>(cb))
       , books_()
       , orders_()
-      , cfg_(cfg) {
+      , cfg_(cfg)
+      , latency_(latency) {
   }
 
-  explicit compute_book(callback_type const& cb, book_type_config const& cfg)
-      : compute_book(callback_type(cb), cfg) {
+  explicit compute_book(
+      callback_type const& cb, book_type_config const& cfg,
+      pipeline_latency* latency = nullptr)
+      : compute_book(callback_type(cb), cfg, latency) {
   }
 
   /**
@@ -164,6 +172,7 @@ public:
   void handle_message(
       time_point recvts, long msgcnt, std::size_t msgoffset,
       add_order_message const& msg) {
+    pipeline_latency::scope stamps(latency_, msg.header.message_type, recvts);
     JB_LOG(trace) << " " << msgcnt << ":" << msgoffset << " " << msg;
     auto insert = orders_.emplace(
         msg.order_reference_number,
@@ -181,6 +190,7 @@ public:
                       << ", existing data=" << data << ", msg=" << msg;
       return;
     }
+    stamps.mark(pipeline_stage::order_table);
     // ... find the right book for this order, create one if necessary ...
     auto itbook = books_.find(msg.stock);
     if (itbook == books_.end()) {
@@ -189,10 +199,12 @@ public:
     }
     (void)itbook->second.handle_add_order(
         msg.buy_sell_indicator, msg.price, msg.shares);
+    stamps.mark(pipeline_stage::book);
     callback_(
         msg.header, itbook->second,
         book_update{recvts, msg.stock, msg.buy_sell_indicator, msg.price,
                     msg.shares});
+    stamps.mark(pipeline_stage::output);
   }
 
   /**
@@ -222,10 +234,11 @@ public:
   void handle_message(
       time_point recvts, long msgcnt, std::size_t msgoffset,
       order_executed_message const& msg) {
+    pipeline_latency::scope stamps(latency_, msg.header.message_type, recvts);
     JB_LOG(trace) << " " << msgcnt << ":" << msgoffset << " " << msg;
     handle_order_reduction(
-        recvts, msgcnt, msgoffset, msg.header, msg.order_reference_number,
-        msg.executed_shares);
+        stamps, recvts, msgcnt, msgoffset, msg.header,
+        msg.order_reference_number, msg.executed_shares);
   }
 
   /**
@@ -256,10 +269,11 @@ public:
   void handle_message(
       time_point recvts, long msgcnt, std::size_t msgoffset,
       order_cancel_message const& msg) {
+    pipeline_latency::scope stamps(latency_, msg.header.message_type, recvts);
     JB_LOG(trace) << " " << msgcnt << ":" << msgoffset << " " << msg;
     handle_order_reduction(
-        recvts, msgcnt, msgoffset, msg.header, msg.order_reference_number,
-        msg.canceled_shares);
+        stamps, recvts, msgcnt, msgoffset, msg.header,
+        msg.order_reference_number, msg.canceled_shares);
   }
 
   /**
@@ -273,9 +287,11 @@ public:
   void handle_message(
       time_point recvts, long msgcnt, std::size_t msgoffset,
       order_delete_message const& msg) {
+    pipeline_latency::scope stamps(latency_, msg.header.message_type, recvts);
     JB_LOG(trace) << " " << msgcnt << ":" << msgoffset << " " << msg;
     handle_order_reduction(
-        recvts, msgcnt, msgoffset, msg.header, msg.order_reference_number, 0);
+        stamps, recvts, msgcnt, msgoffset, msg.header,
+        msg.order_reference_number, 0);
   }
 
   /**
@@ -289,6 +305,7 @@ public:
   void handle_message(
       time_point recvts, long msgcnt, std::size_t msgoffset,
       order_replace_message const& msg) {
+    pipeline_latency::scope stamps(latency_, msg.header.message_type, recvts);
     JB_LOG(trace) << " " << msgcnt << ":" << msgoffset << " " << msg;
     // First we need to find the original order ...
     auto position = orders_.find(msg.original_order_reference_number);
@@ -317,17 +334,23 @@ public:
     // ... the book has to exists, since the original add_order created
     // one if needed
     JB_ASSERT_THROW(itbook != books_.end());
-    // ... update the order list and book, but do not make a callback ...
+    // ... update the order list, but do not make a callback ...
     auto update = do_reduce(
-        position, itbook->second, recvts, msgcnt, msgoffset, msg.header,
+        position, recvts, msgcnt, msgoffset, msg.header,
         msg.original_order_reference_number, 0);
     // ... now we need to insert the new order ...
     orders_.emplace(
         msg.new_order_reference_number,
         order_data{update.stock, update.buy_sell_indicator, msg.price,
                    msg.shares});
+    stamps.mark(pipeline_stage::order_table);
+    // ... and update the book, removing the old order and adding the
+    // new one ...
+    (void)itbook->second.handle_order_reduced(
+        update.buy_sell_indicator, update.px, -update.qty);
     (void)itbook->second.handle_add_order(
         update.buy_sell_indicator, msg.price, msg.shares);
+    stamps.mark(pipeline_stage::book);
     // ... adjust the update data structure ...
     update.cxlreplx = true;
     update.oldpx = update.px;
@@ -336,6 +359,7 @@ public:
     update.qty = msg.shares;
     // ... and invoke the callback ...
     callback_(msg.header, itbook->second, update);
+    stamps.mark(pipeline_stage::output);
   }
 
   /**
@@ -354,6 +378,7 @@ public:
   void handle_message(
       time_point recvts, long msgcnt, std::size_t msgoffset,
       stock_directory_message const& msg) {
+    pipeline_latency::scope stamps(latency_, msg.header.message_type, recvts);
     JB_LOG(trace) << " " << msgcnt << ":" << msgoffset << " " << msg;
     // ... create the book and update the map ...
     books_.emplace(msg.stock, order_book<book_type>(cfg_));
@@ -366,7 +391,9 @@ public:
    * else is captured by this template function and ignored.
    */
   template <typename message_type>
-  void handle_message(time_point, long, std::size_t, message_type const&) {
+  void handle_message(
+      time_point recvts, long, std::size_t, message_type const& msg) {
+    pipeline_latency::scope stamps(latency_, msg.header.message_type, recvts);
   }
 
   /**
@@ -393,7 +420,7 @@ public:
 
   /// Return the current timestamp for delay measurements
   time_point now() const {
-    return std::chrono::steady_clock::now();
+    return clock_type::now();
   }
 
 private:
@@ -409,6 +436,7 @@ private:
    * Refactor code to handle order reductions, i.e., cancels and
    * executions
    *
+   * @param stamps the latency measurements for the message
    * @param recvts the timestamp when the message was received
    * @param msgcnt the number of messages received before this message
    * @param msgoffset the number of bytes received before this message
@@ -417,9 +445,9 @@ private:
    * @param shares the number of shares to reduce, if 0 reduce all shares
    */
   void handle_order_reduction(
-      time_point recvts, long msgcnt, std::size_t msgoffset,
-      message_header const& header, std::uint64_t order_reference_number,
-      std::uint32_t shares) {
+      pipeline_latency::scope& stamps, time_point recvts, long msgcnt,
+      std::size_t msgoffset, message_header const& header,
+      std::uint64_t order_reference_number, std::uint32_t shares) {
     // First we need to find the order ...
     auto position = orders_.find(order_reference_number);
     if (position == orders_.end()) {
@@ -439,17 +467,25 @@ private:
     // one if needed
     JB_ASSERT_THROW(itbook != books_.end());
     auto u = do_reduce(
-        position, itbook->second, recvts, msgcnt, msgoffset, header,
-        order_reference_number, shares);
+        position, recvts, msgcnt, msgoffset, header, order_reference_number,
+        shares);
+    stamps.mark(pipeline_stage::order_table);
+    (void)itbook->second.handle_order_reduced(
+        u.buy_sell_indicator, u.px, -u.qty);
+    stamps.mark(pipeline_stage::book);
     callback_(header, itbook->second, u);
+    stamps.mark(pipeline_stage::output);
   }
 
   /**
    * Refactor code common to handle_order_reduction() and
    * handle_message(order_replace_message).
    *
+   * Only the order table is updated, the caller updates the book
+   * using the returned value, that way the latency of each step can
+   * be measured separately.
+   *
    * @param position the location of the order matching order_reference_number
-   * @param book the order_book matching the symbol for the given order
    * @param recvts the timestamp when the message was received
    * @param msgcnt the number of messages received before this message
    * @param msgoffset the number of bytes received before this message
@@ -458,8 +494,8 @@ private:
    * @param shares the number of shares to reduce, if 0 reduce all shares
    */
   book_update do_reduce(
-      orders_iterator position, order_book<book_type>& book, time_point recvts,
-      long msgcnt, std::size_t msgoffset, message_header const& header,
+      orders_iterator position, time_point recvts, long msgcnt,
+      std::size_t msgoffset, message_header const& header,
       std::uint64_t order_reference_number, std::uint32_t shares) {
     auto& data = position->second;
     int qty = shares == 0 ? data.qty : static_cast<int>(shares);
@@ -483,7 +519,6 @@ private:
     if (data.qty == 0) {
       orders_.erase(position);
     }
-    (void)book.handle_order_reduced(u.buy_sell_indicator, u.px, qty);
     return u;
   }
 
@@ -500,6 +535,9 @@ private:
 
   /// reference to the order book config
   book_type_config const& cfg_;
+
+  /// If not null, record the latency of each stage
+  pipeline_latency* latency_;
 };
 
 inline bool operator==(book_update const& a, book_update const& b) {
@@ -2,6 +2,7 @@
 #define jb_itch5_generate_inside_hpp
 
 #include <jb/itch5/compute_book.hpp>
+#include <jb/fast_format.hpp>
 #include <jb/offline_feed_statistics.hpp>
 
 #include <iostream>
@@ -63,6 +64,9 @@ bool record_latency_stats(
  * must be compatible with a duration in the std::chrono sense.
  * @tparam book_type the type used to define order_book<book_type>,
  * must be compatible with jb::itch5::map_price
+ * @tparam output_type where the inside is printed, typically
+ * jb::fast_format, which is much faster than std::ostream for this
+ * purpose, but any std::ostream also works
  *
  * @param stats where to record the statistics
  * @param out where to send the new inside quote if needed
@@ -74,9 +78,9 @@ bool record_latency_stats(
  * (before the any output is generated).
  * @returns true if the inside is affected by the change, false otherwise.
  */
-template <typename duration_t, typename book_type>
+template <typename duration_t, typename book_type, typename output_type>
 bool generate_inside(
-    jb::offline_feed_statistics& stats, std::ostream& out,
+    jb::offline_feed_statistics& stats, output_type& out,
     jb::itch5::message_header const& header,
     jb::itch5::order_book<book_type> const& book,
     jb::itch5::book_update const& update, duration_t processing_latency) {
@@ -0,0 +1,138 @@
+#include "jb/itch5/load_amplifier.hpp"
+
+#include <jb/itch5/base_decoders.hpp>
+#include <jb/itch5/base_encoders.hpp>
+#include <jb/itch5/protocol_constants.hpp>
+#include <jb/itch5/timestamp.hpp>
+
+#include <cstring>
+
+namespace jb {
+namespace itch5 {
+namespace {
+/// The offsets of the fields rewritten in each copy, 0 if not present
+struct field_offsets {
+  std::size_t ref[2];
+  std::size_t match;
+  std::size_t stock;
+};
+
+/**
+ * Find the fields to rewrite for a message type.
+ *
+ * The offsets match the decoders (e.g. jb::itch5::add_order_message),
+ * 'J', 'h' and 'N' are the LULD auction collar, operational halt,
+ * and retail price improvement messages, which do not have decoders
+ * in this library, but carry a ticker too.
+ */
+field_offsets offsets(int message_type) {
+  switch (message_type) {
+  case u'A':
+  case u'F':
+    return field_offsets{{11, 0}, 0, 24};
+  case u'E':
+  case u'C':
+    return field_offsets{{11, 0}, 23, 0};
+  case u'X':
+  case u'D':
+    return field_offsets{{11, 0}, 0, 0};
+  case u'U':
+    return field_offsets{{11, 19}, 0, 0};
+  case u'P':
+    return field_offsets{{11, 0}, 36, 24};
+  case u'Q':
+    return field_offsets{{0, 0}, 31, 19};
+  case u'B':
+    return field_offsets{{0, 0}, 11, 0};
+  case u'R':
+  case u'H':
+  case u'Y':
+  case u'K':
+  case u'J':
+  case u'h':
+  case u'N':
+    return field_offsets{{0, 0}, 0, 11};
+  case u'L':
+    return field_offsets{{0, 0}, 0, 15};
+  case u'I':
+    return field_offsets{{0, 0}, 0, 28};
+  }
+  return field_offsets{{0, 0}, 0, 0};
+}
+
+/// The size of the stock field
+std::size_t const stock_size = 8;
+
+/// Add @a delta to the 8-byte field at @a offset, if present
+void add_u64(char* buf, std::size_t len, std::size_t offset, std::uint64_t d) {
+  if (offset == 0 or offset + 8 > len) {
+    return;
+  }
+  auto x = decoder<false, std::uint64_t>::r(len, buf, offset);
+  encoder<false, std::uint64_t>::w(len, buf, offset, x + d);
+}
+
+/// Append the suffix for the k-th copy to the ticker at @a offset
+void suffix_stock(char* buf, std::size_t len, std::size_t offset, int k) {
+  if (offset == 0 or offset + stock_size > len) {
+    return;
+  }
+  // ... the ticker is padded with spaces, put the suffix in the first
+  // space, or replace the last character if the ticker is full ...
+  char* stock = buf + offset;
+  char* pos = static_cast<char*>(std::memchr(stock, ' ', stock_size));
+  if (pos == nullptr) {
+    pos = stock + stock_size - 1;
+  }
+  encoder<false, std::uint8_t>::w(
+      len, buf, pos - buf, static_cast<std::uint8_t>('a' + k - 1));
+}
+} // anonymous namespace
+
+load_amplifier::load_amplifier(load_amplifier_config const& cfg)
+    : factor_(cfg.factor())
+    , locate_offset_(cfg.locate_offset())
+    , time_compression_(cfg.time_compression())
+    , passthrough_(factor_ == 1 and time_compression_ == 1.0)
+    , started_(false)
+    , first_ts_(0)
+    , count_(0)
+    , buffer_(1 << 16) {
+}
+
+std::size_t load_amplifier::rewrite(int k, unknown_message const& msg) {
+  std::size_t len = msg.len();
+  char* buf = buffer_.data();
+  std::memcpy(buf, msg.buf(), len);
+  if (len < protocol::header_size) {
+    return len;
+  }
+  auto header = decoder<false, message_header>::r(len, buf, 0);
+  if (time_compression_ != 1.0) {
+    if (not started_) {
+      started_ = true;
+      first_ts_ = header.timestamp.ts;
+    }
+    using namespace std::chrono;
+    auto elapsed = duration<double, std::nano>(header.timestamp.ts - first_ts_);
+    auto ts = first_ts_ +
+              duration_cast<nanoseconds>(elapsed / time_compression_);
+    encoder<false, timestamp>::w(len, buf, 5, timestamp{ts});
+  }
+  if (k == 0) {
+    return len;
+  }
+  encoder<false, std::uint16_t>::w(
+      len, buf, 1,
+      static_cast<std::uint16_t>(header.stock_locate + k * locate_offset_));
+  auto const f = offsets(header.message_type);
+  std::uint64_t const delta = static_cast<std::uint64_t>(k) << 56;
+  add_u64(buf, len, f.ref[0], delta);
+  add_u64(buf, len, f.ref[1], delta);
+  add_u64(buf, len, f.match, delta);
+  suffix_stock(buf, len, f.stock, k);
+  return len;
+}
+
+} // namespace itch5
+} // namespace jb
@@ -0,0 +1,95 @@
+#ifndef jb_itch5_load_amplifier_hpp
+#define jb_itch5_load_amplifier_hpp
+
+#include <jb/itch5/load_amplifier_config.hpp>
+#include <jb/itch5/unknown_message.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace jb {
+namespace itch5 {
+
+/**
+ * Generate a heavier ITCH-5.x feed from an existing one.
+ *
+ * Stress tests need feeds with higher message rates than the busiest
+ * day on record.  Replaying a file faster (see
+ * jb::itch5::mold_udp_pacer_config::speed) increases the rate, but
+ * not the number of symbols or orders the feed handler must track.
+ * This class sends each order-flow message @a factor times, the k-th
+ * copy uses different stock locate codes, tickers, and order
+ * reference (and match) numbers, so each copy looks like an
+ * independent, self-consistent, stream for a new set of symbols:
+ *
+ * - the stock locate is incremented by k * locate_offset,
+ * - the order reference and match numbers are incremented by k << 56,
+ * - the ticker gets a lowercase suffix ('a' for k == 1, 'b' for
+ *   k == 2, and so on), NASDAQ tickers are uppercase, so the new
+ *   tickers never collide with the original ones.
+ *
+ * Messages without a stock locate code, such as system events, are
+ * sent only once.  Optionally the class also compresses the time
+ * between messages, rewriting the timestamps.
+ *
+ * The messages are re-encoded in place, in a buffer allocated once by
+ * the constructor, using jb::itch5::encoder<>.  The generated messages
+ * are numbered consecutively, as jb::itch5::mold_udp_pacer uses the
+ * message count to compute the MoldUDP64 sequence numbers.
+ */
+class load_amplifier {
+public:
+  /// Constructor
+  explicit load_amplifier(load_amplifier_config const& cfg);
+
+  /**
+   * Generate the copies of a message.
+   *
+   * @param msg the original message
+   * @param f a functor called for each generated message, the
+   * message buffer is reused, so the functor must consume (or copy)
+   * the message before returning.
+   *
+   * @tparam Functor the type of @a f, it must be callable with a
+   * jb::itch5::unknown_message const&
+   */
+  template <typename Functor>
+  void handle_message(unknown_message const& msg, Functor&& f) {
+    if (passthrough_) {
+      f(msg);
+      return;
+    }
+    int copies = msg.decode_header<false>().stock_locate == 0 ? 1 : factor_;
+    for (int k = 0; k != copies; ++k) {
+      std::size_t len = rewrite(k, msg);
+      unknown_message m(count_++, msg.offset(), len, buffer_.data());
+      f(m);
+    }
+  }
+
+  /// The number of messages generated so far
+  std::uint32_t count() const {
+    return count_;
+  }
+
+private:
+  /// Copy @a msg to the buffer and rewrite the fields for the k-th
+  /// copy, return the length of the message
+  std::size_t rewrite(int k, unknown_message const& msg);
+
+private:
+  int factor_;
+  int locate_offset_;
+  double time_compression_;
+  bool passthrough_;
+  bool started_;
+  std::chrono::nanoseconds first_ts_;
+  std::uint32_t count_;
+  std::vector<char> buffer_;
+};
+
+} // namespace itch5
+} // namespace jb
+
+#endif // jb_itch5_load_amplifier_hpp
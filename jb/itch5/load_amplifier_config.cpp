@@ -0,0 +1,84 @@
+#include "jb/itch5/load_amplifier_config.hpp"
+
+#include <sstream>
+
+namespace jb {
+namespace itch5 {
+/// Default the default values for ITCH-5.x configuation.
+namespace defaults {
+
+#ifndef JB_ITCH5_DEFAULTS_amplifier_factor
+#define JB_ITCH5_DEFAULTS_amplifier_factor 1
+#endif // JB_ITCH5_DEFAULTS_amplifier_factor
+
+/*
+ * NASDAQ assigns the stock locate codes sequentially, and there are
+ * fewer than 10,000 symbols in a typical day, the offset must be
+ * larger than the highest locate code in the file.
+ */
+#ifndef JB_ITCH5_DEFAULTS_amplifier_locate_offset
+#define JB_ITCH5_DEFAULTS_amplifier_locate_offset 10000
+#endif // JB_ITCH5_DEFAULTS_amplifier_locate_offset
+
+#ifndef JB_ITCH5_DEFAULTS_amplifier_time_compression
+#define JB_ITCH5_DEFAULTS_amplifier_time_compression 1.0
+#endif // JB_ITCH5_DEFAULTS_amplifier_time_compression
+
+int amplifier_factor = JB_ITCH5_DEFAULTS_amplifier_factor;
+int amplifier_locate_offset = JB_ITCH5_DEFAULTS_amplifier_locate_offset;
+double amplifier_time_compression =
+    JB_ITCH5_DEFAULTS_amplifier_time_compression;
+
+} // namespace defaults
+
+/// The maximum number of copies, limited by the suffixes for the
+/// stock tickers
+int const max_amplifier_factor = 16;
+
+load_amplifier_config::load_amplifier_config()
+    : factor(
+          desc("factor").help(
+              "Send this many copies of each order-flow message, each copy "
+              "uses different stock locate codes, tickers, and order "
+              "reference numbers.  The default (1) sends the original "
+              "feed."),
+          this, defaults::amplifier_factor)
+    , locate_offset(
+          desc("locate-offset")
+              .help("The stock locate codes for the k-th copy are "
+                    "incremented by k times this value, it must be larger "
+                    "than any stock locate code in the input."),
+          this, defaults::amplifier_locate_offset)
+    , time_compression(
+          desc("time-compression")
+              .help("Divide the time between the first message and each "
+                    "message by this value, and rewrite the message "
+                    "timestamps accordingly.  Use --pacer.speed to replay "
+                    "faster without changing the timestamps."),
+          this, defaults::amplifier_time_compression) {
+}
+
+void load_amplifier_config::validate() const {
+  if (factor() < 1 or factor() > max_amplifier_factor) {
+    std::ostringstream os;
+    os << "--factor must be in the [1," << max_amplifier_factor
+       << "] range, value=" << factor();
+    throw jb::usage{os.str(), 1};
+  }
+  // ... the remapped stock locate codes must fit in 16 bits ...
+  if (locate_offset() <= 0 or factor() * locate_offset() > (1 << 16)) {
+    std::ostringstream os;
+    os << "--locate-offset must be positive and factor * locate-offset "
+       << "must not exceed " << (1 << 16) << ", factor=" << factor()
+       << ", locate-offset=" << locate_offset();
+    throw jb::usage{os.str(), 1};
+  }
+  if (not(time_compression() >= 1.0)) {
+    std::ostringstream os;
+    os << "--time-compression must be >= 1.0, value=" << time_compression();
+    throw jb::usage{os.str(), 1};
+  }
+}
+
+} // namespace itch5
+} // namespace jb
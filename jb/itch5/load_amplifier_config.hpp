@@ -0,0 +1,27 @@
+#ifndef jb_itch5_load_amplifier_config_hpp
+#define jb_itch5_load_amplifier_config_hpp
+
+#include <jb/config_object.hpp>
+
+namespace jb {
+namespace itch5 {
+
+/**
+ * Configuration object for the jb::itch5::load_amplifier class.
+ */
+class load_amplifier_config : public jb::config_object {
+public:
+  load_amplifier_config();
+  config_object_constructors(load_amplifier_config);
+
+  void validate() const override;
+
+  jb::config_attribute<load_amplifier_config, int> factor;
+  jb::config_attribute<load_amplifier_config, int> locate_offset;
+  jb::config_attribute<load_amplifier_config, double> time_compression;
+};
+
+} // namespace itch5
+} // namespace jb
+
+#endif // jb_itch5_load_amplifier_config_hpp
@@ -0,0 +1,48 @@
+#include "jb/itch5/message_store.hpp"
+#include <jb/itch5/base_decoders.hpp>
+
+#include <istream>
+#include <sstream>
+#include <stdexcept>
+
+namespace jb {
+namespace itch5 {
+
+message_store::message_store()
+    : buffer_()
+    , offsets_(1, 0) {
+}
+
+void message_store::load(std::istream& is) {
+  char msgbuf[1 << 16];
+  while (is.good()) {
+    char blen[2];
+    is.read(blen, 2);
+    if (not is) {
+      if (is.gcount() != 0) {
+        std::ostringstream os;
+        os << "message_store::load - truncated length after " << size()
+           << " messages";
+        throw std::runtime_error(os.str());
+      }
+      return;
+    }
+    std::size_t msglen = decoder<true, std::uint16_t>::r(2, blen, 0);
+    is.read(msgbuf, msglen);
+    if (not is) {
+      std::ostringstream os;
+      os << "message_store::load - truncated message after " << size()
+         << " messages";
+      throw std::runtime_error(os.str());
+    }
+    append(msgbuf, msglen);
+  }
+}
+
+void message_store::append(char const* msg, std::size_t msglen) {
+  buffer_.insert(buffer_.end(), msg, msg + msglen);
+  offsets_.push_back(buffer_.size());
+}
+
+} // namespace itch5
+} // namespace jb
@@ -0,0 +1,62 @@
+#ifndef jb_itch5_message_store_hpp
+#define jb_itch5_message_store_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+namespace jb {
+namespace itch5 {
+
+/**
+ * Keep a full ITCH-5.x feed in memory, indexed by sequence number.
+ *
+ * A MoldUDP64 server needs random access to the messages to answer
+ * retransmission requests.  This class loads a raw ITCH-5.x file (each
+ * message prefixed by its 2-byte big endian length) into a single
+ * contiguous buffer, and keeps the offset of each message.  The first
+ * message in the file has sequence number 0, matching the numbering
+ * used by jb::itch5::mold_udp_pacer.
+ */
+class message_store {
+public:
+  message_store();
+
+  /**
+   * Append all the messages in a raw ITCH-5.x stream.
+   *
+   * @param is the input stream, read until EOF
+   * @throws std::runtime_error if the stream is truncated
+   */
+  void load(std::istream& is);
+
+  /// Append a single message
+  void append(char const* msg, std::size_t msglen);
+
+  /// The number of messages in the store
+  std::uint64_t size() const {
+    return offsets_.size() - 1;
+  }
+
+  /// The contents of message @a sequence_number, which must be valid
+  char const* message_data(std::uint64_t sequence_number) const {
+    return buffer_.data() + offsets_[sequence_number];
+  }
+
+  /// The length of message @a sequence_number, which must be valid
+  std::size_t message_size(std::uint64_t sequence_number) const {
+    return offsets_[sequence_number + 1] - offsets_[sequence_number];
+  }
+
+private:
+  std::vector<char> buffer_;
+  // The location of each message in buffer_, with an extra element at
+  // the end to simplify message_size()
+  std::vector<std::size_t> offsets_;
+};
+
+} // namespace itch5
+} // namespace jb
+
+#endif // jb_itch5_message_store_hpp
@@ -10,13 +10,20 @@
  * long did it take to process the event, and what was the elapsed
  * time since the last change to the inside".
  */
+#include <jb/itch5/clock_recalibrator.hpp>
 #include <jb/itch5/generate_inside.hpp>
 #include <jb/itch5/mold_udp_channel.hpp>
+#include <jb/itch5/packet_mmap_channel.hpp>
+#include <jb/itch5/per_symbol_statistics.hpp>
+#include <jb/itch5/pipeline_latency.hpp>
 #include <jb/itch5/process_iostream.hpp>
 #include <jb/itch5/udp_receiver_config.hpp>
+#include <jb/fast_format.hpp>
 #include <jb/fileio.hpp>
 #include <jb/log.hpp>
+#include <jb/metrics.hpp>
 
+#include <memory>
 #include <stdexcept>
 #include <unordered_map>
 
@@ -34,12 +41,19 @@ public:
   void validate() const override;
 
   jb::config_attribute<config, jb::itch5::udp_receiver_config> receiver;
+  jb::config_attribute<config, jb::itch5::mold_udp_channel_config> channel;
+  jb::config_attribute<config, bool> enable_packet_mmap;
+  jb::config_attribute<config, jb::itch5::packet_mmap_config> packet_mmap;
   jb::config_attribute<config, std::string> output_file;
   jb::config_attribute<config, jb::log::config> log;
   jb::config_attribute<config, jb::offline_feed_statistics::config> stats;
   jb::config_attribute<config, jb::offline_feed_statistics::config>
       symbol_stats;
   jb::config_attribute<config, bool> enable_symbol_stats;
+  jb::config_attribute<config, jb::itch5::pipeline_latency::config>
+      stage_latency;
+  jb::config_attribute<config, bool> enable_stage_latency;
+  jb::config_attribute<config, jb::itch5::clock_recalibrator::config> clock;
 };
 
 } // anonymous namespace
@@ -67,48 +81,56 @@ int main(int argc, char* argv[]) try {
 
   boost::asio::io_service io_service;
 
+  // ... the latency of every message is measured, keep the clock
+  // calibrated while the program runs ...
+  jb::itch5::clock_recalibrator recalibrator(io_service, cfg.clock());
+
   boost::iostreams::filtering_ostream out;
   jb::open_output_file(out, cfg.output_file());
+  // ... format the inside into a large buffer, much faster than
+  // formatting each field with the iostream operators ...
+  jb::fast_format fmt(out);
 
-  std::map<jb::itch5::stock_t, jb::offline_feed_statistics> per_symbol;
+  jb::itch5::per_symbol_statistics<jb::offline_feed_statistics> per_symbol(
+      cfg.symbol_stats());
   jb::offline_feed_statistics stats(cfg.stats());
 
   jb::itch5::compute_book<jb::itch5::map_based_order_book>::callback_type cb =
-      [&stats, &out](
+      [&stats, &fmt](
           jb::itch5::message_header const& header,
           jb::itch5::order_book<jb::itch5::map_based_order_book> const&
               updated_book,
           jb::itch5::book_update const& update) {
-        auto pl = std::chrono::steady_clock::now() - update.recvts;
+        auto pl = jb::itch5::clock_type::now() - update.recvts;
         (void)jb::itch5::generate_inside(
-            stats, out, header, updated_book, update, pl);
+            stats, fmt, header, updated_book, update, pl);
       };
   if (cfg.enable_symbol_stats()) {
     // ... replace the calback with one that also records the stats
     // for each symbol ...
-    jb::offline_feed_statistics::config symcfg(cfg.symbol_stats());
-    cb = [&stats, &out, &per_symbol, symcfg](
+    cb = [&stats, &fmt, &per_symbol](
         jb::itch5::message_header const& header,
         jb::itch5::order_book<jb::itch5::map_based_order_book> const&
             updated_book,
         jb::itch5::book_update const& update) {
-      auto pl = std::chrono::steady_clock::now() - update.recvts;
+      auto pl = jb::itch5::clock_type::now() - update.recvts;
       if (not jb::itch5::generate_inside(
-              stats, out, header, updated_book, update, pl)) {
+              stats, fmt, header, updated_book, update, pl)) {
         return;
       }
-      auto location = per_symbol.find(update.stock);
-      if (location == per_symbol.end()) {
-        auto p = per_symbol.emplace(
-            update.stock, jb::offline_feed_statistics(symcfg));
-        location = p.first;
-      }
-      location->second.sample(header.timestamp.ts, pl);
+      per_symbol.get(header.stock_locate, update.stock)
+          .sample(header.timestamp.ts, pl);
     };
   }
 
   typename jb::itch5::map_based_order_book::config cfg_bk;
-  jb::itch5::compute_book<jb::itch5::map_based_order_book> handler(cb, cfg_bk);
+  std::unique_ptr<jb::itch5::pipeline_latency> latency;
+  if (cfg.enable_stage_latency()) {
+    latency = std::make_unique<jb::itch5::pipeline_latency>(
+        cfg.stage_latency());
+  }
+  jb::itch5::compute_book<jb::itch5::map_based_order_book> handler(
+      cb, cfg_bk, latency.get());
   auto process_buffer = [&handler](
       std::chrono::steady_clock::time_point recv_ts, std::uint64_t msgcnt,
       std::size_t msgoffset, char const* msgbuf, std::size_t msglen) {
@@ -118,16 +140,37 @@ int main(int argc, char* argv[]) try {
         process(handler, recv_ts, msgcnt, msgoffset, msgbuf, msglen);
   };
 
-  jb::itch5::mold_udp_channel channel(
-      io_service, std::move(process_buffer), cfg.receiver());
+  // ... only one of the data sources is created ...
+  std::unique_ptr<jb::itch5::mold_udp_channel> channel;
+  std::unique_ptr<jb::itch5::packet_mmap_channel> mmap_channel;
+  if (cfg.enable_packet_mmap()) {
+    mmap_channel = std::make_unique<jb::itch5::packet_mmap_channel>(
+        io_service, std::move(process_buffer), cfg.receiver(),
+        cfg.packet_mmap());
+  } else {
+    channel = std::make_unique<jb::itch5::mold_udp_channel>(
+        io_service, std::move(process_buffer), cfg.receiver(), cfg.channel());
+  }
 
   io_service.run();
+  fmt.flush();
+  if (latency) {
+    latency->log_final_progress();
+  }
+  // ... the receivers count the messages, gaps and drops in the
+  // default metrics registry ...
+  std::string metrics;
+  jb::metrics::default_registry().append_text(metrics);
+  JB_LOG(info) << "final metrics:\n" << metrics;
 
   jb::offline_feed_statistics::print_csv_header(std::cout);
-  for (auto const& i : per_symbol) {
-    i.second.print_csv(i.first.c_str(), std::cout);
-  }
+  per_symbol.for_each([](auto const& stock, auto const& s) {
+    s.print_csv(stock.c_str(), std::cout);
+  });
   stats.print_csv("__aggregate__", std::cout);
+  if (latency) {
+    latency->print_csv(std::cout);
+  }
 
   return 0;
 } catch (jb::usage const& u) {
@@ -144,18 +187,6 @@ int main(int argc, char* argv[]) try {
 namespace {
 
 namespace defaults {
-// Define the default per-symbol stats
-jb::offline_feed_statistics::config per_symbol_stats() {
-  return jb::offline_feed_statistics::config()
-      .reporting_interval_seconds(24 * 3600)     // effectively disable updates
-      .max_processing_latency_nanoseconds(10000) // limit memory usage
-      .max_interarrival_time_nanoseconds(10000)  // limit memory usage
-      .max_messages_per_microsecond(1000)        // limit memory usage
-      .max_messages_per_millisecond(10000)       // limit memory usage
-      .max_messages_per_second(10000)            // limit memory usage
-      ;
-}
-
 std::string const local_address = "";
 std::string const address = "::1";
 int const port = 50000;
@@ -167,6 +198,15 @@ config::config()
                                       .port(defaults::port)
                                       .local_address(defaults::local_address)
                                       .address(defaults::address))
+    , channel(desc("channel", "mold-udp-channel"), this)
+    , enable_packet_mmap(
+          desc("enable-packet-mmap")
+              .help("If set, receive the packets from a memory mapped "
+                    "AF_PACKET ring instead of a UDP socket.  The ring is "
+                    "configured via --packet-mmap.*, and typically requires "
+                    "CAP_NET_RAW."),
+          this, false)
+    , packet_mmap(desc("packet-mmap", "packet-mmap"), this)
     , output_file(
           desc("output-file")
               .help("The name of the file where to store the inside data."
@@ -176,14 +216,23 @@ config::config()
     , stats(desc("stats", "offline-feed-statistics"), this)
     , symbol_stats(
           desc("symbol-stats", "offline-feed-statistics"), this,
-          defaults::per_symbol_stats())
+          jb::itch5::default_per_symbol_feed_statistics())
     , enable_symbol_stats(
           desc("enable-symbol-stats")
               .help(
                   "If set, enable per-symbol statistics."
-                  "  Collecting per-symbol statistics is expensive in both"
-                  " memory and execution time, so it is disabled by default."),
-          this, false) {
+                  "  The statistics for each symbol are allocated when the"
+                  " symbol is first seen, configure their size and precision"
+                  " using --symbol-stats."),
+          this, true)
+    , stage_latency(desc("stage-latency", "pipeline-latency"), this)
+    , enable_stage_latency(
+          desc("enable-stage-latency")
+              .help("If set, measure the latency of each stage (decode, "
+                    "order table, book, and output) for each message type."
+                    "  The results are printed after the other statistics."),
+          this, false)
+    , clock(desc("clock", "clock-recalibrator"), this) {
 }
 
 void config::validate() const {
@@ -194,9 +243,13 @@ void config::validate() const {
         "  You must specify an output file.",
         1);
   }
+  channel().validate();
+  packet_mmap().validate();
   log().validate();
   stats().validate();
   symbol_stats().validate();
+  stage_latency().validate();
+  clock().validate();
 }
 
 } // anonymous namespace
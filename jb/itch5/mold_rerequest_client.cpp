@@ -0,0 +1,174 @@
+#include "jb/itch5/mold_rerequest_client.hpp"
+
+#include <jb/itch5/base_encoders.hpp>
+#include <jb/log.hpp>
+
+#include <algorithm>
+#include <utility>
+
+namespace jb {
+namespace itch5 {
+
+mold_rerequest_client::mold_rerequest_client(
+    boost::asio::io_service& io, packet_handler&& handler,
+    mold_rerequest_config const& cfg)
+    : handler_(std::move(handler))
+    , server_(boost::asio::ip::address::from_string(cfg.address()), cfg.port())
+    , socket_(io)
+    , timer_(io)
+    , timer_armed_(false)
+    , max_outstanding_requests_(cfg.max_outstanding_requests())
+    , max_messages_per_request_(cfg.max_messages_per_request())
+    , request_timeout_(cfg.request_timeout_microseconds())
+    , session_()
+    , requests_()
+    , requests_sent_(0)
+    , requests_retried_(0)
+    , responses_received_(0) {
+  // ... the responses are sent back to the source of the request, so
+  // bind to an ephemeral port of the right address family ...
+  boost::asio::ip::address local_address = boost::asio::ip::address_v4();
+  if (server_.address().is_v6()) {
+    local_address = boost::asio::ip::address_v6();
+  }
+  boost::asio::ip::udp::endpoint endpoint(local_address, 0);
+  socket_.open(endpoint.protocol());
+  socket_.bind(endpoint);
+  restart_async_receive_from();
+}
+
+void mold_rerequest_client::request(
+    char const* session, std::uint64_t first, std::uint64_t count) {
+  if (session_.empty()) {
+    session_.assign(session, mold_udp_protocol::session_id_size);
+  }
+  // ... split the range so each request fits in a 16-bit count, and
+  // the responses do not flood the socket buffers ...
+  while (count != 0) {
+    auto n = std::min(count, max_messages_per_request_);
+    requests_.push_back(pending_request{
+        first, n, std::chrono::steady_clock::time_point(), false});
+    first += n;
+    count -= n;
+  }
+  send_pending();
+}
+
+void mold_rerequest_client::received_until(std::uint64_t sequence_number) {
+  bool progress = false;
+  while (not requests_.empty()) {
+    auto& r = requests_.front();
+    if (r.first >= sequence_number) {
+      break;
+    }
+    progress = true;
+    if (r.first + r.count <= sequence_number) {
+      requests_.pop_front();
+      continue;
+    }
+    // ... the request is partially satisfied, keep the rest, if it
+    // times out only the missing messages are requested again ...
+    r.count -= sequence_number - r.first;
+    r.first = sequence_number;
+    break;
+  }
+  if (progress) {
+    send_pending();
+  }
+}
+
+std::uint64_t mold_rerequest_client::pending_messages() const {
+  std::uint64_t total = 0;
+  for (auto const& r : requests_) {
+    total += r.count;
+  }
+  return total;
+}
+
+void mold_rerequest_client::send_pending() {
+  auto n = std::min(requests_.size(), max_outstanding_requests_);
+  for (std::size_t i = 0; i != n; ++i) {
+    if (not requests_[i].sent) {
+      send_request(requests_[i]);
+    }
+  }
+  if (not requests_.empty()) {
+    restart_timer();
+  }
+}
+
+void mold_rerequest_client::send_request(pending_request& r) {
+  char request[mold_udp_protocol::request_size];
+  std::copy(session_.begin(), session_.end(), request);
+  encoder<true, std::uint64_t>::w(
+      sizeof(request), request, mold_udp_protocol::sequence_number_offset,
+      r.first);
+  encoder<true, std::uint16_t>::w(
+      sizeof(request), request, mold_udp_protocol::block_count_offset,
+      static_cast<std::uint16_t>(r.count));
+
+  boost::system::error_code ec;
+  socket_.send_to(
+      boost::asio::buffer(request, sizeof(request)), server_, 0, ec);
+  if (ec) {
+    // ... the request is retried on the next timeout anyway ...
+    JB_LOG(info) << "error sending retransmission request [" << r.first << ","
+                 << r.first + r.count << "): " << ec.message();
+  }
+  r.sent_ts = std::chrono::steady_clock::now();
+  r.sent = true;
+  ++requests_sent_;
+}
+
+void mold_rerequest_client::restart_timer() {
+  if (timer_armed_) {
+    return;
+  }
+  timer_armed_ = true;
+  timer_.expires_from_now(request_timeout_);
+  timer_.async_wait(
+      [this](boost::system::error_code const& ec) { handle_timeout(ec); });
+}
+
+void mold_rerequest_client::handle_timeout(
+    boost::system::error_code const& ec) {
+  timer_armed_ = false;
+  if (ec) {
+    return;
+  }
+  auto now = std::chrono::steady_clock::now();
+  auto n = std::min(requests_.size(), max_outstanding_requests_);
+  for (std::size_t i = 0; i != n; ++i) {
+    auto& r = requests_[i];
+    if (r.sent and now - r.sent_ts >= request_timeout_) {
+      ++requests_retried_;
+      send_request(r);
+    }
+  }
+  send_pending();
+}
+
+void mold_rerequest_client::restart_async_receive_from() {
+  socket_.async_receive_from(
+      boost::asio::buffer(buffer_, buflen), sender_endpoint_,
+      [this](boost::system::error_code const& ec, size_t bytes_received) {
+        handle_received(ec, bytes_received);
+      });
+}
+
+void mold_rerequest_client::handle_received(
+    boost::system::error_code const& ec, size_t bytes_received) {
+  if (ec) {
+    JB_LOG(info) << "error received in mold_rerequest_client::handle_received: "
+                 << ec.message() << " (" << ec << ")";
+    return;
+  }
+  if (bytes_received > 0) {
+    ++responses_received_;
+    handler_(std::chrono::steady_clock::now(), buffer_, bytes_received);
+  }
+  restart_async_receive_from();
+}
+
+} // namespace itch5
+} // namespace jb
@@ -0,0 +1,170 @@
+#ifndef jb_itch5_mold_rerequest_client_hpp
+#define jb_itch5_mold_rerequest_client_hpp
+
+#include <jb/itch5/mold_rerequest_config.hpp>
+#include <jb/itch5/mold_udp_protocol_constants.hpp>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/ip/udp.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+
+namespace jb {
+namespace itch5 {
+
+/**
+ * Request the retransmission of missing MoldUDP64 messages.
+ *
+ * The client sends retransmission requests over unicast UDP to a
+ * MoldUDP64 server, and forwards the responses (which are normal
+ * MoldUDP64 packets) to a handler, typically
+ * jb::itch5::mold_udp_stream::process_packet() so they are merged
+ * into the reorder buffer.
+ *
+ * Large gaps are split into several requests, and only a limited
+ * number of requests are in flight at any time.  Requests that are
+ * not satisfied before the timeout are sent again.  The owner must
+ * report progress via received_until(), that is how the client knows
+ * a request is satisfied.
+ *
+ * All the work happens in the Boost.ASIO io_service, the class is not
+ * thread-safe.
+ */
+class mold_rerequest_client {
+public:
+  /**
+   * A callback function type to process the responses.
+   *
+   * The parameters represent (in order)
+   * - The timestamp when the packet was received
+   * - The contents of the MoldUDP64 packet
+   * - The length of the packet
+   */
+  typedef std::function<void(
+      std::chrono::steady_clock::time_point, char const*, std::size_t)>
+      packet_handler;
+
+  /**
+   * Constructor, create the socket and register for IO notifications.
+   *
+   * @param io the Boost.ASIO IO service to register with
+   * @param handler the callback to process the responses
+   * @param cfg the configuration for the client
+   */
+  mold_rerequest_client(
+      boost::asio::io_service& io, packet_handler&& handler,
+      mold_rerequest_config const& cfg);
+
+  /**
+   * Request the retransmission of a range of messages.
+   *
+   * The request may be queued if there are too many outstanding
+   * requests.
+   *
+   * @param session the session id, mold_udp_protocol::session_id_size
+   * bytes
+   * @param first the sequence number of the first missing message
+   * @param count the number of missing messages
+   */
+  void request(char const* session, std::uint64_t first, std::uint64_t count);
+
+  /**
+   * Report that all messages before @a sequence_number were received.
+   *
+   * Satisfied requests are discarded, which may allow queued requests
+   * to be sent.
+   */
+  void received_until(std::uint64_t sequence_number);
+
+  //@{
+  /**
+   * @name Accessors
+   */
+  /// The number of requests sent, including retries
+  std::uint64_t requests_sent() const {
+    return requests_sent_;
+  }
+
+  /// The number of requests sent again after a timeout
+  std::uint64_t requests_retried() const {
+    return requests_retried_;
+  }
+
+  /// The number of response packets received
+  std::uint64_t responses_received() const {
+    return responses_received_;
+  }
+
+  /// The number of messages requested but not received yet
+  std::uint64_t pending_messages() const;
+  //@}
+
+private:
+  /// A range of messages to request
+  struct pending_request {
+    std::uint64_t first;
+    std::uint64_t count;
+    std::chrono::steady_clock::time_point sent_ts;
+    bool sent;
+  };
+
+  /// Send any queued requests, up to the limit of outstanding requests
+  void send_pending();
+
+  /// Send (or send again) a request
+  void send_request(pending_request& r);
+
+  /// Arm the retry timer, unless it is already armed
+  void restart_timer();
+
+  /// Send again any requests that timed out
+  void handle_timeout(boost::system::error_code const& ec);
+
+  /// Register for the next response
+  void restart_async_receive_from();
+
+  /// The Boost.ASIO callback for responses
+  void
+  handle_received(boost::system::error_code const& ec, size_t bytes_received);
+
+private:
+  packet_handler handler_;
+  boost::asio::ip::udp::endpoint server_;
+  boost::asio::ip::udp::socket socket_;
+  boost::asio::steady_timer timer_;
+  bool timer_armed_;
+
+  std::size_t max_outstanding_requests_;
+  std::uint64_t max_messages_per_request_;
+  std::chrono::microseconds request_timeout_;
+
+  // The session id, copied from the first gap
+  std::string session_;
+
+  // The requests, ordered by sequence number, only the first
+  // max_outstanding_requests_ can be in flight
+  std::deque<pending_request> requests_;
+
+  std::uint64_t requests_sent_;
+  std::uint64_t requests_retried_;
+  std::uint64_t responses_received_;
+
+  // The maximum packet length expected (UDP is limited to 2^16 bytes)
+  static std::size_t const buflen = 1 << 16;
+
+  // A buffer to read the responses into
+  char buffer_[buflen];
+
+  // The endpoint that sent the last response
+  boost::asio::ip::udp::endpoint sender_endpoint_;
+};
+
+} // namespace itch5
+} // namespace jb
+
+#endif // jb_itch5_mold_rerequest_client_hpp
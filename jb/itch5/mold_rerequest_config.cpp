@@ -0,0 +1,119 @@
+#include "jb/itch5/mold_rerequest_config.hpp"
+#include <jb/usage.hpp>
+
+#include <boost/asio/ip/address.hpp>
+#include <sstream>
+
+namespace jb {
+namespace itch5 {
+namespace defaults {
+
+#ifndef JB_ITCH5_DEFAULTS_rerequest_address
+#define JB_ITCH5_DEFAULTS_rerequest_address "127.0.0.1"
+#endif // JB_ITCH5_DEFAULTS_rerequest_address
+
+#ifndef JB_ITCH5_DEFAULTS_max_outstanding_requests
+#define JB_ITCH5_DEFAULTS_max_outstanding_requests 2
+#endif // JB_ITCH5_DEFAULTS_max_outstanding_requests
+
+#ifndef JB_ITCH5_DEFAULTS_max_messages_per_request
+#define JB_ITCH5_DEFAULTS_max_messages_per_request 1000
+#endif // JB_ITCH5_DEFAULTS_max_messages_per_request
+
+#ifndef JB_ITCH5_DEFAULTS_request_timeout_microseconds
+#define JB_ITCH5_DEFAULTS_request_timeout_microseconds 10000
+#endif // JB_ITCH5_DEFAULTS_request_timeout_microseconds
+
+#ifndef JB_ITCH5_DEFAULTS_max_buffered_messages
+#define JB_ITCH5_DEFAULTS_max_buffered_messages 1000000
+#endif // JB_ITCH5_DEFAULTS_max_buffered_messages
+
+std::string rerequest_address = JB_ITCH5_DEFAULTS_rerequest_address;
+int max_outstanding_requests = JB_ITCH5_DEFAULTS_max_outstanding_requests;
+int max_messages_per_request = JB_ITCH5_DEFAULTS_max_messages_per_request;
+int request_timeout_microseconds =
+    JB_ITCH5_DEFAULTS_request_timeout_microseconds;
+int max_buffered_messages = JB_ITCH5_DEFAULTS_max_buffered_messages;
+
+} // namespace defaults
+
+mold_rerequest_config::mold_rerequest_config()
+    : address(
+          desc("address").help(
+              "The unicast address where the MoldUDP64 server listens "
+              "for retransmission requests."),
+          this, defaults::rerequest_address)
+    , port(
+          desc("port").help(
+              "The UDP port where the MoldUDP64 server listens for "
+              "retransmission requests.  If 0, gap recovery is disabled."),
+          this, 0)
+    , max_outstanding_requests(
+          desc("max-outstanding-requests")
+              .help("The maximum number of retransmission requests in flight, "
+                    "additional requests are queued until some of the "
+                    "outstanding ones are satisfied."),
+          this, defaults::max_outstanding_requests)
+    , max_messages_per_request(
+          desc("max-messages-per-request")
+              .help("Larger gaps are split into several requests of at most "
+                    "this many messages."),
+          this, defaults::max_messages_per_request)
+    , request_timeout_microseconds(
+          desc("request-timeout-microseconds")
+              .help("Send a request again if it is not satisfied after this "
+                    "many microseconds."),
+          this, defaults::request_timeout_microseconds)
+    , max_buffered_messages(
+          desc("max-buffered-messages")
+              .help("The maximum number of messages received after a gap that "
+                    "are kept while waiting for the gap to be filled.  If the "
+                    "buffer grows larger the oldest gap is abandoned."),
+          this, defaults::max_buffered_messages) {
+}
+
+void mold_rerequest_config::validate() const {
+  if (port() == 0) {
+    return;
+  }
+  if (port() < 0 or port() > 65535) {
+    std::ostringstream os;
+    os << "--port must be in the [0,65535] range, value=" << port();
+    throw jb::usage(os.str(), 1);
+  }
+  boost::system::error_code ec;
+  boost::asio::ip::address::from_string(address(), ec);
+  if (ec) {
+    std::ostringstream os;
+    os << "--address must be a valid IP address, value=" << address();
+    throw jb::usage(os.str(), 1);
+  }
+  if (max_outstanding_requests() < 1) {
+    std::ostringstream os;
+    os << "--max-outstanding-requests must be >= 1, value="
+       << max_outstanding_requests();
+    throw jb::usage(os.str(), 1);
+  }
+  // ... the message count in a request is a 16-bit field ...
+  if (max_messages_per_request() < 1 or max_messages_per_request() > 65535) {
+    std::ostringstream os;
+    os << "--max-messages-per-request must be in the [1,65535] range, value="
+       << max_messages_per_request();
+    throw jb::usage(os.str(), 1);
+  }
+  if (request_timeout_microseconds() <= 0) {
+    std::ostringstream os;
+    os << "--request-timeout-microseconds must be > 0, value="
+       << request_timeout_microseconds();
+    throw jb::usage(os.str(), 1);
+  }
+  if (max_buffered_messages() < 1) {
+    std::ostringstream os;
+    os << "--max-buffered-messages must be >= 1, value="
+       << max_buffered_messages();
+    throw jb::usage(os.str(), 1);
+  }
+}
+
+} // namespace itch5
+} // namespace jb
@@ -0,0 +1,35 @@
+#ifndef jb_itch5_mold_rerequest_config_hpp
+#define jb_itch5_mold_rerequest_config_hpp
+
+#include <jb/config_object.hpp>
+
+namespace jb {
+namespace itch5 {
+
+/**
+ * Configure how a jb::itch5::mold_rerequest_client recovers gaps.
+ *
+ * MoldUDP64 servers listen for retransmission requests on a unicast
+ * UDP address, and respond with normal MoldUDP64 packets containing
+ * the requested messages.  By default (@a port is 0) recovery is
+ * disabled, and the gaps are simply logged.
+ */
+class mold_rerequest_config : public jb::config_object {
+public:
+  mold_rerequest_config();
+  config_object_constructors(mold_rerequest_config);
+
+  void validate() const override;
+
+  jb::config_attribute<mold_rerequest_config, std::string> address;
+  jb::config_attribute<mold_rerequest_config, int> port;
+  jb::config_attribute<mold_rerequest_config, int> max_outstanding_requests;
+  jb::config_attribute<mold_rerequest_config, int> max_messages_per_request;
+  jb::config_attribute<mold_rerequest_config, int> request_timeout_microseconds;
+  jb::config_attribute<mold_rerequest_config, int> max_buffered_messages;
+};
+
+} // namespace itch5
+} // namespace jb
+
+#endif // jb_itch5_mold_rerequest_config_hpp
@@ -0,0 +1,128 @@
+#include "jb/itch5/mold_rerequest_server.hpp"
+
+#include <jb/itch5/base_decoders.hpp>
+#include <jb/itch5/base_encoders.hpp>
+#include <jb/itch5/make_socket_udp_recv.hpp>
+#include <jb/itch5/mold_udp_protocol_constants.hpp>
+#include <jb/itch5/udp_receiver_config.hpp>
+#include <jb/log.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+namespace jb {
+namespace itch5 {
+
+mold_rerequest_server::mold_rerequest_server(
+    boost::asio::io_service& io, message_store const& store,
+    udp_receiver_config const& cfg, std::size_t max_packet_size)
+    : store_(store)
+    , socket_(make_socket_udp_recv<>(io, cfg))
+    , max_packet_size_(max_packet_size)
+    , requests_received_(0)
+    , messages_sent_(0)
+    , packets_sent_(0)
+    , sender_endpoint_()
+    , packet_(max_packet_size) {
+  if (max_packet_size_ <= mold_udp_protocol::header_size + 2) {
+    std::ostringstream os;
+    os << "mold_rerequest_server - max_packet_size (" << max_packet_size
+       << ") is too small";
+    throw std::invalid_argument(os.str());
+  }
+  // ... messages too large for a packet are detected as they are sent,
+  // checking the full store here would require a full scan ...
+  restart_async_receive_from();
+}
+
+void mold_rerequest_server::restart_async_receive_from() {
+  socket_.async_receive_from(
+      boost::asio::buffer(buffer_, buflen), sender_endpoint_,
+      [this](boost::system::error_code const& ec, size_t bytes_received) {
+        handle_received(ec, bytes_received);
+      });
+}
+
+void mold_rerequest_server::handle_received(
+    boost::system::error_code const& ec, size_t bytes_received) {
+  if (ec) {
+    JB_LOG(info) << "error received in mold_rerequest_server::handle_received: "
+                 << ec.message() << " (" << ec << ")";
+    return;
+  }
+  if (bytes_received < mold_udp_protocol::request_size) {
+    JB_LOG(info) << "short retransmission request (" << bytes_received
+                 << " bytes) from " << sender_endpoint_;
+    restart_async_receive_from();
+    return;
+  }
+  ++requests_received_;
+  auto first = decoder<true, std::uint64_t>::r(
+      bytes_received, buffer_, mold_udp_protocol::sequence_number_offset);
+  auto count = decoder<true, std::uint16_t>::r(
+      bytes_received, buffer_, mold_udp_protocol::block_count_offset);
+  // ... the responses echo the session id in the request ...
+  std::memcpy(packet_.data(), buffer_, mold_udp_protocol::session_id_size);
+  // ... ignore requests past the end of the store, and clamp the
+  // count so first + count cannot wrap around ...
+  if (first < store_.size()) {
+    std::uint64_t n = std::min<std::uint64_t>(count, store_.size() - first);
+    send_range(first, first + n);
+  }
+  restart_async_receive_from();
+}
+
+void mold_rerequest_server::send_range(
+    std::uint64_t first, std::uint64_t last) {
+  std::size_t size = mold_udp_protocol::header_size;
+  std::uint64_t packet_first = first;
+  std::uint16_t count = 0;
+  for (auto seqno = first; seqno != last; ++seqno) {
+    auto msglen = store_.message_size(seqno);
+    if (mold_udp_protocol::header_size + 2 + msglen > max_packet_size_) {
+      JB_LOG(warning) << "message " << seqno << " (" << msglen
+                      << " bytes) does not fit in a packet, stopping";
+      break;
+    }
+    if (size + 2 + msglen > max_packet_size_) {
+      flush(packet_first, count, size);
+      size = mold_udp_protocol::header_size;
+      packet_first = seqno;
+      count = 0;
+    }
+    encoder<true, std::uint16_t>::w(
+        packet_.size(), packet_.data(), size,
+        static_cast<std::uint16_t>(msglen));
+    std::memcpy(packet_.data() + size + 2, store_.message_data(seqno), msglen);
+    size += 2 + msglen;
+    ++count;
+  }
+  if (count != 0) {
+    flush(packet_first, count, size);
+  }
+}
+
+void mold_rerequest_server::flush(
+    std::uint64_t first, std::uint16_t count, std::size_t size) {
+  encoder<true, std::uint64_t>::w(
+      packet_.size(), packet_.data(), mold_udp_protocol::sequence_number_offset,
+      first);
+  encoder<true, std::uint16_t>::w(
+      packet_.size(), packet_.data(), mold_udp_protocol::block_count_offset,
+      count);
+  boost::system::error_code ec;
+  socket_.send_to(
+      boost::asio::buffer(packet_.data(), size), sender_endpoint_, 0, ec);
+  if (ec) {
+    JB_LOG(info) << "error sending retransmission to " << sender_endpoint_
+                 << ": " << ec.message();
+    return;
+  }
+  ++packets_sent_;
+  messages_sent_ += count;
+}
+
+} // namespace itch5
+} // namespace jb
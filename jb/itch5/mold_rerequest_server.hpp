@@ -0,0 +1,99 @@
+#ifndef jb_itch5_mold_rerequest_server_hpp
+#define jb_itch5_mold_rerequest_server_hpp
+
+#include <jb/itch5/message_store.hpp>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/ip/udp.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace jb {
+namespace itch5 {
+
+class udp_receiver_config;
+
+/**
+ * Answer MoldUDP64 retransmission requests from a jb::itch5::message_store.
+ *
+ * Each request is answered with as many MoldUDP64 packets as needed to
+ * carry the requested messages, sent back to the source of the
+ * request.  The session id in the responses is copied from the
+ * request.  Requests beyond the end of the store are truncated, and
+ * ignored if nothing is left.
+ */
+class mold_rerequest_server {
+public:
+  /**
+   * Constructor, create the socket and register for IO notifications.
+   *
+   * @param io the Boost.ASIO IO service to register with
+   * @param store the messages to serve, must outlive the server
+   * @param cfg where to listen for requests
+   * @param max_packet_size the maximum size of the response packets
+   */
+  mold_rerequest_server(
+      boost::asio::io_service& io, message_store const& store,
+      udp_receiver_config const& cfg, std::size_t max_packet_size);
+
+  /// The local endpoint, useful if the configuration used port 0
+  boost::asio::ip::udp::endpoint local_endpoint() const {
+    return socket_.local_endpoint();
+  }
+
+  //@{
+  /**
+   * @name Accessors
+   */
+  std::uint64_t requests_received() const {
+    return requests_received_;
+  }
+  std::uint64_t messages_sent() const {
+    return messages_sent_;
+  }
+  std::uint64_t packets_sent() const {
+    return packets_sent_;
+  }
+  //@}
+
+private:
+  /// Register for the next request
+  void restart_async_receive_from();
+
+  /// The Boost.ASIO callback for requests
+  void
+  handle_received(boost::system::error_code const& ec, size_t bytes_received);
+
+  /// Send the messages in [first, last) to the source of the request
+  void send_range(std::uint64_t first, std::uint64_t last);
+
+  /// Send the packet accumulated in packet_
+  void flush(std::uint64_t first, std::uint16_t count, std::size_t size);
+
+private:
+  message_store const& store_;
+  boost::asio::ip::udp::socket socket_;
+  std::size_t max_packet_size_;
+
+  std::uint64_t requests_received_;
+  std::uint64_t messages_sent_;
+  std::uint64_t packets_sent_;
+
+  // The maximum packet length expected (UDP is limited to 2^16 bytes)
+  static std::size_t const buflen = 1 << 16;
+
+  // A buffer to read the requests into
+  char buffer_[buflen];
+
+  // The source of the last request
+  boost::asio::ip::udp::endpoint sender_endpoint_;
+
+  // A buffer to build the responses
+  std::vector<char> packet_;
+};
+
+} // namespace itch5
+} // namespace jb
+
+#endif // jb_itch5_mold_rerequest_server_hpp
@@ -1,32 +1,85 @@
 #include "jb/itch5/mold_udp_channel.hpp"
 
-#include <jb/itch5/base_decoders.hpp>
+#include <jb/itch5/clock_type.hpp>
 #include <jb/itch5/make_socket_udp_recv.hpp>
-#include <jb/itch5/mold_udp_protocol_constants.hpp>
 #include <jb/itch5/udp_receiver_config.hpp>
+#include <jb/launch_thread.hpp>
 #include <jb/log.hpp>
 
 #include <boost/asio/ip/multicast.hpp>
 
+#include <cerrno>
+#include <cstring>
 #include <utility>
+#include <vector>
+
+#include <sys/socket.h>
 
 namespace jb {
 namespace itch5 {
 
 mold_udp_channel::mold_udp_channel(
     boost::asio::io_service& io, buffer_handler const& handler,
-    udp_receiver_config const& cfg)
-    : mold_udp_channel(io, buffer_handler(handler), cfg) {
+    udp_receiver_config const& cfg, mold_udp_channel_config const& chcfg)
+    : mold_udp_channel(io, buffer_handler(handler), cfg, chcfg) {
 }
 
 mold_udp_channel::mold_udp_channel(
     boost::asio::io_service& io, buffer_handler&& handler,
-    udp_receiver_config const& cfg)
-    : handler_(std::move(handler))
+    udp_receiver_config const& cfg, mold_udp_channel_config const& chcfg)
+    : stream_(std::move(handler))
     , socket_(make_socket_udp_recv<>(io, cfg))
-    , expected_sequence_number_(0)
-    , message_offset_(0) {
-  restart_async_receive_from();
+    , stop_(false)
+    , poll_thread_()
+    , client_() {
+  if (chcfg.rerequest().port() != 0) {
+    client_.reset(new mold_rerequest_client(
+        io,
+        [this](
+            std::chrono::steady_clock::time_point recv_ts, char const* buffer,
+            std::size_t bytes_received) {
+          handle_retransmission(recv_ts, buffer, bytes_received);
+        },
+        chcfg.rerequest()));
+    stream_.enable_recovery(
+        [this](char const* session, std::uint64_t first, std::uint64_t count) {
+          client_->request(session, first, count);
+        },
+        chcfg.rerequest().max_buffered_messages());
+  }
+  if (chcfg.busy_poll_microseconds() != 0) {
+#if defined(SO_BUSY_POLL)
+    using busy_poll_option = boost::asio::detail::socket_option::integer<
+        SOL_SOCKET, SO_BUSY_POLL>;
+    socket_.set_option(busy_poll_option(chcfg.busy_poll_microseconds()));
+#else
+    JB_LOG(warning) << "SO_BUSY_POLL not supported on this platform, "
+                    << "ignoring --busy-poll-microseconds="
+                    << chcfg.busy_poll_microseconds();
+#endif // defined(SO_BUSY_POLL)
+  }
+  if (not chcfg.busy_poll()) {
+    restart_async_receive_from();
+    return;
+  }
+  // ... in busy poll mode we never register with the reactor, so we
+  // need to keep the io_service busy, otherwise io_service::run()
+  // returns immediately.  The work object is owned by the thread
+  // functor, so it is released when the thread exits, for whatever
+  // reason ...
+  socket_.non_blocking(true);
+  boost::asio::io_service::work work(io);
+  std::size_t batch_size = chcfg.receive_batch_size();
+  jb::launch_thread(
+      poll_thread_, chcfg.poll_thread(),
+      [this, batch_size, work]() { busy_poll_loop(batch_size); });
+}
+
+mold_udp_channel::~mold_udp_channel() {
+  stop_.store(true, std::memory_order_release);
+  if (poll_thread_.joinable()) {
+    poll_thread_.join();
+  }
 }
 
 void mold_udp_channel::restart_async_receive_from() {
@@ -57,55 +110,62 @@ void mold_udp_channel::handle_received(
   // ... we have no errors and at least some data to process, get the
   // current timestamp, all the messages in the MoldUDP64 packet share
   // the same timestamp ...
-  auto recv_ts = std::chrono::steady_clock::now();
-  // ... parse the sequence number of the first message in the
-  // MoldUDP64 packet ...
-  auto sequence_number = jb::itch5::decoder<true, std::uint64_t>::r(
-      bytes_received, buffer_,
-      jb::itch5::mold_udp_protocol::sequence_number_offset);
-  // ... and parse the number of blocks in the MoldUDP64 packet ...
-  auto block_count = jb::itch5::decoder<true, std::uint16_t>::r(
-      bytes_received, buffer_,
-      jb::itch5::mold_udp_protocol::block_count_offset);
-
-  // ... if the message is out of order we simply print the problem,
-  // in a more realistic application we would need to reorder them
-  // and gap fill if needed, and sometimes do even more complicated
-  // things ...
-  if (sequence_number != expected_sequence_number_) {
-    JB_LOG(info) << "Mismatched sequence number, expected="
-                 << expected_sequence_number_ << ", got=" << sequence_number;
+  auto recv_ts = clock_type::now();
+  stream_.process_packet(recv_ts, buffer_, bytes_received);
+  if (client_) {
+    client_->received_until(stream_.expected_sequence_number());
   }
 
-  //  Keep track of where each ITCH-5.0 message starts in the
-  //  MoldUDP64 block ...
-  std::size_t offset = jb::itch5::mold_udp_protocol::header_size;
-  // ... process each message in the MoldUDP64 packet, in order ...
-  for (std::size_t block = 0; block != block_count; ++block) {
-    // ... parse the block size ...
-    auto message_size = jb::itch5::decoder<true, std::uint16_t>::r(
-        bytes_received, buffer_, offset);
-    // ... increment the offset into the MoldUDP64 packet, this is
-    // the start of the ITCH-5.x message ...
-    offset += 2;
-    // ... process the buffer ...
-    handler_(
-        recv_ts, expected_sequence_number_, message_offset_, buffer_ + offset,
-        message_size);
-
-    // ... increment counters to reflect that this message was
-    // proceesed ...
-    sequence_number++;
-    message_offset_ += message_size;
-    offset += message_size;
-  }
-  // ... since we are not dealing with gaps, or message reordering
-  // just reset the next expected number ...
-  expected_sequence_number_ = sequence_number;
-
   // ... and register for a new IO callback ...
   restart_async_receive_from();
 }
 
+void mold_udp_channel::handle_retransmission(
+    std::chrono::steady_clock::time_point recv_ts, char const* buffer,
+    std::size_t bytes_received) {
+  stream_.process_packet(recv_ts, buffer, bytes_received);
+  client_->received_until(stream_.expected_sequence_number());
+}
+
+void mold_udp_channel::busy_poll_loop(std::size_t batch_size) {
+  // ... allocate all the buffers once, they are reused on each call
+  // to recvmmsg(2) ...
+  std::vector<char> buffers(batch_size * buflen);
+  std::vector<::iovec> iov(batch_size);
+  std::vector<::mmsghdr> msgs(batch_size);
+  for (std::size_t i = 0; i != batch_size; ++i) {
+    iov[i].iov_base = buffers.data() + i * buflen;
+    iov[i].iov_len = buflen;
+    std::memset(&msgs[i], 0, sizeof(msgs[i]));
+    msgs[i].msg_hdr.msg_iov = &iov[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  auto fd = socket_.native_handle();
+  while (not stop_.load(std::memory_order_acquire)) {
+    int n = ::recvmmsg(fd, msgs.data(), batch_size, MSG_DONTWAIT, nullptr);
+    if (n < 0) {
+      if (errno == EAGAIN or errno == EWOULDBLOCK or errno == EINTR) {
+        continue;
+      }
+      // ... same as in handle_received(), simply report the error
+      // and stop receiving ...
+      JB_LOG(info) << "error received in mold_udp_channel::busy_poll_loop: "
+                   << std::strerror(errno) << " (" << errno << ")";
+      return;
+    }
+    // ... all the packets in the batch share the same timestamp,
+    // they were all in the socket buffer by now ...
+    auto recv_ts = clock_type::now();
+    for (int i = 0; i != n; ++i) {
+      if (msgs[i].msg_len == 0) {
+        continue;
+      }
+      stream_.process_packet(
+          recv_ts, static_cast<char const*>(iov[i].iov_base), msgs[i].msg_len);
+    }
+  }
+}
+
 } // namespace itch5
 } // namespace jb
@@ -1,11 +1,16 @@
 #ifndef jb_itch5_mold_udp_channel_hpp
 #define jb_itch5_mold_udp_channel_hpp
 
+#include <jb/itch5/mold_rerequest_client.hpp>
+#include <jb/itch5/mold_udp_channel_config.hpp>
+#include <jb/itch5/mold_udp_stream.hpp>
+
 #include <boost/asio/io_service.hpp>
 #include <boost/asio/ip/udp.hpp>
 
-#include <chrono>
-#include <functional>
+#include <atomic>
+#include <memory>
+#include <thread>
 
 namespace jb {
 namespace itch5 {
@@ -20,26 +25,24 @@ class udp_receiver_config;
  * packets in the socket, and when new packets are received it breaks
  * down the packet into ITCH-5.0 messages and invokes a handler for
  * each one.
+ *
+ * Optionally (see jb::itch5::mold_udp_channel_config) the channel
+ * bypasses the Boost.ASIO reactor: it puts the socket in non-blocking
+ * mode and spins on recvmmsg(2) from a dedicated thread.  The handler
+ * is then invoked from that thread, but otherwise the contract is
+ * unchanged.
+ *
+ * If retransmission requests are configured the channel recovers any
+ * gaps using a jb::itch5::mold_rerequest_client, in that case the
+ * messages are delivered strictly in sequence number order.
  */
 class mold_udp_channel {
 public:
   /**
    * A callback function type to process any received ITCH-5.0
-   * messages
-   *
-   * The parameters represent (in order)
-   * - When was the MoldUDP64 packet containing this message received
-   * - The sequence number for this particular message
-   * - The offset (in bytes) from the beginning of the MoldUDP64
-   * stream for this message
-   * - The message, including the ITCH-5.0 headers but excluding any
-   * MoldUDP64 headers.
-   * - The size of the message, in bytes.
+   * messages, see jb::itch5::mold_udp_stream for details.
    */
-  typedef std::function<void(
-      std::chrono::steady_clock::time_point, std::uint64_t, std::size_t,
-      char const*, std::size_t)>
-      buffer_handler;
+  typedef mold_udp_stream::buffer_handler buffer_handler;
 
   /**
    * Constructor, create a socket and register for IO notifications.
@@ -49,10 +52,12 @@ public:
    * @param io the Boost.ASIO IO service to register with for IO
    * notifications
    * @param cfg the configuration for the UDP receiver.
+   * @param chcfg the configuration for the receive loop.
    */
   mold_udp_channel(
       boost::asio::io_service& io, buffer_handler const& handler,
-      udp_receiver_config const& cfg);
+      udp_receiver_config const& cfg,
+      mold_udp_channel_config const& chcfg = mold_udp_channel_config());
 
   /**
    * Constructor, create a socket and register for IO notifications.
@@ -62,10 +67,15 @@ public:
    * @param io the Boost.ASIO IO service to register with for IO
    * notifications
    * @param cfg the configuration for the UDP receiver.
+   * @param chcfg the configuration for the receive loop.
    */
   mold_udp_channel(
       boost::asio::io_service& io, buffer_handler&& handler,
-      udp_receiver_config const& cfg);
+      udp_receiver_config const& cfg,
+      mold_udp_channel_config const& chcfg = mold_udp_channel_config());
+
+  /// Destructor, stop the busy polling thread (if any).
+  ~mold_udp_channel();
 
 private:
   /**
@@ -89,23 +99,29 @@ private:
   void
   handle_received(boost::system::error_code const& ec, size_t bytes_received);
 
+  /**
+   * Spin on recvmmsg(2) until the channel is destroyed.
+   *
+   * @param batch_size the maximum number of packets to receive on
+   * each call
+   */
+  void busy_poll_loop(std::size_t batch_size);
+
+  /// Process a retransmitted packet
+  void handle_retransmission(
+      std::chrono::steady_clock::time_point recv_ts, char const* buffer,
+      std::size_t bytes_received);
+
   /// Allow testing class access to the code ...
   friend struct mold_udp_channel_tester;
 
 private:
-  // The callback handler
-  buffer_handler handler_;
+  // Break down the packets and invoke the callback handler
+  mold_udp_stream stream_;
 
   // A UDP socket configured as per the constructor arguments
   boost::asio::ip::udp::socket socket_;
 
-  // The next sequence number expected from the MoldUDP64 stream
-  std::uint64_t expected_sequence_number_;
-
-  // The offset (in bytes) since the beginning of the MoldUDP64
-  // stream, mostly for logging.
-  std::size_t message_offset_;
-
   // The maximum packet length expected (UDP is limited to 2^16 bytes)
   static std::size_t const buflen = 1 << 16;
 
@@ -115,6 +131,15 @@ private:
 
   // The UDP endpoint that sent the last received MoldUDP64 packet
   boost::asio::ip::udp::endpoint sender_endpoint_;
+
+  // Signal the busy polling thread to stop
+  std::atomic<bool> stop_;
+
+  // The busy polling thread, not joinable in reactor mode
+  std::thread poll_thread_;
+
+  // Request missing messages, null if gap recovery is disabled
+  std::unique_ptr<mold_rerequest_client> client_;
 };
 
 } // namespace itch5
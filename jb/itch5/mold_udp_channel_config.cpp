@@ -0,0 +1,86 @@
+#include "jb/itch5/mold_udp_channel_config.hpp"
+#include <jb/usage.hpp>
+
+#include <sstream>
+
+namespace jb {
+namespace itch5 {
+namespace defaults {
+
+#ifndef JB_ITCH5_DEFAULTS_busy_poll
+#define JB_ITCH5_DEFAULTS_busy_poll false
+#endif // JB_ITCH5_DEFAULTS_busy_poll
+
+#ifndef JB_ITCH5_DEFAULTS_busy_poll_microseconds
+#define JB_ITCH5_DEFAULTS_busy_poll_microseconds 0
+#endif // JB_ITCH5_DEFAULTS_busy_poll_microseconds
+
+#ifndef JB_ITCH5_DEFAULTS_receive_batch_size
+#define JB_ITCH5_DEFAULTS_receive_batch_size 16
+#endif // JB_ITCH5_DEFAULTS_receive_batch_size
+
+bool busy_poll = JB_ITCH5_DEFAULTS_busy_poll;
+int busy_poll_microseconds = JB_ITCH5_DEFAULTS_busy_poll_microseconds;
+int receive_batch_size = JB_ITCH5_DEFAULTS_receive_batch_size;
+
+} // namespace defaults
+
+mold_udp_channel_config::mold_udp_channel_config()
+    : busy_poll(
+          desc("busy-poll")
+              .help("If set, receive packets from a dedicated thread that "
+                    "spins on a non-blocking socket instead of using the "
+                    "Boost.ASIO reactor.  The handler is called from that "
+                    "thread."),
+          this, defaults::busy_poll)
+    , busy_poll_microseconds(
+          desc("busy-poll-microseconds")
+              .help("If not zero, set the SO_BUSY_POLL socket option to this "
+                    "value.  The kernel then polls the device queue for up to "
+                    "this many microseconds on each receive.  Typically "
+                    "requires CAP_NET_ADMIN."),
+          this, defaults::busy_poll_microseconds)
+    , receive_batch_size(
+          desc("receive-batch-size")
+              .help("The maximum number of packets received on each "
+                    "recvmmsg(2) call when --busy-poll is set."),
+          this, defaults::receive_batch_size)
+    , poll_thread(
+          desc("poll-thread", "thread-config")
+              .help("Configure the busy polling thread, typically used to "
+                    "pin the thread to an isolated core."),
+          this, jb::thread_config().name("mold-poll"))
+    , rerequest(
+          desc("rerequest", "mold-rerequest")
+              .help("Configure the recovery of gaps via MoldUDP64 "
+                    "retransmission requests."),
+          this) {
+}
+
+void mold_udp_channel_config::validate() const {
+  if (busy_poll_microseconds() < 0) {
+    std::ostringstream os;
+    os << "--busy-poll-microseconds must be >= 0, value="
+       << busy_poll_microseconds();
+    throw jb::usage(os.str(), 1);
+  }
+  // ... recvmmsg(2) is limited to UIO_MAXIOV messages per call, and
+  // each message gets a 64KiB buffer, so keep this reasonable ...
+  if (receive_batch_size() < 1 or receive_batch_size() > 1024) {
+    std::ostringstream os;
+    os << "--receive-batch-size must be in the [1,1024] range, value="
+       << receive_batch_size();
+    throw jb::usage(os.str(), 1);
+  }
+  poll_thread().validate();
+  rerequest().validate();
+  if (busy_poll() and rerequest().port() != 0) {
+    throw jb::usage(
+        "--busy-poll cannot be combined with --rerequest.port, the gap "
+        "recovery runs on the Boost.ASIO reactor",
+        1);
+  }
+}
+
+} // namespace itch5
+} // namespace jb
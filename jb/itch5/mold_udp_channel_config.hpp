@@ -0,0 +1,43 @@
+#ifndef jb_itch5_mold_udp_channel_config_hpp
+#define jb_itch5_mold_udp_channel_config_hpp
+
+#include <jb/itch5/mold_rerequest_config.hpp>
+#include <jb/config_object.hpp>
+#include <jb/thread_config.hpp>
+
+namespace jb {
+namespace itch5 {
+
+/**
+ * Configure how a jb::itch5::mold_udp_channel receives packets.
+ *
+ * By default the channel uses the Boost.ASIO reactor, that is, the
+ * packets are received (and the handler is called) from whatever
+ * thread runs the io_service.  When @a busy_poll is set the channel
+ * puts the socket in non-blocking mode and dedicates a thread
+ * (configured via @a poll_thread) to spin on recvmmsg(2).  That
+ * avoids the wakeup latency of the reactor, at the cost of burning a
+ * full core.
+ *
+ * Gap recovery (see @a rerequest) runs on the Boost.ASIO reactor, so
+ * it cannot be combined with @a busy_poll.
+ */
+class mold_udp_channel_config : public jb::config_object {
+public:
+  mold_udp_channel_config();
+  config_object_constructors(mold_udp_channel_config);
+
+  void validate() const override;
+
+  jb::config_attribute<mold_udp_channel_config, bool> busy_poll;
+  jb::config_attribute<mold_udp_channel_config, int> busy_poll_microseconds;
+  jb::config_attribute<mold_udp_channel_config, int> receive_batch_size;
+  jb::config_attribute<mold_udp_channel_config, jb::thread_config> poll_thread;
+  jb::config_attribute<mold_udp_channel_config, mold_rerequest_config>
+      rerequest;
+};
+
+} // namespace itch5
+} // namespace jb
+
+#endif // jb_itch5_mold_udp_channel_config_hpp
@@ -0,0 +1,116 @@
+#include "jb/itch5/mold_udp_impairment.hpp"
+
+#include <jb/itch5/base_decoders.hpp>
+#include <jb/itch5/mold_udp_protocol_constants.hpp>
+#include <jb/log.hpp>
+
+#include <cmath>
+#include <limits>
+
+namespace jb {
+namespace itch5 {
+
+mold_udp_impairment::mold_udp_impairment(
+    mold_udp_impairment_config const& cfg, std::string const& name)
+    : cfg_(cfg)
+    , name_(name)
+    , enabled_(cfg.enabled())
+    , generator_(cfg.seed())
+    , burst_remaining_(0)
+    , packets_(0)
+    , dropped_(0)
+    , duplicated_(0)
+    , reordered_(0)
+    , delayed_(0)
+    , held_()
+    , scratch_(1 << 16) {
+}
+
+mold_udp_impairment::action
+mold_udp_impairment::decide(time_point now, boost::asio::const_buffer packet) {
+  ++packets_;
+  // ... always draw the same number of values for each packet, so
+  // changing one probability does not change the schedule for the
+  // other impairments ...
+  double const u_drop = uniform();
+  double const u_burst = uniform();
+  double const u_delay = uniform();
+  double const u_reorder = uniform();
+  double const u_duplicate = uniform();
+
+  if (burst_remaining_ > 0) {
+    --burst_remaining_;
+    ++dropped_;
+    log_event("burst-drop", packet);
+    return action::drop;
+  }
+  if (u_burst < cfg_.burst_probability()) {
+    // ... the burst lengths are geometrically distributed, with the
+    // configured mean, this packet is the first one in the burst ...
+    double const p = 1.0 / cfg_.burst_length();
+    double const extra =
+        p >= 1.0 ? 0.0 : std::floor(std::log1p(-uniform()) / std::log1p(-p));
+    burst_remaining_ = static_cast<std::uint64_t>(extra);
+    ++dropped_;
+    log_event("burst-start", packet);
+    return action::drop;
+  }
+  if (u_drop < cfg_.drop_probability()) {
+    ++dropped_;
+    log_event("drop", packet);
+    return action::drop;
+  }
+
+  auto const data = boost::asio::buffer_cast<char const*>(packet);
+  auto const size = boost::asio::buffer_size(packet);
+  if (u_delay < cfg_.delay_probability()) {
+    ++delayed_;
+    log_event("delay", packet);
+    held_.push_back(held_packet{
+        std::vector<char>(data, data + size),
+        std::numeric_limits<std::uint64_t>::max(),
+        now + std::chrono::microseconds(cfg_.delay_microseconds())});
+    return action::hold;
+  }
+  if (u_reorder < cfg_.reorder_probability()) {
+    ++reordered_;
+    log_event("reorder", packet);
+    auto distance = 1 + generator_() % cfg_.reorder_window();
+    held_.push_back(held_packet{std::vector<char>(data, data + size),
+                                packets_ + distance, time_point::max()});
+    return action::hold;
+  }
+  if (u_duplicate < cfg_.duplicate_probability()) {
+    ++duplicated_;
+    log_event("duplicate", packet);
+    return action::duplicate;
+  }
+  return action::send;
+}
+
+double mold_udp_impairment::uniform() {
+  // ... use the top 53 bits, the std:: distributions are not
+  // guaranteed to produce the same values across implementations ...
+  return (generator_() >> 11) * (1.0 / (std::uint64_t(1) << 53));
+}
+
+void mold_udp_impairment::log_event(
+    char const* event, boost::asio::const_buffer packet) const {
+  auto const size = boost::asio::buffer_size(packet);
+  if (size < mold_udp_protocol::header_size) {
+    JB_LOG(info) << "impairment " << name_ << " " << event
+                 << " packet=" << packets_ << " size=" << size;
+    return;
+  }
+  auto const data = boost::asio::buffer_cast<char const*>(packet);
+  auto seqno = decoder<false, std::uint64_t>::r(
+      size, data, mold_udp_protocol::sequence_number_offset);
+  auto count = decoder<false, std::uint16_t>::r(
+      size, data, mold_udp_protocol::block_count_offset);
+  JB_LOG(info) << "impairment " << name_ << " " << event
+               << " packet=" << packets_ << " seqno=" << seqno
+               << " count=" << count;
+}
+
+} // namespace itch5
+} // namespace jb
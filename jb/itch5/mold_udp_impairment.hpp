@@ -0,0 +1,187 @@
+#ifndef jb_itch5_mold_udp_impairment_hpp
+#define jb_itch5_mold_udp_impairment_hpp
+
+#include <jb/itch5/mold_udp_impairment_config.hpp>
+
+#include <boost/asio/buffer.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace jb {
+namespace itch5 {
+
+/**
+ * Inject network impairments into a stream of MoldUDP64 packets.
+ *
+ * jb::itch5::mold_udp_pacer generates a perfect stream of packets,
+ * which does not exercise the gap detection and recovery code in the
+ * feed handlers.  This class sits between the pacer and the socket,
+ * and drops (individually or in bursts), duplicates, reorders, or
+ * delays the packets.
+ *
+ * The decisions depend only on the seed and the order of the packets,
+ * so the same seed produces the same impairment schedule on every
+ * run.  Each decision is logged, with the MoldUDP64 sequence number
+ * and block count of the packet, so the gap recovery latency can be
+ * measured against the exact schedule.  Use one instance (with
+ * different seeds) for each destination, the primary and secondary
+ * feeds are impaired independently.
+ *
+ * Reordered packets are held until a random number of packets
+ * (between 1 and the reorder window) have been sent.  Delayed packets
+ * are held until the first packet after the delay expires, or until
+ * flush() is called.
+ */
+class mold_udp_impairment {
+public:
+  //@{
+  /**
+   * @name Type traits
+   */
+  typedef std::chrono::steady_clock::time_point time_point;
+  typedef std::chrono::steady_clock::duration duration;
+  //@}
+
+  /**
+   * Constructor.
+   *
+   * @param cfg the impairment probabilities and parameters
+   * @param name identify the destination in the logs
+   */
+  mold_udp_impairment(
+      mold_udp_impairment_config const& cfg, std::string const& name);
+
+  /**
+   * Send a packet, possibly impaired.
+   *
+   * @param now the current wall-clock time, used to release delayed
+   * packets
+   * @param buffers the MoldUDP64 packet, possibly as a gather list
+   * @param sink a functor to send the packets, the signature must be
+   * compatible with void(auto buffers), where buffers meets the
+   * requirements of a Boost.Asio ConstBufferSequence
+   *
+   * @tparam const_buffer_sequence the type of @a buffers
+   * @tparam packet_sink_type the type of @a sink
+   */
+  template <typename const_buffer_sequence, typename packet_sink_type>
+  void handle_packet(
+      time_point now, const_buffer_sequence const& buffers,
+      packet_sink_type& sink) {
+    if (not enabled_) {
+      sink(buffers);
+      return;
+    }
+    // ... the decisions need a contiguous packet ...
+    auto size =
+        boost::asio::buffer_copy(boost::asio::buffer(scratch_), buffers);
+    boost::asio::const_buffer packet(scratch_.data(), size);
+    switch (decide(now, packet)) {
+    case action::send:
+      sink(boost::asio::const_buffers_1(packet));
+      break;
+    case action::duplicate:
+      sink(boost::asio::const_buffers_1(packet));
+      sink(boost::asio::const_buffers_1(packet));
+      break;
+    case action::hold:
+    case action::drop:
+      break;
+    }
+    release(now, sink);
+  }
+
+  /**
+   * Send all the packets held for reordering or delay.
+   *
+   * @tparam packet_sink_type please see handle_packet()
+   */
+  template <typename packet_sink_type>
+  void flush(packet_sink_type& sink) {
+    for (auto const& p : held_) {
+      sink(boost::asio::buffer(p.bytes));
+    }
+    held_.clear();
+  }
+
+  //@{
+  /**
+   * @name Accessors
+   */
+  std::uint64_t packets() const {
+    return packets_;
+  }
+  std::uint64_t dropped() const {
+    return dropped_;
+  }
+  std::uint64_t duplicated() const {
+    return duplicated_;
+  }
+  std::uint64_t reordered() const {
+    return reordered_;
+  }
+  std::uint64_t delayed() const {
+    return delayed_;
+  }
+  std::size_t held() const {
+    return held_.size();
+  }
+  //@}
+
+private:
+  /// The decision for each packet
+  enum class action { send, drop, duplicate, hold };
+
+  /// A packet held for reordering or delay
+  struct held_packet {
+    std::vector<char> bytes;
+    std::uint64_t release_after;
+    time_point deadline;
+  };
+
+  /// Decide what to do with the packet, holding it if needed
+  action decide(time_point now, boost::asio::const_buffer packet);
+
+  /// Send the held packets that are due
+  template <typename packet_sink_type>
+  void release(time_point now, packet_sink_type& sink) {
+    for (auto i = held_.begin(); i != held_.end();) {
+      if (packets_ >= i->release_after or now >= i->deadline) {
+        sink(boost::asio::buffer(i->bytes));
+        i = held_.erase(i);
+      } else {
+        ++i;
+      }
+    }
+  }
+
+  /// Return a uniformly distributed number in [0,1)
+  double uniform();
+
+  /// Log an impairment event
+  void log_event(char const* event, boost::asio::const_buffer packet) const;
+
+private:
+  mold_udp_impairment_config cfg_;
+  std::string name_;
+  bool enabled_;
+  std::mt19937_64 generator_;
+  std::uint64_t burst_remaining_;
+  std::uint64_t packets_;
+  std::uint64_t dropped_;
+  std::uint64_t duplicated_;
+  std::uint64_t reordered_;
+  std::uint64_t delayed_;
+  std::list<held_packet> held_;
+  std::vector<char> scratch_;
+};
+
+} // namespace itch5
+} // namespace jb
+
+#endif // jb_itch5_mold_udp_impairment_hpp
@@ -0,0 +1,122 @@
+#include "jb/itch5/mold_udp_impairment_config.hpp"
+
+#include <sstream>
+
+namespace jb {
+namespace itch5 {
+/// Default the default values for ITCH-5.x configuation.
+namespace defaults {
+
+#ifndef JB_ITCH5_DEFAULTS_impairment_seed
+#define JB_ITCH5_DEFAULTS_impairment_seed 1
+#endif // JB_ITCH5_DEFAULTS_impairment_seed
+
+#ifndef JB_ITCH5_DEFAULTS_impairment_burst_length
+#define JB_ITCH5_DEFAULTS_impairment_burst_length 4.0
+#endif // JB_ITCH5_DEFAULTS_impairment_burst_length
+
+#ifndef JB_ITCH5_DEFAULTS_impairment_reorder_window
+#define JB_ITCH5_DEFAULTS_impairment_reorder_window 4
+#endif // JB_ITCH5_DEFAULTS_impairment_reorder_window
+
+#ifndef JB_ITCH5_DEFAULTS_impairment_delay_microseconds
+#define JB_ITCH5_DEFAULTS_impairment_delay_microseconds 1000
+#endif // JB_ITCH5_DEFAULTS_impairment_delay_microseconds
+
+unsigned int impairment_seed = JB_ITCH5_DEFAULTS_impairment_seed;
+double impairment_burst_length = JB_ITCH5_DEFAULTS_impairment_burst_length;
+int impairment_reorder_window = JB_ITCH5_DEFAULTS_impairment_reorder_window;
+int impairment_delay_microseconds =
+    JB_ITCH5_DEFAULTS_impairment_delay_microseconds;
+
+} // namespace defaults
+
+namespace {
+/// Validate a probability and report the invalid value
+void check_probability(char const* name, double p) {
+  if (p >= 0 and p <= 1) {
+    return;
+  }
+  std::ostringstream os;
+  os << "--" << name << " must be in the [0,1] range, value=" << p;
+  throw jb::usage{os.str(), 1};
+}
+} // anonymous namespace
+
+mold_udp_impairment_config::mold_udp_impairment_config()
+    : seed(
+          desc("seed").help(
+              "Seed the pseudo-random number generator, the same seed "
+              "produces the same impairment schedule."),
+          this, defaults::impairment_seed)
+    , drop_probability(
+          desc("drop-probability")
+              .help("The probability of dropping each packet."),
+          this, 0.0)
+    , burst_probability(
+          desc("burst-probability")
+              .help("The probability that a packet starts a burst of "
+                    "losses, all the packets in a burst are dropped."),
+          this, 0.0)
+    , burst_length(
+          desc("burst-length")
+              .help("The average number of packets dropped in a burst, "
+                    "the lengths are geometrically distributed."),
+          this, defaults::impairment_burst_length)
+    , duplicate_probability(
+          desc("duplicate-probability")
+              .help("The probability of sending a packet twice."),
+          this, 0.0)
+    , reorder_probability(
+          desc("reorder-probability")
+              .help("The probability of holding a packet, and sending it "
+                    "after some of the packets that follow it."),
+          this, 0.0)
+    , reorder_window(
+          desc("reorder-window")
+              .help("The maximum number of packets sent before a "
+                    "reordered packet."),
+          this, defaults::impairment_reorder_window)
+    , delay_probability(
+          desc("delay-probability")
+              .help("The probability of delaying a packet."),
+          this, 0.0)
+    , delay_microseconds(
+          desc("delay-microseconds")
+              .help("How long are the packets delayed.  The delayed "
+                    "packets are sent with the first packet after the "
+                    "delay expires."),
+          this, defaults::impairment_delay_microseconds) {
+}
+
+void mold_udp_impairment_config::validate() const {
+  check_probability("drop-probability", drop_probability());
+  check_probability("burst-probability", burst_probability());
+  check_probability("duplicate-probability", duplicate_probability());
+  check_probability("reorder-probability", reorder_probability());
+  check_probability("delay-probability", delay_probability());
+  if (not(burst_length() >= 1.0)) {
+    std::ostringstream os;
+    os << "--burst-length must be >= 1.0, value=" << burst_length();
+    throw jb::usage{os.str(), 1};
+  }
+  if (reorder_window() < 1) {
+    std::ostringstream os;
+    os << "--reorder-window must be positive, value=" << reorder_window();
+    throw jb::usage{os.str(), 1};
+  }
+  if (delay_microseconds() < 0) {
+    std::ostringstream os;
+    os << "--delay-microseconds must be >= 0, value=" << delay_microseconds();
+    throw jb::usage{os.str(), 1};
+  }
+}
+
+bool mold_udp_impairment_config::enabled() const {
+  return drop_probability() > 0 or burst_probability() > 0 or
+         duplicate_probability() > 0 or reorder_probability() > 0 or
+         delay_probability() > 0;
+}
+
+} // namespace itch5
+} // namespace jb
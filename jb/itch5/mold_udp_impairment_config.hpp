@@ -0,0 +1,37 @@
+#ifndef jb_itch5_mold_udp_impairment_config_hpp
+#define jb_itch5_mold_udp_impairment_config_hpp
+
+#include <jb/config_object.hpp>
+
+namespace jb {
+namespace itch5 {
+
+/**
+ * Configuration object for the jb::itch5::mold_udp_impairment class.
+ */
+class mold_udp_impairment_config : public jb::config_object {
+public:
+  mold_udp_impairment_config();
+  config_object_constructors(mold_udp_impairment_config);
+
+  void validate() const override;
+
+  /// Return true if any impairment is enabled
+  bool enabled() const;
+
+  jb::config_attribute<mold_udp_impairment_config, unsigned int> seed;
+  jb::config_attribute<mold_udp_impairment_config, double> drop_probability;
+  jb::config_attribute<mold_udp_impairment_config, double> burst_probability;
+  jb::config_attribute<mold_udp_impairment_config, double> burst_length;
+  jb::config_attribute<mold_udp_impairment_config, double>
+      duplicate_probability;
+  jb::config_attribute<mold_udp_impairment_config, double> reorder_probability;
+  jb::config_attribute<mold_udp_impairment_config, int> reorder_window;
+  jb::config_attribute<mold_udp_impairment_config, double> delay_probability;
+  jb::config_attribute<mold_udp_impairment_config, int> delay_microseconds;
+};
+
+} // namespace itch5
+} // namespace jb
+
+#endif // jb_itch5_mold_udp_impairment_config_hpp
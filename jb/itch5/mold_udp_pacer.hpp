@@ -11,6 +11,8 @@
 
 #include <boost/asio/buffer.hpp>
 
+#include <vector>
+
 namespace jb {
 namespace itch5 {
 
@@ -30,6 +32,22 @@ namespace itch5 {
  * into a single large packet.  If the messages are separated in time
  * the class blocks until enough wall-clock time has elapsed.
  *
+ * The interval between messages can be scaled by a speed multiplier,
+ * for example, to replay a full day of data in a couple of hours.  In
+ * unthrottled mode the class never blocks, but the messages are
+ * grouped into packets exactly as they would be in paced mode.
+ *
+ * By default the messages are copied into a buffer as they are
+ * packed into the current packet.  In zero-copy mode the class builds
+ * a gather list instead: the packet header, and the 2-byte length and
+ * original location of each message.  The sink sends the list with a
+ * single sendmsg(2) call (which Boost.Asio does for any buffer
+ * sequence).  The messages must remain valid until the packet is
+ * sent, for example, when they are read from a
+ * jb::itch5::message_store.  Boost.Asio uses at most 64 buffers per
+ * call, so in this mode the packets are flushed after 31 messages,
+ * even if the MTU would allow more.
+ *
  * @tparam clock_type a dependency injection point to make this class
  * testable.  Normally the class is simply used with a
  * std::chrono::steady_clock.  Under test, it is convenient to be able
@@ -75,13 +93,23 @@ public:
       : last_send_{std::chrono::microseconds(0)}
       , max_delay_(std::chrono::microseconds(cfg.maximum_delay_microseconds()))
       , mtu_(cfg.maximum_transmission_unit())
+      , speed_(cfg.speed())
+      , unthrottled_(cfg.unthrottled())
+      , zero_copy_(cfg.zero_copy())
       , packet_(rawbuf, rawbufsize)
       , packet_size_(mold_udp_protocol::header_size)
       , first_block_(0)
       , first_block_ts_{std::chrono::microseconds(0)}
-      , block_count_(0) {
+      , block_count_(0)
+      , gather_() {
     boost::asio::buffer_copy(
         packet_, boost::asio::buffer(session_id.c_str(), session_id.wire_size));
+    if (zero_copy_) {
+      // ... allocate the gather list once, the header is always the
+      // first element ...
+      gather_.reserve(max_gather_buffers);
+      gather_.emplace_back(rawbuf, mold_udp_protocol::header_size);
+    }
   }
 
   /**
@@ -93,11 +121,14 @@ public:
    * used to pace the outgoing MoldUDP64 packets
    * @param sink a functor to send the MoldUDP64 packets
    * @param sleeper a functor to sleep and effectively pace the
-   * messages
+   * messages, it is not called in unthrottled mode.  See
+   * jb::itch5::pacing_engine for an accurate implementation.
    *
    * @tparam message_sink_type the type of the @a sink functor.  The
    * signature must be compatible with void(auto buffers) where
    * buffers meets the requirements of a Boost.Asio ConstBufferSequence.
+   * In zero-copy mode the sequence refers to the original messages,
+   * it is only valid during the call.
    * @tparam sleep_functor_type the type of the sleeper function, the
    * signature must be compatible with void(clock_type::duration const&)
    */
@@ -113,7 +144,7 @@ public:
       // we would likely flush the first message always ...
       last_send_ = msghdr.timestamp;
     }
-    auto elapsed = msghdr.timestamp.ts - last_send_.ts;
+    auto elapsed = scaled(msghdr.timestamp.ts - last_send_.ts);
     if (elapsed < max_delay_) {
       // ... save the message to send later, potentially flushing if
       // the queue is big enough ...
@@ -123,7 +154,9 @@ public:
     // ... flush whatever is in the queue ...
     flush(msghdr.timestamp, sink);
     // ... until the timer has expired ...
-    sleeper(elapsed);
+    if (not unthrottled_) {
+      sleeper(elapsed);
+    }
     // ... send the message immediately ...
     coalesce(ts, msg, msghdr.timestamp, sink);
   }
@@ -160,6 +193,15 @@ public:
   }
 
 private:
+  /// Convert an interval in the original feed to wall-clock time
+  duration scaled(std::chrono::nanoseconds d) const {
+    if (speed_ == 1.0) {
+      return std::chrono::duration_cast<duration>(d);
+    }
+    return std::chrono::duration_cast<duration>(
+        std::chrono::duration<double, std::nano>(d) / speed_);
+  }
+
   /**
    * Add another message to the current queue, flushing first if
    * necessary.
@@ -189,6 +231,21 @@ private:
       first_block_ = msg.count();
       first_block_ts_ = ts;
     }
+    if (zero_copy_) {
+      // ... the block header goes in the buffer, right after the
+      // packet header, and the payload is sent from the original
+      // location ...
+      boost::asio::mutable_buffer block_header =
+          packet_ + (mold_udp_protocol::header_size + 2 * block_count_);
+      encoder<true, std::uint16_t>::w(
+          buffer_size(block_header),
+          boost::asio::buffer_cast<void*>(block_header), 0, msg.len());
+      gather_.emplace_back(boost::asio::buffer_cast<void*>(block_header), 2);
+      gather_.emplace_back(msg.buf(), msg.len());
+      packet_size_ += msg.len() + 2;
+      block_count_++;
+      return;
+    }
     // ... append the message as a new block in the MoldUDP packet,
     // first update the block header ...
     boost::asio::mutable_buffer block_header = packet_ + packet_size_;
@@ -229,7 +286,12 @@ private:
   template <typename message_sink_type>
   void flush_impl(timestamp ts, message_sink_type& sink) {
     fillup_header_fields();
-    sink(boost::asio::buffer(packet_, packet_size_));
+    if (zero_copy_) {
+      sink(gather_list{gather_.data(), gather_.data() + gather_.size()});
+      gather_.resize(1);
+    } else {
+      sink(boost::asio::buffer(packet_, packet_size_));
+    }
     last_send_ = ts;
     first_block_ = first_block_ + block_count_;
     block_count_ = 0;
@@ -247,13 +309,43 @@ private:
     if (block_size + 2 + packet_size_ >= std::size_t(mtu_)) {
       return true;
     }
+    if (zero_copy_ and gather_.size() + 2 > max_gather_buffers) {
+      return true;
+    }
     return block_count_ == std::numeric_limits<std::uint16_t>::max();
   }
 
+  /**
+   * A non-owning view of the gather list.
+   *
+   * Meets the requirements of a Boost.Asio ConstBufferSequence
+   * without copying the list for each packet.
+   */
+  struct gather_list {
+    typedef boost::asio::const_buffer value_type;
+    typedef boost::asio::const_buffer const* const_iterator;
+
+    const_iterator begin() const {
+      return b;
+    }
+    const_iterator end() const {
+      return e;
+    }
+
+    const_iterator b;
+    const_iterator e;
+  };
+
+  /// Boost.Asio sends at most this many buffers in a single call
+  static constexpr std::size_t max_gather_buffers = 64;
+
 private:
   jb::itch5::timestamp last_send_;
   duration max_delay_;
   int mtu_;
+  double speed_;
+  bool unthrottled_;
+  bool zero_copy_;
 
   // Use a simple raw buffer to hold the packet, this is good enough
   // because MoldUDP64 can only operate on UDP packets, which never
@@ -267,6 +359,9 @@ private:
   std::uint32_t first_block_;
   timestamp first_block_ts_;
   std::uint16_t block_count_;
+
+  // The header, block headers, and payloads in zero-copy mode
+  std::vector<boost::asio::const_buffer> gather_;
 };
 
 } // namespace itch5
@@ -41,8 +41,48 @@ namespace defaults {
 #define JB_ITCH5_DEFAULTS_maximum_transmission_unit 508
 #endif // JB_ITCH5_DEFAULTS_maximum_transmission_unit
 
+#ifndef JB_ITCH5_DEFAULTS_pacer_speed
+#define JB_ITCH5_DEFAULTS_pacer_speed 1.0
+#endif // JB_ITCH5_DEFAULTS_pacer_speed
+
+#ifndef JB_ITCH5_DEFAULTS_pacer_unthrottled
+#define JB_ITCH5_DEFAULTS_pacer_unthrottled false
+#endif // JB_ITCH5_DEFAULTS_pacer_unthrottled
+
+/*
+ * std::this_thread::sleep_for() typically wakes up 50 to 100
+ * microseconds late, spin for the last part of each wait.
+ */
+#ifndef JB_ITCH5_DEFAULTS_pacer_spin_microseconds
+#define JB_ITCH5_DEFAULTS_pacer_spin_microseconds 100
+#endif // JB_ITCH5_DEFAULTS_pacer_spin_microseconds
+
+#ifndef JB_ITCH5_DEFAULTS_pacer_maximum_sleep_milliseconds
+#define JB_ITCH5_DEFAULTS_pacer_maximum_sleep_milliseconds 10000
+#endif // JB_ITCH5_DEFAULTS_pacer_maximum_sleep_milliseconds
+
+/*
+ * The replay spins on jb::tsc_clock, recalibrate it about as often
+ * as the feed handlers do.
+ */
+#ifndef JB_ITCH5_DEFAULTS_pacer_recalibration_period_milliseconds
+#define JB_ITCH5_DEFAULTS_pacer_recalibration_period_milliseconds 100
+#endif // JB_ITCH5_DEFAULTS_pacer_recalibration_period_milliseconds
+
+#ifndef JB_ITCH5_DEFAULTS_pacer_zero_copy
+#define JB_ITCH5_DEFAULTS_pacer_zero_copy false
+#endif // JB_ITCH5_DEFAULTS_pacer_zero_copy
+
 int maximum_delay_microseconds = JB_ITCH5_DEFAULTS_maximum_delay_microseconds;
 int maximum_transmission_unit = JB_ITCH5_DEFAULTS_maximum_transmission_unit;
+double pacer_speed = JB_ITCH5_DEFAULTS_pacer_speed;
+bool pacer_unthrottled = JB_ITCH5_DEFAULTS_pacer_unthrottled;
+int pacer_spin_microseconds = JB_ITCH5_DEFAULTS_pacer_spin_microseconds;
+int pacer_maximum_sleep_milliseconds =
+    JB_ITCH5_DEFAULTS_pacer_maximum_sleep_milliseconds;
+int pacer_recalibration_period_milliseconds =
+    JB_ITCH5_DEFAULTS_pacer_recalibration_period_milliseconds;
+bool pacer_zero_copy = JB_ITCH5_DEFAULTS_pacer_zero_copy;
 
 } // namespace defaults
 
@@ -60,7 +100,44 @@ mold_udp_pacer_config::mold_udp_pacer_config()
                   "If your Ethernet network is configured for an MTU of 1500, "
                   "use 1432 for this value.  Beware of VLANs and other details "
                   "that may consume your available bytes."),
-          this, defaults::maximum_transmission_unit) {
+          this, defaults::maximum_transmission_unit)
+    , speed(
+          desc("speed").help(
+              "Replay the messages this many times faster than the "
+              "original feed, e.g., 2.0 replays a full day in 12 hours.  "
+              "Values smaller than 1.0 replay the feed slower."),
+          this, defaults::pacer_speed)
+    , unthrottled(
+          desc("unthrottled")
+              .help("Send the messages as fast as possible, ignoring the "
+                    "timestamps.  The messages are still grouped into "
+                    "packets as if they were paced."),
+          this, defaults::pacer_unthrottled)
+    , spin_microseconds(
+          desc("spin-microseconds")
+              .help("Busy-wait for the last portion of each wait, "
+                    "sleeping is not accurate enough to reproduce "
+                    "microbursts.  Set to 0 to always sleep."),
+          this, defaults::pacer_spin_microseconds)
+    , maximum_sleep_milliseconds(
+          desc("maximum-sleep-milliseconds")
+              .help("Never wait for more than this time between two "
+                    "messages.  The feeds have long idle periods, waiting "
+                    "for hours to do something interesting is boring."),
+          this, defaults::pacer_maximum_sleep_milliseconds)
+    , recalibration_period_milliseconds(
+          desc("recalibration-period-milliseconds")
+              .help("How often the clock used to spin is recalibrated, "
+                    "between two waits.  Long replays drift otherwise.  "
+                    "Set to 0 to calibrate the clock only once."),
+          this, defaults::pacer_recalibration_period_milliseconds)
+    , zero_copy(
+          desc("zero-copy")
+              .help("Send the messages from their original location, "
+                    "using a gather list, instead of copying them into "
+                    "each packet.  Requires an in-memory source, e.g., "
+                    "a preloaded input file."),
+          this, defaults::pacer_zero_copy) {
 }
 
 void mold_udp_pacer_config::validate() const {
@@ -92,6 +169,31 @@ void mold_udp_pacer_config::validate() const {
        << " (24 hours)] range, value=" << maximum_delay_microseconds();
     throw jb::usage{os.str(), 1};
   }
+
+  // ... the speed multiplier must be positive, use unthrottled to
+  // replay as fast as possible ...
+  if (not(speed() > 0)) {
+    std::ostringstream os;
+    os << "--speed must be positive, value=" << speed();
+    throw jb::usage{os.str(), 1};
+  }
+  if (spin_microseconds() < 0) {
+    std::ostringstream os;
+    os << "--spin-microseconds must be >= 0, value=" << spin_microseconds();
+    throw jb::usage{os.str(), 1};
+  }
+  if (maximum_sleep_milliseconds() <= 0) {
+    std::ostringstream os;
+    os << "--maximum-sleep-milliseconds must be positive, value="
+       << maximum_sleep_milliseconds();
+    throw jb::usage{os.str(), 1};
+  }
+  if (recalibration_period_milliseconds() < 0) {
+    std::ostringstream os;
+    os << "--recalibration-period-milliseconds must be >= 0, value="
+       << recalibration_period_milliseconds();
+    throw jb::usage{os.str(), 1};
+  }
 }
 
 } // namespace itch5
@@ -18,6 +18,13 @@ public:
 
   jb::config_attribute<mold_udp_pacer_config, int> maximum_delay_microseconds;
   jb::config_attribute<mold_udp_pacer_config, int> maximum_transmission_unit;
+  jb::config_attribute<mold_udp_pacer_config, double> speed;
+  jb::config_attribute<mold_udp_pacer_config, bool> unthrottled;
+  jb::config_attribute<mold_udp_pacer_config, int> spin_microseconds;
+  jb::config_attribute<mold_udp_pacer_config, int> maximum_sleep_milliseconds;
+  jb::config_attribute<mold_udp_pacer_config, int>
+      recalibration_period_milliseconds;
+  jb::config_attribute<mold_udp_pacer_config, bool> zero_copy;
 };
 
 } // namespace itch5
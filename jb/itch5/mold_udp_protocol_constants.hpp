@@ -1,6 +1,8 @@
 #ifndef jb_itch5_mold_udp_protocol_constants_hpp
 #define jb_itch5_mold_udp_protocol_constants_hpp
 
+#include <cstddef>
+
 namespace jb {
 namespace itch5 {
 /**
@@ -29,6 +31,15 @@ constexpr std::size_t block_count_offset = sequence_number_offset + 8;
  */
 constexpr std::size_t header_size = block_count_offset + 2;
 
+/**
+ * The total size of a retransmission request.
+ *
+ * A request has the same layout as the header: the session id, the
+ * first sequence number requested, and the number of messages
+ * requested.
+ */
+constexpr std::size_t request_size = header_size;
+
 } // namespace mold_udp_protocol
 } // namespace itch5
 } // namespace jb
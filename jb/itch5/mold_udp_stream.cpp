@@ -0,0 +1,187 @@
+#include "jb/itch5/mold_udp_stream.hpp"
+
+#include <jb/itch5/base_decoders.hpp>
+#include <jb/itch5/mold_udp_protocol_constants.hpp>
+#include <jb/log.hpp>
+
+#include <algorithm>
+#include <utility>
+
+namespace jb {
+namespace itch5 {
+
+mold_udp_stream::mold_udp_stream(buffer_handler&& handler)
+    : handler_(std::move(handler))
+    , expected_sequence_number_(0)
+    , synchronized_(false)
+    , message_offset_(0)
+    , gap_handler_()
+    , max_buffered_messages_(0)
+    , reorder_buffer_()
+    , requested_until_(0)
+    , duplicate_messages_(0)
+    , lost_messages_(0)
+    , messages_metric_(jb::metrics::default_registry().make_counter(
+          "mold_messages_received",
+          "the number of messages received in MoldUDP64 streams"))
+    , gaps_metric_(jb::metrics::default_registry().make_counter(
+          "mold_gaps", "the number of gaps detected in MoldUDP64 streams"))
+    , duplicates_metric_(jb::metrics::default_registry().make_counter(
+          "mold_duplicate_messages",
+          "the number of duplicate messages discarded in MoldUDP64 streams"))
+    , lost_metric_(jb::metrics::default_registry().make_counter(
+          "mold_lost_messages",
+          "the number of messages given up as lost in MoldUDP64 streams")) {
+}
+
+void mold_udp_stream::enable_recovery(
+    gap_handler&& handler, std::size_t max_buffered_messages) {
+  gap_handler_ = std::move(handler);
+  max_buffered_messages_ = max_buffered_messages;
+}
+
+void mold_udp_stream::process_packet(
+    std::chrono::steady_clock::time_point recv_ts, char const* buffer,
+    std::size_t bytes_received) {
+  // ... parse the sequence number of the first message in the
+  // MoldUDP64 packet ...
+  auto sequence_number = jb::itch5::decoder<true, std::uint64_t>::r(
+      bytes_received, buffer,
+      jb::itch5::mold_udp_protocol::sequence_number_offset);
+  // ... and parse the number of blocks in the MoldUDP64 packet ...
+  auto block_count = jb::itch5::decoder<true, std::uint16_t>::r(
+      bytes_received, buffer, jb::itch5::mold_udp_protocol::block_count_offset);
+
+  if (gap_handler_) {
+    if (not synchronized_) {
+      // ... the receiver may join the session at any point, start
+      // from the first packet received, otherwise the whole history
+      // of the session would be requested ...
+      JB_LOG(info) << "Starting MoldUDP64 stream at seqno=" << sequence_number;
+      expected_sequence_number_ = sequence_number;
+      requested_until_ = sequence_number;
+      synchronized_ = true;
+    }
+    // ... with recovery enabled each message is delivered, buffered
+    // or discarded, depending on its sequence number ...
+    std::size_t offset = jb::itch5::mold_udp_protocol::header_size;
+    for (std::size_t block = 0; block != block_count; ++block) {
+      auto message_size = jb::itch5::decoder<true, std::uint16_t>::r(
+          bytes_received, buffer, offset);
+      offset += 2;
+      if (offset + message_size > bytes_received) {
+        JB_LOG(info) << "Truncated MoldUDP64 packet, seqno=" << sequence_number
+                     << ", block=" << block;
+        break;
+      }
+      auto message_seqno = sequence_number + block;
+      if (message_seqno < expected_sequence_number_) {
+        ++duplicate_messages_;
+        duplicates_metric_.inc();
+      } else if (message_seqno == expected_sequence_number_) {
+        deliver(recv_ts, buffer + offset, message_size);
+      } else {
+        buffer_message(buffer, message_seqno, buffer + offset, message_size);
+      }
+      offset += message_size;
+    }
+    drain_buffer(recv_ts);
+    return;
+  }
+
+  // ... if the message is out of order we simply print the problem,
+  // in a more realistic application we would need to reorder them
+  // and gap fill if needed, and sometimes do even more complicated
+  // things ...
+  if (sequence_number != expected_sequence_number_) {
+    gaps_metric_.inc();
+    JB_LOG(info) << "Mismatched sequence number, expected="
+                 << expected_sequence_number_ << ", got=" << sequence_number;
+  }
+
+  //  Keep track of where each ITCH-5.0 message starts in the
+  //  MoldUDP64 block ...
+  std::size_t offset = jb::itch5::mold_udp_protocol::header_size;
+  // ... process each message in the MoldUDP64 packet, in order ...
+  for (std::size_t block = 0; block != block_count; ++block) {
+    // ... parse the block size ...
+    auto message_size = jb::itch5::decoder<true, std::uint16_t>::r(
+        bytes_received, buffer, offset);
+    // ... increment the offset into the MoldUDP64 packet, this is
+    // the start of the ITCH-5.x message ...
+    offset += 2;
+    // ... process the buffer ...
+    handler_(
+        recv_ts, expected_sequence_number_, message_offset_, buffer + offset,
+        message_size);
+
+    // ... increment counters to reflect that this message was
+    // proceesed ...
+    sequence_number++;
+    message_offset_ += message_size;
+    offset += message_size;
+  }
+  messages_metric_.inc(block_count);
+  // ... since we are not dealing with gaps, or message reordering
+  // just reset the next expected number ...
+  expected_sequence_number_ = sequence_number;
+}
+
+void mold_udp_stream::deliver(
+    std::chrono::steady_clock::time_point recv_ts, char const* msg,
+    std::size_t msglen) {
+  handler_(recv_ts, expected_sequence_number_, message_offset_, msg, msglen);
+  messages_metric_.inc();
+  ++expected_sequence_number_;
+  message_offset_ += msglen;
+}
+
+void mold_udp_stream::buffer_message(
+    char const* session, std::uint64_t sequence_number, char const* msg,
+    std::size_t msglen) {
+  auto r = reorder_buffer_.emplace(sequence_number, std::string(msg, msglen));
+  if (not r.second) {
+    ++duplicate_messages_;
+    duplicates_metric_.inc();
+    return;
+  }
+  // ... request any messages between the last one received (or
+  // requested) and this one ...
+  auto first = std::max(expected_sequence_number_, requested_until_);
+  if (sequence_number > first) {
+    gaps_metric_.inc();
+    gap_handler_(session, first, sequence_number - first);
+  }
+  requested_until_ = std::max(requested_until_, sequence_number + 1);
+}
+
+void mold_udp_stream::drain_buffer(
+    std::chrono::steady_clock::time_point recv_ts) {
+  while (not reorder_buffer_.empty()) {
+    auto i = reorder_buffer_.begin();
+    if (i->first < expected_sequence_number_) {
+      ++duplicate_messages_;
+      duplicates_metric_.inc();
+      reorder_buffer_.erase(i);
+      continue;
+    }
+    if (i->first != expected_sequence_number_) {
+      if (reorder_buffer_.size() <= max_buffered_messages_) {
+        return;
+      }
+      // ... the reorder buffer is too large, give up on the oldest
+      // gap, the book is probably corrupt from here on, but that is
+      // better than running out of memory ...
+      JB_LOG(warning) << "Giving up on MoldUDP64 gap ["
+                      << expected_sequence_number_ << "," << i->first << ")";
+      lost_messages_ += i->first - expected_sequence_number_;
+      lost_metric_.inc(i->first - expected_sequence_number_);
+      expected_sequence_number_ = i->first;
+    }
+    deliver(recv_ts, i->second.data(), i->second.size());
+    reorder_buffer_.erase(i);
+  }
+}
+
+} // namespace itch5
+} // namespace jb
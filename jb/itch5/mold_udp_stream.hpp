@@ -0,0 +1,169 @@
+#ifndef jb_itch5_mold_udp_stream_hpp
+#define jb_itch5_mold_udp_stream_hpp
+
+#include <jb/metrics.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+
+namespace jb {
+namespace itch5 {
+
+/**
+ * Break down MoldUDP64 packets into ITCH-5.0 messages.
+ *
+ * This class keeps track of the state of a MoldUDP64 stream (the
+ * next expected sequence number, and the offset of each message in
+ * the stream) and invokes a handler for each message in the packets.
+ * It does not care how the packets are received, so it is shared by
+ * all the receive paths, e.g., jb::itch5::mold_udp_channel and
+ * jb::itch5::packet_mmap_channel.
+ *
+ * By default gaps and duplicates are simply logged, and all the
+ * messages are passed to the handler as they arrive.  If recovery is
+ * enabled (see enable_recovery()) the messages are delivered strictly
+ * in sequence number order: duplicates are discarded, and messages
+ * received after a gap are kept in a reorder buffer until the gap is
+ * filled.  The stream starts at the sequence number of the first
+ * packet received, a receiver that joins a session in progress does
+ * not request the messages sent before it joined.
+ *
+ * The messages, gaps, duplicates and lost messages are also counted in
+ * jb::metrics::default_registry(), added up across all the streams in
+ * the process.
+ */
+class mold_udp_stream {
+public:
+  /**
+   * A callback function type to process any received ITCH-5.0
+   * messages
+   *
+   * The parameters represent (in order)
+   * - When was the MoldUDP64 packet containing this message received
+   * - The sequence number for this particular message
+   * - The offset (in bytes) from the beginning of the MoldUDP64
+   * stream for this message
+   * - The message, including the ITCH-5.0 headers but excluding any
+   * MoldUDP64 headers.
+   * - The size of the message, in bytes.
+   */
+  typedef std::function<void(
+      std::chrono::steady_clock::time_point, std::uint64_t, std::size_t,
+      char const*, std::size_t)>
+      buffer_handler;
+
+  /**
+   * A callback function type to request the retransmission of
+   * missing messages.
+   *
+   * The parameters represent (in order)
+   * - The session id, mold_udp_protocol::session_id_size bytes
+   * - The sequence number of the first missing message
+   * - The number of missing messages
+   */
+  typedef std::function<void(char const*, std::uint64_t, std::uint64_t)>
+      gap_handler;
+
+  /// Constructor
+  explicit mold_udp_stream(buffer_handler&& handler);
+
+  /**
+   * Enable gap recovery.
+   *
+   * @param handler invoked each time a new gap is detected
+   * @param max_buffered_messages the maximum size of the reorder
+   * buffer, if it grows larger than this the stream gives up on the
+   * oldest gap and reports the messages as lost
+   */
+  void
+  enable_recovery(gap_handler&& handler, std::size_t max_buffered_messages);
+
+  /// The sequence number of the next message to deliver
+  std::uint64_t expected_sequence_number() const {
+    return expected_sequence_number_;
+  }
+
+  /// The number of duplicate messages discarded, only with recovery
+  std::uint64_t duplicate_messages() const {
+    return duplicate_messages_;
+  }
+
+  /// The number of messages given up as lost, only with recovery
+  std::uint64_t lost_messages() const {
+    return lost_messages_;
+  }
+
+  /**
+   * Break down a MoldUDP64 packet and invoke the handler for each
+   * message.
+   *
+   * @param recv_ts when was the packet received
+   * @param buffer the contents of the packet
+   * @param bytes_received the size of the packet
+   */
+  void process_packet(
+      std::chrono::steady_clock::time_point recv_ts, char const* buffer,
+      std::size_t bytes_received);
+
+private:
+  /// Invoke the handler for the next message in the stream
+  void deliver(
+      std::chrono::steady_clock::time_point recv_ts, char const* msg,
+      std::size_t msglen);
+
+  /// Keep a message received after a gap, request the gap if needed
+  void buffer_message(
+      char const* session, std::uint64_t sequence_number, char const* msg,
+      std::size_t msglen);
+
+  /// Deliver any buffered messages that are now in sequence
+  void drain_buffer(std::chrono::steady_clock::time_point recv_ts);
+
+private:
+  // The callback handler
+  buffer_handler handler_;
+
+  // The next sequence number expected from the MoldUDP64 stream
+  std::uint64_t expected_sequence_number_;
+
+  // With recovery enabled, true once the first packet has set the
+  // expected sequence number
+  bool synchronized_;
+
+  // The offset (in bytes) since the beginning of the MoldUDP64
+  // stream, mostly for logging.
+  std::size_t message_offset_;
+
+  // If set, gap recovery is enabled and this is called for new gaps
+  gap_handler gap_handler_;
+
+  // The maximum number of messages in the reorder buffer
+  std::size_t max_buffered_messages_;
+
+  // Messages received after a gap, indexed by sequence number
+  std::map<std::uint64_t, std::string> reorder_buffer_;
+
+  // All the messages before this one have been received or requested
+  std::uint64_t requested_until_;
+
+  std::uint64_t duplicate_messages_;
+  std::uint64_t lost_messages_;
+
+  //@{
+  /**
+   * @name The counters in the default metrics registry
+   */
+  jb::metrics::counter& messages_metric_;
+  jb::metrics::counter& gaps_metric_;
+  jb::metrics::counter& duplicates_metric_;
+  jb::metrics::counter& lost_metric_;
+  //@}
+};
+
+} // namespace itch5
+} // namespace jb
+
+#endif // jb_itch5_mold_udp_stream_hpp
@@ -8,19 +8,31 @@
  */
 #include <jb/ehs/acceptor.hpp>
 #include <jb/itch5/array_based_order_book.hpp>
+#include <jb/itch5/clock_recalibrator.hpp>
 #include <jb/itch5/generate_inside.hpp>
-#include <jb/itch5/make_socket_udp_send.hpp>
 #include <jb/itch5/mold_udp_channel.hpp>
+#include <jb/itch5/pipeline_latency.hpp>
 #include <jb/itch5/process_iostream.hpp>
+#include <jb/itch5/udp_batch_sender.hpp>
 #include <jb/itch5/udp_receiver_config.hpp>
 #include <jb/itch5/udp_sender_config.hpp>
 #include <jb/mktdata/inside_levels_update.hpp>
+#include <jb/mktdata/shm_ring_writer.hpp>
+#include <jb/conflation_queue.hpp>
+#include <jb/fast_format.hpp>
 #include <jb/fileio.hpp>
+#include <jb/explicit_cuts_binning.hpp>
+#include <jb/launch_thread.hpp>
 #include <jb/log.hpp>
+#include <jb/metrics.hpp>
+#include <jb/spsc_ring.hpp>
 
+#include <atomic>
 #include <ctime>
+#include <memory>
 #include <sstream>
 #include <stdexcept>
+#include <thread>
 #include <type_traits>
 #include <unordered_map>
 
@@ -39,24 +51,37 @@ public:
   jb::config_attribute<config, int> levels;
   jb::config_attribute<config, jb::itch5::udp_receiver_config> primary;
   jb::config_attribute<config, jb::itch5::udp_receiver_config> secondary;
+  jb::config_attribute<config, jb::itch5::mold_udp_channel_config> channel;
   jb::config_attribute<config, std::string> output_file;
+  jb::config_attribute<config, jb::thread_config> output_file_thread;
+  jb::config_attribute<config, int> output_file_queue_size;
   jb::config_attribute<config, std::vector<jb::itch5::udp_sender_config>>
       output;
+  jb::config_attribute<config, jb::itch5::udp_batch_sender_config>
+      output_batch;
+  jb::config_attribute<config, jb::thread_config> output_thread;
+  jb::config_attribute<config, jb::mktdata::shm_ring_config> output_shm;
   jb::config_attribute<config, std::string> control_host;
   jb::config_attribute<config, unsigned short> control_port;
   using book_config = typename jb::itch5::array_based_order_book::config;
   jb::config_attribute<config, book_config> book;
+  jb::config_attribute<config, jb::itch5::pipeline_latency::config>
+      stage_latency;
+  jb::config_attribute<config, bool> enable_stage_latency;
+  jb::config_attribute<config, jb::itch5::clock_recalibrator::config> clock;
   jb::config_attribute<config, jb::log::config> log;
 };
 
 template <typename callback_t>
 std::unique_ptr<jb::itch5::mold_udp_channel> create_udp_channel(
     boost::asio::io_service& io, callback_t cb,
-    jb::itch5::udp_receiver_config const& cfg) {
+    jb::itch5::udp_receiver_config const& cfg,
+    jb::itch5::mold_udp_channel_config const& chcfg) {
   if (cfg.port() == 0 or cfg.address() == "") {
     return std::unique_ptr<jb::itch5::mold_udp_channel>();
   }
-  return std::make_unique<jb::itch5::mold_udp_channel>(io, std::move(cb), cfg);
+  return std::make_unique<jb::itch5::mold_udp_channel>(
+      io, std::move(cb), cfg, chcfg);
 }
 
 /// Define the type of order book used in the program.
@@ -68,21 +93,108 @@ using output_function = std::function<void(
     jb::itch5::message_header const& header, order_book const& updated_book,
     jb::itch5::book_update const& update)>;
 
-/// Create the output function for the file option.
-output_function create_output_file(config const& cfg) {
-  // ... otherwise create an output iostream and use it ...
-  auto out = std::make_shared<boost::iostreams::filtering_ostream>();
-  jb::open_output_file(*out, cfg.output_file());
-  return [out](
+/// Report metrics from the output layer, in Prometheus text format
+using metrics_function = std::function<void(std::string& body)>;
+
+/**
+ * Write the inside to a (possibly compressed) text file.
+ *
+ * Formatting and compressing the output is too expensive for the
+ * book building thread.  This class copies the data for each update
+ * into a preallocated queue, and a background thread formats,
+ * compresses, and writes the data in large batches.  If the writer
+ * falls behind the updates are dropped, and counted, the book
+ * building thread never waits for the file.
+ */
+class file_output {
+public:
+  explicit file_output(config const& cfg)
+      : out_()
+      , fmt_(out_)
+      , queue_(cfg.output_file_queue_size())
+      , stop_(false)
+      , dropped_(jb::metrics::default_registry().make_counter(
+            "file_output_dropped", "updates dropped because the output file "
+                                   "writer fell behind"))
+      , written_(jb::metrics::default_registry().make_counter(
+            "file_output_written", "updates written to the output file"))
+      , writer_thread_() {
+    jb::open_output_file(out_, cfg.output_file());
+    jb::launch_thread(
+        writer_thread_, cfg.output_file_thread(), [this]() { drain_loop(); });
+  }
+
+  ~file_output() {
+    stop_.store(true, std::memory_order_release);
+    if (writer_thread_.joinable()) {
+      writer_thread_.join();
+    }
+  }
+
+  /// Queue the inside for @a updated_book
+  void operator()(
       jb::itch5::message_header const& header, order_book const& updated_book,
       jb::itch5::book_update const& update) {
-    auto bid = updated_book.best_bid();
-    auto offer = updated_book.best_offer();
-    *out << header.timestamp.ts.count() << " " << header.stock_locate << " "
-         << update.stock << " " << bid.first.as_integer() << " " << bid.second
-         << " " << offer.first.as_integer() << " " << offer.second << "\n";
+    record r{header.timestamp.ts.count(), header.stock_locate, update.stock,
+             updated_book.best_bid(), updated_book.best_offer()};
+    if (not queue_.try_push(r)) {
+      dropped_.inc();
+    }
+  }
+
+private:
+  /// The main loop in the writer thread
+  void drain_loop() {
+    auto write = [this](record const& r) {
+      fmt_ << r.timestamp << ' ' << r.stock_locate << ' ' << r.stock << ' '
+           << r.bid.first.as_integer() << ' ' << r.bid.second << ' '
+           << r.offer.first.as_integer() << ' ' << r.offer.second << '\n';
+    };
+    while (true) {
+      // ... check the flag before draining, so all the updates queued
+      // before stop are written ...
+      bool stopped = stop_.load(std::memory_order_acquire);
+      auto n = queue_.consume(write, drain_batch_size);
+      written_.inc(n);
+      if (n != 0) {
+        continue;
+      }
+      if (stopped) {
+        break;
+      }
+      // ... the queue is empty, write whatever is buffered and wait,
+      // there is no point in spinning, the file output is not
+      // latency sensitive ...
+      fmt_.flush();
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    fmt_.flush();
+    out_.flush();
+  }
+
+private:
+  /// The data saved for each update
+  struct record {
+    std::int64_t timestamp;
+    int stock_locate;
+    jb::itch5::stock_t stock;
+    jb::itch5::half_quote bid;
+    jb::itch5::half_quote offer;
   };
-}
+
+  /// How many updates are formatted at a time
+  static constexpr std::size_t drain_batch_size = 1024;
+
+  boost::iostreams::filtering_ostream out_;
+  jb::fast_format fmt_;
+  jb::spsc_ring<record> queue_;
+  std::atomic<bool> stop_;
+  jb::metrics::counter& dropped_;
+  jb::metrics::counter& written_;
+  std::thread writer_thread_;
+};
+
+constexpr std::size_t file_output::drain_batch_size;
 
 // TODO() - this value is cached, we need think about what happens for
 // programs that run 24x7 ...
@@ -99,32 +211,39 @@ std::chrono::system_clock::time_point midnight() {
   return system_clock::from_time_t(std::mktime(&date));
 }
 
-void send_inside_levels_update(
-    boost::asio::ip::udp::socket& socket,
-    boost::asio::ip::udp::endpoint const& destination,
-    std::chrono::system_clock::time_point const& midnight,
+/// The message sent by the feed handler
+// TODO() - the number of levels should be based on the "levels()"
+// configuration parameter
+using inside_update = jb::mktdata::inside_levels_update<1>;
+
+/**
+ * Fill up @a msg with the inside of @a updated_book.
+ *
+ * @returns false if the update did not change the inside, and thus
+ * there is nothing to send
+ */
+bool make_inside_levels_update(
+    inside_update& msg, std::chrono::system_clock::time_point const& midnight,
     jb::itch5::message_header const& header, order_book const& updated_book,
     jb::itch5::book_update const& update) {
   // ... filter out messages that do not update the inside ...
   if (update.buy_sell_indicator == u'B') {
     if (updated_book.best_bid().first != update.px) {
-      return;
+      return false;
     }
   } else {
     if (updated_book.best_offer().first != update.px) {
-      return;
+      return false;
     }
   }
   // ... prepare the message to send ...
-  // TODO() - the number of levels should be based on the "levels()"
-  // configuration parameter
-  jb::mktdata::inside_levels_update<1> msg;
   static_assert(
-      std::is_pod<decltype(msg)>::value, "Message type should be a POD type");
-  msg.message_type = jb::mktdata::inside_levels_update<1>::mtype;
+      std::is_pod<inside_update>::value, "Message type should be a POD type");
+  msg.message_type = inside_update::mtype;
   // TODO() - add configuration to send sizeof(msg) - sizeof(msg.annotations)
   msg.message_size = sizeof(msg);
-  // TODO() - actually create sequence numbers ...
+  // ... the sequence number is assigned when the message is sent, the
+  // updates are conflated before that, see socket_output ...
   msg.sequence_number = 0;
   // TODO() - this should be configured, the configuration parameters
   // should be the short strings (e.g. NASD-PITCH-5), and the feed
@@ -158,48 +277,204 @@ void send_inside_levels_update(
   std::memcpy(
       msg.annotations.security_feed, update.stock.c_str(),
       update.stock.wire_size);
-  // TODO() - consider a non-blocking write for the socket
-  socket.send_to(
-      boost::asio::buffer(&msg, msg.message_size.value()), destination);
-  // TODO() - increment a counter to show that the socket was sent,
-  // different counters for success and failure ...
+  return true;
 }
 
-/// Create an output function for a single socket
-output_function create_output_socket(
-    boost::asio::io_service& io, jb::itch5::udp_sender_config const& cfg) {
-  auto s = jb::itch5::make_socket_udp_send<>(io, cfg);
-  auto socket = std::make_shared<decltype(s)>(std::move(s));
-  auto const address = boost::asio::ip::address::from_string(cfg.address());
-  auto const destination = boost::asio::ip::udp::endpoint(address, cfg.port());
+/**
+ * Send the inside updates to all the output sockets.
+ *
+ * The book building thread only computes the new inside and stores
+ * it in a conflation queue, keyed by stock locate.  A separate output
+ * thread drains the queue and sends the updates.  If the output falls
+ * behind, only the latest update for each security is sent, and the
+ * book building thread never waits for the network.
+ */
+class socket_output {
+public:
+  socket_output(
+      boost::asio::io_service& io,
+      std::vector<jb::itch5::udp_sender_config> const& destinations,
+      jb::itch5::udp_batch_sender_config const& cfg,
+      jb::thread_config const& thrcfg)
+      : sender_(io, destinations, cfg)
+      , queue_(max_stock_locate)
+      , midnight_(midnight())
+      , output_thread_() {
+    jb::launch_thread(output_thread_, thrcfg, [this]() { drain_loop(); });
+  }
+
+  ~socket_output() {
+    queue_.stop();
+    if (output_thread_.joinable()) {
+      output_thread_.join();
+    }
+  }
+
+  /// Queue the new inside for @a updated_book, if it changed
+  void operator()(
+      jb::itch5::message_header const& header, order_book const& updated_book,
+      jb::itch5::book_update const& update) {
+    inside_update msg;
+    if (not make_inside_levels_update(
+            msg, midnight_, header, updated_book, update)) {
+      return;
+    }
+    queue_.push(header.stock_locate, msg);
+  }
+
+  /// Append the per-security conflation metrics in Prometheus format
+  void append_metrics(std::string& body) const {
+    std::ostringstream updates;
+    std::ostringstream sent;
+    std::ostringstream ratio;
+    updates << "# HELP conflation_updates inside updates computed for "
+            << "each security\n"
+            << "# TYPE conflation_updates counter\n";
+    sent << "# HELP conflation_sent inside updates sent for each security\n"
+         << "# TYPE conflation_sent counter\n";
+    ratio << "# HELP conflation_ratio inside updates computed per update sent"
+          << "\n"
+          << "# TYPE conflation_ratio gauge\n";
+    using queue_type = jb::conflation_queue<inside_update>;
+    queue_.for_each_stats([&](
+        queue_type::key_type key, queue_type::key_stats const& s,
+        inside_update const& msg) {
+      // ... the security_feed annotation is space padded, trim it ...
+      std::string symbol(
+          reinterpret_cast<char const*>(msg.annotations.security_feed),
+          sizeof(msg.annotations.security_feed));
+      symbol.erase(symbol.find_last_not_of(" \0", std::string::npos, 2) + 1);
+      std::ostringstream labels;
+      labels << "{stock_locate=\"" << key << "\",symbol=\"" << symbol
+             << "\"}";
+      updates << "conflation_updates" << labels.str() << " " << s.pushed
+              << "\n";
+      sent << "conflation_sent" << labels.str() << " " << s.popped << "\n";
+      if (s.popped != 0) {
+        ratio << "conflation_ratio" << labels.str() << " "
+              << static_cast<double>(s.pushed) / s.popped << "\n";
+      }
+    });
+    body += updates.str();
+    body += sent.str();
+    body += ratio.str();
+  }
+
+private:
+  /// The main loop in the output thread
+  void drain_loop() {
+    std::vector<jb::conflation_queue<inside_update>::entry_type> batch;
+    batch.reserve(drain_batch_size);
+    while (not queue_.stopped()) {
+      batch.clear();
+      queue_.pop_wait(batch, drain_batch_size, std::chrono::milliseconds(10));
+      for (auto const& e : batch) {
+        // ... the message is packed with other updates and sent to
+        // all the destinations at once, see
+        // jb::itch5::udp_batch_sender ...
+        sender_.append(&e.second, e.second.message_size.value());
+      }
+      // ... once the queue is drained there is no reason to wait for
+      // more data, send anything the sender has buffered ...
+      if (not batch.empty() and queue_.dirty_count() == 0) {
+        sender_.flush();
+      }
+    }
+  }
+
+private:
+  /// Stock locate codes are 16-bit integers
+  static constexpr std::size_t max_stock_locate = 65536;
+  /// How many updates are removed from the queue at a time
+  static constexpr std::size_t drain_batch_size = 64;
+
+  jb::itch5::udp_batch_sender sender_;
+  jb::conflation_queue<inside_update> queue_;
+  std::chrono::system_clock::time_point const midnight_;
+  std::thread output_thread_;
+};
+
+constexpr std::size_t socket_output::max_stock_locate;
+constexpr std::size_t socket_output::drain_batch_size;
+
+/**
+ * Create the output function for the shared memory ring.
+ *
+ * Publishing to the ring never blocks, so it runs in the book
+ * building thread, without any conflation.
+ */
+output_function create_output_shm(config const& cfg) {
+  auto writer =
+      std::make_shared<jb::mktdata::shm_ring_writer>(cfg.output_shm());
   auto const mid = midnight();
-  return [socket, cfg, destination, mid](
-      jb::itch5::message_header const& h, order_book const& ub,
-      jb::itch5::book_update const& u) {
-    send_inside_levels_update(*socket, destination, mid, h, ub, u);
+  return [writer, mid](
+      jb::itch5::message_header const& header, order_book const& updated_book,
+      jb::itch5::book_update const& update) {
+    inside_update msg;
+    if (not make_inside_levels_update(msg, mid, header, updated_book, update)) {
+      return;
+    }
+    writer->publish(&msg, msg.message_size.value());
   };
 }
 
-/// Create a composite output function aggregating all the different
-/// configured outputs
-output_function
-create_output_layer(boost::asio::io_service& io, config const& cfg) {
+/**
+ * Create a composite output function aggregating all the different
+ * configured outputs.
+ *
+ * @param io the io_service used by the output sockets
+ * @param cfg the program configuration
+ * @param metrics the functions to report the metrics of each output
+ * are appended to this vector
+ */
+output_function create_output_layer(
+    boost::asio::io_service& io, config const& cfg,
+    std::vector<metrics_function>& metrics) {
   std::vector<output_function> outs;
   if (cfg.output_file() != "") {
-    outs.push_back(create_output_file(cfg));
+    auto file = std::make_shared<file_output>(cfg);
+    outs.push_back([file](
+        jb::itch5::message_header const& h, order_book const& ub,
+        jb::itch5::book_update const& u) { (*file)(h, ub, u); });
+  }
+  if (cfg.output_shm().name() != "") {
+    outs.push_back(create_output_shm(cfg));
   }
+  std::vector<jb::itch5::udp_sender_config> destinations;
   for (auto const& outcfg : cfg.output()) {
     if (outcfg.port() == 0 and outcfg.address() == "") {
       continue;
     }
-    outs.push_back(create_output_socket(io, outcfg));
+    destinations.push_back(outcfg);
+  }
+  if (not destinations.empty()) {
+    auto sockets = std::make_shared<socket_output>(
+        io, destinations, cfg.output_batch(), cfg.output_thread());
+    outs.push_back([sockets](
+        jb::itch5::message_header const& h, order_book const& ub,
+        jb::itch5::book_update const& u) { (*sockets)(h, ub, u); });
+    metrics.push_back(
+        [sockets](std::string& body) { sockets->append_metrics(body); });
   }
-  return [outputs = std::move(outs)](
+  // ... measure the time from receiving the message until all the
+  // outputs have the update, the bins are in nanoseconds ...
+  auto& latency = jb::metrics::default_registry().make_histogram(
+      "feed_handler_latency_nanoseconds",
+      "the time from receiving a message until all the outputs have the "
+      "resulting update",
+      jb::explicit_cuts_binning<std::int64_t>(
+          {0, 1000, 2000, 5000, 10000, 20000, 50000, 100000, 200000, 500000,
+           1000000, 10000000}));
+  return [outputs = std::move(outs), &latency](
       jb::itch5::message_header const& header, order_book const& updated_book,
       jb::itch5::book_update const& update) {
-    for (auto f : outputs) {
+    for (auto const& f : outputs) {
       f(header, updated_book, update);
     }
+    latency.sample(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            jb::itch5::clock_type::now() - update.recvts)
+            .count());
   };
 }
 
@@ -239,6 +514,10 @@ int main(int argc, char* argv[]) try {
   // threads with their own io_service ...
   boost::asio::io_service io;
 
+  // ... every message is timestamped, keep the clock calibrated
+  // during the whole trading day ...
+  jb::itch5::clock_recalibrator recalibrator(io, cfg.clock());
+
   // ... define the classes used to build the book ...
   using compute_book =
       jb::itch5::compute_book<jb::itch5::array_based_order_book>;
@@ -250,7 +529,8 @@ int main(int argc, char* argv[]) try {
   // TODO() - actually output the messages to UDP sockets and files
   // TODO() - run a master election via etcd and only output to
   // sockets if this is the master
-  auto output_layer = create_output_layer(io, cfg);
+  std::vector<metrics_function> output_metrics;
+  auto output_layer = create_output_layer(io, cfg, output_metrics);
 
   // ... here we should have a layer to arbitrage between the ITCH-5.x
   // feed and the UQDF/CQS feeds.  Normally ITCH-5.x is a better feed,
@@ -270,7 +550,18 @@ int main(int argc, char* argv[]) try {
   // ... in this layer we compute the book, i.e., assemble the list of
   // orders received from the feed into a quantity at each price level
   // ...
-  compute_book book_build_layer(std::move(output_layer), cfg.book());
+  // ... optionally measure the latency of each stage in the critical
+  // data path, the histograms are reported in /metrics ...
+  std::unique_ptr<jb::itch5::pipeline_latency> latency;
+  if (cfg.enable_stage_latency()) {
+    latency = std::make_unique<jb::itch5::pipeline_latency>(
+        cfg.stage_latency());
+    auto recorder = latency.get();
+    output_metrics.push_back(
+        [recorder](std::string& body) { recorder->append_metrics(body); });
+  }
+  compute_book book_build_layer(
+      std::move(output_layer), cfg.book(), latency.get());
 
   // ... in this layer we decode the raw ITCH messages into objects
   // that can be more easily manipulated ...
@@ -292,8 +583,8 @@ int main(int argc, char* argv[]) try {
   // TODO() - we need to refactor the mold_udp_channel class to
   // support multiple input sockets and to handle out-of-order,
   // duplicate, and gaps in the message stream.
-  auto data_source_layer =
-      create_udp_channel(io, itch_decoding_layer, cfg.primary());
+  auto data_source_layer = create_udp_channel(
+      io, itch_decoding_layer, cfg.primary(), cfg.channel());
 
   // ... that was it for the critical data path.  There are several
   // TODO() entries there ...
@@ -303,7 +594,7 @@ int main(int argc, char* argv[]) try {
   // HTTP server that responds to simple GET requests.  Adding new
   // control methods is easy, as we will see ...
   // TODO() - this should be refactored to a "application" class, they
-  // are very repetitive.  We need to solve the counter problem first.
+  // are very repetitive.
   using endpoint = boost::asio::ip::tcp::endpoint;
   using address = boost::asio::ip::address;
   endpoint ep{address::from_string(cfg.control_host()), cfg.control_port()};
@@ -336,13 +627,9 @@ int main(int argc, char* argv[]) try {
   std::weak_ptr<jb::ehs::request_dispatcher> disp = dispatcher;
   // ... this handler collects the metrics and reports them in human
   // readable form ...
-  // TODO() - we need a separate handler to serve the metrics in
-  // protobuf form for efficiency
-  // TODO() - once we solve the counter problem we should show the
-  // counter values here, not just whatever the dispatcher collects
-  // about itself
   dispatcher->add_handler(
-      "/metrics", [disp](request_type const&, response_type& res) {
+      "/metrics",
+      [disp, output_metrics](request_type const&, response_type& res) {
         std::shared_ptr<jb::ehs::request_dispatcher> d(disp);
         if (not d) {
           res.result(beast::http::status::internal_server_error);
@@ -351,7 +638,25 @@ int main(int argc, char* argv[]) try {
           return;
         }
         res.set("content-type", "text/plain; version=0.0.4");
-        d->append_metrics(res);
+        d->append_metrics(res, jb::metrics::default_registry());
+        for (auto const& f : output_metrics) {
+          f(res.body);
+        }
+      });
+  // ... the same metrics in a compact binary form, for clients that
+  // scrape many times per second, see jb/metrics_binary.hpp.  Only
+  // the metrics in the registry are included ...
+  dispatcher->add_handler(
+      "/metrics-binary", [disp](request_type const& req, response_type& res) {
+        std::shared_ptr<jb::ehs::request_dispatcher> d(disp);
+        if (not d) {
+          res.result(beast::http::status::internal_server_error);
+          res.body = std::string(
+              "An internal error occurred\r\n"
+              "Null request handler in /metrics-binary\r\n");
+          return;
+        }
+        d->append_binary_metrics(req, res, jb::metrics::default_registry());
       });
 
   // ... create an acceptor to handle incoming connections, if we wanted
@@ -385,6 +690,7 @@ std::string const mold_address = "127.0.0.1";
 unsigned short const mold_port = 12300;
 std::string const output_address = "127.0.0.1";
 unsigned short const output_port = 13000;
+int const output_file_queue_size = 1 << 16;
 } // namespace defaults
 
 config::config()
@@ -400,6 +706,12 @@ config::config()
     , secondary(
           desc("secondary"), this,
           jb::itch5::udp_receiver_config().address(defaults::mold_address))
+    , channel(
+          desc("channel", "mold-udp-channel")
+              .help("Configure how the MoldUDP64 packets are received.  With "
+                    "--channel.busy-poll the critical data path runs in a "
+                    "dedicated thread instead of the Boost.ASIO reactor."),
+          this)
     , output_file(
           desc("output-file")
               .help("Configure the feed handler to log to a "
@@ -407,6 +719,17 @@ config::config()
                     "  The user should consider the performance impact of this "
                     "option when using this as the primary feedhandler."),
           this)
+    , output_file_thread(
+          desc("output-file-thread", "thread-config")
+              .help("Configure the thread that formats and writes the "
+                    "output file."),
+          this, jb::thread_config().name("file-output"))
+    , output_file_queue_size(
+          desc("output-file-queue-size")
+              .help("The number of updates buffered for the output file "
+                    "writer, rounded up to a power of 2.  If the writer "
+                    "falls behind by more than this, updates are dropped."),
+          this, defaults::output_file_queue_size)
     , output(
           desc("output").help(
               "Configure the output UDP addresses for the feed handler "
@@ -416,6 +739,24 @@ config::config()
               "redundancy, or to send copies to another process in "
               "the localhost for logging."),
           this)
+    , output_batch(
+          desc("output-batch", "udp-batch-sender")
+              .help("Configure how the output messages are packed into "
+                    "datagrams."),
+          this)
+    , output_thread(
+          desc("output-thread", "thread-config")
+              .help("Configure the thread that sends the output messages.  "
+                    "The book is built in the main thread, the inside "
+                    "updates are conflated per security while they wait for "
+                    "this thread."),
+          this, jb::thread_config().name("output"))
+    , output_shm(
+          desc("output-shm", "shm-ring")
+              .help("Configure a shared memory ring to publish the output "
+                    "messages to consumers in the same host.  Use "
+                    "jb::mktdata::shm_ring_reader to receive them."),
+          this)
     , control_host(
           desc("control-host")
               .help("Where does the server listen for control connections."
@@ -426,6 +767,14 @@ config::config()
           desc("control-port").help("The port to receive control connections."),
           this, defaults::control_port)
     , book(desc("book", "order-book-config"), this)
+    , stage_latency(desc("stage-latency", "pipeline-latency"), this)
+    , enable_stage_latency(
+          desc("enable-stage-latency")
+              .help("If set, measure the latency of each stage (decode, "
+                    "order table, book, and output) for each message type, "
+                    "and report the histograms in /metrics."),
+          this, false)
+    , clock(desc("clock", "clock-recalibrator"), this)
     , log(desc("log", "logging"), this) {
   output({jb::itch5::udp_sender_config()
               .address(defaults::output_address)
@@ -461,9 +810,23 @@ void config::validate() const {
       ++outputs;
     }
   }
-  if (outputs == 0 and output_file() == "") {
-    throw jb::usage("No --output nor --output-file configured", 1);
+  if (outputs == 0 and output_file() == "" and output_shm().name() == "") {
+    throw jb::usage(
+        "No --output, --output-file, nor --output-shm configured", 1);
+  }
+  if (output_file_queue_size() <= 0) {
+    std::ostringstream os;
+    os << "Invalid value (" << output_file_queue_size()
+       << ") for --output-file-queue-size option.";
+    throw jb::usage(os.str(), 1);
   }
+  output_file_thread().validate();
+  output_batch().validate();
+  output_thread().validate();
+  output_shm().validate();
+  channel().validate();
+  stage_latency().validate();
+  clock().validate();
   log().validate();
 }
 
@@ -5,15 +5,47 @@
  *
  * This program replays a ITCH-5.x file via multicast, simulating the
  * behavior of a market data feed.
+ *
+ * Optionally the program also answers MoldUDP64 retransmission
+ * requests, serving the messages from an in-memory copy of the same
+ * file.  That is useful to test (and benchmark) gap recovery locally.
+ *
+ * The program can run multiple replay sessions concurrently, each
+ * with its own input file, destinations, pacing, and thread
+ * configuration, e.g., to simulate the feeds from two different
+ * exchanges, or the A and B lines of a feed.  The sessions are
+ * controlled with the /replay-* HTTP endpoints:
+ *
+ *   curl http://localhost:23000/replay-sessions
+ *   curl http://localhost:23000/replay-start?session=nasdaq-a
+ *   curl http://localhost:23000/replay-status?session=nasdaq-a
+ *   curl http://localhost:23000/replay-stop
+ *
+ * Without a session parameter the requests apply to all the sessions.
+ *
+ * For stress tests the sessions can amplify the feed, sending K
+ * copies of each order-flow message for K independent sets of
+ * symbols, see jb::itch5::load_amplifier.  To test gap recovery the
+ * sessions can also drop, duplicate, reorder, or delay the packets
+ * sent to each destination, see jb::itch5::mold_udp_impairment.
  */
 #include <jb/ehs/acceptor.hpp>
+#include <jb/itch5/load_amplifier.hpp>
+#include <jb/itch5/message_store.hpp>
+#include <jb/itch5/mold_rerequest_server.hpp>
+#include <jb/itch5/mold_udp_impairment.hpp>
 #include <jb/itch5/mold_udp_pacer.hpp>
+#include <jb/itch5/pacing_engine.hpp>
 #include <jb/itch5/process_iostream_mlist.hpp>
+#include <jb/itch5/process_store_mlist.hpp>
+#include <jb/itch5/replay_pacing_statistics.hpp>
+#include <jb/itch5/udp_receiver_config.hpp>
 #include <jb/as_hhmmss.hpp>
 #include <jb/config_object.hpp>
 #include <jb/fileio.hpp>
 #include <jb/launch_thread.hpp>
 #include <jb/log.hpp>
+#include <jb/metrics.hpp>
 
 #include <beast/http.hpp>
 #include <boost/asio/io_service.hpp>
@@ -24,13 +56,54 @@
 
 #include <chrono>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <set>
 #include <stdexcept>
 #include <thread>
+#include <vector>
 
 /// Types and functions used in this program
 namespace {
+/**
+ * The configuration for a single replay session.
+ */
+class session_config : public jb::config_object {
+public:
+  session_config();
+  config_object_constructors(session_config);
+
+  void validate() const override;
+
+  /// Return true if the session sends an amplified feed
+  bool amplified() const {
+    return amplifier().factor() != 1 or amplifier().time_compression() != 1.0;
+  }
+
+  jb::config_attribute<session_config, std::string> name;
+  jb::config_attribute<session_config, std::string> primary_destination;
+  jb::config_attribute<session_config, int> primary_port;
+  jb::config_attribute<session_config, std::string> secondary_destination;
+  jb::config_attribute<session_config, int> secondary_port;
+  jb::config_attribute<session_config, std::string> input_file;
+  jb::config_attribute<session_config, bool> preload;
+  jb::config_attribute<session_config, jb::thread_config> replay_session;
+  jb::config_attribute<session_config, jb::itch5::mold_udp_pacer_config>
+      pacer;
+  jb::config_attribute<session_config, jb::itch5::load_amplifier_config>
+      amplifier;
+  jb::config_attribute<session_config, jb::itch5::mold_udp_impairment_config>
+      primary_impairment;
+  jb::config_attribute<session_config, jb::itch5::mold_udp_impairment_config>
+      secondary_impairment;
+};
+
 /**
  * Program configuration.
+ *
+ * The top-level destinations, input file, etc. define a session
+ * called "default", which is used only if the sessions list is
+ * empty.
  */
 class config : public jb::config_object {
 public:
@@ -46,11 +119,49 @@ public:
   jb::config_attribute<config, std::string> control_host;
   jb::config_attribute<config, unsigned short> control_port;
   jb::config_attribute<config, std::string> input_file;
+  jb::config_attribute<config, bool> preload;
   jb::config_attribute<config, jb::thread_config> replay_session;
   jb::config_attribute<config, jb::itch5::mold_udp_pacer_config> pacer;
+  jb::config_attribute<config, jb::itch5::load_amplifier_config> amplifier;
+  jb::config_attribute<config, jb::itch5::mold_udp_impairment_config>
+      primary_impairment;
+  jb::config_attribute<config, jb::itch5::mold_udp_impairment_config>
+      secondary_impairment;
+  jb::config_attribute<config, std::vector<session_config>> sessions;
+  jb::config_attribute<config, jb::itch5::udp_receiver_config> rerequest;
   jb::config_attribute<config, jb::log::config> log;
+
+  /// The configuration for all the replay sessions
+  std::vector<session_config> replay_sessions() const;
+};
+
+/**
+ * Send the MoldUDP64 packets to one destination.
+ */
+struct udp_sink {
+  template <typename buffers_type>
+  void operator()(buffers_type const& buffers) {
+    socket.send_to(buffers, endpoint);
+  }
+
+  boost::asio::ip::udp::socket& socket;
+  boost::asio::ip::udp::endpoint& endpoint;
 };
 
+/// The files loaded in memory, shared by all the sessions
+typedef std::shared_ptr<jb::itch5::message_store const> shared_store;
+typedef std::map<std::string, shared_store> preloaded_files;
+
+/**
+ * Load (and decompress) a file into memory, unless it is already
+ * loaded.
+ *
+ * @param files the files already loaded
+ * @param filename the file to load
+ * @return the messages in the file
+ */
+shared_store preload_file(preloaded_files& files, std::string const& filename);
+
 class session : public std::enable_shared_from_this<session> {
 public:
   //@{
@@ -60,8 +171,14 @@ public:
   typedef std::chrono::steady_clock::time_point time_point;
   //@}
 
-  /// Create a new session to replay a ITCH-5.x file.
-  session(config const& cfg);
+  /**
+   * Create a new session to replay a ITCH-5.x file.
+   *
+   * @param cfg the session configuration
+   * @param store the messages in the input file, if preloaded,
+   *   otherwise the session reads the file each time it starts
+   */
+  session(session_config const& cfg, shared_store store);
 
   /// Start running a new session
   void start();
@@ -79,49 +196,115 @@ public:
     return last_message_offset_.load(std::memory_order_relaxed);
   }
 
+  /// The number of messages sent by this session
+  std::uint64_t messages_sent() const {
+    return messages_sent_.load(std::memory_order_relaxed);
+  }
+
+  /// The number of packets sent by this session
+  std::uint64_t packets_sent() const {
+    return packets_sent_.load(std::memory_order_relaxed);
+  }
+
+  /// The average message rate since the session started
+  double message_rate() const;
+
   /// Implement the callback for jb::itch5::process_iostream_mlist<>
   void handle_unknown(
       time_point const& recv_ts, jb::itch5::unknown_message const& msg);
 
+  /// Send a (possibly amplified) message
+  void send(time_point const& recv_ts, jb::itch5::unknown_message const& msg);
+
   /// Return the current timestamp for delay measurements
   time_point now() const {
     return std::chrono::steady_clock::now();
   }
 
 private:
-  config cfg_;
+  session_config cfg_;
+  shared_store store_;
   std::atomic_bool stop_;
+  jb::itch5::load_amplifier amplifier_;
   jb::itch5::mold_udp_pacer<> pacer_;
+  jb::itch5::pacing_engine engine_;
+  jb::itch5::replay_pacing_statistics stats_;
   std::atomic<std::uint32_t> last_message_count_;
   std::atomic<std::uint64_t> last_message_offset_;
+  std::atomic<std::uint64_t> messages_sent_;
+  std::atomic<std::uint64_t> packets_sent_;
+  std::atomic<time_point::rep> started_;
+  jb::metrics::counter& messages_metric_;
+  jb::metrics::counter& packets_metric_;
   boost::asio::io_service io_;
   boost::asio::ip::udp::socket s0_;
   boost::asio::ip::udp::endpoint ep0_;
   boost::asio::ip::udp::socket s1_;
   boost::asio::ip::udp::endpoint ep1_;
   bool ep1_enabled_;
+  udp_sink sink0_;
+  udp_sink sink1_;
+  jb::itch5::mold_udp_impairment impairment0_;
+  jb::itch5::mold_udp_impairment impairment1_;
 };
 
+/**
+ * Control the replay sessions.
+ *
+ * Each session has an independent state machine: it moves from idle
+ * to starting when a start request is received, to replaying once
+ * its thread runs, to stopping when a stop request is received, and
+ * back to idle when the replay finishes (or is stopped).  The
+ * requests select a session with the "session" query parameter, if
+ * the parameter is missing the request applies to all the sessions.
+ */
 class replayer_control {
 public:
-  explicit replayer_control(config const& cfg);
+  /**
+   * Constructor.
+   *
+   * @param cfg the program configuration
+   * @param files the preloaded input files, must include the input
+   *   file of any session configured with --preload
+   */
+  replayer_control(config const& cfg, preloaded_files const& files);
 
   enum class state { idle, starting, replaying, stopping };
 
-  void status(jb::ehs::response_type& res) const;
+  void sessions(
+      jb::ehs::request_type const& req, jb::ehs::response_type& res) const;
+  void status(
+      jb::ehs::request_type const& req, jb::ehs::response_type& res) const;
   void start(jb::ehs::request_type const& req, jb::ehs::response_type& res);
   void stop(jb::ehs::request_type const& req, jb::ehs::response_type& res);
 
 private:
-  bool start_check();
-  void replay_done();
+  /// The state of a single session
+  struct session_state {
+    session_config cfg;
+    shared_store store;
+    state current;
+    std::shared_ptr<session> replay;
+  };
+
+  /**
+   * Return the names of the sessions selected by a request.
+   *
+   * Sets a 404 error in @a res and returns an empty vector if the
+   * request names a session that does not exist.
+   */
+  std::vector<std::string> selected(
+      jb::ehs::request_type const& req, jb::ehs::response_type& res) const;
+
+  /// Start a session, must be called with mu_ held
+  void start_session(std::string const& name, session_state& s);
+
+  bool start_check(std::string const& name);
+  void replay_done(std::string const& name);
 
 private:
-  config cfg_;
   mutable std::mutex mu_;
-  state current_state_;
-  std::thread session_thread_;
-  std::shared_ptr<session> session_;
+  std::map<std::string, session_state> sessions_;
 };
 
 } // anonymous namespace
@@ -138,9 +321,23 @@ int main(int argc, char* argv[]) try {
   using address = boost::asio::ip::address;
   endpoint ep{address::from_string(cfg.control_host()), cfg.control_port()};
 
+  // ... load the input files only once, they are shared by the
+  // sessions configured with --preload and by the retransmission
+  // server ...
+  preloaded_files files;
+  for (auto const& s : cfg.replay_sessions()) {
+    if (s.preload()) {
+      preload_file(files, s.input_file());
+    }
+  }
+  shared_store rerequest_store;
+  if (cfg.rerequest().port() != 0) {
+    rerequest_store = preload_file(files, cfg.input_file());
+  }
+
   // ... create the replayer control, this is where the main work
   // happens ...
-  auto replayer = std::make_shared<replayer_control>(cfg);
+  auto replayer = std::make_shared<replayer_control>(cfg, files);
 
   // ... create a dispatcher to process the HTTP requests, register
   // some basic handlers ...
@@ -170,11 +367,29 @@ int main(int argc, char* argv[]) try {
           return;
         }
         res.set("content-type", "text/plain; version=0.0.4");
-        d->append_metrics(res);
+        d->append_metrics(res, jb::metrics::default_registry());
+      });
+  dispatcher->add_handler(
+      "/metrics-binary", [disp](request_type const& req, response_type& res) {
+        std::shared_ptr<jb::ehs::request_dispatcher> d(disp);
+        if (not d) {
+          res.result(beast::http::status::internal_server_error);
+          res.body = std::string(
+              "An internal error occurred\r\n"
+              "Null request handler in /metrics-binary\r\n");
+          return;
+        }
+        d->append_binary_metrics(req, res, jb::metrics::default_registry());
+      });
+  dispatcher->add_handler(
+      "/replay-sessions",
+      [replayer](request_type const& req, response_type& res) {
+        replayer->sessions(req, res);
       });
   dispatcher->add_handler(
-      "/replay-status", [replayer](request_type const&, response_type& res) {
-        replayer->status(res);
+      "/replay-status",
+      [replayer](request_type const& req, response_type& res) {
+        replayer->status(req, res);
       });
   dispatcher->add_handler(
       "/replay-start", [replayer](request_type const& req, response_type& res) {
@@ -190,6 +405,16 @@ int main(int argc, char* argv[]) try {
   // pointing to the same dispatcher ...
   jb::ehs::acceptor acceptor(io_service, ep, dispatcher);
 
+  // ... if configured, answer retransmission requests from an
+  // in-memory copy of the input file, validate() checks that all
+  // the sessions replay that file ...
+  std::unique_ptr<jb::itch5::mold_rerequest_server> rerequest_server;
+  if (rerequest_store) {
+    rerequest_server.reset(new jb::itch5::mold_rerequest_server(
+        io_service, *rerequest_store, cfg.rerequest(),
+        cfg.pacer().maximum_transmission_unit()));
+  }
+
   // ... run the program forever ...
   io_service.run();
 
@@ -249,6 +474,12 @@ config::config()
           this, defaults::control_port)
     , input_file(
           desc("input-file").help("The file to replay when requested."), this)
+    , preload(
+          desc("preload")
+              .help("Load the complete input file into memory when the "
+                    "program starts.  Use this option for fast replays, "
+                    "see --pacer.speed and --pacer.unthrottled."),
+          this, false)
     , replay_session(
           desc("replay-session", "thread-config")
               .help("Configure the replay session threads."),
@@ -256,31 +487,211 @@ config::config()
     , pacer(
           desc("pacer", "mold-udp-pacer").help("Configure the ITCH-5.x pacer"),
           this)
+    , amplifier(
+          desc("amplifier", "load-amplifier")
+              .help("Send multiple copies of the feed, for stress tests."),
+          this)
+    , primary_impairment(
+          desc("primary-impairment", "mold-udp-impairment")
+              .help("Drop, duplicate, reorder, or delay the packets sent "
+                    "to the primary destination."),
+          this)
+    , secondary_impairment(
+          desc("secondary-impairment", "mold-udp-impairment")
+              .help("Drop, duplicate, reorder, or delay the packets sent "
+                    "to the secondary destination."),
+          this, jb::itch5::mold_udp_impairment_config().seed(2))
+    , sessions(
+          desc("sessions")
+              .help("Configure multiple replay sessions, each with its own "
+                    "input file, destinations, pacer, and thread "
+                    "configuration.  If empty, the program runs a single "
+                    "session, called 'default', configured with the "
+                    "top-level settings."),
+          this)
+    , rerequest(
+          desc("rerequest")
+              .help("Where to listen for MoldUDP64 retransmission requests. "
+                    "If the port is 0 the requests are not served.  The "
+                    "requests are answered from the top-level input file, "
+                    "so every session must replay that file, and this "
+                    "cannot be used with the amplifier."),
+          this, jb::itch5::udp_receiver_config().address("127.0.0.1"))
     , log(desc("log", "logging"), this) {
 }
 
 void config::validate() const {
+  if (rerequest().port() != 0 and input_file() == "") {
+    throw jb::usage(
+        "Missing input-file argument or setting, required to answer "
+        "retransmission requests.",
+        1);
+  }
+  std::set<std::string> names;
+  for (auto const& s : replay_sessions()) {
+    s.validate();
+    if (not names.insert(s.name()).second) {
+      throw jb::usage("Duplicate session name: " + s.name(), 1);
+    }
+    // ... the retransmission requests are answered from the original
+    // file, the sequence numbers of an amplified feed do not match ...
+    if (rerequest().port() != 0 and s.amplified()) {
+      throw jb::usage(
+          "The amplifier cannot be used with --rerequest.port, in session " +
+              s.name(),
+          1);
+    }
+    // ... there is a single retransmission server, it can only answer
+    // for the sessions replaying the file it serves ...
+    if (rerequest().port() != 0 and s.input_file() != input_file()) {
+      throw jb::usage(
+          "--rerequest.port requires all the sessions to replay the "
+          "top-level input-file (" +
+              input_file() + "), session " + s.name() + " replays " +
+              s.input_file(),
+          1);
+    }
+  }
+  rerequest().validate();
+  log().validate();
+}
+
+std::vector<session_config> config::replay_sessions() const {
+  if (not sessions().empty()) {
+    return sessions();
+  }
+  return {session_config()
+              .name("default")
+              .primary_destination(primary_destination())
+              .primary_port(primary_port())
+              .secondary_destination(secondary_destination())
+              .secondary_port(secondary_port())
+              .input_file(input_file())
+              .preload(preload())
+              .replay_session(replay_session())
+              .pacer(pacer())
+              .amplifier(amplifier())
+              .primary_impairment(primary_impairment())
+              .secondary_impairment(secondary_impairment())};
+}
+
+session_config::session_config()
+    : name(desc("name").help("The name of the session."), this)
+    , primary_destination(
+          desc("primary-destination")
+              .help("The destination for the UDP messages. "
+                    "The destination can be a unicast or multicast address."),
+          this, defaults::primary_destination)
+    , primary_port(
+          desc("primary-port")
+              .help("The destination port for the UDP messages."),
+          this, defaults::primary_port)
+    , secondary_destination(
+          desc("secondary-destination")
+              .help("The destination for the UDP messages. "
+                    "The destination can be empty, a unicast, or a multicast "
+                    "address."),
+          this, defaults::secondary_destination)
+    , secondary_port(
+          desc("secondary-port")
+              .help("The destination port for the UDP messages."),
+          this, defaults::secondary_port)
+    , input_file(
+          desc("input-file").help("The file to replay when requested."), this)
+    , preload(
+          desc("preload")
+              .help("Load the complete input file into memory when the "
+                    "program starts.  Sessions replaying the same file "
+                    "share a single copy."),
+          this, false)
+    , replay_session(
+          desc("replay-session", "thread-config")
+              .help("Configure the thread for this session, e.g., its "
+                    "CPU affinity."),
+          this, jb::thread_config().name("replay"))
+    , pacer(
+          desc("pacer", "mold-udp-pacer").help("Configure the ITCH-5.x pacer"),
+          this)
+    , amplifier(
+          desc("amplifier", "load-amplifier")
+              .help("Send multiple copies of the feed, for stress tests."),
+          this)
+    , primary_impairment(
+          desc("primary-impairment", "mold-udp-impairment")
+              .help("Drop, duplicate, reorder, or delay the packets sent "
+                    "to the primary destination."),
+          this)
+    , secondary_impairment(
+          desc("secondary-impairment", "mold-udp-impairment")
+              .help("Drop, duplicate, reorder, or delay the packets sent "
+                    "to the secondary destination.  Use a different seed "
+                    "than the primary destination to impair the feeds "
+                    "independently."),
+          this, jb::itch5::mold_udp_impairment_config().seed(2)) {
+}
+
+void session_config::validate() const {
+  if (name() == "") {
+    throw jb::usage("Missing name for replay session.", 1);
+  }
   if (primary_destination() == "") {
-    throw jb::usage("Missing primary-destination argument or setting.", 1);
+    throw jb::usage(
+        "Missing primary-destination argument or setting for session " +
+            name(),
+        1);
   }
   if (input_file() == "") {
-    throw jb::usage("Missing input-file argument or setting.", 1);
+    throw jb::usage(
+        "Missing input-file argument or setting for session " + name(), 1);
   }
-  log().validate();
+  pacer().validate();
+  amplifier().validate();
+  // ... in zero-copy mode the pacer refers to the messages until they
+  // are sent, they must stay in memory ...
+  if (pacer().zero_copy() and (not preload() or amplified())) {
+    throw jb::usage(
+        "--pacer.zero-copy requires --preload and disables the "
+        "amplifier, in session " +
+            name(),
+        1);
+  }
+  primary_impairment().validate();
+  secondary_impairment().validate();
 }
 
-session::session(config const& cfg)
+session::session(session_config const& cfg, shared_store store)
     : cfg_(cfg)
+    , store_(std::move(store))
     , stop_(false)
+    , amplifier_(cfg.amplifier())
     , pacer_(cfg.pacer())
+    , engine_(
+          cfg.pacer(), jb::metrics::default_registry(),
+          {{"session", cfg.name()}})
+    , stats_(
+          cfg.pacer(), jb::metrics::default_registry(),
+          {{"session", cfg.name()}})
     , last_message_count_(0)
     , last_message_offset_(0)
+    , messages_sent_(0)
+    , packets_sent_(0)
+    , started_(0)
+    , messages_metric_(jb::metrics::default_registry().make_counter(
+          "replay_messages", "the number of ITCH-5.x messages replayed",
+          {{"session", cfg.name()}}))
+    , packets_metric_(jb::metrics::default_registry().make_counter(
+          "replay_packets_sent", "the number of MoldUDP64 packets sent",
+          {{"session", cfg.name()}}))
     , io_()
     , s0_(io_)
     , ep0_()
     , s1_(io_)
     , ep1_()
-    , ep1_enabled_(false) {
+    , ep1_enabled_(false)
+    , sink0_{s0_, ep0_}
+    , sink1_{s1_, ep1_}
+    , impairment0_(cfg.primary_impairment(), cfg.name() + "/primary")
+    , impairment1_(cfg.secondary_impairment(), cfg.name() + "/secondary") {
 #ifndef ATOMIC_BOOL_LOCK_FREE
 #error "Missing ATOMIC_BOOL_LOCK_FREE required by C++11 standard"
 #endif // ATOMIC_BOOL_LOCK_FREE
@@ -313,16 +724,38 @@ session::session(config const& cfg)
 
 void session::start() {
   auto self = shared_from_this();
-
-  boost::iostreams::filtering_istream in;
-  jb::open_input_file(in, cfg_.input_file());
-  jb::itch5::process_iostream_mlist<session>(in, *self);
+  started_.store(now().time_since_epoch().count(), std::memory_order_relaxed);
+
+  if (store_) {
+    // ... the file was loaded (and decompressed) when the program
+    // started, otherwise fast replays are limited by the I/O ...
+    jb::itch5::process_store_mlist<session>(*store_, *self);
+  } else {
+    boost::iostreams::filtering_istream in;
+    jb::open_input_file(in, cfg_.input_file());
+    jb::itch5::process_iostream_mlist<session>(in, *self);
+  }
+  // ... send any packets held by the impairments ...
+  impairment0_.flush(sink0_);
+  impairment1_.flush(sink1_);
+  stats_.log_summary();
 }
 
 void session::stop() {
   stop_.store(true, std::memory_order_release);
 }
 
+double session::message_rate() const {
+  auto started = started_.load(std::memory_order_relaxed);
+  if (started == 0) {
+    return 0;
+  }
+  using fseconds = std::chrono::duration<double>;
+  auto elapsed = now() - time_point(time_point::duration(started));
+  auto seconds = std::chrono::duration_cast<fseconds>(elapsed).count();
+  return seconds <= 0 ? 0 : messages_sent() / seconds;
+}
+
 void session::handle_unknown(
     time_point const& recv_ts, jb::itch5::unknown_message const& msg) {
   if (stop_.load(std::memory_order_consume)) {
@@ -330,126 +763,247 @@ void session::handle_unknown(
   }
   last_message_count_.store(msg.count(), std::memory_order_relaxed);
   last_message_offset_.store(msg.offset(), std::memory_order_relaxed);
+  amplifier_.handle_message(
+      msg, [this, &recv_ts](jb::itch5::unknown_message const& m) {
+        send(recv_ts, m);
+      });
+}
+
+void session::send(
+    time_point const& recv_ts, jb::itch5::unknown_message const& msg) {
+  messages_metric_.inc();
+  messages_sent_.fetch_add(1, std::memory_order_relaxed);
   auto sink = [this](auto buffers) {
-    s0_.send_to(buffers, ep0_);
+    packets_metric_.inc();
+    packets_sent_.fetch_add(1, std::memory_order_relaxed);
+    auto const send_ts = now();
+    impairment0_.handle_packet(send_ts, buffers, sink0_);
     if (ep1_enabled_) {
-      s1_.send_to(buffers, ep1_);
+      impairment1_.handle_packet(send_ts, buffers, sink1_);
     }
   };
-  auto sleeper = [](jb::itch5::mold_udp_pacer<>::duration d) {
-    // ... never sleep for more than 10 seconds, the feeds typically
-    // have large idle times early and waiting for hours to start
-    // doing anything interesting is kind of boring ...
-    if (d > std::chrono::seconds(10)) {
-      d = std::chrono::seconds(10);
-    }
-    std::this_thread::sleep_for(d);
+  auto ts = msg.decode_header<false>().timestamp;
+  if (msg.count() == 0) {
+    engine_.start(recv_ts, ts);
+  }
+  auto sleeper = [this, ts](jb::itch5::mold_udp_pacer<>::duration) {
+    // ... the engine never waits for more than
+    // --pacer.maximum-sleep-milliseconds, the feeds typically have
+    // large idle times early and waiting for hours to start doing
+    // anything interesting is kind of boring ...
+    stats_.skip(engine_.wait(ts));
   };
   pacer_.handle_message(recv_ts, msg, sink, sleeper);
+  stats_.sample(now(), ts);
 }
 
-replayer_control::replayer_control(config const& cfg)
-    : cfg_(cfg)
-    , mu_()
-    , current_state_(state::idle) {
+replayer_control::replayer_control(
+    config const& cfg, preloaded_files const& files)
+    : mu_()
+    , sessions_() {
+  for (auto const& c : cfg.replay_sessions()) {
+    shared_store store;
+    if (c.preload()) {
+      store = files.at(c.input_file());
+    }
+    sessions_.emplace(c.name(), session_state{c, store, state::idle, nullptr});
+  }
 }
 
-void replayer_control::status(jb::ehs::response_type& res) const {
-  res.set("content-type", "text/plain");
+/// Return a printable name for each state
+char const* state_name(replayer_control::state s) {
+  switch (s) {
+  case replayer_control::state::idle:
+    return "idle";
+  case replayer_control::state::starting:
+    return "starting";
+  case replayer_control::state::replaying:
+    return "replaying";
+  case replayer_control::state::stopping:
+    return "stopping";
+  }
+  return "unknown";
+}
 
+void replayer_control::sessions(
+    jb::ehs::request_type const&, jb::ehs::response_type& res) const {
+  res.set("content-type", "text/plain");
   std::lock_guard<std::mutex> guard(mu_);
   std::ostringstream os;
-  switch (current_state_) {
-  case state::idle:
-    res.body = "idle\nNothing to see here folks\n";
-    return;
-  case state::starting:
-    os << "starting\nMessages arriving shortly\n";
-    break;
-  case state::stopping:
-    os << "stopping\nMessages will stop flowing\n";
-    break;
-  case state::replaying:
-    os << "replaying\n";
-    break;
-  default:
-    res.result(beast::http::status::internal_server_error);
-    res.body = "Unkown state\n";
-    return;
+  for (auto const& i : sessions_) {
+    os << i.first << ": " << state_name(i.second.current) << "\n";
   }
-  JB_ASSERT_THROW(session_.get() != 0);
-  os << "  last-count: " << session_->last_message_count() << "\n"
-     << "  last-offset: " << session_->last_message_offset() << "\n"
-     << "\n";
   res.body = os.str();
 }
 
+void replayer_control::status(
+    jb::ehs::request_type const& req, jb::ehs::response_type& res) const {
+  res.set("content-type", "text/plain");
+
+  std::lock_guard<std::mutex> guard(mu_);
+  auto names = selected(req, res);
+  std::ostringstream os;
+  for (auto const& name : names) {
+    auto const& s = sessions_.at(name);
+    os << name << ": " << state_name(s.current) << "\n"
+       << "  input-file: " << s.cfg.input_file() << "\n";
+    if (s.current == state::idle or not s.replay) {
+      os << "\n";
+      continue;
+    }
+    os << "  last-count: " << s.replay->last_message_count() << "\n"
+       << "  last-offset: " << s.replay->last_message_offset() << "\n"
+       << "  messages-sent: " << s.replay->messages_sent() << "\n"
+       << "  packets-sent: " << s.replay->packets_sent() << "\n"
+       << "  message-rate: " << s.replay->message_rate() << "\n"
+       << "\n";
+  }
+  res.body += os.str();
+}
+
 void replayer_control::start(
-    jb::ehs::request_type const&, jb::ehs::response_type& res) {
+    jb::ehs::request_type const& req, jb::ehs::response_type& res) {
   std::lock_guard<std::mutex> guard(mu_);
-  if (current_state_ != state::idle) {
-    res.result(beast::http::status::precondition_required);
-    res.body = "request rejected, current status is not idle\n";
+  auto names = selected(req, res);
+  if (names.empty()) {
     return;
   }
   // ... set the result before any computation, if there is a failure
   // it will raise an exception and the caller sends back the error
   // ...
   res.result(beast::http::status::ok);
-  res.body = "request succeeded, started new session\n";
-  auto s = std::make_shared<session>(cfg_);
+  std::ostringstream os;
+  int started = 0;
+  for (auto const& name : names) {
+    auto& s = sessions_.at(name);
+    if (s.current != state::idle) {
+      os << name << ": rejected, current status is "
+         << state_name(s.current) << "\n";
+      continue;
+    }
+    start_session(name, s);
+    os << name << ": started new session\n";
+    ++started;
+  }
+  if (started == 0) {
+    res.result(beast::http::status::precondition_required);
+    os << "request rejected, no sessions started\n";
+  } else {
+    os << "request succeeded\n";
+  }
+  res.body = os.str();
+}
+
+void replayer_control::stop(
+    jb::ehs::request_type const& req, jb::ehs::response_type& res) {
+  std::lock_guard<std::mutex> guard(mu_);
+  auto names = selected(req, res);
+  if (names.empty()) {
+    return;
+  }
+  res.result(beast::http::status::ok);
+  std::ostringstream os;
+  int stopped = 0;
+  for (auto const& name : names) {
+    auto& s = sessions_.at(name);
+    if (s.current != state::replaying and s.current != state::starting) {
+      os << name << ": rejected, current status is "
+         << state_name(s.current) << "\n";
+      continue;
+    }
+    s.current = state::stopping;
+    JB_ASSERT_THROW(s.replay.get() != 0);
+    s.replay->stop();
+    os << name << ": stopping current session\n";
+    ++stopped;
+  }
+  if (stopped == 0) {
+    res.result(beast::http::status::precondition_required);
+    os << "request rejected, no sessions stopped\n";
+  } else {
+    os << "request succeeded\n";
+  }
+  res.body = os.str();
+}
+
+std::vector<std::string> replayer_control::selected(
+    jb::ehs::request_type const& req, jb::ehs::response_type& res) const {
+  auto name = jb::ehs::request_dispatcher::query_parameter(
+      std::string(req.target()), "session");
+  std::vector<std::string> names;
+  if (name.empty()) {
+    for (auto const& i : sessions_) {
+      names.push_back(i.first);
+    }
+    return names;
+  }
+  if (sessions_.find(name) == sessions_.end()) {
+    res.result(beast::http::status::not_found);
+    res.body = "unknown session: " + name + "\n";
+    return names;
+  }
+  names.push_back(name);
+  return names;
+}
+
+void replayer_control::start_session(
+    std::string const& name, session_state& s) {
+  auto replay = std::make_shared<session>(s.cfg, s.store);
   // ... wait until this point to set the state to starting, if there
   // are failures before we have not changed the state and can
   // continue ...
-  current_state_ = state::starting;
-  jb::launch_thread(session_thread_, cfg_.replay_session(), [s, this]() {
+  s.current = state::starting;
+  s.replay = replay;
+  std::thread t;
+  jb::launch_thread(t, s.cfg.replay_session(), [replay, name, this]() {
     // ... check if the session can start, maybe it was stopped
     // before the thread started ...
-    if (not start_check()) {
+    if (not start_check(name)) {
       return;
     }
     // ... run the session, without holding the mu_ lock ...
     try {
-      s->start();
+      replay->start();
     } catch (...) {
     }
     // ... reset the state to idle, even if an exception is raised
     // ...
-    replay_done();
+    replay_done(name);
   });
-  session_thread_.detach();
-  session_ = s;
-}
-
-void replayer_control::stop(
-    jb::ehs::request_type const&, jb::ehs::response_type& res) {
-  std::lock_guard<std::mutex> guard(mu_);
-  if (current_state_ != state::replaying and
-      current_state_ != state::starting) {
-    res.result(beast::http::status::precondition_required);
-    res.body = "request rejected, current status is not valid\n";
-    return;
-  }
-  current_state_ = state::stopping;
-  res.result(beast::http::status::ok);
-  res.body = "request succeeded, stopping current session\n";
-  JB_ASSERT_THROW(session_.get() != 0);
-  session_->stop();
+  t.detach();
 }
 
-bool replayer_control::start_check() {
+bool replayer_control::start_check(std::string const& name) {
   std::lock_guard<std::mutex> guard(mu_);
-  if (current_state_ != state::starting) {
+  auto& s = sessions_.at(name);
+  if (s.current != state::starting) {
     return false;
   }
-  current_state_ = state::replaying;
+  s.current = state::replaying;
   return true;
 }
 
-void replayer_control::replay_done() {
+void replayer_control::replay_done(std::string const& name) {
   std::lock_guard<std::mutex> guard(mu_);
-  current_state_ = state::idle;
-  session_.reset();
+  auto& s = sessions_.at(name);
+  s.current = state::idle;
+  s.replay.reset();
+}
+
+shared_store
+preload_file(preloaded_files& files, std::string const& filename) {
+  auto i = files.find(filename);
+  if (i != files.end()) {
+    return i->second;
+  }
+  boost::iostreams::filtering_istream in;
+  jb::open_input_file(in, filename);
+  auto store = std::make_shared<jb::itch5::message_store>();
+  store->load(in);
+  JB_LOG(info) << "preloaded " << store->size() << " messages from "
+               << filename;
+  files.emplace(filename, store);
+  return store;
 }
 
 } // anonymous namespace
@@ -0,0 +1,109 @@
+#include "jb/itch5/pacing_engine.hpp"
+
+#include <thread>
+#include <vector>
+
+namespace jb {
+namespace itch5 {
+namespace {
+/// Fractional nanoseconds, to scale the intervals by the speed
+using fnanoseconds = std::chrono::duration<double, std::nano>;
+
+/**
+ * The binning for the skew histogram.
+ *
+ * Use 1-2-5 steps from 10 nanoseconds to 10 seconds, the interesting
+ * values are well below the sleep_for() granularity.
+ */
+jb::explicit_cuts_binning<std::int64_t> skew_binning() {
+  std::vector<std::int64_t> cuts{0};
+  for (std::int64_t decade = 10; decade != 10000000000; decade *= 10) {
+    cuts.push_back(decade);
+    cuts.push_back(2 * decade);
+    cuts.push_back(5 * decade);
+  }
+  cuts.push_back(10000000000);
+  return jb::explicit_cuts_binning<std::int64_t>(cuts.begin(), cuts.end());
+}
+
+/// Hint the CPU that we are in a spin loop
+inline void cpu_relax() {
+#if defined(JB_TSC_CLOCK_HAS_TSC)
+  _mm_pause();
+#endif // defined(JB_TSC_CLOCK_HAS_TSC)
+}
+} // anonymous namespace
+
+pacing_engine::pacing_engine(
+    mold_udp_pacer_config const& cfg, jb::metrics::registry& r,
+    jb::metrics::labels const& l)
+    : speed_(cfg.speed())
+    , spin_(std::chrono::microseconds(cfg.spin_microseconds()))
+    , maximum_sleep_(
+          std::chrono::milliseconds(cfg.maximum_sleep_milliseconds()))
+    , recalibration_period_(std::chrono::milliseconds(
+          cfg.recalibration_period_milliseconds()))
+    , last_recalibration_()
+    , recalibrations_(0)
+    , started_(false)
+    , origin_wall_()
+    , origin_ts_(0)
+    , skew_(r.make_histogram(
+          "replay_send_skew_nanoseconds",
+          "the difference between the scheduled and actual end of each "
+          "wait in the replay",
+          skew_binning(), l)) {
+  clock_type::calibrate();
+  last_recalibration_ = clock_type::now();
+}
+
+void pacing_engine::start(time_point now, timestamp ts) {
+  origin_wall_ = now;
+  origin_ts_ = ts.ts;
+  started_ = true;
+}
+
+pacing_engine::duration pacing_engine::wait(timestamp ts) {
+  auto now = clock_type::now();
+  if (recalibration_period_.count() != 0 and
+      now - last_recalibration_ >= recalibration_period_) {
+    clock_type::recalibrate(recalibration_period_);
+    ++recalibrations_;
+    last_recalibration_ = now = clock_type::now();
+  }
+  if (not started_) {
+    start(now, ts);
+    return duration(0);
+  }
+  auto deadline = origin_wall_ + std::chrono::duration_cast<duration>(
+                                     fnanoseconds(ts.ts - origin_ts_) / speed_);
+  // ... if the wait is too long, move the schedule so the wait is
+  // exactly the maximum sleep time ...
+  duration skipped(0);
+  if (deadline - now > maximum_sleep_) {
+    skipped = deadline - now - maximum_sleep_;
+    origin_wall_ -= skipped;
+    deadline -= skipped;
+  }
+  // ... sleep for the coarse part of the wait, the thread may wake up
+  // late, but hopefully not later than the deadline ...
+  if (deadline - now > spin_) {
+    std::this_thread::sleep_for(deadline - now - spin_);
+  }
+  now = spin_until(deadline);
+  skew_.sample((now - deadline).count());
+  return skipped;
+}
+
+pacing_engine::time_point
+pacing_engine::spin_until(time_point deadline) const {
+  auto now = clock_type::now();
+  while (now < deadline) {
+    cpu_relax();
+    now = clock_type::now();
+  }
+  return now;
+}
+
+} // namespace itch5
+} // namespace jb
@@ -0,0 +1,121 @@
+#ifndef jb_itch5_pacing_engine_hpp
+#define jb_itch5_pacing_engine_hpp
+
+#include <jb/itch5/mold_udp_pacer_config.hpp>
+#include <jb/itch5/timestamp.hpp>
+#include <jb/explicit_cuts_binning.hpp>
+#include <jb/metrics.hpp>
+#include <jb/tsc_clock.hpp>
+
+#include <chrono>
+#include <cstdint>
+
+namespace jb {
+namespace itch5 {
+
+/**
+ * Wait until the (scaled) time when a message must be sent.
+ *
+ * jb::itch5::mold_udp_pacer decides when a replay must wait, but it
+ * delegates the actual waiting to a sleeper functor.  Simply calling
+ * std::this_thread::sleep_for() in the functor has two problems:
+ * the thread typically wakes up 50 to 100 microseconds late, which
+ * destroys the microbursts in the original feed, and the errors
+ * accumulate over the replay.
+ *
+ * This class computes an absolute deadline for each message, using
+ * the wall-clock time and timestamp of the first message, scaled by
+ * the replay speed.  It sleeps for the coarse part of the wait, and
+ * then spins on jb::tsc_clock (which is cheap to call) until the
+ * deadline.  The difference between the deadline and the time the
+ * wait actually ends is recorded in a histogram.  Replays can last
+ * for hours, so the clock is recalibrated periodically, at the
+ * beginning of a wait, never while spinning.
+ *
+ * Typically used in the sleeper functor:
+ *
+ * @code
+ * auto sleeper = [this, ts](mold_udp_pacer<>::duration) {
+ *   engine_.wait(ts);
+ * };
+ * pacer_.handle_message(recv_ts, msg, sink, sleeper);
+ * @endcode
+ */
+class pacing_engine {
+public:
+  //@{
+  /**
+   * @name Type traits
+   */
+  typedef jb::tsc_clock clock_type;
+  typedef clock_type::time_point time_point;
+  typedef clock_type::duration duration;
+  typedef jb::metrics::histogram<jb::explicit_cuts_binning<std::int64_t>>
+      skew_histogram;
+  //@}
+
+  /**
+   * Constructor.
+   *
+   * @param cfg the pacer configuration, defines the replay speed, how
+   * long to spin, and the maximum wait
+   * @param r where to publish the skew histogram
+   * @param l the labels for the skew histogram
+   */
+  explicit pacing_engine(
+      mold_udp_pacer_config const& cfg,
+      jb::metrics::registry& r = jb::metrics::default_registry(),
+      jb::metrics::labels const& l = jb::metrics::labels());
+
+  /**
+   * Set the origin of the schedule.
+   *
+   * @param now the wall-clock time for the first message
+   * @param ts the timestamp of the first message
+   */
+  void start(time_point now, timestamp ts);
+
+  /**
+   * Block until the deadline for a message.
+   *
+   * If the origin was not set the schedule starts with this
+   * message, and the function returns immediately.
+   *
+   * @param ts the timestamp of the message
+   * @returns how much of the wait was skipped because it exceeded
+   * the maximum sleep time, the schedule for all the following
+   * messages is moved earlier by this amount
+   */
+  duration wait(timestamp ts);
+
+  /// The histogram of send skews, in nanoseconds
+  skew_histogram const& skew() const {
+    return skew_;
+  }
+
+  /// The number of times the clock was recalibrated
+  std::uint64_t recalibrations() const {
+    return recalibrations_;
+  }
+
+private:
+  /// Spin until @a deadline, return the time when the spin ended
+  time_point spin_until(time_point deadline) const;
+
+private:
+  double speed_;
+  duration spin_;
+  duration maximum_sleep_;
+  duration recalibration_period_;
+  time_point last_recalibration_;
+  std::uint64_t recalibrations_;
+  bool started_;
+  time_point origin_wall_;
+  std::chrono::nanoseconds origin_ts_;
+  skew_histogram& skew_;
+};
+
+} // namespace itch5
+} // namespace jb
+
+#endif // jb_itch5_pacing_engine_hpp
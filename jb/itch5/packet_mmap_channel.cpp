@@ -0,0 +1,318 @@
+#include "jb/itch5/packet_mmap_channel.hpp"
+
+#include <jb/itch5/clock_type.hpp>
+#include <jb/itch5/make_socket_udp_recv.hpp>
+#include <jb/itch5/udp_receiver_config.hpp>
+#include <jb/launch_thread.hpp>
+#include <jb/log.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+#include <utility>
+
+#include <arpa/inet.h>
+#include <linux/filter.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace jb {
+namespace itch5 {
+namespace {
+/// The fragment offset and more-fragments bits in the IPv4 header,
+/// any of them set means the packet is a fragment
+std::uint16_t const ipv4_fragment_mask = 0x3fff;
+
+/// Raise a std::system_error if @a r is -1, using errno
+void check_syscall(int r, char const* msg) {
+  if (r != -1) {
+    return;
+  }
+  throw std::system_error(errno, std::generic_category(), msg);
+}
+
+/// Read a 16-bit big endian value from an unaligned location
+std::uint16_t read_be16(char const* p) {
+  std::uint16_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return ntohs(v);
+}
+
+/**
+ * Attach a classic BPF filter to a socket.
+ *
+ * @param fd the socket
+ * @param code the filter program
+ * @param len the number of instructions in @a code
+ */
+void attach_filter(int fd, ::sock_filter* code, std::size_t len) {
+  ::sock_fprog prog;
+  prog.len = static_cast<unsigned short>(len);
+  prog.filter = code;
+  check_syscall(
+      ::setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog)),
+      "packet_mmap_channel - attaching filter");
+}
+} // anonymous namespace
+
+packet_mmap_channel::packet_mmap_channel(
+    boost::asio::io_service& io, buffer_handler const& handler,
+    udp_receiver_config const& cfg, packet_mmap_config const& mmcfg)
+    : packet_mmap_channel(io, buffer_handler(handler), cfg, mmcfg) {
+}
+
+packet_mmap_channel::packet_mmap_channel(
+    boost::asio::io_service& io, buffer_handler&& handler,
+    udp_receiver_config const& cfg, packet_mmap_config const& mmcfg)
+    : stream_(std::move(handler))
+    , membership_(make_socket_udp_recv<>(io, cfg))
+    , destination_(
+          boost::asio::ip::address::from_string(cfg.address()), cfg.port())
+    , fd_(-1)
+    , ring_(nullptr)
+    , block_size_(mmcfg.block_size())
+    , block_count_(mmcfg.block_count())
+    , busy_poll_(mmcfg.busy_poll())
+    , stop_(false)
+    , poll_thread_() {
+  // ... the membership socket is never read, all the data is received
+  // via the ring, so have the kernel drop its packets as early as
+  // possible ...
+  ::sock_filter drop_all[] = {BPF_STMT(BPF_RET | BPF_K, 0)};
+  attach_filter(membership_.native_handle(), drop_all, 1);
+
+  open_ring(mmcfg);
+
+  // ... same as the busy poll mode in mold_udp_channel, the io_service
+  // must be kept busy while the thread runs ...
+  boost::asio::io_service::work work(io);
+  jb::launch_thread(
+      poll_thread_, mmcfg.poll_thread(), [this, work]() { poll_loop(); });
+}
+
+packet_mmap_channel::~packet_mmap_channel() {
+  stop_.store(true, std::memory_order_release);
+  if (poll_thread_.joinable()) {
+    poll_thread_.join();
+  }
+  close_ring();
+}
+
+void packet_mmap_channel::open_ring(packet_mmap_config const& mmcfg) {
+  fd_ = ::socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+  check_syscall(fd_, "packet_mmap_channel - creating AF_PACKET socket");
+  try {
+    int version = TPACKET_V3;
+    check_syscall(
+        ::setsockopt(
+            fd_, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)),
+        "packet_mmap_channel - setting TPACKET_V3");
+
+    // ... restrict the frames to the destination, only for IPv4, the
+    // IPv6 headers are too variable for a simple filter.  The
+    // program assumes an Ethernet header, which is also what the
+    // loopback and veth interfaces use.  It must accept exactly the
+    // same frames as process_frame() ...
+    auto const& address = destination_.address();
+    if (address.is_v4()) {
+      std::uint32_t dst = address.to_v4().to_ulong();
+      ::sock_filter code[] = {
+          BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 12),
+          BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_IP, 0, 10),
+          BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 23),
+          BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, 0, 8),
+          BPF_STMT(BPF_LD | BPF_W | BPF_ABS, 30),
+          BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, dst, 0, 6),
+          BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 20),
+          BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, ipv4_fragment_mask, 4, 0),
+          BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, 14),
+          BPF_STMT(BPF_LD | BPF_H | BPF_IND, 16),
+          BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, destination_.port(), 0, 1),
+          BPF_STMT(BPF_RET | BPF_K, 0x40000),
+          BPF_STMT(BPF_RET | BPF_K, 0),
+      };
+      // ... an unspecified address accepts any destination, replace
+      // the load and comparison of the destination with no-ops ...
+      if (address.is_unspecified()) {
+        code[4] = BPF_STMT(BPF_JMP | BPF_JA, 0);
+        code[5] = BPF_STMT(BPF_JMP | BPF_JA, 0);
+      }
+      attach_filter(fd_, code, sizeof(code) / sizeof(code[0]));
+    }
+
+#if defined(PACKET_IGNORE_OUTGOING)
+    // ... on the loopback interface each packet is seen twice, skip
+    // the outgoing copy in the kernel if possible, process_block()
+    // drops them otherwise ...
+    int ignore = 1;
+    (void)::setsockopt(
+        fd_, SOL_PACKET, PACKET_IGNORE_OUTGOING, &ignore, sizeof(ignore));
+#endif // defined(PACKET_IGNORE_OUTGOING)
+
+    ::tpacket_req3 req;
+    std::memset(&req, 0, sizeof(req));
+    req.tp_block_size = mmcfg.block_size();
+    req.tp_block_nr = mmcfg.block_count();
+    req.tp_frame_size = mmcfg.frame_size();
+    req.tp_frame_nr = (req.tp_block_size / req.tp_frame_size) * req.tp_block_nr;
+    req.tp_retire_blk_tov = mmcfg.block_timeout_milliseconds();
+    check_syscall(
+        ::setsockopt(fd_, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)),
+        "packet_mmap_channel - creating PACKET_RX_RING");
+
+    void* ring = ::mmap(
+        nullptr, block_size_ * block_count_, PROT_READ | PROT_WRITE,
+        MAP_SHARED, fd_, 0);
+    if (ring == MAP_FAILED) {
+      check_syscall(-1, "packet_mmap_channel - mapping the ring");
+    }
+    ring_ = static_cast<char*>(ring);
+
+    ::sockaddr_ll ll;
+    std::memset(&ll, 0, sizeof(ll));
+    ll.sll_family = AF_PACKET;
+    ll.sll_protocol = htons(ETH_P_ALL);
+    ll.sll_ifindex = ::if_nametoindex(mmcfg.interface().c_str());
+    if (ll.sll_ifindex == 0) {
+      check_syscall(-1, "packet_mmap_channel - unknown interface");
+    }
+    check_syscall(
+        ::bind(fd_, reinterpret_cast<::sockaddr*>(&ll), sizeof(ll)),
+        "packet_mmap_channel - binding to interface");
+  } catch (...) {
+    close_ring();
+    throw;
+  }
+  JB_LOG(info) << "packet_mmap_channel: receiving " << destination_
+               << " on interface " << mmcfg.interface();
+}
+
+void packet_mmap_channel::close_ring() {
+  if (ring_ != nullptr) {
+    ::munmap(ring_, block_size_ * block_count_);
+    ring_ = nullptr;
+  }
+  if (fd_ != -1) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+
+void packet_mmap_channel::poll_loop() {
+  std::size_t current = 0;
+  while (not stop_.load(std::memory_order_acquire)) {
+    auto block =
+        reinterpret_cast<::tpacket_block_desc*>(ring_ + current * block_size_);
+    // ... the kernel and the application hand over the blocks using
+    // the status field, it must be read and written with the right
+    // memory ordering ...
+    auto status =
+        __atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE);
+    if ((status & TP_STATUS_USER) == 0) {
+      if (not busy_poll_) {
+        // ... wait for the next block, but not forever, we need to
+        // check if the channel is stopped every so often ...
+        ::pollfd pfd;
+        pfd.fd = fd_;
+        pfd.events = POLLIN | POLLERR;
+        pfd.revents = 0;
+        (void)::poll(&pfd, 1, 10);
+      }
+      continue;
+    }
+    process_block(reinterpret_cast<char const*>(block));
+    // ... return the block to the kernel and move to the next one ...
+    __atomic_store_n(
+        &block->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+    current = (current + 1) % block_count_;
+  }
+}
+
+void packet_mmap_channel::process_block(char const* block) {
+  auto const& bh =
+      reinterpret_cast<::tpacket_block_desc const*>(block)->hdr.bh1;
+  // ... all the frames in the block share the same timestamp, the
+  // kernel timestamps are in the wrong clock anyway ...
+  auto recv_ts = clock_type::now();
+  char const* frame = block + bh.offset_to_first_pkt;
+  for (std::uint32_t i = 0; i != bh.num_pkts; ++i) {
+    auto hdr = reinterpret_cast<::tpacket3_hdr const*>(frame);
+    auto ll = reinterpret_cast<::sockaddr_ll const*>(
+        frame + TPACKET_ALIGN(sizeof(::tpacket3_hdr)));
+    if (ll->sll_pkttype != PACKET_OUTGOING) {
+      process_frame(recv_ts, frame + hdr->tp_mac, hdr->tp_snaplen);
+    }
+    frame += hdr->tp_next_offset;
+  }
+}
+
+void packet_mmap_channel::process_frame(
+    std::chrono::steady_clock::time_point recv_ts, char const* frame,
+    std::size_t len) {
+  // ... the BPF filter already did most of this for IPv4, but frames
+  // received before the filter was attached can be in the ring, and
+  // IPv6 is not filtered at all ...
+  std::size_t const eth_header_size = 14;
+  if (len < eth_header_size) {
+    return;
+  }
+  auto ethertype = read_be16(frame + 12);
+  char const* l3 = frame + eth_header_size;
+  std::size_t l3len = len - eth_header_size;
+
+  auto const& address = destination_.address();
+  char const* udp = nullptr;
+  if (ethertype == ETH_P_IP and address.is_v4()) {
+    if (l3len < 20 or l3[9] != IPPROTO_UDP) {
+      return;
+    }
+    // ... ignore fragments, MoldUDP64 packets should never be
+    // fragmented ...
+    if ((read_be16(l3 + 6) & ipv4_fragment_mask) != 0) {
+      return;
+    }
+    auto dst = address.to_v4().to_bytes();
+    if (not address.is_unspecified() and
+        std::memcmp(l3 + 16, dst.data(), dst.size()) != 0) {
+      return;
+    }
+    std::size_t ihl = (l3[0] & 0x0f) * 4;
+    udp = l3 + ihl;
+  } else if (ethertype == ETH_P_IPV6 and address.is_v6()) {
+    // ... extension headers are not supported ...
+    if (l3len < 40 or l3[6] != IPPROTO_UDP) {
+      return;
+    }
+    auto dst = address.to_v6().to_bytes();
+    if (not address.is_unspecified() and
+        std::memcmp(l3 + 24, dst.data(), dst.size()) != 0) {
+      return;
+    }
+    udp = l3 + 40;
+  } else {
+    return;
+  }
+
+  std::size_t const udp_header_size = 8;
+  if (udp + udp_header_size > frame + len) {
+    return;
+  }
+  if (read_be16(udp + 2) != destination_.port()) {
+    return;
+  }
+  std::size_t udp_length = read_be16(udp + 4);
+  if (udp_length < udp_header_size or udp + udp_length > frame + len) {
+    return;
+  }
+  stream_.process_packet(
+      recv_ts, udp + udp_header_size, udp_length - udp_header_size);
+}
+
+} // namespace itch5
+} // namespace jb
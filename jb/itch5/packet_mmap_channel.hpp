@@ -0,0 +1,128 @@
+#ifndef jb_itch5_packet_mmap_channel_hpp
+#define jb_itch5_packet_mmap_channel_hpp
+
+#include <jb/itch5/mold_udp_stream.hpp>
+#include <jb/itch5/packet_mmap_config.hpp>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/ip/udp.hpp>
+
+#include <atomic>
+#include <thread>
+
+namespace jb {
+namespace itch5 {
+
+class udp_receiver_config;
+
+/**
+ * Receive MoldUDP64 packets from a memory mapped TPACKET_V3 ring.
+ *
+ * This is an alternative to jb::itch5::mold_udp_channel that avoids
+ * copying each packet from the kernel into an application buffer.
+ * The class creates an AF_PACKET socket bound to a network interface,
+ * maps its receive ring into the process, and parses the MoldUDP64
+ * blocks directly out of the ring frames.  A (classic) BPF filter
+ * restricts the frames to the configured IPv4 destination address
+ * and port, IPv6 frames are filtered in user space.
+ *
+ * The class also opens a regular UDP socket, configured as usual
+ * via udp_receiver_config, so the host joins the multicast group (or
+ * owns the unicast port).  That socket drops all its packets in the
+ * kernel, it is never read.
+ *
+ * The ring is read from a dedicated thread, which invokes the
+ * handler.  Creating AF_PACKET sockets typically requires the
+ * CAP_NET_RAW capability.
+ */
+class packet_mmap_channel {
+public:
+  /**
+   * A callback function type to process any received ITCH-5.0
+   * messages, see jb::itch5::mold_udp_stream for details.
+   */
+  typedef mold_udp_stream::buffer_handler buffer_handler;
+
+  /**
+   * Constructor, create the ring and start the thread reading it.
+   *
+   * @param io the Boost.ASIO IO service, used for the group membership
+   * socket, and kept busy while the thread runs
+   * @param handler the callback to invoke to process any ITCH-5.0
+   * messages received
+   * @param cfg the destination of the MoldUDP64 packets
+   * @param mmcfg the configuration for the ring
+   * @throws std::system_error if the ring cannot be created
+   */
+  packet_mmap_channel(
+      boost::asio::io_service& io, buffer_handler const& handler,
+      udp_receiver_config const& cfg, packet_mmap_config const& mmcfg);
+
+  /// Constructor, see above
+  packet_mmap_channel(
+      boost::asio::io_service& io, buffer_handler&& handler,
+      udp_receiver_config const& cfg, packet_mmap_config const& mmcfg);
+
+  /// Destructor, stop the thread and release the ring
+  ~packet_mmap_channel();
+
+  packet_mmap_channel(packet_mmap_channel const&) = delete;
+  packet_mmap_channel& operator=(packet_mmap_channel const&) = delete;
+
+private:
+  /// Create the AF_PACKET socket and map its ring
+  void open_ring(packet_mmap_config const& mmcfg);
+
+  /// Release the ring and close the AF_PACKET socket
+  void close_ring();
+
+  /// Read blocks from the ring until the channel is destroyed
+  void poll_loop();
+
+  /// Process all the frames in a block owned by the application
+  void process_block(char const* block);
+
+  /**
+   * Process a single frame, if it is a UDP datagram for the
+   * configured destination pass the payload to the stream.
+   *
+   * @param recv_ts when was the frame received
+   * @param frame the frame, starting at the link layer header
+   * @param len the length of the frame
+   */
+  void process_frame(
+      std::chrono::steady_clock::time_point recv_ts, char const* frame,
+      std::size_t len);
+
+private:
+  // Break down the packets and invoke the callback handler
+  mold_udp_stream stream_;
+
+  // Join the multicast group, or own the unicast port
+  boost::asio::ip::udp::socket membership_;
+
+  // The destination of the MoldUDP64 packets
+  boost::asio::ip::udp::endpoint destination_;
+
+  // The AF_PACKET socket
+  int fd_;
+
+  // The memory mapped ring
+  char* ring_;
+  std::size_t block_size_;
+  std::size_t block_count_;
+
+  // If true, spin on the ring instead of blocking on poll(2)
+  bool busy_poll_;
+
+  // Signal the thread to stop
+  std::atomic<bool> stop_;
+
+  // The thread reading the ring
+  std::thread poll_thread_;
+};
+
+} // namespace itch5
+} // namespace jb
+
+#endif // jb_itch5_packet_mmap_channel_hpp
@@ -0,0 +1,113 @@
+#include "jb/itch5/packet_mmap_config.hpp"
+#include <jb/usage.hpp>
+
+#include <sstream>
+
+#include <unistd.h>
+
+namespace jb {
+namespace itch5 {
+namespace defaults {
+
+#ifndef JB_ITCH5_DEFAULTS_packet_mmap_interface
+#define JB_ITCH5_DEFAULTS_packet_mmap_interface "lo"
+#endif // JB_ITCH5_DEFAULTS_packet_mmap_interface
+
+#ifndef JB_ITCH5_DEFAULTS_packet_mmap_block_size
+#define JB_ITCH5_DEFAULTS_packet_mmap_block_size (1 << 20)
+#endif // JB_ITCH5_DEFAULTS_packet_mmap_block_size
+
+#ifndef JB_ITCH5_DEFAULTS_packet_mmap_block_count
+#define JB_ITCH5_DEFAULTS_packet_mmap_block_count 64
+#endif // JB_ITCH5_DEFAULTS_packet_mmap_block_count
+
+#ifndef JB_ITCH5_DEFAULTS_packet_mmap_frame_size
+#define JB_ITCH5_DEFAULTS_packet_mmap_frame_size 2048
+#endif // JB_ITCH5_DEFAULTS_packet_mmap_frame_size
+
+#ifndef JB_ITCH5_DEFAULTS_packet_mmap_block_timeout_milliseconds
+#define JB_ITCH5_DEFAULTS_packet_mmap_block_timeout_milliseconds 1
+#endif // JB_ITCH5_DEFAULTS_packet_mmap_block_timeout_milliseconds
+
+std::string packet_mmap_interface = JB_ITCH5_DEFAULTS_packet_mmap_interface;
+int packet_mmap_block_size = JB_ITCH5_DEFAULTS_packet_mmap_block_size;
+int packet_mmap_block_count = JB_ITCH5_DEFAULTS_packet_mmap_block_count;
+int packet_mmap_frame_size = JB_ITCH5_DEFAULTS_packet_mmap_frame_size;
+int packet_mmap_block_timeout_milliseconds =
+    JB_ITCH5_DEFAULTS_packet_mmap_block_timeout_milliseconds;
+
+} // namespace defaults
+
+packet_mmap_config::packet_mmap_config()
+    : interface(
+          desc("interface")
+              .help("The network interface to receive packets from, for "
+                    "example 'lo' or 'eth0'."),
+          this, defaults::packet_mmap_interface)
+    , block_size(
+          desc("block-size")
+              .help("The size of each block in the TPACKET_V3 ring.  Must be "
+                    "a multiple of the page size."),
+          this, defaults::packet_mmap_block_size)
+    , block_count(
+          desc("block-count").help("The number of blocks in the ring."), this,
+          defaults::packet_mmap_block_count)
+    , frame_size(
+          desc("frame-size")
+              .help("The nominal frame size.  With TPACKET_V3 frames are "
+                    "variable length, but the kernel still requires this "
+                    "value to be consistent with --block-size."),
+          this, defaults::packet_mmap_frame_size)
+    , block_timeout_milliseconds(
+          desc("block-timeout-milliseconds")
+              .help("How long does the kernel wait before retiring a "
+                    "partially filled block.  Lower values reduce latency "
+                    "at low packet rates."),
+          this, defaults::packet_mmap_block_timeout_milliseconds)
+    , busy_poll(
+          desc("busy-poll")
+              .help("If set, spin on the ring instead of blocking on "
+                    "poll(2) when no blocks are ready."),
+          this, false)
+    , poll_thread(
+          desc("poll-thread", "thread-config")
+              .help("Configure the thread that reads from the ring."),
+          this, jb::thread_config().name("packet-mmap")) {
+}
+
+void packet_mmap_config::validate() const {
+  if (interface() == "") {
+    throw jb::usage("--interface must not be empty", 1);
+  }
+  long const page_size = ::sysconf(_SC_PAGESIZE);
+  if (block_size() <= 0 or block_size() % page_size != 0) {
+    std::ostringstream os;
+    os << "--block-size must be a positive multiple of the page size ("
+       << page_size << "), value=" << block_size();
+    throw jb::usage(os.str(), 1);
+  }
+  if (block_count() <= 0) {
+    std::ostringstream os;
+    os << "--block-count must be positive, value=" << block_count();
+    throw jb::usage(os.str(), 1);
+  }
+  // ... the kernel requires frames to be aligned to TPACKET_ALIGNMENT
+  // (16 bytes), and to fit in a block ...
+  if (frame_size() <= 0 or frame_size() % 16 != 0 or
+      frame_size() > block_size()) {
+    std::ostringstream os;
+    os << "--frame-size must be a positive multiple of 16, not larger than "
+       << "--block-size (" << block_size() << "), value=" << frame_size();
+    throw jb::usage(os.str(), 1);
+  }
+  if (block_timeout_milliseconds() < 0) {
+    std::ostringstream os;
+    os << "--block-timeout-milliseconds must be >= 0, value="
+       << block_timeout_milliseconds();
+    throw jb::usage(os.str(), 1);
+  }
+  poll_thread().validate();
+}
+
+} // namespace itch5
+} // namespace jb
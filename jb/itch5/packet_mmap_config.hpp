@@ -0,0 +1,38 @@
+#ifndef jb_itch5_packet_mmap_config_hpp
+#define jb_itch5_packet_mmap_config_hpp
+
+#include <jb/config_object.hpp>
+#include <jb/thread_config.hpp>
+
+namespace jb {
+namespace itch5 {
+
+/**
+ * Configure a jb::itch5::packet_mmap_channel.
+ *
+ * The channel receives all the frames in a network interface through
+ * a memory mapped TPACKET_V3 ring.  The ring is organized in @a
+ * block_count blocks of @a block_size bytes each, the kernel hands
+ * over a block to the application when it is full, or when @a
+ * block_timeout_milliseconds expire, whichever happens first.
+ */
+class packet_mmap_config : public jb::config_object {
+public:
+  packet_mmap_config();
+  config_object_constructors(packet_mmap_config);
+
+  void validate() const override;
+
+  jb::config_attribute<packet_mmap_config, std::string> interface;
+  jb::config_attribute<packet_mmap_config, int> block_size;
+  jb::config_attribute<packet_mmap_config, int> block_count;
+  jb::config_attribute<packet_mmap_config, int> frame_size;
+  jb::config_attribute<packet_mmap_config, int> block_timeout_milliseconds;
+  jb::config_attribute<packet_mmap_config, bool> busy_poll;
+  jb::config_attribute<packet_mmap_config, jb::thread_config> poll_thread;
+};
+
+} // namespace itch5
+} // namespace jb
+
+#endif // jb_itch5_packet_mmap_config_hpp
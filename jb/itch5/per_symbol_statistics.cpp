@@ -0,0 +1,21 @@
+#include "jb/itch5/per_symbol_statistics.hpp"
+
+#include <cstdint>
+
+jb::offline_feed_statistics::config
+jb::itch5::default_per_symbol_feed_statistics() {
+  // ... all the histograms use 2 significant digits, the latency
+  // histograms cover up to one hour with fewer bins than one bin per
+  // nanosecond up to 10 microseconds, and the statistics are small
+  // enough to keep them for every symbol ...
+  std::int64_t const one_hour = 3600 * 1000000000LL;
+  return jb::offline_feed_statistics::config()
+      .reporting_interval_seconds(24 * 3600)     // disable reporting
+      .max_processing_latency_nanoseconds(one_hour)
+      .max_interarrival_time_nanoseconds(one_hour)
+      .significant_digits(2)                     // limit memory usage
+      .max_messages_per_microsecond(1000)        // limit memory usage
+      .max_messages_per_millisecond(10000)       // limit memory usage
+      .max_messages_per_second(10000)            // limit memory usage
+      ;
+}
@@ -0,0 +1,137 @@
+#ifndef jb_itch5_per_symbol_statistics_hpp
+#define jb_itch5_per_symbol_statistics_hpp
+
+#include <jb/itch5/stock_field.hpp>
+#include <jb/offline_feed_statistics.hpp>
+
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace jb {
+namespace itch5 {
+
+/**
+ * Keep statistics for each symbol in an ITCH-5.x feed.
+ *
+ * The ITCH-5.x tools used to keep the per-symbol statistics in a
+ * std::map keyed by the symbol, that requires a string comparison
+ * search for each event.  This class uses the stock locate field in
+ * the message header instead: every symbol receives a unique, small,
+ * locate number for the session, so the statistics can be stored in
+ * a vector indexed by that number.
+ *
+ * The statistics are allocated the first time a symbol is seen, and
+ * owned by a std::map keyed by the symbol, so each symbol has exactly
+ * one set of statistics.  The vector only caches a pointer for each
+ * locate number up to the largest one observed.  If a locate number
+ * is reused with a different symbol, or if it is 0 (the messages were
+ * not generated by a real feed), the statistics are found via the
+ * (slower) map.
+ *
+ * @tparam statistics_t the type of statistics kept for each symbol,
+ * typically jb::offline_feed_statistics or jb::book_depth_statistics,
+ * it must be constructible from a statistics_t::config object.
+ */
+template <typename statistics_t>
+class per_symbol_statistics {
+public:
+  //@{
+  /**
+   * @name Type traits
+   */
+  typedef statistics_t statistics_type;
+  typedef typename statistics_t::config config;
+  //@}
+
+  /**
+   * Constructor.
+   *
+   * @param cfg the configuration for each symbol statistics
+   */
+  explicit per_symbol_statistics(config const& cfg)
+      : cfg_(cfg)
+      , by_locate_()
+      , by_stock_() {
+  }
+
+  /**
+   * Return the statistics for a symbol, creating them if needed.
+   *
+   * @param stock_locate the stock locate number in the message header
+   * @param stock the symbol
+   */
+  statistics_type& get(int stock_locate, stock_t const& stock) {
+    if (stock_locate <= 0) {
+      return get_by_stock(stock);
+    }
+    auto index = static_cast<std::size_t>(stock_locate);
+    if (index >= by_locate_.size()) {
+      by_locate_.resize(index + 1);
+    }
+    auto& e = by_locate_[index];
+    if (e.stats == nullptr) {
+      e.stock = stock;
+      e.stats = &get_by_stock(stock);
+    } else if (not(e.stock == stock)) {
+      return get_by_stock(stock);
+    }
+    return *e.stats;
+  }
+
+  /// The number of symbols with statistics
+  std::size_t size() const {
+    return by_stock_.size();
+  }
+
+  /**
+   * Call a functor for each symbol, in alphabetical order.
+   *
+   * @param f a functor compatible with
+   *   void(stock_t const&, statistics_type const&)
+   */
+  template <typename functor>
+  void for_each(functor&& f) const {
+    for (auto const& i : by_stock_) {
+      f(i.first, *i.second);
+    }
+  }
+
+private:
+  /// Find or create the statistics for a symbol
+  statistics_type& get_by_stock(stock_t const& stock) {
+    auto location = by_stock_.find(stock);
+    if (location == by_stock_.end()) {
+      location =
+          by_stock_.emplace(stock, std::make_unique<statistics_type>(cfg_))
+              .first;
+    }
+    return *location->second;
+  }
+
+private:
+  /// The cached statistics for one locate number, owned by by_stock_
+  struct entry {
+    stock_t stock;
+    statistics_type* stats = nullptr;
+  };
+
+  config cfg_;
+  std::vector<entry> by_locate_;
+  std::map<stock_t, std::unique_ptr<statistics_type>> by_stock_;
+};
+
+/**
+ * The default configuration for the per-symbol feed statistics.
+ *
+ * The tools that keep a jb::offline_feed_statistics for each symbol
+ * use this configuration, it disables the periodic reports and uses
+ * coarser histograms than the defaults, so the statistics for every
+ * symbol in the feed fit in memory.
+ */
+jb::offline_feed_statistics::config default_per_symbol_feed_statistics();
+
+} // namespace itch5
+} // namespace jb
+
+#endif // jb_itch5_per_symbol_statistics_hpp
@@ -0,0 +1,262 @@
+#include "jb/itch5/pipeline_latency.hpp"
+
+#include <jb/log.hpp>
+#include <jb/offline_feed_statistics.hpp>
+#include <jb/usage.hpp>
+
+#include <sstream>
+
+namespace jb {
+namespace itch5 {
+namespace defaults {
+
+#ifndef JB_ITCH5_DEFAULTS_pipeline_max_latency_nanoseconds
+#define JB_ITCH5_DEFAULTS_pipeline_max_latency_nanoseconds 1000000
+#endif // JB_ITCH5_DEFAULTS_pipeline_max_latency_nanoseconds
+
+#ifndef JB_ITCH5_DEFAULTS_pipeline_publish_interval_milliseconds
+#define JB_ITCH5_DEFAULTS_pipeline_publish_interval_milliseconds 100
+#endif // JB_ITCH5_DEFAULTS_pipeline_publish_interval_milliseconds
+
+std::int64_t pipeline_max_latency_nanoseconds =
+    JB_ITCH5_DEFAULTS_pipeline_max_latency_nanoseconds;
+int pipeline_publish_interval_milliseconds =
+    JB_ITCH5_DEFAULTS_pipeline_publish_interval_milliseconds;
+
+} // namespace defaults
+
+namespace {
+/**
+ * Create the cuts for the latency histograms.
+ *
+ * The histograms have one bin per nanosecond up to 100, and then 90
+ * bins per power of 10, i.e., the estimated latencies have (at least)
+ * two significant digits.  With the default maximum (1ms) that is
+ * about 460 bins per histogram, an integer_range_binning would need
+ * a million.
+ */
+std::vector<std::int64_t> latency_cuts(std::int64_t max) {
+  std::vector<std::int64_t> cuts;
+  for (std::int64_t i = 0; i != 100 and i < max; ++i) {
+    cuts.push_back(i);
+  }
+  for (std::int64_t step = 10; 10 * step < max; step *= 10) {
+    for (std::int64_t v = 10 * step; v != 100 * step and v < max; v += step) {
+      cuts.push_back(v);
+    }
+  }
+  cuts.push_back(max);
+  return cuts;
+}
+
+/// Return the name used in the reports for a message type index
+std::string message_type_name(std::size_t index) {
+  if (index + 1 == pipeline_latency::message_type_count) {
+    return "other";
+  }
+  return std::string(1, static_cast<char>('A' + index));
+}
+} // anonymous namespace
+
+constexpr int pipeline_latency::stage_count;
+constexpr int pipeline_latency::total;
+constexpr std::size_t pipeline_latency::message_type_count;
+
+pipeline_latency::pipeline_latency(config const& cfg)
+    : current_()
+    , publish_interval_(std::chrono::duration_cast<time_point::duration>(
+          std::chrono::milliseconds(cfg.publish_interval_milliseconds())))
+    , last_publish_()
+    , snapshot_requested_(false)
+    , mu_()
+    , published_() {
+  // ... allocate all the histograms upfront, recording a sample must
+  // not allocate memory ...
+  auto cuts = latency_cuts(cfg.max_latency_nanoseconds());
+  latency_histogram h(
+      latency_histogram::binning_strategy(cuts.begin(), cuts.end()));
+  message_histograms m{0, std::vector<latency_histogram>(stage_count + 1, h),
+                       std::vector<std::uint64_t>(stage_count + 1, 0)};
+  current_.assign(message_type_count, m);
+  published_ = current_;
+}
+
+void pipeline_latency::record(
+    int message_type, time_point received,
+    time_point const (&completed)[stage_count]) {
+  using std::chrono::duration_cast;
+  using std::chrono::nanoseconds;
+  auto& h = current_[message_type_index(message_type)];
+  ++h.count;
+  auto sample = [&h](int stage, time_point::duration d) {
+    auto nanos = duration_cast<nanoseconds>(d).count();
+    // ... the receive timestamp may come from a different core,
+    // tolerate small negative values ...
+    nanos = nanos < 0 ? 0 : nanos;
+    h.latency[stage].sample(nanos);
+    h.sum[stage] += nanos;
+  };
+  auto last = received;
+  for (int i = 0; i != stage_count; ++i) {
+    if (completed[i] == time_point()) {
+      continue;
+    }
+    sample(i, completed[i] - last);
+    last = completed[i];
+  }
+  auto const& output = completed[static_cast<int>(pipeline_stage::output)];
+  if (output != time_point()) {
+    sample(total, output - received);
+  }
+  if (snapshot_requested_.load(std::memory_order_relaxed) or
+      received - last_publish_ >= publish_interval_) {
+    publish(received);
+  }
+}
+
+pipeline_latency::histograms pipeline_latency::snapshot() const {
+  std::lock_guard<std::mutex> guard(mu_);
+  snapshot_requested_.store(true, std::memory_order_relaxed);
+  return published_;
+}
+
+void pipeline_latency::print_csv(std::ostream& os) const {
+  for (std::size_t i = 0; i != current_.size(); ++i) {
+    auto const& h = current_[i];
+    if (h.count == 0) {
+      continue;
+    }
+    for (int s = 0; s != stage_count + 1; ++s) {
+      if (h.latency[s].nsamples() == 0) {
+        continue;
+      }
+      jb::offline_feed_statistics::print_latency_csv(
+          std::string("stage:") + stage_name(s) + ":" + message_type_name(i),
+          h.latency[s], os);
+    }
+  }
+}
+
+void pipeline_latency::log_final_progress() const {
+  for (std::size_t i = 0; i != current_.size(); ++i) {
+    auto const& h = current_[i];
+    if (h.count == 0) {
+      continue;
+    }
+    for (int s = 0; s != stage_count + 1; ++s) {
+      auto const& l = h.latency[s];
+      if (l.nsamples() == 0) {
+        continue;
+      }
+      JB_LOG(info) << "stage " << stage_name(s) << "/"
+                   << message_type_name(i) << ": min=" << l.observed_min()
+                   << "ns, p50=" << l.estimated_quantile(0.50)
+                   << "ns, p90=" << l.estimated_quantile(0.90)
+                   << "ns, p99=" << l.estimated_quantile(0.99)
+                   << "ns, p99.9=" << l.estimated_quantile(0.999)
+                   << "ns, max=" << l.observed_max()
+                   << "ns, N=" << l.nsamples();
+    }
+  }
+}
+
+void pipeline_latency::append_metrics(std::string& body) const {
+  // ... never wait for the processing thread, it may be the thread
+  // serving this request, report the last published copy ...
+  auto h = snapshot();
+  std::ostringstream os;
+  os << "# HELP stage_latency_nanoseconds the latency of each stage in "
+     << "the ITCH-5.0 pipeline, by message type\n"
+     << "# TYPE stage_latency_nanoseconds summary\n";
+  double const quantiles[] = {0.5, 0.9, 0.99, 0.999};
+  for (std::size_t i = 0; i != h.size(); ++i) {
+    if (h[i].count == 0) {
+      continue;
+    }
+    for (int s = 0; s != stage_count + 1; ++s) {
+      auto const& l = h[i].latency[s];
+      if (l.nsamples() == 0) {
+        continue;
+      }
+      std::string labels = std::string("stage=\"") + stage_name(s) +
+                           "\",message_type=\"" + message_type_name(i) +
+                           "\"";
+      for (auto q : quantiles) {
+        os << "stage_latency_nanoseconds{" << labels << ",quantile=\"" << q
+           << "\"} " << l.estimated_quantile(q) << "\n";
+      }
+      os << "stage_latency_nanoseconds_sum{" << labels << "} " << h[i].sum[s]
+         << "\n"
+         << "stage_latency_nanoseconds_count{" << labels << "} "
+         << l.nsamples() << "\n";
+    }
+  }
+  body += os.str();
+}
+
+char const* pipeline_latency::stage_name(int stage) {
+  switch (stage) {
+  case static_cast<int>(pipeline_stage::decode):
+    return "decode";
+  case static_cast<int>(pipeline_stage::order_table):
+    return "order_table";
+  case static_cast<int>(pipeline_stage::book):
+    return "book";
+  case static_cast<int>(pipeline_stage::output):
+    return "output";
+  }
+  return "total";
+}
+
+void pipeline_latency::publish(time_point now) {
+  std::unique_lock<std::mutex> lock(mu_, std::try_to_lock);
+  if (not lock) {
+    // ... another thread is reading the published copy, try again
+    // after the next message ...
+    return;
+  }
+  // ... only copy the message types that changed, the copies have
+  // the same size, so this does not allocate memory ...
+  for (std::size_t i = 0; i != current_.size(); ++i) {
+    if (current_[i].count != published_[i].count) {
+      published_[i] = current_[i];
+    }
+  }
+  last_publish_ = now;
+  snapshot_requested_.store(false, std::memory_order_relaxed);
+}
+
+pipeline_latency::config::config()
+    : max_latency_nanoseconds(
+          desc("max-latency-nanoseconds")
+              .help("Configure the stage latency histograms to expect no "
+                    "latency higher than this value.  Higher values use "
+                    "more memory, the histograms keep two significant "
+                    "digits."),
+          this, defaults::pipeline_max_latency_nanoseconds)
+    , publish_interval_milliseconds(
+          desc("publish-interval-milliseconds")
+              .help("How often the processing thread publishes a copy of "
+                    "the histograms for the metrics.  The copy is also "
+                    "published after the next message when the metrics "
+                    "are read."),
+          this, defaults::pipeline_publish_interval_milliseconds) {
+}
+
+void pipeline_latency::config::validate() const {
+  if (max_latency_nanoseconds() <= 1) {
+    std::ostringstream os;
+    os << "max-latency-nanoseconds must be > 1, value="
+       << max_latency_nanoseconds();
+    throw jb::usage(os.str(), 1);
+  }
+  if (publish_interval_milliseconds() < 0) {
+    std::ostringstream os;
+    os << "publish-interval-milliseconds must be >= 0, value="
+       << publish_interval_milliseconds();
+    throw jb::usage(os.str(), 1);
+  }
+}
+
+} // namespace itch5
+} // namespace jb
@@ -0,0 +1,242 @@
+#ifndef jb_itch5_pipeline_latency_hpp
+#define jb_itch5_pipeline_latency_hpp
+
+#include <jb/itch5/clock_type.hpp>
+#include <jb/config_object.hpp>
+#include <jb/explicit_cuts_binning.hpp>
+#include <jb/histogram.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace jb {
+namespace itch5 {
+
+/**
+ * The stages of the ITCH-5.0 pipeline measured by
+ * jb::itch5::pipeline_latency.
+ *
+ * Each stage is measured from the end of the previous stage, the
+ * first stage is measured from the time the message was received.
+ */
+enum class pipeline_stage : int {
+  /// Parse the message from the raw buffer
+  decode = 0,
+  /// Find, insert, or modify the order in the table of live orders
+  order_table = 1,
+  /// Update the book for the security
+  book = 2,
+  /// Generate any output, i.e., run the compute_book callback
+  output = 3,
+};
+
+/**
+ * Measure the latency of each stage in the ITCH-5.0 pipeline.
+ *
+ * The existing tools only measure the time from receiving a message
+ * until the book is updated, which lumps together receiving,
+ * decoding, looking up the order and updating the book.  This class
+ * records the time taken by each stage (see
+ * jb::itch5::pipeline_stage), and the total time from receiving the
+ * message until its output is generated, in a separate histogram for
+ * each stage and ITCH-5.0 message type.
+ *
+ * The thread processing the messages owns the histograms, recording
+ * a sample never blocks or allocates memory.  The processing thread
+ * publishes a copy of the histograms periodically, and after the
+ * next message when another thread has asked for a snapshot.  Other
+ * threads never wait for the processing thread, which often also
+ * serves the HTTP requests for the metrics, they just read the last
+ * published copy.  The copy is protected by a mutex, but the
+ * processing thread only tries to lock it, if another thread holds
+ * the lock the copy is published after a later message.
+ */
+class pipeline_latency {
+public:
+  class config;
+  class scope;
+
+  /// The number of stages in the pipeline
+  static constexpr int stage_count = 4;
+
+  /// The index of the histograms for the total latency
+  static constexpr int total = stage_count;
+
+  /// The histogram type used for each stage and message type
+  using latency_histogram =
+      jb::histogram<jb::explicit_cuts_binning<std::int64_t>, std::uint64_t>;
+
+  /// The histograms for a single message type
+  struct message_histograms {
+    /// The number of messages of this type
+    std::uint64_t count;
+    /// The latency of each stage, followed by the total latency
+    std::vector<latency_histogram> latency;
+    /// The sum of the latencies (in nanoseconds) in each histogram
+    std::vector<std::uint64_t> sum;
+  };
+
+  /// The histograms for all the message types
+  using histograms = std::vector<message_histograms>;
+
+  /// Constructor
+  explicit pipeline_latency(config const& cfg);
+
+  /**
+   * Record the timestamps for a message.
+   *
+   * @param message_type the ITCH-5.0 message type
+   * @param received when the message was received
+   * @param completed when each stage completed, stages that did not
+   * complete (e.g. because the message was ignored or rejected) are
+   * set to the default time_point
+   */
+  void record(
+      int message_type, time_point received,
+      time_point const (&completed)[stage_count]);
+
+  /**
+   * Return the histograms.
+   *
+   * Must be called from the thread that records the samples, or
+   * after that thread stopped.
+   */
+  histograms const& local() const {
+    return current_;
+  }
+
+  /**
+   * Return a copy of the histograms, can be called from any thread.
+   *
+   * Returns the last copy published by the thread recording the
+   * samples, without waiting for it, and asks for a new copy after
+   * the next message.
+   */
+  histograms snapshot() const;
+
+  /**
+   * Print the histograms as rows in the
+   * jb::offline_feed_statistics CSV format.
+   *
+   * The rows are named "stage:<stage>:<message type>", only message
+   * types with at least one sample are printed.  Must be called from
+   * the thread that records the samples, or after that thread
+   * stopped.
+   */
+  void print_csv(std::ostream& os) const;
+
+  /**
+   * Log a summary of the histograms.
+   *
+   * Must be called from the thread that records the samples, or
+   * after that thread stopped.
+   */
+  void log_final_progress() const;
+
+  /**
+   * Append the histograms to @a body in Prometheus text format.
+   *
+   * Can be called from any thread, see snapshot().
+   */
+  void append_metrics(std::string& body) const;
+
+  /// Return the name of a stage, or "total" for the total latency
+  static char const* stage_name(int stage);
+
+  /// Return the index for @a message_type in the vector of histograms
+  static std::size_t message_type_index(int message_type) {
+    return 'A' <= message_type and message_type <= 'Z'
+               ? static_cast<std::size_t>(message_type - 'A')
+               : message_type_count - 1;
+  }
+
+  /// The number of message types, the letters plus one for others
+  static constexpr std::size_t message_type_count = 27;
+
+private:
+  /// Copy the histograms for the threads calling snapshot()
+  void publish(time_point now);
+
+private:
+  histograms current_;
+  time_point::duration publish_interval_;
+  time_point last_publish_;
+  mutable std::atomic<bool> snapshot_requested_;
+  mutable std::mutex mu_;
+  histograms published_;
+};
+
+/**
+ * Collect the timestamps for a single message.
+ *
+ * The handler for each message creates one of these objects when it
+ * starts, i.e., after the message is decoded, and marks the
+ * completion of each stage.  The samples are recorded when the
+ * object is destroyed, so early returns (such as rejected messages)
+ * are handled correctly.  If the recorder is null all the operations
+ * are no-ops, the cost is a single branch per stage.
+ */
+class pipeline_latency::scope {
+public:
+  /**
+   * Constructor, marks the decode stage as completed.
+   *
+   * @param recorder where to record the samples, can be null
+   * @param message_type the ITCH-5.0 message type
+   * @param received when the message was received
+   */
+  scope(pipeline_latency* recorder, int message_type, time_point received)
+      : recorder_(recorder)
+      , message_type_(message_type)
+      , received_(received)
+      , completed_() {
+    mark(pipeline_stage::decode);
+  }
+
+  ~scope() {
+    if (recorder_ != nullptr) {
+      recorder_->record(message_type_, received_, completed_);
+    }
+  }
+
+  scope(scope const&) = delete;
+  scope& operator=(scope const&) = delete;
+
+  /// Mark @a stage as completed
+  void mark(pipeline_stage stage) {
+    if (recorder_ != nullptr) {
+      completed_[static_cast<int>(stage)] = clock_type::now();
+    }
+  }
+
+private:
+  pipeline_latency* recorder_;
+  int message_type_;
+  time_point received_;
+  time_point completed_[stage_count];
+};
+
+/**
+ * Configure a pipeline_latency object.
+ */
+class pipeline_latency::config : public jb::config_object {
+public:
+  config();
+  config_object_constructors(config);
+
+  /// Validate the configuration
+  void validate() const override;
+
+  jb::config_attribute<config, std::int64_t> max_latency_nanoseconds;
+  jb::config_attribute<config, int> publish_interval_milliseconds;
+};
+
+} // namespace itch5
+} // namespace jb
+
+#endif // jb_itch5_pipeline_latency_hpp
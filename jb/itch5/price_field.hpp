@@ -3,6 +3,7 @@
 
 #include <jb/itch5/base_decoders.hpp>
 #include <jb/itch5/static_digits.hpp>
+#include <jb/fast_format.hpp>
 
 #include <boost/io/ios_state.hpp>
 #include <boost/operators.hpp>
@@ -127,6 +128,20 @@ operator<<(std::ostream& os, price_field<wire_type_t, denom_v> const& x) {
             << std::setfill('0') << d.rem;
 }
 
+/// Format a jb::itch5::price_field<> into a jb::fast_format buffer
+template <typename wire_type_t, std::intmax_t denom_v>
+jb::fast_format&
+operator<<(jb::fast_format& out, price_field<wire_type_t, denom_v> const& x) {
+  typedef typename std::make_unsigned<wire_type_t>::type unsigned_type;
+  // ... the integer part, the decimal point and the decimals never
+  // need more than this ...
+  char* buf = out.reserve(jb::max_formatted_integer_size + 2);
+  out.commit(jb::format_fixed(
+      buf, unsigned_type(x.as_integer()), unsigned_type(x.denom),
+      x.denom_digits - 1));
+  return out;
+}
+
 /// Convenience definition for Price(4) fields.
 typedef price_field<std::uint32_t, 10000> price4_t;
 
@@ -0,0 +1,48 @@
+#ifndef jb_itch5_process_store_mlist_hpp
+#define jb_itch5_process_store_mlist_hpp
+
+#include <jb/itch5/message_store.hpp>
+#include <jb/itch5/process_buffer_mlist.hpp>
+
+namespace jb {
+namespace itch5 {
+
+/*
+ * Process the ITCH-5.0 messages in a message_store given a list of
+ * expected messages.
+ *
+ * This is the in-memory version of
+ * jb::itch5::process_iostream_mlist(): the messages are passed to the
+ * handler directly from the store, without any I/O or copies.  That
+ * is useful to replay (or otherwise process) a feed as fast as
+ * possible, once the file has been loaded (and decompressed) into
+ * memory.
+ *
+ * The message counts and offsets passed to the handler are the same
+ * that jb::itch5::process_iostream_mlist() would report for the
+ * original file.
+ *
+ * Please see @ref jb::itch5::message_handler_concept for a detailed
+ * description of the message_handler requirements.
+ */
+template <typename message_handler, typename... message_types>
+void process_store_mlist(
+    message_store const& store, message_handler& handler) {
+  std::size_t msgoffset = 0;
+  for (std::uint64_t msgcnt = 0; msgcnt != store.size(); ++msgcnt) {
+    // ... skip the 2-byte length that precedes each message in the
+    // original file ...
+    msgoffset += 2;
+    auto msglen = store.message_size(msgcnt);
+    auto recv_ts = handler.now();
+    process_buffer_mlist<message_handler, message_types...>::process(
+        handler, recv_ts, msgcnt, msgoffset, store.message_data(msgcnt),
+        msglen);
+    msgoffset += msglen;
+  }
+}
+
+} // namespace itch5
+} // namespace jb
+
+#endif // jb_itch5_process_store_mlist_hpp
@@ -0,0 +1,99 @@
+#include "jb/itch5/replay_pacing_statistics.hpp"
+
+#include <jb/log.hpp>
+
+#include <vector>
+
+namespace jb {
+namespace itch5 {
+namespace {
+/// Update the message rate gauge after this many messages
+std::uint64_t const rate_update_period = 1024;
+
+/// Fractional nanoseconds, to scale the intervals by the speed
+using fnanoseconds = std::chrono::duration<double, std::nano>;
+
+/// Fractional seconds, to compute and report rates
+using fseconds = std::chrono::duration<double>;
+
+/**
+ * The binning for the pacing errors.
+ *
+ * Use 1-2-5 steps from 1 microsecond to 10 seconds, early messages
+ * are counted in the underflow bin.
+ */
+jb::explicit_cuts_binning<std::int64_t> error_binning() {
+  std::vector<std::int64_t> cuts{0};
+  for (std::int64_t decade = 1000; decade != 10000000000; decade *= 10) {
+    cuts.push_back(decade);
+    cuts.push_back(2 * decade);
+    cuts.push_back(5 * decade);
+  }
+  cuts.push_back(10000000000);
+  return jb::explicit_cuts_binning<std::int64_t>(cuts.begin(), cuts.end());
+}
+} // anonymous namespace
+
+replay_pacing_statistics::replay_pacing_statistics(
+    mold_udp_pacer_config const& cfg, jb::metrics::registry& r,
+    jb::metrics::labels const& l)
+    : speed_(cfg.speed())
+    , unthrottled_(cfg.unthrottled())
+    , nmessages_(0)
+    , first_wall_()
+    , last_wall_()
+    , first_ts_(0)
+    , skipped_(0)
+    , error_(r.make_histogram(
+          "replay_pacing_error_nanoseconds",
+          "how late each message was sent, compared to the original feed "
+          "scaled by the replay speed",
+          error_binning(), l))
+    , rate_(r.make_gauge(
+          "replay_message_rate",
+          "the achieved replay rate, in messages per second", l)) {
+}
+
+void replay_pacing_statistics::sample(time_point now, timestamp ts) {
+  if (nmessages_++ == 0) {
+    first_wall_ = now;
+    first_ts_ = ts.ts;
+  }
+  last_wall_ = now;
+  if (nmessages_ % rate_update_period == 0) {
+    rate_.set(message_rate());
+  }
+  if (unthrottled_) {
+    return;
+  }
+  using std::chrono::duration_cast;
+  auto offset =
+      duration_cast<duration>(fnanoseconds(ts.ts - first_ts_) / speed_);
+  auto scheduled = first_wall_ - skipped_ + offset;
+  error_.sample(
+      duration_cast<std::chrono::nanoseconds>(now - scheduled).count());
+}
+
+double replay_pacing_statistics::message_rate() const {
+  auto seconds = std::chrono::duration_cast<fseconds>(elapsed()).count();
+  if (seconds <= 0) {
+    return 0;
+  }
+  return nmessages_ / seconds;
+}
+
+void replay_pacing_statistics::log_summary() const {
+  rate_.set(message_rate());
+  JB_LOG(info) << "replayed " << nmessages_ << " messages in "
+               << std::chrono::duration_cast<fseconds>(elapsed()).count()
+               << "s, rate=" << message_rate() << " msgs/s";
+  if (unthrottled_) {
+    return;
+  }
+  auto h = error_.snapshot();
+  JB_LOG(info) << "pacing error (ns): " << h.summary()
+               << ", early=" << h.underflow_count();
+}
+
+} // namespace itch5
+} // namespace jb
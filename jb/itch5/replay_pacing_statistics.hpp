@@ -0,0 +1,113 @@
+#ifndef jb_itch5_replay_pacing_statistics_hpp
+#define jb_itch5_replay_pacing_statistics_hpp
+
+#include <jb/itch5/mold_udp_pacer_config.hpp>
+#include <jb/itch5/timestamp.hpp>
+#include <jb/explicit_cuts_binning.hpp>
+#include <jb/metrics.hpp>
+
+#include <chrono>
+#include <cstdint>
+
+namespace jb {
+namespace itch5 {
+
+/**
+ * Measure the message rate and pacing error of a replay.
+ *
+ * The replay programs (moldreplay, itch5moldreplay) use
+ * jb::itch5::mold_udp_pacer to match the original time interval
+ * between messages, possibly scaled by a speed multiplier.  This
+ * class computes when each message should have been sent, given the
+ * wall-clock time of the first message, and records how late (or
+ * early) it actually was in a histogram.  It also tracks the
+ * achieved message rate, which is the interesting metric for
+ * unthrottled replays.
+ *
+ * The statistics are published as metrics in a jb::metrics::registry,
+ * so they can be scraped while the replay is running.
+ */
+class replay_pacing_statistics {
+public:
+  //@{
+  /**
+   * @name Type traits
+   */
+  typedef std::chrono::steady_clock::time_point time_point;
+  typedef std::chrono::steady_clock::duration duration;
+  typedef jb::metrics::histogram<jb::explicit_cuts_binning<std::int64_t>>
+      error_histogram;
+  //@}
+
+  /**
+   * Constructor.
+   *
+   * @param cfg the configuration for the pacer, used to compute the
+   * schedule
+   * @param r where to publish the metrics
+   * @param l the labels for the metrics, e.g., to identify the
+   * replay session
+   */
+  explicit replay_pacing_statistics(
+      mold_udp_pacer_config const& cfg,
+      jb::metrics::registry& r = jb::metrics::default_registry(),
+      jb::metrics::labels const& l = jb::metrics::labels());
+
+  /**
+   * Record the time when a message was released by the pacer.
+   *
+   * @param now the wall-clock time after the pacer processed the
+   * message
+   * @param ts the timestamp in the message
+   */
+  void sample(time_point now, timestamp ts);
+
+  /**
+   * Move the schedule earlier for all the messages that follow.
+   *
+   * The replay programs do not wait for more than a few seconds,
+   * even if the feed has long idle periods.  They must call this
+   * function with the time they did not wait, otherwise all the
+   * following messages would appear to be late.
+   */
+  void skip(duration d) {
+    skipped_ += d;
+  }
+
+  /// The number of messages recorded so far
+  std::uint64_t nmessages() const {
+    return nmessages_;
+  }
+
+  /// The wall-clock time between the first and last messages
+  duration elapsed() const {
+    return last_wall_ - first_wall_;
+  }
+
+  /// The achieved message rate, in messages per second
+  double message_rate() const;
+
+  /// The histogram of pacing errors, in nanoseconds
+  error_histogram const& pacing_error() const {
+    return error_;
+  }
+
+  /// Log a summary of the statistics
+  void log_summary() const;
+
+private:
+  double speed_;
+  bool unthrottled_;
+  std::uint64_t nmessages_;
+  time_point first_wall_;
+  time_point last_wall_;
+  std::chrono::nanoseconds first_ts_;
+  duration skipped_;
+  error_histogram& error_;
+  jb::metrics::gauge& rate_;
+};
+
+} // namespace itch5
+} // namespace jb
+
+#endif // jb_itch5_replay_pacing_statistics_hpp
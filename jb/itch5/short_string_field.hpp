@@ -3,6 +3,7 @@
 
 #include <jb/itch5/decoder.hpp>
 #include <jb/itch5/noop_validator.hpp>
+#include <jb/fast_format.hpp>
 #include <jb/p2ceil.hpp>
 
 #include <boost/functional/hash.hpp>
@@ -180,6 +181,13 @@ operator<<(std::ostream& os, short_string_field<size, F> const& x) {
   return os << x.c_str();
 }
 
+/// Format a jb::itch5::short_string_field into a jb::fast_format buffer
+template <std::size_t size, typename F>
+jb::fast_format&
+operator<<(jb::fast_format& out, short_string_field<size, F> const& x) {
+  return out << x.c_str();
+}
+
 /// Implement a hash function and integrate with boost::hash
 template <std::size_t size, typename F>
 std::size_t hash_value(short_string_field<size, F> const& x) {
@@ -1,5 +1,6 @@
 #include "jb/itch5/testing/data.hpp"
 
+#include <jb/itch5/mold_udp_protocol_constants.hpp>
 #include <jb/itch5/protocol_constants.hpp>
 #include <jb/itch5/timestamp.hpp>
 
@@ -314,6 +315,32 @@ std::vector<char> create_message(
   return msg;
 }
 
+std::vector<char>
+create_mold_udp_packet(std::uint64_t sequence_number, int message_count) {
+  namespace mold = jb::itch5::mold_udp_protocol;
+  std::vector<char> packet(mold::header_size);
+  jb::itch5::encoder<true, std::uint64_t>::w(
+      packet.size(), packet.data(), mold::sequence_number_offset,
+      sequence_number);
+  jb::itch5::encoder<true, std::uint16_t>::w(
+      packet.size(), packet.data(), mold::block_count_offset, message_count);
+
+  char msg_type = 'A';
+  int ts = 5;
+  for (int i = 0; i != message_count; ++i) {
+    auto message = create_message(
+        msg_type, jb::itch5::timestamp{std::chrono::microseconds(ts)}, 64);
+    ts += 5;
+    msg_type++;
+    char len[2];
+    jb::itch5::encoder<true, std::uint16_t>::w(
+        sizeof(len), len, 0, message.size());
+    packet.insert(packet.end(), len, len + sizeof(len));
+    packet.insert(packet.end(), message.begin(), message.end());
+  }
+  return packet;
+}
+
 } // namespace testing
 } // namespace itch5
 } // namespace jb
@@ -3,6 +3,7 @@
 
 #include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <utility>
 #include <vector>
 
@@ -57,6 +58,18 @@ std::pair<char const*, std::size_t> trade();
 std::vector<char> create_message(
     int message_type, jb::itch5::timestamp ts, std::size_t total_size);
 
+/**
+ * Generate a MoldUDP64 packet with test messages.
+ *
+ * The messages are generated using create_message(), each one with a
+ * different message type and timestamp.
+ *
+ * @param sequence_number the sequence number of the first message
+ * @param message_count the number of messages in the packet
+ */
+std::vector<char>
+create_mold_udp_packet(std::uint64_t sequence_number, int message_count);
+
 } // namespace testing
 } // namespace itch5
 } // namespace jb
@@ -0,0 +1,220 @@
+#include "jb/itch5/udp_batch_sender.hpp"
+
+#include <jb/itch5/make_socket_udp_send.hpp>
+#include <jb/mktdata/batch_header.hpp>
+#include <jb/mktdata/message_header.hpp>
+#include <jb/log.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+namespace jb {
+namespace itch5 {
+namespace {
+/// Return true if two destinations can share the same socket
+bool compatible(udp_sender_config const& a, udp_sender_config const& b) {
+  auto aa = boost::asio::ip::address::from_string(a.address());
+  auto ba = boost::asio::ip::address::from_string(b.address());
+  return aa.is_v6() == ba.is_v6() and aa.is_multicast() == ba.is_multicast() and
+      a.enable_loopback() == b.enable_loopback() and a.hops() == b.hops() and
+      a.outbound_interface() == b.outbound_interface() and
+      a.broadcast() == b.broadcast();
+}
+} // anonymous namespace
+
+udp_batch_sender::udp_batch_sender(
+    boost::asio::io_service& io,
+    std::vector<udp_sender_config> const& destinations,
+    udp_batch_sender_config const& cfg)
+    : mu_()
+    , socket_(io)
+    , destinations_()
+    , timer_(io)
+    , timer_armed_(false)
+    , max_packet_size_(cfg.max_packet_size())
+    , flush_deadline_(cfg.flush_deadline_microseconds())
+    , header_size_(
+          flush_deadline_.count() == 0 ? 0 : sizeof(jb::mktdata::batch_header))
+    , packet_(cfg.max_packet_size())
+    , packet_size_(header_size_)
+    , message_count_(0)
+    , sequence_number_(0)
+    , message_sequence_number_(0)
+    , oldest_message_()
+    , messages_sent_(0)
+    , packets_sent_(0)
+    , send_calls_(0)
+    , send_errors_(0)
+    , iov_()
+    , msgs_() {
+  if (destinations.empty()) {
+    throw std::invalid_argument("udp_batch_sender - no destinations");
+  }
+  for (auto const& d : destinations) {
+    if (not compatible(destinations.front(), d)) {
+      std::ostringstream os;
+      os << "udp_batch_sender - destination " << d.address() << ":"
+         << d.port() << " cannot share a socket with "
+         << destinations.front().address() << ":"
+         << destinations.front().port();
+      throw std::invalid_argument(os.str());
+    }
+    destinations_.emplace_back(
+        boost::asio::ip::address::from_string(d.address()), d.port());
+  }
+  socket_ = make_socket_udp_send<>(io, destinations.front());
+
+  // ... prepare the sendmmsg(2) arguments once, all the messages
+  // point to the same datagram ...
+  iov_.iov_base = packet_.data();
+  iov_.iov_len = 0;
+  msgs_.resize(destinations_.size());
+  for (std::size_t i = 0; i != destinations_.size(); ++i) {
+    std::memset(&msgs_[i], 0, sizeof(msgs_[i]));
+    msgs_[i].msg_hdr.msg_name = destinations_[i].data();
+    msgs_[i].msg_hdr.msg_namelen = destinations_[i].size();
+    msgs_[i].msg_hdr.msg_iov = &iov_;
+    msgs_[i].msg_hdr.msg_iovlen = 1;
+  }
+}
+
+udp_batch_sender::~udp_batch_sender() {
+  std::lock_guard<std::mutex> guard(mu_);
+  flush_locked();
+  boost::system::error_code ec;
+  timer_.cancel(ec);
+}
+
+std::uint32_t udp_batch_sender::append(void const* msg, std::size_t msglen) {
+  std::lock_guard<std::mutex> guard(mu_);
+  if (msglen < sizeof(jb::mktdata::message_header)) {
+    std::ostringstream os;
+    os << "udp_batch_sender::append - message too small (" << msglen
+       << " bytes) for a jb::mktdata::message_header";
+    throw std::invalid_argument(os.str());
+  }
+  if (header_size_ + msglen > max_packet_size_) {
+    std::ostringstream os;
+    os << "udp_batch_sender::append - message too large (" << msglen
+       << " bytes) for --max-packet-size=" << max_packet_size_;
+    throw std::invalid_argument(os.str());
+  }
+  if (packet_size_ + msglen > max_packet_size_) {
+    flush_locked();
+  }
+  if (message_count_ == 0) {
+    oldest_message_ = std::chrono::steady_clock::now();
+  }
+  auto location = packet_.data() + packet_size_;
+  std::memcpy(location, msg, msglen);
+  auto seqno = ++message_sequence_number_;
+  reinterpret_cast<jb::mktdata::message_header*>(location)->sequence_number =
+      seqno;
+  packet_size_ += msglen;
+  ++message_count_;
+  if (flush_deadline_.count() == 0) {
+    flush_locked();
+    return seqno;
+  }
+  if (not timer_armed_) {
+    timer_armed_ = true;
+    timer_.expires_at(oldest_message_ + flush_deadline_);
+    timer_.async_wait(
+        [this](boost::system::error_code const& ec) { handle_deadline(ec); });
+  }
+  return seqno;
+}
+
+void udp_batch_sender::flush() {
+  std::lock_guard<std::mutex> guard(mu_);
+  flush_locked();
+}
+
+std::uint64_t udp_batch_sender::messages_sent() const {
+  std::lock_guard<std::mutex> guard(mu_);
+  return messages_sent_;
+}
+
+std::uint64_t udp_batch_sender::packets_sent() const {
+  std::lock_guard<std::mutex> guard(mu_);
+  return packets_sent_;
+}
+
+std::uint64_t udp_batch_sender::send_calls() const {
+  std::lock_guard<std::mutex> guard(mu_);
+  return send_calls_;
+}
+
+std::uint64_t udp_batch_sender::send_errors() const {
+  std::lock_guard<std::mutex> guard(mu_);
+  return send_errors_;
+}
+
+void udp_batch_sender::flush_locked() {
+  if (message_count_ == 0) {
+    return;
+  }
+  // ... without batching each datagram is a bare message, the same
+  // wire format used before batching was introduced ...
+  if (header_size_ != 0) {
+    auto header = reinterpret_cast<jb::mktdata::batch_header*>(packet_.data());
+    header->batch_size = static_cast<std::uint16_t>(packet_size_);
+    header->message_count = message_count_;
+    header->sequence_number = sequence_number_++;
+  }
+
+  // ... the same datagram goes to all the destinations, only the
+  // address changes, see the constructor ...
+  iov_.iov_len = packet_size_;
+  std::size_t sent = 0;
+  while (sent != msgs_.size()) {
+    ++send_calls_;
+    int n = ::sendmmsg(
+        socket_.native_handle(), msgs_.data() + sent, msgs_.size() - sent, 0);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      // ... skip the destination that failed, UDP is unreliable
+      // anyway, but report the problem ...
+      ++send_errors_;
+      JB_LOG(info) << "error sending batch to " << destinations_[sent] << ": "
+                   << std::strerror(errno) << " (" << errno << ")";
+      ++sent;
+      continue;
+    }
+    sent += n;
+    packets_sent_ += n;
+  }
+  messages_sent_ += message_count_;
+  packet_size_ = header_size_;
+  message_count_ = 0;
+}
+
+void udp_batch_sender::handle_deadline(boost::system::error_code const& ec) {
+  std::lock_guard<std::mutex> guard(mu_);
+  timer_armed_ = false;
+  if (ec) {
+    return;
+  }
+  if (message_count_ == 0) {
+    return;
+  }
+  // ... the datagram may have been flushed on size after the timer
+  // was armed, in that case wait for the deadline of the new oldest
+  // message ...
+  auto deadline = oldest_message_ + flush_deadline_;
+  if (std::chrono::steady_clock::now() < deadline) {
+    timer_armed_ = true;
+    timer_.expires_at(deadline);
+    timer_.async_wait(
+        [this](boost::system::error_code const& e) { handle_deadline(e); });
+    return;
+  }
+  flush_locked();
+}
+
+} // namespace itch5
+} // namespace jb
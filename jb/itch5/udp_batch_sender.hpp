@@ -0,0 +1,136 @@
+#ifndef jb_itch5_udp_batch_sender_hpp
+#define jb_itch5_udp_batch_sender_hpp
+
+#include <jb/itch5/udp_batch_sender_config.hpp>
+#include <jb/itch5/udp_sender_config.hpp>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/ip/udp.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+namespace jb {
+namespace itch5 {
+
+/**
+ * Pack many small messages into datagrams and send them to multiple
+ * destinations.
+ *
+ * Sending each message with its own send_to() call, to each
+ * destination, makes the system calls the bottleneck of a feed
+ * handler.  This class accumulates the messages in a datagram
+ * (prefixed by a jb::mktdata::batch_header), and sends the datagram
+ * when it is full, or when the oldest message has waited for the
+ * configured deadline.  The copies for all the destinations are
+ * sent with a single sendmmsg(2) call.
+ *
+ * Batching is opt-in: if the deadline is 0 each message is sent
+ * immediately in its own datagram, without a batch header, so
+ * existing consumers see the same wire format as before.
+ *
+ * The sender assigns the sequence number of each message (see
+ * jb::mktdata::message_header) as it is appended.  Every destination
+ * receives exactly the same datagrams, so each destination sees a
+ * contiguous sequence starting at 1, and a receiver can detect lost
+ * messages on its own socket.
+ *
+ * All the destinations share a single socket, created using the
+ * configuration of the first destination, so they must agree on the
+ * address family and the multicast and unicast socket options.
+ *
+ * The deadline is implemented with a Boost.ASIO timer, so some thread
+ * must run the io_service.  The class is thread-safe, messages can be
+ * appended from a thread other than the one running the io_service.
+ */
+class udp_batch_sender {
+public:
+  /**
+   * Constructor, create the socket.
+   *
+   * @param io the Boost.ASIO IO service used for the deadline timer
+   * @param destinations where to send the datagrams
+   * @param cfg the batching configuration
+   * @throws std::invalid_argument if the destinations are not
+   * compatible
+   */
+  udp_batch_sender(
+      boost::asio::io_service& io,
+      std::vector<udp_sender_config> const& destinations,
+      udp_batch_sender_config const& cfg);
+
+  /// Destructor, send any pending messages
+  ~udp_batch_sender();
+
+  /**
+   * Append a message to the current datagram.
+   *
+   * @param msg the message contents, it must start with a
+   * jb::mktdata::message_header, the sequence number field is
+   * overwritten in the copy sent over the network
+   * @param msglen the size of the message
+   * @returns the sequence number assigned to the message
+   * @throws std::invalid_argument if the message is too large for a
+   * datagram, or too small to contain a header
+   */
+  std::uint32_t append(void const* msg, std::size_t msglen);
+
+  /// Send the current datagram, if it has any messages
+  void flush();
+
+  //@{
+  /**
+   * @name Accessors
+   */
+  std::uint64_t messages_sent() const;
+  std::uint64_t packets_sent() const;
+  std::uint64_t send_calls() const;
+  std::uint64_t send_errors() const;
+  //@}
+
+private:
+  /// Send the current datagram, the caller must hold mu_
+  void flush_locked();
+
+  /// The deadline timer callback
+  void handle_deadline(boost::system::error_code const& ec);
+
+private:
+  mutable std::mutex mu_;
+  boost::asio::ip::udp::socket socket_;
+  std::vector<boost::asio::ip::udp::endpoint> destinations_;
+  boost::asio::steady_timer timer_;
+  bool timer_armed_;
+  std::size_t max_packet_size_;
+  std::chrono::microseconds flush_deadline_;
+  std::size_t header_size_;
+
+  // The datagram being assembled, starts with a batch_header unless
+  // batching is disabled
+  std::vector<char> packet_;
+  std::size_t packet_size_;
+  std::uint16_t message_count_;
+  std::uint32_t sequence_number_;
+  std::uint32_t message_sequence_number_;
+  std::chrono::steady_clock::time_point oldest_message_;
+
+  std::uint64_t messages_sent_;
+  std::uint64_t packets_sent_;
+  std::uint64_t send_calls_;
+  std::uint64_t send_errors_;
+
+  // The arguments for sendmmsg(2), one message per destination
+  ::iovec iov_;
+  std::vector<::mmsghdr> msgs_;
+};
+
+} // namespace itch5
+} // namespace jb
+
+#endif // jb_itch5_udp_batch_sender_hpp
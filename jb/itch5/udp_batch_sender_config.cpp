@@ -0,0 +1,57 @@
+#include "jb/itch5/udp_batch_sender_config.hpp"
+#include <jb/usage.hpp>
+
+#include <sstream>
+
+namespace jb {
+namespace itch5 {
+namespace defaults {
+
+#ifndef JB_ITCH5_DEFAULTS_batch_max_packet_size
+#define JB_ITCH5_DEFAULTS_batch_max_packet_size 1400
+#endif // JB_ITCH5_DEFAULTS_batch_max_packet_size
+
+#ifndef JB_ITCH5_DEFAULTS_flush_deadline_microseconds
+#define JB_ITCH5_DEFAULTS_flush_deadline_microseconds 0
+#endif // JB_ITCH5_DEFAULTS_flush_deadline_microseconds
+
+int batch_max_packet_size = JB_ITCH5_DEFAULTS_batch_max_packet_size;
+int flush_deadline_microseconds = JB_ITCH5_DEFAULTS_flush_deadline_microseconds;
+
+} // namespace defaults
+
+udp_batch_sender_config::udp_batch_sender_config()
+    : max_packet_size(
+          desc("max-packet-size")
+              .help("The maximum size of each datagram, including the batch "
+                    "header.  Typically this is the MTU minus the IP and UDP "
+                    "headers."),
+          this, defaults::batch_max_packet_size)
+    , flush_deadline_microseconds(
+          desc("flush-deadline-microseconds")
+              .help("Send a partial datagram if its oldest message has waited "
+                    "this long.  If 0, each message is sent immediately, in "
+                    "its own datagram and without a batch header, i.e., there "
+                    "is no batching."),
+          this, defaults::flush_deadline_microseconds) {
+}
+
+void udp_batch_sender_config::validate() const {
+  // ... the batch size is a 16-bit field, and the largest UDP payload
+  // over IPv4 is 65507 bytes ...
+  if (max_packet_size() < 64 or max_packet_size() > 65507) {
+    std::ostringstream os;
+    os << "--max-packet-size must be in the [64,65507] range, value="
+       << max_packet_size();
+    throw jb::usage(os.str(), 1);
+  }
+  if (flush_deadline_microseconds() < 0) {
+    std::ostringstream os;
+    os << "--flush-deadline-microseconds must be >= 0, value="
+       << flush_deadline_microseconds();
+    throw jb::usage(os.str(), 1);
+  }
+}
+
+} // namespace itch5
+} // namespace jb
@@ -0,0 +1,33 @@
+#ifndef jb_itch5_udp_batch_sender_config_hpp
+#define jb_itch5_udp_batch_sender_config_hpp
+
+#include <jb/config_object.hpp>
+
+namespace jb {
+namespace itch5 {
+
+/**
+ * Configure how a jb::itch5::udp_batch_sender packs messages.
+ *
+ * Messages are accumulated until the datagram reaches
+ * @a max_packet_size, or until the oldest message has waited for
+ * @a flush_deadline_microseconds.  Larger deadlines mean fewer
+ * packets and system calls, at the cost of additional latency when
+ * the message rate is low.
+ */
+class udp_batch_sender_config : public jb::config_object {
+public:
+  udp_batch_sender_config();
+  config_object_constructors(udp_batch_sender_config);
+
+  void validate() const override;
+
+  jb::config_attribute<udp_batch_sender_config, int> max_packet_size;
+  jb::config_attribute<udp_batch_sender_config, int>
+      flush_deadline_microseconds;
+};
+
+} // namespace itch5
+} // namespace jb
+
+#endif // jb_itch5_udp_batch_sender_config_hpp
@@ -0,0 +1,26 @@
+#include <jb/itch5/clock_recalibrator.hpp>
+#include <jb/usage.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+/**
+ * @test Verify that jb::itch5::clock_recalibrator works as expected.
+ */
+BOOST_AUTO_TEST_CASE(itch5_clock_recalibrator_basic) {
+  using config = jb::itch5::clock_recalibrator::config;
+  boost::asio::io_service io;
+  jb::itch5::clock_recalibrator tested(io, config().period_milliseconds(1));
+  for (int i = 0; i != 3; ++i) {
+    io.run_one();
+  }
+  BOOST_CHECK_EQUAL(tested.recalibrations(), 3);
+
+  // ... with a 0 period the timer is never armed ...
+  boost::asio::io_service idle;
+  jb::itch5::clock_recalibrator once(idle, config().period_milliseconds(0));
+  BOOST_CHECK_EQUAL(idle.poll(), 0);
+  BOOST_CHECK_EQUAL(once.recalibrations(), 0);
+
+  BOOST_CHECK_NO_THROW(config().validate());
+  BOOST_CHECK_THROW(config().period_milliseconds(-1).validate(), jb::usage);
+}
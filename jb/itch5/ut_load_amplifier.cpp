@@ -0,0 +1,148 @@
+#include <jb/itch5/add_order_message.hpp>
+#include <jb/itch5/load_amplifier.hpp>
+#include <jb/itch5/order_replace_message.hpp>
+#include <jb/itch5/system_event_message.hpp>
+#include <jb/itch5/trade_message.hpp>
+
+#include <jb/itch5/testing/data.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace {
+/// Copy a test message and set its stock locate
+std::string with_locate(std::pair<char const*, std::size_t> p, int locate) {
+  std::string msg(p.first, p.second);
+  jb::itch5::encoder<true, std::uint16_t>::w(
+      msg.size(), &msg[0], 1, std::uint16_t(locate));
+  return msg;
+}
+
+/// Capture the messages generated by a jb::itch5::load_amplifier
+struct capture {
+  void operator()(jb::itch5::unknown_message const& msg) {
+    counts.push_back(msg.count());
+    auto buf = static_cast<char const*>(msg.buf());
+    messages.emplace_back(buf, buf + msg.len());
+  }
+
+  std::vector<std::uint32_t> counts;
+  std::vector<std::string> messages;
+};
+
+/// Run a message through the amplifier
+void amplify(
+    jb::itch5::load_amplifier& amplifier, std::string const& msg,
+    std::uint32_t count, capture& c) {
+  jb::itch5::unknown_message m(count, 0, msg.size(), msg.data());
+  amplifier.handle_message(m, std::ref(c));
+}
+
+/// Decode a captured message
+template <typename message_type>
+message_type decode(std::string const& msg) {
+  return jb::itch5::decoder<true, message_type>::r(msg.size(), msg.data(), 0);
+}
+} // anonymous namespace
+
+/**
+ * @test Verify that jb::itch5::load_amplifier does not modify the
+ * messages with the default configuration.
+ */
+BOOST_AUTO_TEST_CASE(itch5_load_amplifier_passthrough) {
+  jb::itch5::load_amplifier amplifier(jb::itch5::load_amplifier_config{});
+  capture c;
+  auto msg = with_locate(jb::itch5::testing::add_order(), 7);
+  amplify(amplifier, msg, 42, c);
+  BOOST_REQUIRE_EQUAL(c.messages.size(), 1);
+  BOOST_CHECK_EQUAL(c.counts.at(0), 42);
+  BOOST_CHECK(c.messages.at(0) == msg);
+}
+
+/**
+ * @test Verify that jb::itch5::load_amplifier remaps the stock
+ * locate, tickers, and order reference numbers in each copy.
+ */
+BOOST_AUTO_TEST_CASE(itch5_load_amplifier_clone) {
+  using namespace jb::itch5;
+  load_amplifier amplifier(
+      load_amplifier_config().factor(3).locate_offset(100));
+  capture c;
+  amplify(amplifier, with_locate(testing::system_event(), 0), 0, c);
+  amplify(amplifier, with_locate(testing::add_order(), 7), 1, c);
+  amplify(amplifier, with_locate(testing::order_replace(), 7), 2, c);
+  amplify(amplifier, with_locate(testing::trade(), 7), 3, c);
+  BOOST_REQUIRE_EQUAL(c.messages.size(), 10);
+  for (std::uint32_t i = 0; i != c.counts.size(); ++i) {
+    BOOST_CHECK_EQUAL(c.counts[i], i);
+  }
+
+  auto se = decode<system_event_message>(c.messages.at(0));
+  BOOST_CHECK_EQUAL(se.header.stock_locate, 0);
+
+  std::uint64_t const delta = std::uint64_t(1) << 56;
+  char const* expected_stock[] = {"HSART", "HSARTa", "HSARTb"};
+  for (int k = 0; k != 3; ++k) {
+    auto add = decode<add_order_message>(c.messages.at(1 + k));
+    BOOST_CHECK_EQUAL(add.header.stock_locate, 7 + 100 * k);
+    BOOST_CHECK_EQUAL(add.order_reference_number, 42 + k * delta);
+    BOOST_CHECK_EQUAL(add.stock, expected_stock[k]);
+    BOOST_CHECK_EQUAL(add.shares, 100);
+
+    auto replace = decode<order_replace_message>(c.messages.at(4 + k));
+    BOOST_CHECK_EQUAL(replace.header.stock_locate, 7 + 100 * k);
+    BOOST_CHECK_EQUAL(replace.original_order_reference_number, 42 + k * delta);
+    BOOST_CHECK_EQUAL(replace.new_order_reference_number, 4242 + k * delta);
+
+    auto trade = decode<trade_message>(c.messages.at(7 + k));
+    auto original = decode<trade_message>(c.messages.at(7));
+    BOOST_CHECK_EQUAL(trade.header.stock_locate, 7 + 100 * k);
+    BOOST_CHECK_EQUAL(
+        trade.order_reference_number,
+        original.order_reference_number + k * delta);
+    BOOST_CHECK_EQUAL(trade.match_number, original.match_number + k * delta);
+  }
+}
+
+/**
+ * @test Verify that jb::itch5::load_amplifier compresses the time
+ * between messages.
+ */
+BOOST_AUTO_TEST_CASE(itch5_load_amplifier_time_compression) {
+  using namespace jb::itch5;
+  using namespace std::chrono;
+  load_amplifier amplifier(load_amplifier_config().time_compression(4.0));
+  capture c;
+  auto t0 = timestamp{hours(9) + minutes(30)};
+  for (auto ts : {t0, timestamp{t0.ts + microseconds(400)},
+                  timestamp{t0.ts + seconds(4)}}) {
+    auto v = testing::create_message(u'S', ts, 12);
+    amplify(amplifier, std::string(v.begin(), v.end()), c.counts.size(), c);
+  }
+  BOOST_REQUIRE_EQUAL(c.messages.size(), 3);
+  auto m0 = decode<message_header>(c.messages.at(0));
+  auto m1 = decode<message_header>(c.messages.at(1));
+  auto m2 = decode<message_header>(c.messages.at(2));
+  BOOST_CHECK_EQUAL(m0.timestamp.ts.count(), t0.ts.count());
+  BOOST_CHECK_EQUAL(
+      m1.timestamp.ts.count(), (t0.ts + microseconds(100)).count());
+  BOOST_CHECK_EQUAL(m2.timestamp.ts.count(), (t0.ts + seconds(1)).count());
+}
+
+/**
+ * @test Verify that jb::itch5::load_amplifier_config validation works.
+ */
+BOOST_AUTO_TEST_CASE(itch5_load_amplifier_config_validate) {
+  using config = jb::itch5::load_amplifier_config;
+  BOOST_CHECK_NO_THROW(config().validate());
+  BOOST_CHECK_THROW(config().factor(0).validate(), jb::usage);
+  BOOST_CHECK_THROW(config().factor(17).validate(), jb::usage);
+  BOOST_CHECK_THROW(config().factor(8).locate_offset(0).validate(), jb::usage);
+  BOOST_CHECK_THROW(
+      config().factor(8).locate_offset(10000).validate(), jb::usage);
+  BOOST_CHECK_NO_THROW(config().factor(6).locate_offset(10000).validate());
+  BOOST_CHECK_THROW(config().time_compression(0.5).validate(), jb::usage);
+}
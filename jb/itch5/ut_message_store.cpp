@@ -0,0 +1,48 @@
+#include <jb/itch5/message_store.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+/**
+ * @test Verify that jb::itch5::message_store works as expected.
+ */
+BOOST_AUTO_TEST_CASE(itch5_message_store_basic) {
+  std::string raw;
+  for (std::string msg : {"A", "BB", "CCC"}) {
+    raw.push_back(0);
+    raw.push_back(static_cast<char>(msg.size()));
+    raw += msg;
+  }
+  std::istringstream is(raw);
+
+  jb::itch5::message_store store;
+  BOOST_CHECK_EQUAL(store.size(), 0);
+  store.load(is);
+  BOOST_REQUIRE_EQUAL(store.size(), 3);
+  BOOST_CHECK_EQUAL(store.message_size(0), 1);
+  BOOST_CHECK_EQUAL(store.message_size(2), 3);
+  BOOST_CHECK_EQUAL(
+      std::string(store.message_data(1), store.message_size(1)), "BB");
+
+  store.append("DDDD", 4);
+  BOOST_REQUIRE_EQUAL(store.size(), 4);
+  BOOST_CHECK_EQUAL(
+      std::string(store.message_data(3), store.message_size(3)), "DDDD");
+}
+
+/**
+ * @test Verify that jb::itch5::message_store detects truncated files.
+ */
+BOOST_AUTO_TEST_CASE(itch5_message_store_truncated) {
+  std::string truncated_message("\x00\x05" "ABC", 5);
+  std::istringstream is0(truncated_message);
+  jb::itch5::message_store store;
+  BOOST_CHECK_THROW(store.load(is0), std::runtime_error);
+
+  std::string truncated_length("\x00\x01" "A" "\x00", 4);
+  std::istringstream is1(truncated_length);
+  BOOST_CHECK_THROW(store.load(is1), std::runtime_error);
+}
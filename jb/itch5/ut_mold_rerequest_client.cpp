@@ -0,0 +1,94 @@
+#include <jb/itch5/base_decoders.hpp>
+#include <jb/itch5/mold_rerequest_client.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <thread>
+
+/**
+ * Helper types and functions to test jb::itch5::mold_rerequest_client
+ */
+namespace {
+namespace mold = jb::itch5::mold_udp_protocol;
+
+/// Receive a request and return its sequence number and count
+std::pair<std::uint64_t, std::uint16_t> receive_request(
+    boost::asio::ip::udp::socket& socket,
+    boost::asio::ip::udp::endpoint& sender) {
+  char buffer[1 << 16];
+  auto n =
+      socket.receive_from(boost::asio::buffer(buffer, sizeof(buffer)), sender);
+  BOOST_REQUIRE_EQUAL(n, mold::request_size);
+  BOOST_CHECK_EQUAL(std::string(buffer, 10), "SESSION001");
+  return std::make_pair(
+      jb::itch5::decoder<true, std::uint64_t>::r(
+          n, buffer, mold::sequence_number_offset),
+      jb::itch5::decoder<true, std::uint16_t>::r(
+          n, buffer, mold::block_count_offset));
+}
+} // anonymous namespace
+
+/**
+ * @test Verify that jb::itch5::mold_rerequest_client splits, limits,
+ * and retries requests.
+ */
+BOOST_AUTO_TEST_CASE(itch5_mold_rerequest_client_basic) {
+  using boost::asio::ip::udp;
+  boost::asio::io_service io;
+  udp::socket server(io, udp::endpoint(udp::v4(), 0));
+  udp::endpoint client_ep;
+
+  int responses = 0;
+  jb::itch5::mold_rerequest_client client(
+      io, [&responses](
+              std::chrono::steady_clock::time_point, char const*,
+              std::size_t) { ++responses; },
+      jb::itch5::mold_rerequest_config()
+          .port(server.local_endpoint().port())
+          .max_outstanding_requests(2)
+          .max_messages_per_request(1000)
+          .request_timeout_microseconds(50000));
+
+  client.request("SESSION001", 0, 2500);
+  BOOST_CHECK_EQUAL(client.requests_sent(), 2);
+  BOOST_CHECK_EQUAL(client.pending_messages(), 2500);
+  auto r = receive_request(server, client_ep);
+  BOOST_CHECK_EQUAL(r.first, 0);
+  BOOST_CHECK_EQUAL(r.second, 1000);
+  r = receive_request(server, client_ep);
+  BOOST_CHECK_EQUAL(r.first, 1000);
+  BOOST_CHECK_EQUAL(r.second, 1000);
+
+  // ... satisfying a request allows the next one to go out ...
+  client.received_until(1000);
+  BOOST_CHECK_EQUAL(client.requests_sent(), 3);
+  r = receive_request(server, client_ep);
+  BOOST_CHECK_EQUAL(r.first, 2000);
+  BOOST_CHECK_EQUAL(r.second, 500);
+
+  // ... a partially satisfied request is trimmed ...
+  client.received_until(1500);
+  BOOST_CHECK_EQUAL(client.pending_messages(), 1000);
+
+  // ... after the timeout the outstanding requests are sent again ...
+  std::this_thread::sleep_for(std::chrono::milliseconds(60));
+  io.run_one();
+  BOOST_CHECK_EQUAL(client.requests_retried(), 2);
+  r = receive_request(server, client_ep);
+  BOOST_CHECK_EQUAL(r.first, 1500);
+  BOOST_CHECK_EQUAL(r.second, 500);
+  r = receive_request(server, client_ep);
+  BOOST_CHECK_EQUAL(r.first, 2000);
+  BOOST_CHECK_EQUAL(r.second, 500);
+
+  // ... responses are forwarded to the handler ...
+  char response[mold::header_size] = {0};
+  server.send_to(boost::asio::buffer(response, sizeof(response)), client_ep);
+  io.run_one();
+  BOOST_CHECK_EQUAL(responses, 1);
+  BOOST_CHECK_EQUAL(client.responses_received(), 1);
+
+  client.received_until(2500);
+  BOOST_CHECK_EQUAL(client.pending_messages(), 0);
+}
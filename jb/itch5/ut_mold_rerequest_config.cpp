@@ -0,0 +1,40 @@
+#include <jb/itch5/mold_rerequest_config.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+/**
+ * @test Verify that jb::itch5::mold_rerequest_config validation
+ * works as expected.
+ */
+BOOST_AUTO_TEST_CASE(itch5_mold_rerequest_config_validate) {
+  using config = jb::itch5::mold_rerequest_config;
+
+  config default_validates;
+  BOOST_CHECK_NO_THROW(default_validates.validate());
+  BOOST_CHECK_EQUAL(default_validates.port(), 0);
+
+  // ... when disabled nothing else is checked ...
+  BOOST_CHECK_NO_THROW(config().max_outstanding_requests(0).validate());
+
+  BOOST_CHECK_NO_THROW(config().port(40124).validate());
+  BOOST_CHECK_NO_THROW(config().port(40124).address("::1").validate());
+
+  config bad_port = config().port(70000);
+  BOOST_CHECK_THROW(bad_port.validate(), jb::usage);
+
+  config bad_address = config().port(40124).address("not-an-address");
+  BOOST_CHECK_THROW(bad_address.validate(), jb::usage);
+
+  config no_requests = config().port(40124).max_outstanding_requests(0);
+  BOOST_CHECK_THROW(no_requests.validate(), jb::usage);
+
+  config too_many_messages =
+      config().port(40124).max_messages_per_request(70000);
+  BOOST_CHECK_THROW(too_many_messages.validate(), jb::usage);
+
+  config zero_timeout = config().port(40124).request_timeout_microseconds(0);
+  BOOST_CHECK_THROW(zero_timeout.validate(), jb::usage);
+
+  config no_buffer = config().port(40124).max_buffered_messages(0);
+  BOOST_CHECK_THROW(no_buffer.validate(), jb::usage);
+}
@@ -0,0 +1,107 @@
+#include <jb/itch5/base_decoders.hpp>
+#include <jb/itch5/base_encoders.hpp>
+#include <jb/itch5/mold_rerequest_server.hpp>
+#include <jb/itch5/mold_udp_protocol_constants.hpp>
+#include <jb/itch5/udp_receiver_config.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstring>
+#include <string>
+
+/**
+ * Helper types and functions to test jb::itch5::mold_rerequest_server
+ */
+namespace {
+namespace mold = jb::itch5::mold_udp_protocol;
+
+/// Send a request and let the server process it
+void send_request(
+    boost::asio::io_service& io, boost::asio::ip::udp::socket& socket,
+    boost::asio::ip::udp::endpoint const& server, std::uint64_t first,
+    std::uint16_t count) {
+  char request[mold::request_size];
+  std::memcpy(request, "SESSION001", mold::session_id_size);
+  jb::itch5::encoder<true, std::uint64_t>::w(
+      sizeof(request), request, mold::sequence_number_offset, first);
+  jb::itch5::encoder<true, std::uint16_t>::w(
+      sizeof(request), request, mold::block_count_offset, count);
+  socket.send_to(boost::asio::buffer(request, sizeof(request)), server);
+  io.run_one();
+}
+
+/// Receive a response and return its sequence number and block count
+std::pair<std::uint64_t, std::uint16_t>
+receive_response(boost::asio::ip::udp::socket& socket) {
+  char buffer[1 << 16];
+  auto n = socket.receive(boost::asio::buffer(buffer, sizeof(buffer)));
+  BOOST_REQUIRE_GE(n, mold::header_size);
+  BOOST_CHECK_EQUAL(std::string(buffer, 10), "SESSION001");
+  auto seqno = jb::itch5::decoder<true, std::uint64_t>::r(
+      n, buffer, mold::sequence_number_offset);
+  auto count = jb::itch5::decoder<true, std::uint16_t>::r(
+      n, buffer, mold::block_count_offset);
+  // ... verify the contents of each message ...
+  std::size_t offset = mold::header_size;
+  for (std::uint16_t i = 0; i != count; ++i) {
+    auto msglen = jb::itch5::decoder<true, std::uint16_t>::r(n, buffer, offset);
+    BOOST_CHECK_EQUAL(msglen, 50);
+    auto contents =
+        jb::itch5::decoder<true, std::uint64_t>::r(n, buffer, offset + 2);
+    BOOST_CHECK_EQUAL(contents, seqno + i);
+    offset += 2 + msglen;
+  }
+  BOOST_CHECK_EQUAL(offset, n);
+  return std::make_pair(seqno, count);
+}
+} // anonymous namespace
+
+/**
+ * @test Verify that jb::itch5::mold_rerequest_server works.
+ */
+BOOST_AUTO_TEST_CASE(itch5_mold_rerequest_server_basic) {
+  jb::itch5::message_store store;
+  for (std::uint64_t i = 0; i != 100; ++i) {
+    char msg[50] = {0};
+    jb::itch5::encoder<true, std::uint64_t>::w(sizeof(msg), msg, 0, i);
+    store.append(msg, sizeof(msg));
+  }
+
+  boost::asio::io_service io;
+  // ... each packet has room for 3 messages ...
+  jb::itch5::mold_rerequest_server server(
+      io, store, jb::itch5::udp_receiver_config().address("127.0.0.1"), 200);
+  auto server_ep = server.local_endpoint();
+  BOOST_CHECK_NE(server_ep.port(), 0);
+
+  boost::asio::ip::udp::socket client(
+      io, boost::asio::ip::udp::endpoint(boost::asio::ip::udp::v4(), 0));
+
+  send_request(io, client, server_ep, 10, 7);
+  BOOST_CHECK_EQUAL(server.requests_received(), 1);
+  BOOST_CHECK_EQUAL(server.packets_sent(), 3);
+  BOOST_CHECK_EQUAL(server.messages_sent(), 7);
+  auto r = receive_response(client);
+  BOOST_CHECK_EQUAL(r.first, 10);
+  BOOST_CHECK_EQUAL(r.second, 3);
+  r = receive_response(client);
+  BOOST_CHECK_EQUAL(r.first, 13);
+  BOOST_CHECK_EQUAL(r.second, 3);
+  r = receive_response(client);
+  BOOST_CHECK_EQUAL(r.first, 16);
+  BOOST_CHECK_EQUAL(r.second, 1);
+
+  // ... requests past the end are truncated ...
+  send_request(io, client, server_ep, 98, 5);
+  r = receive_response(client);
+  BOOST_CHECK_EQUAL(r.first, 98);
+  BOOST_CHECK_EQUAL(r.second, 2);
+
+  // ... and ignored if there is nothing to send ...
+  send_request(io, client, server_ep, 200, 5);
+  // ... even if first + count wraps around ...
+  send_request(io, client, server_ep, ~std::uint64_t(0) - 2, 5);
+  BOOST_CHECK_EQUAL(server.requests_received(), 4);
+  BOOST_CHECK_EQUAL(server.packets_sent(), 4);
+  BOOST_CHECK_EQUAL(server.messages_sent(), 9);
+}
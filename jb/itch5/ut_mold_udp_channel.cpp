@@ -1,6 +1,7 @@
 #include <jb/itch5/make_socket_udp_recv.hpp>
+#include <jb/itch5/message_store.hpp>
+#include <jb/itch5/mold_rerequest_server.hpp>
 #include <jb/itch5/mold_udp_channel.hpp>
-#include <jb/itch5/mold_udp_protocol_constants.hpp>
 #include <jb/itch5/testing/data.hpp>
 #include <jb/itch5/timestamp.hpp>
 #include <jb/itch5/udp_receiver_config.hpp>
@@ -8,40 +9,15 @@
 #include <jb/gmock/init.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 /**
  * Helper types and functions to test jb::itch5::mold_udp_channel
  */
 namespace {
-std::vector<char>
-create_mold_udp_packet(std::uint64_t sequence_number, int message_count) {
-  std::size_t const max_packet_size = 1 << 16;
-  char packet[max_packet_size] = {0};
-
-  jb::itch5::encoder<true, std::uint64_t>::w(
-      max_packet_size, packet,
-      jb::itch5::mold_udp_protocol::sequence_number_offset, sequence_number);
-  jb::itch5::encoder<true, std::uint16_t>::w(
-      max_packet_size, packet, jb::itch5::mold_udp_protocol::block_count_offset,
-      message_count);
-
-  std::size_t packet_size = jb::itch5::mold_udp_protocol::header_size;
-  boost::asio::mutable_buffer dst(packet, packet_size);
-
-  char msg_type = 'A';
-  int ts = 5;
-  for (int i = 0; i != message_count; ++i) {
-    auto message = jb::itch5::testing::create_message(
-        msg_type, jb::itch5::timestamp{std::chrono::microseconds(ts)}, 64);
-    ts += 5;
-    msg_type++;
-    jb::itch5::encoder<true, std::uint16_t>::w(
-        max_packet_size, packet, packet_size, message.size());
-    packet_size += 2;
-    boost::asio::buffer_copy(dst + packet_size, boost::asio::buffer(message));
-    packet_size += message.size();
-  }
-  return std::vector<char>(packet, packet + packet_size);
-}
+using jb::itch5::testing::create_mold_udp_packet;
 
 /**
  * Pick a localhost address that is valid on the testing host.
@@ -187,3 +163,95 @@ BOOST_AUTO_TEST_CASE(itch5_mold_udp_channel_coverage) {
   jb::itch5::mold_udp_channel_tester::call_with_empty_packet(c2);
   jb::itch5::mold_udp_channel_tester::call_with_error_code(c2);
 }
+
+/**
+ * @test Verify that jb::itch5::mold_udp_channel works in busy poll mode.
+ */
+BOOST_AUTO_TEST_CASE(itch5_mold_udp_channel_busy_poll) {
+  std::mutex mu;
+  std::condition_variable cv;
+  std::vector<std::size_t> sizes;
+  auto adapter = [&](
+      std::chrono::steady_clock::time_point ts, std::uint64_t seqno,
+      std::size_t offset, char const* msg, std::size_t msgsize) {
+    std::lock_guard<std::mutex> guard(mu);
+    sizes.push_back(msgsize);
+    cv.notify_one();
+  };
+
+  using boost::asio::ip::udp;
+
+  boost::asio::io_service io;
+  auto local = select_localhost_address(io);
+  BOOST_TEST_MESSAGE("Running test on " << local);
+
+  jb::itch5::mold_udp_channel channel(
+      io, adapter, jb::itch5::udp_receiver_config().port(50000).address(local),
+      jb::itch5::mold_udp_channel_config().busy_poll(true).receive_batch_size(
+          4));
+
+  udp::resolver resolver(io);
+  auto d_address = boost::asio::ip::address::from_string(local);
+  auto protocol = d_address.is_v6() ? udp::v6() : udp::v4();
+  udp::endpoint send_to = *resolver.resolve({protocol, local, "50000"});
+  udp::socket socket(io, udp::endpoint(protocol, 0));
+
+  socket.send_to(boost::asio::buffer(create_mold_udp_packet(0, 3)), send_to);
+  socket.send_to(boost::asio::buffer(create_mold_udp_packet(3, 2)), send_to);
+  socket.send_to(boost::asio::buffer(create_mold_udp_packet(5, 0)), send_to);
+
+  std::unique_lock<std::mutex> lock(mu);
+  bool done = cv.wait_for(
+      lock, std::chrono::seconds(5), [&sizes]() { return sizes.size() >= 5; });
+  BOOST_CHECK(done);
+  BOOST_CHECK_EQUAL(sizes.size(), 5UL);
+}
+
+/**
+ * @test Verify that jb::itch5::mold_udp_channel recovers gaps using
+ * retransmission requests.
+ */
+BOOST_AUTO_TEST_CASE(itch5_mold_udp_channel_rerequest) {
+  jb::itch5::message_store store;
+  for (int i = 0; i != 20; ++i) {
+    auto msg = jb::itch5::testing::create_message(
+        'A', jb::itch5::timestamp{std::chrono::microseconds(i)}, 64);
+    store.append(msg.data(), msg.size());
+  }
+
+  using boost::asio::ip::udp;
+  boost::asio::io_service io;
+  jb::itch5::mold_rerequest_server server(
+      io, store, jb::itch5::udp_receiver_config().address("127.0.0.1"), 1400);
+
+  std::vector<std::uint64_t> seqnos;
+  auto adapter = [&seqnos](
+      std::chrono::steady_clock::time_point ts, std::uint64_t seqno,
+      std::size_t offset, char const* msg,
+      std::size_t msgsize) { seqnos.push_back(seqno); };
+  jb::itch5::mold_udp_channel channel(
+      io, adapter,
+      jb::itch5::udp_receiver_config().port(50000).address("127.0.0.1"),
+      jb::itch5::mold_udp_channel_config().rerequest(
+          jb::itch5::mold_rerequest_config().port(
+              server.local_endpoint().port())));
+
+  udp::socket socket(io, udp::endpoint(udp::v4(), 0));
+  udp::endpoint send_to(boost::asio::ip::address_v4::loopback(), 50000);
+
+  // ... lose the messages in [3,15) ...
+  socket.send_to(boost::asio::buffer(create_mold_udp_packet(0, 3)), send_to);
+  socket.send_to(boost::asio::buffer(create_mold_udp_packet(15, 5)), send_to);
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (seqnos.size() < 20 and std::chrono::steady_clock::now() < deadline) {
+    if (io.poll() == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  BOOST_REQUIRE_EQUAL(seqnos.size(), 20UL);
+  for (std::uint64_t i = 0; i != seqnos.size(); ++i) {
+    BOOST_CHECK_EQUAL(seqnos[i], i);
+  }
+  BOOST_CHECK_EQUAL(server.messages_sent(), 12);
+}
@@ -0,0 +1,33 @@
+#include <jb/itch5/mold_udp_channel_config.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+/**
+ * @test Verify that jb::itch5::mold_udp_channel_config validation
+ * works as expected.
+ */
+BOOST_AUTO_TEST_CASE(itch5_mold_udp_channel_config_validate) {
+  using config = jb::itch5::mold_udp_channel_config;
+
+  config default_validates;
+  BOOST_CHECK_NO_THROW(default_validates.validate());
+  BOOST_CHECK_EQUAL(default_validates.busy_poll(), false);
+
+  BOOST_CHECK_NO_THROW(config().busy_poll(true).validate());
+  BOOST_CHECK_NO_THROW(config().busy_poll_microseconds(50).validate());
+
+  config negative_busy_poll = config().busy_poll_microseconds(-1);
+  BOOST_CHECK_THROW(negative_busy_poll.validate(), jb::usage);
+
+  config batch_too_small = config().receive_batch_size(0);
+  BOOST_CHECK_THROW(batch_too_small.validate(), jb::usage);
+
+  config batch_too_big = config().receive_batch_size(2000);
+  BOOST_CHECK_THROW(batch_too_big.validate(), jb::usage);
+
+  using rerequest = jb::itch5::mold_rerequest_config;
+  BOOST_CHECK_NO_THROW(config().rerequest(rerequest().port(40124)).validate());
+  config busy_and_rerequest =
+      config().busy_poll(true).rerequest(rerequest().port(40124));
+  BOOST_CHECK_THROW(busy_and_rerequest.validate(), jb::usage);
+}
@@ -0,0 +1,164 @@
+#include <jb/itch5/base_decoders.hpp>
+#include <jb/itch5/base_encoders.hpp>
+#include <jb/itch5/mold_udp_impairment.hpp>
+#include <jb/itch5/mold_udp_protocol_constants.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+using jb::itch5::mold_udp_impairment;
+using jb::itch5::mold_udp_impairment_config;
+
+/// Capture the sequence numbers of the packets sent by the impairment
+struct capture {
+  template <typename buffers_type>
+  void operator()(buffers_type const& buffers) {
+    auto b = *buffers.begin();
+    auto size = boost::asio::buffer_size(b);
+    auto data = boost::asio::buffer_cast<char const*>(b);
+    seqnos.push_back(jb::itch5::decoder<true, std::uint64_t>::r(
+        size, data, jb::itch5::mold_udp_protocol::sequence_number_offset));
+  }
+  std::vector<std::uint64_t> seqnos;
+};
+
+/// Run @a n packets through the impairment, return the sequence
+/// numbers actually sent
+std::vector<std::uint64_t>
+run(mold_udp_impairment& impairment, std::uint64_t n) {
+  capture sink;
+  char packet[jb::itch5::mold_udp_protocol::header_size] = {0};
+  auto now = mold_udp_impairment::time_point();
+  for (std::uint64_t i = 0; i != n; ++i) {
+    jb::itch5::encoder<true, std::uint64_t>::w(
+        sizeof(packet), packet,
+        jb::itch5::mold_udp_protocol::sequence_number_offset, i);
+    impairment.handle_packet(now, boost::asio::buffer(packet), sink);
+  }
+  impairment.flush(sink);
+  return sink.seqnos;
+}
+} // anonymous namespace
+
+/**
+ * @test Verify that jb::itch5::mold_udp_impairment does not modify
+ * the stream with the default configuration.
+ */
+BOOST_AUTO_TEST_CASE(itch5_mold_udp_impairment_disabled) {
+  mold_udp_impairment impairment(mold_udp_impairment_config(), "test");
+  auto sent = run(impairment, 100);
+  BOOST_REQUIRE_EQUAL(sent.size(), 100);
+  for (std::uint64_t i = 0; i != sent.size(); ++i) {
+    BOOST_CHECK_EQUAL(sent[i], i);
+  }
+  BOOST_CHECK_EQUAL(impairment.dropped(), 0);
+}
+
+/**
+ * @test Verify that jb::itch5::mold_udp_impairment produces the same
+ * schedule for the same seed.
+ */
+BOOST_AUTO_TEST_CASE(itch5_mold_udp_impairment_deterministic) {
+  auto cfg = mold_udp_impairment_config()
+                 .seed(42)
+                 .drop_probability(0.05)
+                 .burst_probability(0.01)
+                 .duplicate_probability(0.05)
+                 .reorder_probability(0.05);
+  mold_udp_impairment a(cfg, "a");
+  mold_udp_impairment b(cfg, "b");
+  auto sent_a = run(a, 2000);
+  auto sent_b = run(b, 2000);
+  BOOST_CHECK(sent_a == sent_b);
+  BOOST_CHECK_GT(a.dropped(), 0);
+  BOOST_CHECK_GT(a.duplicated(), 0);
+  BOOST_CHECK_GT(a.reordered(), 0);
+  BOOST_CHECK_EQUAL(a.held(), 0);
+  BOOST_CHECK_EQUAL(
+      sent_a.size(), 2000 - a.dropped() + a.duplicated());
+
+  mold_udp_impairment c(cfg.seed(7), "c");
+  auto sent_c = run(c, 2000);
+  BOOST_CHECK(sent_a != sent_c);
+}
+
+/**
+ * @test Verify that jb::itch5::mold_udp_impairment drops,
+ * duplicates, and reorders packets as configured.
+ */
+BOOST_AUTO_TEST_CASE(itch5_mold_udp_impairment_each) {
+  mold_udp_impairment drop(
+      mold_udp_impairment_config().drop_probability(1.0), "drop");
+  BOOST_CHECK(run(drop, 10).empty());
+
+  mold_udp_impairment burst(
+      mold_udp_impairment_config().burst_probability(0.5).burst_length(3),
+      "burst");
+  auto sent = run(burst, 1000);
+  BOOST_CHECK_EQUAL(sent.size(), 1000 - burst.dropped());
+  BOOST_CHECK_GT(burst.dropped(), 500);
+
+  mold_udp_impairment dup(
+      mold_udp_impairment_config().duplicate_probability(1.0), "dup");
+  sent = run(dup, 10);
+  BOOST_REQUIRE_EQUAL(sent.size(), 20);
+  BOOST_CHECK_EQUAL(sent[0], 0);
+  BOOST_CHECK_EQUAL(sent[1], 0);
+  BOOST_CHECK_EQUAL(sent[19], 9);
+
+  mold_udp_impairment reorder(
+      mold_udp_impairment_config().reorder_probability(0.5).reorder_window(3),
+      "reorder");
+  sent = run(reorder, 1000);
+  BOOST_REQUIRE_EQUAL(sent.size(), 1000);
+  BOOST_CHECK(not std::is_sorted(sent.begin(), sent.end()));
+  std::sort(sent.begin(), sent.end());
+  for (std::uint64_t i = 0; i != sent.size(); ++i) {
+    BOOST_CHECK_EQUAL(sent[i], i);
+  }
+}
+
+/**
+ * @test Verify that jb::itch5::mold_udp_impairment releases the
+ * delayed packets once the delay expires.
+ */
+BOOST_AUTO_TEST_CASE(itch5_mold_udp_impairment_delay) {
+  mold_udp_impairment impairment(
+      mold_udp_impairment_config().delay_probability(1.0).delay_microseconds(
+          1000),
+      "delay");
+  capture sink;
+  char packet[jb::itch5::mold_udp_protocol::header_size] = {0};
+  auto t0 = mold_udp_impairment::time_point();
+  impairment.handle_packet(t0, boost::asio::buffer(packet), sink);
+  BOOST_CHECK_EQUAL(sink.seqnos.size(), 0);
+  impairment.handle_packet(
+      t0 + std::chrono::microseconds(500), boost::asio::buffer(packet), sink);
+  BOOST_CHECK_EQUAL(sink.seqnos.size(), 0);
+  impairment.handle_packet(
+      t0 + std::chrono::microseconds(1200), boost::asio::buffer(packet), sink);
+  BOOST_CHECK_EQUAL(sink.seqnos.size(), 1);
+  BOOST_CHECK_EQUAL(impairment.held(), 2);
+  impairment.flush(sink);
+  BOOST_CHECK_EQUAL(sink.seqnos.size(), 3);
+  BOOST_CHECK_EQUAL(impairment.delayed(), 3);
+}
+
+/**
+ * @test Verify that jb::itch5::mold_udp_impairment_config validation
+ * works.
+ */
+BOOST_AUTO_TEST_CASE(itch5_mold_udp_impairment_config_validate) {
+  using config = mold_udp_impairment_config;
+  BOOST_CHECK_NO_THROW(config().validate());
+  BOOST_CHECK(not config().enabled());
+  BOOST_CHECK(config().drop_probability(0.1).enabled());
+  BOOST_CHECK_THROW(config().drop_probability(-0.1).validate(), jb::usage);
+  BOOST_CHECK_THROW(config().burst_probability(1.1).validate(), jb::usage);
+  BOOST_CHECK_THROW(config().burst_length(0.5).validate(), jb::usage);
+  BOOST_CHECK_THROW(config().reorder_window(0).validate(), jb::usage);
+  BOOST_CHECK_THROW(config().delay_microseconds(-1).validate(), jb::usage);
+}
@@ -275,6 +275,147 @@ BOOST_AUTO_TEST_CASE(itch5_mold_udp_pacer_flush_timeout) {
   BOOST_CHECK_EQUAL(hdrsize + 100 + 2 + 90 + 2, sink.packets.at(0).size());
 }
 
+/**
+ * @test Verify that the speed multiplier scales the sleep requests
+ * and the maximum delay.
+ */
+BOOST_AUTO_TEST_CASE(itch5_mold_udp_pacer_speed) {
+  using namespace ::testing;
+  mock_clock_interface::clear();
+  EXPECT_CALL(mock_clock_interface::instance(), now())
+      .WillRepeatedly(Invoke([]() {
+        static int ts = 0;
+        return mock_clock::time_point(std::chrono::microseconds(++ts));
+      }));
+  std::vector<mock_clock::duration> sleeps;
+  auto mock_sleep = [&sleeps](mock_clock::duration d) { sleeps.push_back(d); };
+  mock_sink sink;
+
+  // ... at 4x messages 3000 usecs apart in the feed are only 750
+  // usecs apart in wall-clock time, so they are coalesced ...
+  jb::itch5::mold_udp_pacer<mock_clock> p(jb::itch5::mold_udp_pacer_config()
+                                              .maximum_delay_microseconds(1000)
+                                              .maximum_transmission_unit(1024)
+                                              .speed(4.0));
+
+  int msgcnt = 0;
+  for (int ts : {5, 3005, 11005}) {
+    auto m = jb::itch5::testing::create_message(
+        'A', jb::itch5::timestamp{std::chrono::microseconds(ts)}, 100);
+    p.handle_message(
+        mock_clock::now(),
+        jb::itch5::unknown_message(msgcnt++, 0, m.size(), &m[0]), sink,
+        mock_sleep);
+  }
+
+  // ... while the last message is flushed after sleeping for a
+  // quarter of the original interval ...
+  auto hdrsize = jb::itch5::mold_udp_protocol::header_size;
+  BOOST_REQUIRE_EQUAL(sink.packets.size(), 1);
+  BOOST_CHECK_EQUAL(hdrsize + 2 * (100 + 2), sink.packets.at(0).size());
+  BOOST_REQUIRE_EQUAL(sleeps.size(), 1);
+  BOOST_CHECK(sleeps[0] == std::chrono::microseconds(2750));
+}
+
+/**
+ * @test Verify that unthrottled pacers never sleep, but still create
+ * the same packets.
+ */
+BOOST_AUTO_TEST_CASE(itch5_mold_udp_pacer_unthrottled) {
+  using namespace ::testing;
+  mock_clock_interface::clear();
+  EXPECT_CALL(mock_clock_interface::instance(), now())
+      .WillRepeatedly(Invoke([]() {
+        static int ts = 0;
+        return mock_clock::time_point(std::chrono::microseconds(++ts));
+      }));
+  int sleep_count = 0;
+  auto mock_sleep = [&sleep_count](mock_clock::duration) { ++sleep_count; };
+  mock_sink paced_sink;
+  mock_sink unthrottled_sink;
+
+  auto cfg = jb::itch5::mold_udp_pacer_config()
+                 .maximum_delay_microseconds(1000)
+                 .maximum_transmission_unit(1024);
+  jb::itch5::mold_udp_pacer<mock_clock> paced(cfg);
+  jb::itch5::mold_udp_pacer<mock_clock> unthrottled(
+      jb::itch5::mold_udp_pacer_config(cfg).unthrottled(true));
+
+  int msgcnt = 0;
+  for (int ts : {5, 15, 2025, 2035, 9000}) {
+    auto m = jb::itch5::testing::create_message(
+        'A', jb::itch5::timestamp{std::chrono::microseconds(ts)}, 100);
+    jb::itch5::unknown_message msg(msgcnt++, 0, m.size(), &m[0]);
+    paced.handle_message(mock_clock::now(), msg, paced_sink, mock_sleep);
+    unthrottled.handle_message(
+        mock_clock::now(), msg, unthrottled_sink, mock_sleep);
+  }
+  BOOST_CHECK_EQUAL(sleep_count, 2);
+  BOOST_CHECK_EQUAL(unthrottled_sink.packets.size(), 2);
+  BOOST_CHECK(paced_sink.packets == unthrottled_sink.packets);
+}
+
+/**
+ * @test Verify that jb::itch5::mold_udp_pacer produces the same
+ * packets in zero-copy mode.
+ */
+BOOST_AUTO_TEST_CASE(itch5_mold_udp_pacer_zero_copy) {
+  using namespace ::testing;
+  mock_clock_interface::clear();
+  EXPECT_CALL(mock_clock_interface::instance(), now())
+      .WillRepeatedly(Invoke([]() {
+        static int ts = 0;
+        return mock_clock::time_point(std::chrono::microseconds(++ts));
+      }));
+  auto mock_sleep = [](mock_clock::duration) {};
+  mock_sink copy_sink;
+  mock_sink zero_copy_sink;
+
+  auto cfg = jb::itch5::mold_udp_pacer_config()
+                 .maximum_delay_microseconds(1000)
+                 .maximum_transmission_unit(1024)
+                 .unthrottled(true);
+  jb::itch5::mold_udp_pacer<mock_clock> copy(cfg);
+  jb::itch5::mold_udp_pacer<mock_clock> zero_copy(
+      jb::itch5::mold_udp_pacer_config(cfg).zero_copy(true));
+
+  // ... the messages must remain valid until they are sent ...
+  std::vector<std::vector<char>> messages;
+  for (int ts : {5, 15, 25, 35, 45, 55, 65, 75, 85, 95, 2025, 2035, 9000}) {
+    messages.push_back(jb::itch5::testing::create_message(
+        'A', jb::itch5::timestamp{std::chrono::microseconds(ts)}, 100));
+  }
+  int msgcnt = 0;
+  for (auto& m : messages) {
+    jb::itch5::unknown_message msg(msgcnt++, 0, m.size(), &m[0]);
+    copy.handle_message(mock_clock::now(), msg, copy_sink, mock_sleep);
+    zero_copy.handle_message(
+        mock_clock::now(), msg, zero_copy_sink, mock_sleep);
+  }
+  copy.flush(jb::itch5::timestamp{std::chrono::microseconds(9000)}, copy_sink);
+  zero_copy.flush(
+      jb::itch5::timestamp{std::chrono::microseconds(9000)}, zero_copy_sink);
+  BOOST_CHECK_EQUAL(copy_sink.packets.size(), 4);
+  BOOST_CHECK(copy_sink.packets == zero_copy_sink.packets);
+
+  // ... with very small messages the gather list limits the number
+  // of blocks in each packet ...
+  mock_sink small_sink;
+  jb::itch5::mold_udp_pacer<mock_clock> small(
+      jb::itch5::mold_udp_pacer_config(cfg).zero_copy(true));
+  auto m = jb::itch5::testing::create_message(
+      'A', jb::itch5::timestamp{std::chrono::microseconds(5)}, 16);
+  for (int i = 0; i != 40; ++i) {
+    jb::itch5::unknown_message msg(i, 0, m.size(), &m[0]);
+    small.handle_message(mock_clock::now(), msg, small_sink, mock_sleep);
+  }
+  small.heartbeat(small_sink);
+  auto hdrsize = jb::itch5::mold_udp_protocol::header_size;
+  BOOST_REQUIRE_EQUAL(small_sink.packets.size(), 2);
+  BOOST_CHECK_EQUAL(small_sink.packets.at(0).size(), hdrsize + 31 * 18);
+  BOOST_CHECK_EQUAL(small_sink.packets.at(1).size(), hdrsize + 9 * 18);
+}
+
 /**
  * @test Verify that flush() on an empty packet does not produce a
  * send() request.
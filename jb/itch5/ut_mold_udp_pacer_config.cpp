@@ -27,4 +27,23 @@ BOOST_AUTO_TEST_CASE(itch5_mold_udp_pacer_config_validate) {
   config delay_too_big = config().maximum_delay_microseconds(
       duration_cast<microseconds>(minutes(5)).count());
   BOOST_CHECK_THROW(delay_too_big.validate(), jb::usage);
+
+  config speed_zero = config().speed(0);
+  BOOST_CHECK_THROW(speed_zero.validate(), jb::usage);
+
+  config speed_negative = config().speed(-2);
+  BOOST_CHECK_THROW(speed_negative.validate(), jb::usage);
+
+  config spin_negative = config().spin_microseconds(-1);
+  BOOST_CHECK_THROW(spin_negative.validate(), jb::usage);
+
+  config max_sleep_zero = config().maximum_sleep_milliseconds(0);
+  BOOST_CHECK_THROW(max_sleep_zero.validate(), jb::usage);
+
+  config recalibration_negative =
+      config().recalibration_period_milliseconds(-1);
+  BOOST_CHECK_THROW(recalibration_negative.validate(), jb::usage);
+
+  config slow = config().speed(0.5).unthrottled(true);
+  BOOST_CHECK_NO_THROW(slow.validate());
 }
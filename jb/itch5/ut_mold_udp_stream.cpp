@@ -0,0 +1,175 @@
+#include <jb/itch5/base_decoders.hpp>
+#include <jb/itch5/base_encoders.hpp>
+#include <jb/itch5/mold_udp_protocol_constants.hpp>
+#include <jb/itch5/mold_udp_stream.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * Helper types and functions to test jb::itch5::mold_udp_stream
+ */
+namespace {
+/**
+ * Create a MoldUDP64 packet with @a count messages.
+ *
+ * Each message contains its own sequence number, so the tests can
+ * verify the messages are delivered in order.
+ */
+std::vector<char> create_packet(std::uint64_t first, int count) {
+  namespace mold = jb::itch5::mold_udp_protocol;
+  std::size_t const msglen = 8;
+  std::vector<char> packet(mold::header_size + count * (2 + msglen));
+  std::memcpy(packet.data(), "SESSION001", mold::session_id_size);
+  jb::itch5::encoder<true, std::uint64_t>::w(
+      packet.size(), packet.data(), mold::sequence_number_offset, first);
+  jb::itch5::encoder<true, std::uint16_t>::w(
+      packet.size(), packet.data(), mold::block_count_offset, count);
+  std::size_t offset = mold::header_size;
+  for (int i = 0; i != count; ++i) {
+    jb::itch5::encoder<true, std::uint16_t>::w(
+        packet.size(), packet.data(), offset, msglen);
+    jb::itch5::encoder<true, std::uint64_t>::w(
+        packet.size(), packet.data(), offset + 2, first + i);
+    offset += 2 + msglen;
+  }
+  return packet;
+}
+
+/// Capture the messages and gaps reported by the stream
+struct capture {
+  std::vector<std::uint64_t> seqnos;
+  std::vector<std::uint64_t> contents;
+  std::vector<std::pair<std::uint64_t, std::uint64_t>> gaps;
+
+  jb::itch5::mold_udp_stream::buffer_handler handler() {
+    return [this](
+        std::chrono::steady_clock::time_point, std::uint64_t seqno,
+        std::size_t, char const* msg, std::size_t msglen) {
+      seqnos.push_back(seqno);
+      contents.push_back(
+          jb::itch5::decoder<true, std::uint64_t>::r(msglen, msg, 0));
+    };
+  }
+
+  jb::itch5::mold_udp_stream::gap_handler gap() {
+    return [this](char const* session, std::uint64_t first, std::uint64_t n) {
+      BOOST_CHECK_EQUAL(std::string(session, 10), "SESSION001");
+      gaps.emplace_back(first, n);
+    };
+  }
+};
+
+void process(jb::itch5::mold_udp_stream& stream, std::vector<char> const& p) {
+  stream.process_packet(std::chrono::steady_clock::now(), p.data(), p.size());
+}
+} // anonymous namespace
+
+/**
+ * @test Verify that jb::itch5::mold_udp_stream recovers gaps.
+ */
+BOOST_AUTO_TEST_CASE(itch5_mold_udp_stream_recovery) {
+  capture cap;
+  jb::itch5::mold_udp_stream stream(cap.handler());
+  stream.enable_recovery(cap.gap(), 100);
+
+  process(stream, create_packet(0, 3));
+  BOOST_CHECK_EQUAL(stream.expected_sequence_number(), 3);
+  BOOST_CHECK(cap.gaps.empty());
+
+  // ... skip [3,5), the messages must be buffered and the gap
+  // requested exactly once ...
+  process(stream, create_packet(5, 2));
+  process(stream, create_packet(7, 2));
+  BOOST_CHECK_EQUAL(stream.expected_sequence_number(), 3);
+  BOOST_REQUIRE_EQUAL(cap.gaps.size(), 1);
+  BOOST_CHECK_EQUAL(cap.gaps[0].first, 3);
+  BOOST_CHECK_EQUAL(cap.gaps[0].second, 2);
+
+  // ... a duplicate of a buffered packet is discarded ...
+  process(stream, create_packet(5, 2));
+  BOOST_CHECK_EQUAL(stream.duplicate_messages(), 2);
+
+  // ... fill the gap, with some overlap ...
+  process(stream, create_packet(2, 3));
+  BOOST_CHECK_EQUAL(stream.expected_sequence_number(), 9);
+  BOOST_CHECK_EQUAL(stream.duplicate_messages(), 3);
+  BOOST_CHECK_EQUAL(stream.lost_messages(), 0);
+
+  std::vector<std::uint64_t> expected{0, 1, 2, 3, 4, 5, 6, 7, 8};
+  BOOST_CHECK_EQUAL_COLLECTIONS(
+      cap.seqnos.begin(), cap.seqnos.end(), expected.begin(), expected.end());
+  BOOST_CHECK_EQUAL_COLLECTIONS(
+      cap.contents.begin(), cap.contents.end(), expected.begin(),
+      expected.end());
+}
+
+/**
+ * @test Verify that jb::itch5::mold_udp_stream gives up when the
+ * reorder buffer is full.
+ */
+BOOST_AUTO_TEST_CASE(itch5_mold_udp_stream_recovery_overflow) {
+  capture cap;
+  jb::itch5::mold_udp_stream stream(cap.handler());
+  stream.enable_recovery(cap.gap(), 4);
+
+  process(stream, create_packet(0, 1));
+  process(stream, create_packet(3, 4));
+  BOOST_CHECK_EQUAL(stream.expected_sequence_number(), 1);
+  BOOST_CHECK_EQUAL(cap.gaps.size(), 1);
+
+  // ... this overflows the buffer, the stream skips over [1,3) ...
+  process(stream, create_packet(8, 1));
+  BOOST_CHECK_EQUAL(stream.lost_messages(), 2);
+  BOOST_CHECK_EQUAL(stream.expected_sequence_number(), 7);
+  BOOST_REQUIRE_EQUAL(cap.gaps.size(), 2);
+  BOOST_CHECK_EQUAL(cap.gaps[1].first, 7);
+  BOOST_CHECK_EQUAL(cap.gaps[1].second, 1);
+
+  std::vector<std::uint64_t> expected{0, 3, 4, 5, 6};
+  BOOST_CHECK_EQUAL_COLLECTIONS(
+      cap.contents.begin(), cap.contents.end(), expected.begin(),
+      expected.end());
+}
+
+/**
+ * @test Verify that jb::itch5::mold_udp_stream with recovery starts
+ * at the first packet received.
+ */
+BOOST_AUTO_TEST_CASE(itch5_mold_udp_stream_recovery_join) {
+  capture cap;
+  jb::itch5::mold_udp_stream stream(cap.handler());
+  stream.enable_recovery(cap.gap(), 100);
+
+  process(stream, create_packet(1000, 2));
+  BOOST_CHECK_EQUAL(stream.expected_sequence_number(), 1002);
+  BOOST_CHECK(cap.gaps.empty());
+
+  process(stream, create_packet(1004, 1));
+  BOOST_REQUIRE_EQUAL(cap.gaps.size(), 1);
+  BOOST_CHECK_EQUAL(cap.gaps[0].first, 1002);
+  BOOST_CHECK_EQUAL(cap.gaps[0].second, 2);
+
+  std::vector<std::uint64_t> expected{1000, 1001};
+  BOOST_CHECK_EQUAL_COLLECTIONS(
+      cap.contents.begin(), cap.contents.end(), expected.begin(),
+      expected.end());
+}
+
+/**
+ * @test Verify that jb::itch5::mold_udp_stream without recovery
+ * delivers everything.
+ */
+BOOST_AUTO_TEST_CASE(itch5_mold_udp_stream_no_recovery) {
+  capture cap;
+  jb::itch5::mold_udp_stream stream(cap.handler());
+
+  process(stream, create_packet(0, 2));
+  process(stream, create_packet(4, 2));
+  process(stream, create_packet(1, 1));
+  BOOST_CHECK_EQUAL(cap.contents.size(), 5);
+  BOOST_CHECK(cap.gaps.empty());
+}
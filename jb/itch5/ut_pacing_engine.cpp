@@ -0,0 +1,90 @@
+#include <jb/itch5/pacing_engine.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+/**
+ * @test Verify that jb::itch5::pacing_engine waits until the deadline
+ * of each message, and records the skew.
+ */
+BOOST_AUTO_TEST_CASE(itch5_pacing_engine_basic) {
+  using namespace std::chrono;
+  jb::metrics::registry r;
+  // ... at 2x, messages 400 usecs apart are scheduled every 200 usecs
+  // ...
+  jb::itch5::pacing_engine tested(
+      jb::itch5::mold_udp_pacer_config().speed(2.0).spin_microseconds(50),
+      r);
+
+  auto start = jb::tsc_clock::now();
+  tested.start(start, jb::itch5::timestamp{seconds(3600)});
+  for (int i = 1; i <= 20; ++i) {
+    auto ts = jb::itch5::timestamp{seconds(3600) + microseconds(400 * i)};
+    auto skipped = tested.wait(ts);
+    auto now = jb::tsc_clock::now();
+    BOOST_CHECK(skipped == nanoseconds(0));
+    // ... the deadlines are absolute, so the wait never ends early ...
+    BOOST_CHECK(now - start >= microseconds(200 * i));
+  }
+
+  auto h = tested.skew().snapshot();
+  BOOST_CHECK_EQUAL(h.nsamples(), 20);
+  BOOST_CHECK_EQUAL(h.underflow_count(), 0);
+  BOOST_TEST_MESSAGE("skew=" << h.summary());
+}
+
+/**
+ * @test Verify that jb::itch5::pacing_engine skips long idle periods.
+ */
+BOOST_AUTO_TEST_CASE(itch5_pacing_engine_skip) {
+  using namespace std::chrono;
+  jb::metrics::registry r;
+  jb::itch5::pacing_engine tested(
+      jb::itch5::mold_udp_pacer_config().maximum_sleep_milliseconds(1), r);
+
+  // ... the first message sets the schedule ...
+  BOOST_CHECK(
+      tested.wait(jb::itch5::timestamp{seconds(0)}) == nanoseconds(0));
+
+  // ... a message one hour later only waits for 1ms ...
+  auto start = jb::tsc_clock::now();
+  auto skipped = tested.wait(jb::itch5::timestamp{hours(1)});
+  auto elapsed = jb::tsc_clock::now() - start;
+  BOOST_CHECK(skipped > minutes(59));
+  BOOST_CHECK(elapsed >= milliseconds(1));
+  BOOST_CHECK(elapsed < seconds(10));
+
+  // ... and the following messages are scheduled from there ...
+  start = jb::tsc_clock::now();
+  skipped = tested.wait(jb::itch5::timestamp{hours(1) + microseconds(500)});
+  elapsed = jb::tsc_clock::now() - start;
+  BOOST_CHECK(skipped == nanoseconds(0));
+  BOOST_CHECK(elapsed < milliseconds(100));
+  BOOST_CHECK_EQUAL(tested.skew().nsamples(), 2);
+}
+
+/**
+ * @test Verify that jb::itch5::pacing_engine recalibrates the clock
+ * between waits.
+ */
+BOOST_AUTO_TEST_CASE(itch5_pacing_engine_recalibrate) {
+  using namespace std::chrono;
+  jb::metrics::registry r;
+  jb::itch5::pacing_engine tested(
+      jb::itch5::mold_udp_pacer_config().recalibration_period_milliseconds(1),
+      r);
+  for (int i = 0; i != 5; ++i) {
+    tested.wait(jb::itch5::timestamp{milliseconds(2 * i)});
+  }
+  // ... the first wait starts the schedule, each of the other waits
+  // is 2ms after the previous one ...
+  BOOST_CHECK_GE(tested.recalibrations(), 3);
+
+  jb::metrics::registry r2;
+  jb::itch5::pacing_engine disabled(
+      jb::itch5::mold_udp_pacer_config().recalibration_period_milliseconds(0),
+      r2);
+  for (int i = 0; i != 3; ++i) {
+    disabled.wait(jb::itch5::timestamp{milliseconds(2 * i)});
+  }
+  BOOST_CHECK_EQUAL(disabled.recalibrations(), 0);
+}
@@ -0,0 +1,80 @@
+#include <jb/itch5/packet_mmap_channel.hpp>
+#include <jb/itch5/testing/data.hpp>
+#include <jb/itch5/udp_receiver_config.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <system_error>
+
+using jb::itch5::testing::create_mold_udp_packet;
+
+namespace {
+/**
+ * Send packets to @a port on the loopback interface and verify that
+ * a jb::itch5::packet_mmap_channel listening on @a address receives
+ * them.
+ */
+void check_loopback(char const* address, int port) {
+  std::mutex mu;
+  std::condition_variable cv;
+  std::vector<std::uint64_t> seqnos;
+  auto adapter = [&](
+      std::chrono::steady_clock::time_point ts, std::uint64_t seqno,
+      std::size_t offset, char const* msg, std::size_t msgsize) {
+    std::lock_guard<std::mutex> guard(mu);
+    seqnos.push_back(seqno);
+    cv.notify_one();
+  };
+
+  boost::asio::io_service io;
+  auto cfg = jb::itch5::udp_receiver_config().address(address).port(port);
+  std::unique_ptr<jb::itch5::packet_mmap_channel> channel;
+  try {
+    channel = std::make_unique<jb::itch5::packet_mmap_channel>(
+        io, adapter, cfg,
+        jb::itch5::packet_mmap_config().interface("lo").block_size(1 << 16));
+  } catch (std::system_error const& ex) {
+    // ... AF_PACKET sockets require CAP_NET_RAW, which is not
+    // available in most test environments ...
+    BOOST_TEST_MESSAGE("Skipping test, cannot create ring: " << ex.what());
+    return;
+  }
+
+  using boost::asio::ip::udp;
+  udp::socket socket(io, udp::endpoint(udp::v4(), 0));
+  udp::endpoint send_to(
+      boost::asio::ip::address::from_string("127.0.0.1"), cfg.port());
+  // ... send some noise to a different port, it should be ignored ...
+  socket.send_to(
+      boost::asio::buffer(create_mold_udp_packet(100, 1)),
+      udp::endpoint(send_to.address(), cfg.port() + 1));
+  socket.send_to(boost::asio::buffer(create_mold_udp_packet(0, 3)), send_to);
+  socket.send_to(boost::asio::buffer(create_mold_udp_packet(3, 2)), send_to);
+
+  std::unique_lock<std::mutex> lock(mu);
+  bool done = cv.wait_for(lock, std::chrono::seconds(5), [&seqnos]() {
+    return seqnos.size() >= 5;
+  });
+  BOOST_CHECK(done);
+  BOOST_REQUIRE_EQUAL(seqnos.size(), 5UL);
+}
+} // anonymous namespace
+
+/**
+ * @test Verify that jb::itch5::packet_mmap_channel receives packets
+ * on the loopback interface.
+ */
+BOOST_AUTO_TEST_CASE(itch5_packet_mmap_channel_basic) {
+  check_loopback("127.0.0.1", 50002);
+}
+
+/**
+ * @test Verify that jb::itch5::packet_mmap_channel accepts any
+ * destination when listening on the unspecified address.
+ */
+BOOST_AUTO_TEST_CASE(itch5_packet_mmap_channel_unspecified) {
+  check_loopback("0.0.0.0", 50004);
+}
@@ -0,0 +1,25 @@
+#include <jb/itch5/packet_mmap_config.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+/**
+ * @test Verify that jb::itch5::packet_mmap_config validation works
+ * as expected.
+ */
+BOOST_AUTO_TEST_CASE(itch5_packet_mmap_config_validate) {
+  using config = jb::itch5::packet_mmap_config;
+
+  config default_validates;
+  BOOST_CHECK_NO_THROW(default_validates.validate());
+
+  BOOST_CHECK_THROW(config().interface("").validate(), jb::usage);
+  BOOST_CHECK_THROW(config().block_size(0).validate(), jb::usage);
+  BOOST_CHECK_THROW(config().block_size(1000).validate(), jb::usage);
+  BOOST_CHECK_THROW(config().block_count(0).validate(), jb::usage);
+  BOOST_CHECK_THROW(config().frame_size(0).validate(), jb::usage);
+  BOOST_CHECK_THROW(config().frame_size(100).validate(), jb::usage);
+  BOOST_CHECK_THROW(
+      config().block_size(4096).frame_size(8192).validate(), jb::usage);
+  BOOST_CHECK_THROW(
+      config().block_timeout_milliseconds(-1).validate(), jb::usage);
+}
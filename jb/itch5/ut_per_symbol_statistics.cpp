@@ -0,0 +1,116 @@
+#include <jb/itch5/per_symbol_statistics.hpp>
+#include <jb/book_depth_statistics.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+using jb::itch5::stock_t;
+typedef jb::itch5::per_symbol_statistics<jb::book_depth_statistics>
+    tested_type;
+
+/// Return the symbols and sample counts in the order used by for_each()
+std::vector<std::string> symbols(tested_type const& tested) {
+  std::vector<std::string> result;
+  tested.for_each([&result](stock_t const& stock, auto const& stats) {
+    std::ostringstream os;
+    stats.print_csv(stock.c_str(), os);
+    result.push_back(os.str().substr(0, os.str().find(',', 0) + 2));
+  });
+  return result;
+}
+} // anonymous namespace
+
+/**
+ * @test Verify that jb::itch5::per_symbol_statistics works as
+ * expected.
+ */
+BOOST_AUTO_TEST_CASE(itch5_per_symbol_statistics_basic) {
+  jb::book_depth_statistics::config cfg;
+  tested_type tested(cfg);
+  BOOST_CHECK_EQUAL(tested.size(), 0);
+
+  auto& msft = tested.get(3, stock_t("MSFT"));
+  msft.sample(1);
+  BOOST_CHECK_EQUAL(tested.size(), 1);
+  BOOST_CHECK_EQUAL(&tested.get(3, stock_t("MSFT")), &msft);
+
+  tested.get(2, stock_t("AAPL")).sample(1);
+  tested.get(2, stock_t("AAPL")).sample(2);
+  tested.get(100, stock_t("ZVZZT")).sample(1);
+  BOOST_CHECK_EQUAL(tested.size(), 3);
+
+  std::vector<std::string> expected{"AAPL,2", "MSFT,1", "ZVZZT,1"};
+  auto actual = symbols(tested);
+  BOOST_CHECK_EQUAL_COLLECTIONS(
+      actual.begin(), actual.end(), expected.begin(), expected.end());
+}
+
+/**
+ * @test Verify that jb::itch5::per_symbol_statistics handles messages
+ * without a valid stock locate.
+ */
+BOOST_AUTO_TEST_CASE(itch5_per_symbol_statistics_fallback) {
+  jb::book_depth_statistics::config cfg;
+  tested_type tested(cfg);
+
+  // ... the test data typically has a 0 stock locate ...
+  tested.get(0, stock_t("MSFT")).sample(1);
+  tested.get(0, stock_t("AAPL")).sample(1);
+  tested.get(0, stock_t("MSFT")).sample(1);
+  BOOST_CHECK_EQUAL(tested.size(), 2);
+
+  // ... a reused locate number does not mix the symbols ...
+  auto& ibm = tested.get(5, stock_t("IBM"));
+  auto& hpq = tested.get(5, stock_t("HPQ"));
+  BOOST_CHECK_NE(&ibm, &hpq);
+  ibm.sample(1);
+  hpq.sample(1);
+  BOOST_CHECK_EQUAL(&tested.get(5, stock_t("HPQ")), &hpq);
+  BOOST_CHECK_EQUAL(tested.size(), 4);
+
+  std::vector<std::string> expected{"AAPL,1", "HPQ,1", "IBM,1", "MSFT,2"};
+  auto actual = symbols(tested);
+  BOOST_CHECK_EQUAL_COLLECTIONS(
+      actual.begin(), actual.end(), expected.begin(), expected.end());
+}
+
+/**
+ * @test Verify that jb::itch5::per_symbol_statistics reports each
+ * symbol once, even if it appears under several locate numbers.
+ */
+BOOST_AUTO_TEST_CASE(itch5_per_symbol_statistics_duplicates) {
+  jb::book_depth_statistics::config cfg;
+  tested_type tested(cfg);
+
+  auto& msft = tested.get(0, stock_t("MSFT"));
+  msft.sample(1);
+  tested.get(3, stock_t("MSFT")).sample(1);
+  tested.get(4, stock_t("MSFT")).sample(1);
+  BOOST_CHECK_EQUAL(&tested.get(3, stock_t("MSFT")), &msft);
+  tested.get(5, stock_t("IBM")).sample(1);
+  tested.get(5, stock_t("HPQ")).sample(1);
+  tested.get(6, stock_t("HPQ")).sample(1);
+  BOOST_CHECK_EQUAL(tested.size(), 3);
+
+  std::vector<std::string> expected{"HPQ,2", "IBM,1", "MSFT,3"};
+  auto actual = symbols(tested);
+  BOOST_CHECK_EQUAL_COLLECTIONS(
+      actual.begin(), actual.end(), expected.begin(), expected.end());
+}
+
+/**
+ * @test Verify the default per-symbol feed statistics configuration.
+ */
+BOOST_AUTO_TEST_CASE(itch5_per_symbol_statistics_feed_defaults) {
+  auto cfg = jb::itch5::default_per_symbol_feed_statistics();
+  BOOST_CHECK_NO_THROW(cfg.validate());
+  BOOST_CHECK_EQUAL(cfg.significant_digits(), 2);
+  BOOST_CHECK_EQUAL(cfg.reporting_interval_seconds(), 24 * 3600);
+
+  jb::itch5::per_symbol_statistics<jb::offline_feed_statistics> tested(cfg);
+  BOOST_CHECK_EQUAL(tested.size(), 0);
+}
@@ -0,0 +1,248 @@
+#include <jb/itch5/compute_book.hpp>
+#include <jb/itch5/map_based_order_book.hpp>
+#include <jb/itch5/pipeline_latency.hpp>
+#include <jb/itch5/trade_message.hpp>
+#include <jb/usage.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <sstream>
+#include <thread>
+
+namespace {
+using jb::itch5::pipeline_latency;
+using jb::itch5::time_point;
+
+/// Return the histograms for a message type
+pipeline_latency::message_histograms const&
+histograms_for(pipeline_latency const& latency, char message_type) {
+  return latency.local()[pipeline_latency::message_type_index(message_type)];
+}
+
+/// Return a time_point @a nanos after @a base
+time_point after(time_point base, int nanos) {
+  return base + std::chrono::nanoseconds(nanos);
+}
+} // anonymous namespace
+
+/**
+ * @test Verify that jb::itch5::pipeline_latency records each stage.
+ */
+BOOST_AUTO_TEST_CASE(pipeline_latency_record) {
+  pipeline_latency tested{pipeline_latency::config()};
+  auto const received = jb::itch5::clock_type::now();
+
+  // ... a message that completes all the stages ...
+  time_point const all[] = {after(received, 10), after(received, 30),
+                            after(received, 60), after(received, 100)};
+  tested.record('A', received, all);
+  // ... a message rejected after the decode stage, for example, an
+  // execution for an unknown order ...
+  time_point const rejected[] = {after(received, 20), time_point(),
+                                 time_point(), time_point()};
+  tested.record('E', received, rejected);
+
+  auto const& a = histograms_for(tested, 'A');
+  BOOST_CHECK_EQUAL(a.count, 1);
+  std::uint64_t const expected[] = {10, 20, 30, 40, 100};
+  for (int s = 0; s != pipeline_latency::stage_count + 1; ++s) {
+    BOOST_TEST_MESSAGE("stage=" << pipeline_latency::stage_name(s));
+    BOOST_CHECK_EQUAL(a.latency[s].nsamples(), 1);
+    BOOST_CHECK_EQUAL(a.sum[s], expected[s]);
+  }
+
+  auto const& e = histograms_for(tested, 'E');
+  BOOST_CHECK_EQUAL(e.count, 1);
+  BOOST_CHECK_EQUAL(e.latency[0].nsamples(), 1);
+  BOOST_CHECK_EQUAL(e.sum[0], 20);
+  for (int s = 1; s != pipeline_latency::stage_count + 1; ++s) {
+    BOOST_CHECK_EQUAL(e.latency[s].nsamples(), 0);
+  }
+
+  // ... message types that are not letters share a histogram ...
+  BOOST_CHECK_EQUAL(pipeline_latency::message_type_index('A'), 0);
+  BOOST_CHECK_EQUAL(pipeline_latency::message_type_index('Z'), 25);
+  BOOST_CHECK_EQUAL(
+      pipeline_latency::message_type_index('a'),
+      pipeline_latency::message_type_count - 1);
+
+  // ... verify the reports include the samples ...
+  std::ostringstream os;
+  tested.print_csv(os);
+  BOOST_CHECK_NE(os.str().find("stage:book:A,1"), std::string::npos);
+  BOOST_CHECK_NE(os.str().find("stage:decode:E,1"), std::string::npos);
+  BOOST_CHECK_EQUAL(os.str().find("stage:book:E"), std::string::npos);
+}
+
+/**
+ * @test Verify that jb::itch5::compute_book records the latency of
+ * each stage.
+ */
+BOOST_AUTO_TEST_CASE(pipeline_latency_compute_book) {
+  using namespace jb::itch5;
+  using book_type = map_based_order_book;
+  pipeline_latency latency{pipeline_latency::config()};
+  int updates = 0;
+  auto cb = [&updates](
+      message_header const&, order_book<book_type> const&,
+      book_update const&) { ++updates; };
+  book_type::config cfg;
+  compute_book<book_type> tested(cb, cfg, &latency);
+
+  stock_t const stock("HSART");
+  price4_t const p10(100000);
+  price4_t const p11(110000);
+  buy_sell_indicator_t const buy(u'B');
+  timestamp const ts{std::chrono::nanoseconds(0)};
+  long msgcnt = 0;
+
+  tested.handle_message(
+      tested.now(), ++msgcnt, 0,
+      add_order_message{
+          {add_order_message::message_type, 0, 0, ts}, 1, buy, 300, stock,
+          p10});
+  tested.handle_message(
+      tested.now(), ++msgcnt, 0,
+      order_executed_message{
+          {order_executed_message::message_type, 0, 0, ts}, 1, 100, 7});
+  tested.handle_message(
+      tested.now(), ++msgcnt, 0,
+      order_replace_message{
+          {order_replace_message::message_type, 0, 0, ts}, 1, 2, 400, p11});
+  tested.handle_message(
+      tested.now(), ++msgcnt, 0,
+      order_delete_message{{order_delete_message::message_type, 0, 0, ts},
+                           2});
+  // ... an unknown order is rejected after the decode stage ...
+  tested.handle_message(
+      tested.now(), ++msgcnt, 0,
+      order_delete_message{{order_delete_message::message_type, 0, 0, ts},
+                           2});
+  // ... ignored messages only record the decode stage ...
+  tested.handle_message(
+      tested.now(), ++msgcnt, 0,
+      trade_message{{trade_message::message_type, 0, 0, ts}, 3, buy, 100,
+                    stock, p10, 8});
+  BOOST_CHECK_EQUAL(updates, 4);
+
+  auto check_complete = [&latency](char type) {
+    BOOST_TEST_MESSAGE("message_type=" << type);
+    auto const& h = histograms_for(latency, type);
+    BOOST_CHECK_EQUAL(h.count, 1);
+    for (int s = 0; s != pipeline_latency::stage_count + 1; ++s) {
+      BOOST_CHECK_EQUAL(h.latency[s].nsamples(), 1);
+    }
+  };
+  check_complete(add_order_message::message_type);
+  check_complete(order_executed_message::message_type);
+  check_complete(order_replace_message::message_type);
+
+  auto const& d = histograms_for(latency, order_delete_message::message_type);
+  BOOST_CHECK_EQUAL(d.count, 2);
+  BOOST_CHECK_EQUAL(d.latency[0].nsamples(), 2);
+  BOOST_CHECK_EQUAL(d.latency[pipeline_latency::total].nsamples(), 1);
+
+  auto const& t = histograms_for(latency, trade_message::message_type);
+  BOOST_CHECK_EQUAL(t.count, 1);
+  BOOST_CHECK_EQUAL(t.latency[0].nsamples(), 1);
+  BOOST_CHECK_EQUAL(t.latency[pipeline_latency::total].nsamples(), 0);
+}
+
+/**
+ * @test Verify that jb::itch5::pipeline_latency publishes snapshots
+ * to other threads.
+ */
+BOOST_AUTO_TEST_CASE(pipeline_latency_snapshot) {
+  pipeline_latency tested{pipeline_latency::config()};
+  std::atomic<bool> done(false);
+  std::thread t([&tested, &done]() {
+    while (not done.load()) {
+      auto const received = jb::itch5::clock_type::now();
+      time_point const completed[] = {
+          after(received, 10), after(received, 20), after(received, 30),
+          after(received, 40)};
+      tested.record('A', received, completed);
+    }
+  });
+
+  // ... the first snapshot may be empty if the thread has not
+  // started, but eventually the samples must be visible ...
+  std::uint64_t count = 0;
+  for (int i = 0; i != 100 and count == 0; ++i) {
+    auto s = tested.snapshot();
+    count = s[pipeline_latency::message_type_index('A')].count;
+    if (count == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+  // ... the metrics are also based on a snapshot ...
+  std::string body;
+  tested.append_metrics(body);
+  done.store(true);
+  t.join();
+  BOOST_CHECK_GT(count, 0);
+  BOOST_CHECK_NE(
+      body.find("stage_latency_nanoseconds_count{stage=\"total\","
+                "message_type=\"A\"}"),
+      std::string::npos);
+  BOOST_CHECK_NE(
+      body.find("stage_latency_nanoseconds{stage=\"decode\","
+                "message_type=\"A\",quantile=\"0.5\"} 10"),
+      std::string::npos);
+
+  // ... without new messages the snapshot returns the last published
+  // copy, without waiting ...
+  auto s = tested.snapshot();
+  BOOST_CHECK_LE(
+      s[pipeline_latency::message_type_index('A')].count,
+      histograms_for(tested, 'A').count);
+}
+
+/**
+ * @test Verify that jb::itch5::pipeline_latency publishes the
+ * histograms periodically, and after a snapshot is requested.
+ */
+BOOST_AUTO_TEST_CASE(pipeline_latency_publish_interval) {
+  pipeline_latency tested{
+      pipeline_latency::config().publish_interval_milliseconds(100)};
+  auto const index = pipeline_latency::message_type_index('A');
+  time_point const none[] = {
+      time_point(), time_point(), time_point(), time_point()};
+  auto const r0 = jb::itch5::clock_type::now();
+  using std::chrono::milliseconds;
+
+  // ... the first message is always published, the second one is
+  // too early ...
+  tested.record('A', r0, none);
+  tested.record('A', r0 + milliseconds(50), none);
+  BOOST_CHECK_EQUAL(tested.snapshot()[index].count, 1);
+
+  // ... the snapshot requested a new copy ...
+  tested.record('A', r0 + milliseconds(60), none);
+  tested.record('A', r0 + milliseconds(70), none);
+  tested.record('A', r0 + milliseconds(200), none);
+  BOOST_CHECK_EQUAL(tested.snapshot()[index].count, 5);
+}
+
+/**
+ * @test Verify that jb::itch5::pipeline_latency::config validation
+ * works as expected.
+ */
+BOOST_AUTO_TEST_CASE(pipeline_latency_config) {
+  using config = pipeline_latency::config;
+  BOOST_CHECK_NO_THROW(config().validate());
+  BOOST_CHECK_NO_THROW(config().max_latency_nanoseconds(50).validate());
+  BOOST_CHECK_THROW(config().max_latency_nanoseconds(1).validate(), jb::usage);
+  BOOST_CHECK_THROW(
+      config().publish_interval_milliseconds(-1).validate(), jb::usage);
+
+  // ... small maximums still create a valid histogram ...
+  pipeline_latency tested{config().max_latency_nanoseconds(50)};
+  auto const received = jb::itch5::clock_type::now();
+  time_point const completed[] = {after(received, 10), after(received, 200),
+                                  time_point(), time_point()};
+  tested.record('A', received, completed);
+  auto const& a = histograms_for(tested, 'A');
+  BOOST_CHECK_EQUAL(a.latency[1].observed_max(), 190);
+}
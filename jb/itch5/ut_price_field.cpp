@@ -88,6 +88,30 @@ BOOST_AUTO_TEST_CASE(stream_price_field_8) {
   BOOST_CHECK_EQUAL(os.str(), "123456789.00012000");
 }
 
+/**
+ * @test Verify that jb::itch5::price_field jb::fast_format operator
+ * matches the iostream operator.
+ */
+BOOST_AUTO_TEST_CASE(fast_format_price_field) {
+  using jb::itch5::price4_t;
+  using jb::itch5::price8_t;
+  std::ostringstream expected;
+  std::ostringstream os;
+  {
+    jb::fast_format out(os);
+    for (auto v : {0U, 1U, 99U, 10000U, 12340123U, 4294967295U}) {
+      expected << price4_t(v) << " ";
+      out << price4_t(v) << ' ';
+    }
+    for (auto v : {0ULL, 12000ULL, 12345678900012000ULL,
+                   9223372036854775807ULL}) {
+      expected << price8_t(v) << " ";
+      out << price8_t(v) << ' ';
+    }
+  }
+  BOOST_CHECK_EQUAL(os.str(), expected.str());
+}
+
 /**
  * @test Verify addition and addition assignment operator work as expected.
  */
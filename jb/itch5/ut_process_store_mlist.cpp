@@ -0,0 +1,69 @@
+#include <jb/itch5/process_iostream_mlist.hpp>
+#include <jb/itch5/process_store_mlist.hpp>
+#include <jb/itch5/system_event_message.hpp>
+
+#include <jb/itch5/testing/data.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <sstream>
+#include <tuple>
+#include <vector>
+
+namespace {
+/// Record the messages received by the handler
+struct recording_handler {
+  typedef int time_point;
+
+  int now() const {
+    return 0;
+  }
+
+  void handle_unknown(int const&, jb::itch5::unknown_message const& msg) {
+    auto buf = static_cast<char const*>(msg.buf());
+    received.emplace_back(
+        msg.count(), msg.offset(), std::string(buf, msg.len()));
+  }
+
+  void handle_message(
+      int const&, std::uint64_t msgcnt, std::size_t msgoffset,
+      jb::itch5::system_event_message const&) {
+    received.emplace_back(msgcnt, msgoffset, "system_event");
+  }
+
+  std::vector<std::tuple<std::uint64_t, std::size_t, std::string>> received;
+};
+} // anonymous namespace
+
+/**
+ * @test Verify that jb::itch5::process_store_mlist<> reports the same
+ * messages, counts and offsets as jb::itch5::process_iostream_mlist<>.
+ */
+BOOST_AUTO_TEST_CASE(process_store_mlist_simple) {
+  std::string bytes;
+  for (auto const& p :
+       {jb::itch5::testing::system_event(),
+        jb::itch5::testing::stock_directory(), jb::itch5::testing::add_order(),
+        jb::itch5::testing::trade(), jb::itch5::testing::system_event()}) {
+    bytes.push_back(char(p.second / 256));
+    bytes.push_back(char(p.second % 256));
+    bytes.append(p.first, p.second);
+  }
+
+  recording_handler expected;
+  std::istringstream is(bytes);
+  jb::itch5::process_iostream_mlist<
+      recording_handler, jb::itch5::system_event_message>(is, expected);
+
+  jb::itch5::message_store store;
+  std::istringstream load(bytes);
+  store.load(load);
+  recording_handler actual;
+  jb::itch5::process_store_mlist<
+      recording_handler, jb::itch5::system_event_message>(store, actual);
+
+  BOOST_REQUIRE_EQUAL(actual.received.size(), 5);
+  BOOST_CHECK(actual.received == expected.received);
+  BOOST_CHECK_EQUAL(std::get<2>(actual.received.at(0)), "system_event");
+  BOOST_CHECK_EQUAL(std::get<1>(actual.received.at(0)), 2);
+}
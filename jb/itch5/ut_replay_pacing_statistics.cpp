@@ -0,0 +1,68 @@
+#include <jb/itch5/replay_pacing_statistics.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+/**
+ * @test Verify that jb::itch5::replay_pacing_statistics computes the
+ * pacing errors and message rate.
+ */
+BOOST_AUTO_TEST_CASE(itch5_replay_pacing_statistics_basic) {
+  using namespace std::chrono;
+  jb::metrics::registry r;
+  jb::itch5::replay_pacing_statistics tested(
+      jb::itch5::mold_udp_pacer_config().speed(2.0), r);
+
+  // ... at 2x the messages are scheduled at 0, 1ms, 2ms and 3ms ...
+  steady_clock::time_point start(seconds(100));
+  auto ts = [](int ms) { return jb::itch5::timestamp{milliseconds(ms)}; };
+  tested.sample(start, ts(1000));
+  tested.sample(start + microseconds(1010), ts(1002));
+  tested.sample(start + microseconds(2500), ts(1004));
+  tested.sample(start + microseconds(2990), ts(1006));
+
+  BOOST_CHECK_EQUAL(tested.nmessages(), 4);
+  BOOST_CHECK(tested.elapsed() == microseconds(2990));
+  BOOST_CHECK_CLOSE(tested.message_rate(), 4 / 2990e-6, 0.001);
+
+  auto h = tested.pacing_error().snapshot();
+  BOOST_CHECK_EQUAL(h.nsamples(), 4);
+  BOOST_CHECK_EQUAL(h.underflow_count(), 1);
+  BOOST_CHECK_EQUAL(h.observed_max(), 500000);
+
+  // ... skipped time moves the schedule for the following messages,
+  // at 2x this message is scheduled at 10.004s, but the replay
+  // skipped 10s ...
+  tested.skip(seconds(10));
+  tested.sample(start + microseconds(4000), ts(21008));
+  h = tested.pacing_error().snapshot();
+  BOOST_CHECK_EQUAL(h.nsamples(), 5);
+  BOOST_CHECK_EQUAL(h.observed_max(), 500000);
+
+  std::string text;
+  r.append_text(text);
+  BOOST_CHECK_NE(
+      text.find("replay_pacing_error_nanoseconds_count 5\n"),
+      std::string::npos);
+  BOOST_CHECK_NE(text.find("replay_message_rate"), std::string::npos);
+}
+
+/**
+ * @test Verify that jb::itch5::replay_pacing_statistics does not
+ * record pacing errors for unthrottled replays.
+ */
+BOOST_AUTO_TEST_CASE(itch5_replay_pacing_statistics_unthrottled) {
+  using namespace std::chrono;
+  jb::metrics::registry r;
+  jb::itch5::replay_pacing_statistics tested(
+      jb::itch5::mold_udp_pacer_config().unthrottled(true), r);
+
+  steady_clock::time_point start(seconds(100));
+  for (int i = 0; i != 2048; ++i) {
+    tested.sample(
+        start + microseconds(i), jb::itch5::timestamp{milliseconds(i)});
+  }
+  BOOST_CHECK_EQUAL(tested.nmessages(), 2048);
+  BOOST_CHECK_EQUAL(tested.pacing_error().nsamples(), 0);
+  BOOST_CHECK_CLOSE(tested.message_rate(), 2048 / 2047e-6, 0.001);
+  tested.log_summary();
+}
@@ -0,0 +1,204 @@
+#include <jb/itch5/make_socket_udp_recv.hpp>
+#include <jb/itch5/udp_batch_sender.hpp>
+#include <jb/itch5/udp_receiver_config.hpp>
+#include <jb/mktdata/batch_header.hpp>
+#include <jb/mktdata/message_header.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstring>
+#include <stdexcept>
+
+/**
+ * Helper types and functions to test jb::itch5::udp_batch_sender
+ */
+namespace {
+/// A message with the same prefix as all JayBeams messages
+struct test_message {
+  jb::mktdata::message_header header;
+  boost::endian::little_uint32_buf_t value;
+};
+
+test_message create_message(std::uint32_t value) {
+  test_message msg;
+  msg.header.message_type = 0x4242;
+  msg.header.message_size = sizeof(msg);
+  msg.header.sequence_number = 0;
+  msg.value = value;
+  return msg;
+}
+
+/**
+ * Receive a batch and return the values in it.
+ *
+ * @param socket where to receive the batch from
+ * @param expected_seqno the expected batch sequence number
+ * @param seqnos the message sequence numbers, if not null
+ */
+std::vector<std::uint32_t> receive_batch(
+    boost::asio::ip::udp::socket& socket, std::uint32_t expected_seqno,
+    std::vector<std::uint32_t>* seqnos = nullptr) {
+  char buffer[1 << 16];
+  auto n = socket.receive(boost::asio::buffer(buffer, sizeof(buffer)));
+  BOOST_REQUIRE_GE(n, sizeof(jb::mktdata::batch_header));
+  jb::mktdata::batch_header header;
+  std::memcpy(&header, buffer, sizeof(header));
+  BOOST_CHECK_EQUAL(header.batch_size.value(), n);
+  BOOST_CHECK_EQUAL(header.sequence_number.value(), expected_seqno);
+
+  std::vector<std::uint32_t> values;
+  std::size_t offset = sizeof(header);
+  for (int i = 0; i != header.message_count.value(); ++i) {
+    test_message msg;
+    BOOST_REQUIRE_LE(offset + sizeof(msg), n);
+    std::memcpy(&msg, buffer + offset, sizeof(msg));
+    BOOST_CHECK_EQUAL(msg.header.message_size.value(), sizeof(msg));
+    values.push_back(msg.value.value());
+    if (seqnos != nullptr) {
+      seqnos->push_back(msg.header.sequence_number.value());
+    }
+    offset += msg.header.message_size.value();
+  }
+  BOOST_CHECK_EQUAL(offset, n);
+  return values;
+}
+
+/// Return true if there is any data to read in the socket
+bool has_data(boost::asio::ip::udp::socket& socket) {
+  return socket.available() != 0;
+}
+} // anonymous namespace
+
+/**
+ * @test Verify that jb::itch5::udp_batch_sender works.
+ */
+BOOST_AUTO_TEST_CASE(itch5_udp_batch_sender_basic) {
+  boost::asio::io_service io;
+  auto r0 = jb::itch5::make_socket_udp_recv(
+      io, jb::itch5::udp_receiver_config().address("127.0.0.1").port(50100));
+  auto r1 = jb::itch5::make_socket_udp_recv(
+      io, jb::itch5::udp_receiver_config().address("127.0.0.1").port(50101));
+
+  std::vector<jb::itch5::udp_sender_config> destinations{
+      jb::itch5::udp_sender_config().address("127.0.0.1").port(50100),
+      jb::itch5::udp_sender_config().address("127.0.0.1").port(50101)};
+  // ... 8 byte header + 3 messages of 12 bytes ...
+  jb::itch5::udp_batch_sender sender(
+      io, destinations, jb::itch5::udp_batch_sender_config()
+                            .max_packet_size(44)
+                            .flush_deadline_microseconds(1000000));
+
+  for (std::uint32_t i = 0; i != 3; ++i) {
+    auto msg = create_message(i);
+    BOOST_CHECK_EQUAL(sender.append(&msg, sizeof(msg)), i + 1);
+  }
+  BOOST_CHECK_EQUAL(sender.packets_sent(), 0);
+  BOOST_CHECK(not has_data(r0));
+
+  // ... the fourth message does not fit, the datagram is sent ...
+  auto msg = create_message(3);
+  sender.append(&msg, sizeof(msg));
+  BOOST_CHECK_EQUAL(sender.packets_sent(), 2);
+  BOOST_CHECK_EQUAL(sender.send_calls(), 1);
+  std::vector<std::uint32_t> expected{0, 1, 2};
+  std::vector<std::uint32_t> expected_seqnos{1, 2, 3};
+  for (auto* s : {&r0, &r1}) {
+    std::vector<std::uint32_t> seqnos;
+    auto actual = receive_batch(*s, 0, &seqnos);
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        actual.begin(), actual.end(), expected.begin(), expected.end());
+    // ... every destination sees the same sequence numbers ...
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        seqnos.begin(), seqnos.end(), expected_seqnos.begin(),
+        expected_seqnos.end());
+  }
+
+  sender.flush();
+  BOOST_CHECK_EQUAL(sender.messages_sent(), 4);
+  BOOST_CHECK_EQUAL(sender.send_calls(), 2);
+  for (auto* s : {&r0, &r1}) {
+    std::vector<std::uint32_t> seqnos;
+    auto actual = receive_batch(*s, 1, &seqnos);
+    BOOST_REQUIRE_EQUAL(actual.size(), 1);
+    BOOST_CHECK_EQUAL(actual[0], 3);
+    BOOST_REQUIRE_EQUAL(seqnos.size(), 1);
+    BOOST_CHECK_EQUAL(seqnos[0], 4);
+  }
+
+  // ... an empty flush does nothing ...
+  sender.flush();
+  BOOST_CHECK_EQUAL(sender.send_calls(), 2);
+
+  char large[64] = {0};
+  BOOST_CHECK_THROW(sender.append(large, sizeof(large)), std::invalid_argument);
+  char small[4] = {0};
+  BOOST_CHECK_THROW(sender.append(small, sizeof(small)), std::invalid_argument);
+}
+
+/**
+ * @test Verify that jb::itch5::udp_batch_sender flushes on the deadline.
+ */
+BOOST_AUTO_TEST_CASE(itch5_udp_batch_sender_deadline) {
+  boost::asio::io_service io;
+  auto r0 = jb::itch5::make_socket_udp_recv(
+      io, jb::itch5::udp_receiver_config().address("127.0.0.1").port(50100));
+  std::vector<jb::itch5::udp_sender_config> destinations{
+      jb::itch5::udp_sender_config().address("127.0.0.1").port(50100)};
+  jb::itch5::udp_batch_sender sender(
+      io, destinations,
+      jb::itch5::udp_batch_sender_config().flush_deadline_microseconds(1000));
+
+  auto msg = create_message(42);
+  sender.append(&msg, sizeof(msg));
+  sender.append(&msg, sizeof(msg));
+  BOOST_CHECK_EQUAL(sender.packets_sent(), 0);
+  io.run_one();
+  BOOST_CHECK_EQUAL(sender.packets_sent(), 1);
+  auto actual = receive_batch(r0, 0);
+  BOOST_CHECK_EQUAL(actual.size(), 2);
+
+  // ... without a deadline each message is sent immediately, as a
+  // bare message without a batch header ...
+  jb::itch5::udp_batch_sender unbatched(
+      io, destinations,
+      jb::itch5::udp_batch_sender_config().flush_deadline_microseconds(0));
+  BOOST_CHECK_EQUAL(unbatched.append(&msg, sizeof(msg)), 1);
+  BOOST_CHECK_EQUAL(unbatched.packets_sent(), 1);
+  char buffer[1 << 16];
+  auto n = r0.receive(boost::asio::buffer(buffer, sizeof(buffer)));
+  BOOST_REQUIRE_EQUAL(n, sizeof(test_message));
+  test_message received;
+  std::memcpy(&received, buffer, sizeof(received));
+  BOOST_CHECK_EQUAL(received.value.value(), 42);
+  BOOST_CHECK_EQUAL(received.header.sequence_number.value(), 1);
+
+  // ... a message that fills the datagram is valid without a header ...
+  jb::itch5::udp_batch_sender small(
+      io, destinations, jb::itch5::udp_batch_sender_config()
+                            .max_packet_size(sizeof(test_message))
+                            .flush_deadline_microseconds(0));
+  BOOST_CHECK_NO_THROW(small.append(&msg, sizeof(msg)));
+  n = r0.receive(boost::asio::buffer(buffer, sizeof(buffer)));
+  BOOST_CHECK_EQUAL(n, sizeof(test_message));
+}
+
+/**
+ * @test Verify that jb::itch5::udp_batch_sender rejects incompatible
+ * destinations.
+ */
+BOOST_AUTO_TEST_CASE(itch5_udp_batch_sender_errors) {
+  boost::asio::io_service io;
+  using jb::itch5::udp_sender_config;
+  using jb::itch5::udp_batch_sender_config;
+  BOOST_CHECK_THROW(
+      jb::itch5::udp_batch_sender(
+          io, std::vector<udp_sender_config>{}, udp_batch_sender_config()),
+      std::invalid_argument);
+
+  std::vector<udp_sender_config> mixed{
+      udp_sender_config().address("127.0.0.1").port(50100),
+      udp_sender_config().address("127.0.0.1").port(50101).hops(3)};
+  BOOST_CHECK_THROW(
+      jb::itch5::udp_batch_sender(io, mixed, udp_batch_sender_config()),
+      std::invalid_argument);
+}
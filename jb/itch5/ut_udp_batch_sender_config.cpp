@@ -0,0 +1,23 @@
+#include <jb/itch5/udp_batch_sender_config.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+/**
+ * @test Verify that jb::itch5::udp_batch_sender_config validation
+ * works as expected.
+ */
+BOOST_AUTO_TEST_CASE(itch5_udp_batch_sender_config_validate) {
+  using config = jb::itch5::udp_batch_sender_config;
+
+  BOOST_CHECK_NO_THROW(config().validate());
+  BOOST_CHECK_NO_THROW(config().flush_deadline_microseconds(0).validate());
+
+  config too_small = config().max_packet_size(16);
+  BOOST_CHECK_THROW(too_small.validate(), jb::usage);
+
+  config too_big = config().max_packet_size(70000);
+  BOOST_CHECK_THROW(too_big.validate(), jb::usage);
+
+  config negative_deadline = config().flush_deadline_microseconds(-1);
+  BOOST_CHECK_THROW(negative_deadline.validate(), jb::usage);
+}
@@ -0,0 +1,415 @@
+#ifndef jb_kll_sketch_hpp
+#define jb_kll_sketch_hpp
+
+#include <jb/histogram_summary.hpp>
+#include <jb/metrics_binary.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace jb {
+
+/**
+ * A mergeable quantile sketch with bounded memory.
+ *
+ * jb::histogram needs a range for the samples, values outside the
+ * range are only counted in the underflow or overflow bins, and a
+ * wide range at good precision costs memory.  That is a problem for
+ * long-running processes where the range of the samples is not known
+ * in advance, e.g. the latencies in a feed handler that runs all day.
+ *
+ * This class implements the KLL sketch:
+ *
+ * Z. Karnin, K. Lang, E. Liberty, "Optimal Quantile Approximation in
+ * Streams", FOCS 2016.
+ *
+ * The sketch keeps a stack of compactors, the items in level h of the
+ * stack represent 2^h samples each.  When the sketch is full a level
+ * is sorted, and every other item (starting at a random offset) is
+ * promoted to the next level, the rest are discarded.  The capacity
+ * of each level decreases geometrically (by 2/3) from the top of the
+ * stack, with a minimum of 8 items.
+ *
+ * The sketch retains at most about 3 * k + 8 * log2(n / k) samples,
+ * independent of the range of the values.  The error is measured in
+ * rank: for any quantile q the estimate is the true quantile for
+ * some q' with |q - q'| <= epsilon.  epsilon is O(1 / k), with the
+ * default k = 200 it is about 1.65% with 99% probability, k = 400
+ * halves the error and doubles the memory.  observed_min(),
+ * observed_max() and estimated_mean() are exact.
+ *
+ * The interface is compatible with jb::histogram, so the sketch can
+ * be used where a histogram is used to compute quantiles and
+ * summaries.  Sketches with the same k can be merged, the result has
+ * the same error guarantees as a sketch that received all the
+ * samples.
+ *
+ * @tparam sample_type_t the type of the samples
+ */
+template <typename sample_type_t>
+class kll_sketch {
+public:
+  //@{
+  /**
+   * @name type traits
+   */
+  typedef sample_type_t sample_type;
+  //@}
+
+  /// The default accuracy parameter
+  static constexpr int default_k = 200;
+
+  /// The range for the accuracy parameter
+  static constexpr int min_k = 8;
+  static constexpr int max_k = 65535;
+
+  /**
+   * Constructor.
+   *
+   * @param k the accuracy parameter, the rank error is O(1 / k) and
+   * the memory is O(k)
+   * @throw std::invalid_argument if k is not in the [min_k,max_k]
+   * range
+   */
+  explicit kll_sketch(int k = default_k)
+      : k_(k)
+      , observed_min_(std::numeric_limits<sample_type>::max())
+      , observed_max_(std::numeric_limits<sample_type>::lowest())
+      , nsamples_(0)
+      , sum_(0)
+      , levels_()
+      , capacities_()
+      , retained_(0)
+      , capacity_(0)
+      , random_(0x9E3779B97F4A7C15ULL) {
+    if (k < min_k or k > max_k) {
+      std::ostringstream os;
+      os << "jb::kll_sketch - k (" << k << ") must be in the [" << min_k
+         << "," << max_k << "] range";
+      throw std::invalid_argument(os.str());
+    }
+  }
+
+  /// The accuracy parameter
+  int k() const {
+    return k_;
+  }
+
+  /// The number of samples kept in memory
+  std::size_t retained() const {
+    return retained_;
+  }
+
+  /// Return the number of samples observed to this point.
+  std::uint64_t nsamples() const {
+    return nsamples_;
+  }
+
+  /// Return the smallest sample value observed to this point.
+  sample_type observed_min() const {
+    return observed_min_;
+  }
+
+  /// Return the largest sample value observed to this point.
+  sample_type observed_max() const {
+    return observed_max_;
+  }
+
+  /// Return the mean of the samples
+  sample_type estimated_mean() const {
+    if (nsamples_ == 0) {
+      throw std::invalid_argument("Cannot estimate mean on an empty sketch");
+    }
+    return static_cast<sample_type>(sum_ / nsamples_);
+  }
+
+  /**
+   * Estimate a quantile of the sample distribution.
+   *
+   * Find the smallest retained value Q such that the estimated number
+   * of samples smaller than or equal to Q is at least q * nsamples.
+   *
+   * Estimating quantiles is O(R log R) where R is the number of
+   * retained samples.
+   */
+  sample_type estimated_quantile(double q) const {
+    if (nsamples_ == 0) {
+      throw std::invalid_argument("Cannot estimate quantile for empty sketch");
+    }
+    if (q < 0 or q > 1.0) {
+      throw std::invalid_argument("Quantile value outside 0 <= q <= 1 range");
+    }
+    if (q == 0) {
+      return observed_min();
+    }
+    auto items = weighted_items();
+    double const target = q * nsamples_;
+    std::uint64_t cumulative = 0;
+    for (auto const& i : items) {
+      cumulative += i.second;
+      if (target <= cumulative) {
+        return i.first;
+      }
+    }
+    return observed_max();
+  }
+
+  /// Return a simple summary
+  histogram_summary summary() const {
+    if (nsamples() == 0) {
+      return histogram_summary{0, 0, 0, 0, 0, 0, 0, 0};
+    }
+    return histogram_summary{
+        double(observed_min()),           double(estimated_quantile(0.25)),
+        double(estimated_quantile(0.50)), double(estimated_quantile(0.75)),
+        double(estimated_quantile(0.90)), double(estimated_quantile(0.99)),
+        double(observed_max()),           nsamples()};
+  }
+
+  /// Record a new sample.
+  void sample(sample_type const& t) {
+    weighted_sample(t, 1);
+  }
+
+  /**
+   * Record a sample with a weight.
+   *
+   * A sample of weight w is stored as one item in each level h where
+   * the bit h of w is set, so this is O(log w).
+   */
+  void weighted_sample(sample_type const& t, std::uint64_t weight) {
+    if (weight == 0) {
+      return;
+    }
+    update_totals(weight, t, t, double(t) * weight);
+    for (std::size_t h = 0; weight != 0; ++h, weight >>= 1) {
+      if (weight & 1) {
+        level(h).push_back(t);
+        ++retained_;
+      }
+    }
+    compress();
+  }
+
+  /// Reset all counters
+  void reset() {
+    kll_sketch fresh(k_);
+    *this = std::move(fresh);
+  }
+
+  /**
+   * Add the samples recorded by another sketch.
+   *
+   * @throw std::invalid_argument if the sketches have a different k
+   */
+  void merge(kll_sketch const& rhs) {
+    if (k_ != rhs.k_) {
+      throw std::invalid_argument(
+          "Cannot merge kll_sketch objects with different k");
+    }
+    if (rhs.nsamples_ == 0) {
+      return;
+    }
+    update_totals(
+        rhs.nsamples_, rhs.observed_min_, rhs.observed_max_, rhs.sum_);
+    for (std::size_t h = 0; h != rhs.levels_.size(); ++h) {
+      auto& l = level(h);
+      l.insert(l.end(), rhs.levels_[h].begin(), rhs.levels_[h].end());
+      retained_ += rhs.levels_[h].size();
+    }
+    compress();
+  }
+
+  /**
+   * Append a compact binary representation of the sketch.
+   *
+   * @code
+   * kll_sketch := varint(k) varint(nsamples) zigzag(observed_min)
+   *               zigzag(observed_max) double(sum)
+   *               varint(nlevels) level{nlevels}
+   * level := varint(nitems) zigzag(item){nitems}
+   * @endcode
+   *
+   * @param buffer where the encoded sketch is appended
+   */
+  void encode(std::string& buffer) const {
+    static_assert(
+        std::is_integral<sample_type>::value,
+        "Only sketches of integral samples can be encoded");
+    using namespace metrics::binary;
+    put_varint(buffer, k_);
+    put_varint(buffer, nsamples_);
+    put_zigzag(buffer, static_cast<std::int64_t>(observed_min_));
+    put_zigzag(buffer, static_cast<std::int64_t>(observed_max_));
+    put_double(buffer, sum_);
+    put_varint(buffer, levels_.size());
+    for (auto const& l : levels_) {
+      put_varint(buffer, l.size());
+      for (auto const& i : l) {
+        put_zigzag(buffer, static_cast<std::int64_t>(i));
+      }
+    }
+  }
+
+  /**
+   * Decode a sketch created by encode() and merge its samples.
+   *
+   * @throw std::runtime_error if the encoded sketch is malformed or
+   * has a different k
+   */
+  void merge_encoded(metrics::binary::reader& r) {
+    static_assert(
+        std::is_integral<sample_type>::value,
+        "Only sketches of integral samples can be decoded");
+    auto k = r.varint();
+    if (k != std::uint64_t(k_)) {
+      throw std::runtime_error(
+          "Cannot merge encoded kll_sketch with different k");
+    }
+    auto n = r.varint();
+    auto o_min = static_cast<sample_type>(r.zigzag());
+    auto o_max = static_cast<sample_type>(r.zigzag());
+    auto sum = r.ieee_double();
+    auto nlevels = r.varint();
+    if (nlevels > 64) {
+      throw std::runtime_error("Invalid number of levels in kll_sketch");
+    }
+    // ... decode into a separate sketch, if the data is malformed
+    // this sketch is left unchanged ...
+    kll_sketch decoded(k_);
+    for (std::size_t h = 0; h != nlevels; ++h) {
+      auto nitems = r.varint();
+      auto& l = decoded.level(h);
+      for (std::uint64_t i = 0; i != nitems; ++i) {
+        l.push_back(static_cast<sample_type>(r.zigzag()));
+      }
+      decoded.retained_ += nitems;
+    }
+    if (n == 0) {
+      return;
+    }
+    decoded.update_totals(n, o_min, o_max, sum);
+    merge(decoded);
+  }
+
+private:
+  /// Return the retained samples and their weights, sorted by value
+  std::vector<std::pair<sample_type, std::uint64_t>> weighted_items() const {
+    std::vector<std::pair<sample_type, std::uint64_t>> items;
+    items.reserve(retained_);
+    for (std::size_t h = 0; h != levels_.size(); ++h) {
+      for (auto const& i : levels_[h]) {
+        items.emplace_back(i, std::uint64_t(1) << h);
+      }
+    }
+    std::sort(items.begin(), items.end(), [](auto const& a, auto const& b) {
+      return a.first < b.first;
+    });
+    return items;
+  }
+
+  /// Update the counters and extremes
+  void update_totals(
+      std::uint64_t n, sample_type const& o_min, sample_type const& o_max,
+      double sum) {
+    nsamples_ += n;
+    sum_ += sum;
+    if (observed_min_ > o_min) {
+      observed_min_ = o_min;
+    }
+    if (observed_max_ < o_max) {
+      observed_max_ = o_max;
+    }
+  }
+
+  /// Return a level, creating it if needed
+  std::vector<sample_type>& level(std::size_t h) {
+    if (h >= levels_.size()) {
+      levels_.resize(h + 1);
+      // ... the capacity of each level shrinks geometrically from the
+      // top, adding levels changes all of them ...
+      capacities_.resize(levels_.size());
+      capacity_ = 0;
+      for (std::size_t i = 0; i != levels_.size(); ++i) {
+        auto depth = levels_.size() - i - 1;
+        auto c = std::ceil(k_ * std::pow(2.0 / 3, depth));
+        capacities_[i] =
+            std::max(static_cast<std::size_t>(c), min_level_capacity);
+        capacity_ += capacities_[i];
+      }
+    }
+    return levels_[h];
+  }
+
+  /// Compact levels until the sketch fits in its capacity
+  void compress() {
+    while (retained_ > capacity_) {
+      std::size_t h = 0;
+      while (levels_[h].size() < capacities_[h]) {
+        ++h;
+      }
+      compact(h);
+    }
+  }
+
+  /// Promote every other item in a level to the next one
+  void compact(std::size_t h) {
+    // ... the next level may be created, so get it first ...
+    auto& next = level(h + 1);
+    auto& l = levels_[h];
+    std::sort(l.begin(), l.end());
+    // ... with an odd number of items keep the smallest one in this
+    // level ...
+    std::size_t const start = l.size() % 2;
+    std::size_t const offset = next_random_bit();
+    for (std::size_t i = start + offset; i < l.size(); i += 2) {
+      next.push_back(l[i]);
+    }
+    retained_ -= (l.size() - start) / 2;
+    l.resize(start);
+  }
+
+  /// A cheap (xorshift64) source of random bits
+  std::size_t next_random_bit() {
+    random_ ^= random_ << 13;
+    random_ ^= random_ >> 7;
+    random_ ^= random_ << 17;
+    return static_cast<std::size_t>(random_ >> 63);
+  }
+
+private:
+  /// The minimum capacity for any level
+  static constexpr std::size_t min_level_capacity = 8;
+
+  int k_;
+  sample_type observed_min_;
+  sample_type observed_max_;
+  std::uint64_t nsamples_;
+  double sum_;
+  std::vector<std::vector<sample_type>> levels_;
+  std::vector<std::size_t> capacities_;
+  std::size_t retained_;
+  std::size_t capacity_;
+  std::uint64_t random_;
+};
+
+template <typename sample_type_t>
+constexpr int kll_sketch<sample_type_t>::default_k;
+template <typename sample_type_t>
+constexpr int kll_sketch<sample_type_t>::min_k;
+template <typename sample_type_t>
+constexpr int kll_sketch<sample_type_t>::max_k;
+template <typename sample_type_t>
+constexpr std::size_t kll_sketch<sample_type_t>::min_level_capacity;
+
+} // namespace jb
+
+#endif // jb_kll_sketch_hpp
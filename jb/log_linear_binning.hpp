@@ -0,0 +1,170 @@
+#ifndef jb_log_linear_binning_hpp
+#define jb_log_linear_binning_hpp
+
+#include <jb/histogram_binning_linear_interpolation.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+
+namespace jb {
+
+/**
+ * A histogram binning_strategy with constant relative error.
+ *
+ * This is the binning used by HdrHistogram.  The range is divided in
+ * buckets, each bucket covers twice the range of the previous one,
+ * and each bucket is divided in the same number of (linear) bins.
+ * The first @a 2^s values have one bin each, the next @a 2^s values
+ * are covered by @a 2^(s-1) bins of width 2, the next @a 2^(s+1)
+ * values by @a 2^(s-1) bins of width 4, and so on.
+ *
+ * The number of bins (@a 2^s) is chosen so the width of each bin is
+ * at most @a 10^-d times the value of its samples, where @a d is the
+ * number of significant digits requested by the application.  With 2
+ * significant digits a histogram from 1 nanosecond to 1 hour needs
+ * fewer than 5,000 bins, while jb::integer_range_binning would need
+ * 3.6 trillion.
+ *
+ * If the number of significant digits is large enough for the range
+ * (e.g. 7 digits for a range of 1,000,000), every value in the range
+ * has its own bin, and the histogram is identical to one using
+ * jb::integer_range_binning.
+ *
+ * See jb::binning_strategy_concept.
+ *
+ * @tparam sample_type_t the type of samples, should be an integer type.
+ */
+template <typename sample_type_t>
+class log_linear_binning {
+public:
+  /// type traits as required by @ref jb::binning_strategy_concept
+  typedef sample_type_t sample_type;
+
+  /// The largest number of significant digits supported
+  static constexpr int max_significant_digits = 15;
+
+  /**
+   * Constructor based on the histogram range and precision.
+   *
+   * @param h_min The value for histogram_min()
+   * @param h_max The requested value for histogram_max(), it is
+   * rounded up to the next bin boundary
+   * @param significant_digits the number of decimal digits preserved
+   * for each sample
+   */
+  log_linear_binning(sample_type h_min, sample_type h_max, int digits)
+      : h_min_(h_min)
+      , h_max_(h_max)
+      , sub_bucket_bits_(0)
+      , sub_bucket_half_(0) {
+    static_assert(
+        std::is_integral<sample_type>::value,
+        "The sample_type must be an integral type");
+    if (h_min_ >= h_max_) {
+      std::ostringstream os;
+      os << "jb::log_linear_binning requires h_min (" << h_min
+         << ") to be less than h_max (" << h_max << ")";
+      throw std::invalid_argument(os.str());
+    }
+    if (digits < 1 or digits > max_significant_digits) {
+      std::ostringstream os;
+      os << "jb::log_linear_binning requires significant digits in the [1,"
+         << max_significant_digits << "] range, value=" << digits;
+      throw std::invalid_argument(os.str());
+    }
+    // ... find the smallest power of two larger than 2 * 10^digits,
+    // with that many bins per bucket the relative error is at most
+    // 10^-digits ...
+    std::uint64_t target = 2;
+    for (int i = 0; i != digits; ++i) {
+      target *= 10;
+    }
+    while ((std::uint64_t(1) << sub_bucket_bits_) < target) {
+      ++sub_bucket_bits_;
+    }
+    sub_bucket_half_ = std::uint64_t(1) << (sub_bucket_bits_ - 1);
+    // ... round the maximum up, so the last bin is complete ...
+    h_max_ = bin2sample(sample2bin(h_max - 1) + 1);
+  }
+
+  //@{
+  /**
+   * @name Implement binning_strategy_concept interface.
+   *
+   * Please see @ref binning_strategy_concept for detailed
+   * documentation of each member function.
+   */
+  sample_type histogram_min() const {
+    return h_min_;
+  }
+  sample_type histogram_max() const {
+    return h_max_;
+  }
+  sample_type theoretical_min() const {
+    return std::numeric_limits<sample_type>::min();
+  }
+  sample_type theoretical_max() const {
+    return std::numeric_limits<sample_type>::max();
+  }
+  std::size_t sample2bin(sample_type t) const {
+    auto v = static_cast<std::uint64_t>(t - histogram_min());
+    if (v < 2 * sub_bucket_half_) {
+      return static_cast<std::size_t>(v);
+    }
+    // ... k is the bucket, the bins in bucket k have width 2^k ...
+    int k = floor_log2(v) - (sub_bucket_bits_ - 1);
+    return static_cast<std::size_t>(
+        2 * sub_bucket_half_ + (k - 1) * sub_bucket_half_ +
+        ((v >> k) - sub_bucket_half_));
+  }
+  sample_type bin2sample(std::size_t i) const {
+    if (i < 2 * sub_bucket_half_) {
+      return histogram_min() + static_cast<sample_type>(i);
+    }
+    std::uint64_t j = i - 2 * sub_bucket_half_;
+    int k = static_cast<int>(j / sub_bucket_half_) + 1;
+    std::uint64_t r = j % sub_bucket_half_;
+    return histogram_min() +
+           static_cast<sample_type>((sub_bucket_half_ + r) << k);
+  }
+  sample_type interpolate(
+      sample_type x_a, sample_type x_b, double y_a, double s, double q) const {
+    return histogram_binning_linear_interpolation(x_a, x_b, y_a, s, q);
+  }
+  //@}
+
+  /**
+   * The number of significant digits to store every value in a range
+   * in its own bin.
+   *
+   * Applications use this value to configure a linear histogram.
+   */
+  static int linear_digits(sample_type h_min, sample_type h_max) {
+    auto range = static_cast<std::uint64_t>(h_max - h_min);
+    int digits = 1;
+    for (std::uint64_t p = 10; p < range and digits < max_significant_digits;
+         p *= 10) {
+      ++digits;
+    }
+    return digits;
+  }
+
+private:
+  /// The position of the highest bit set in @a v, which must be > 0
+  static int floor_log2(std::uint64_t v) {
+    return 63 - __builtin_clzll(v);
+  }
+
+private:
+  sample_type h_min_;
+  sample_type h_max_;
+  int sub_bucket_bits_;
+  std::uint64_t sub_bucket_half_;
+};
+
+} // namespace jb
+
+#endif // jb_log_linear_binning_hpp
@@ -0,0 +1,290 @@
+#include "jb/metrics.hpp"
+
+#include <algorithm>
+#include <bitset>
+#include <cstring>
+
+namespace jb {
+namespace metrics {
+namespace {
+/// The number of cells per shard in each chunk allocated by a registry
+std::size_t const cells_per_chunk = 1024;
+
+/// The last shard is shared by all the threads without one of their own
+std::size_t const shared_shard = detail::shard_count - 1;
+
+/// Protect the assignment of shards to threads
+std::mutex shards_mu;
+
+/// The shards currently assigned to a thread
+std::bitset<shared_shard> shards_in_use;
+
+/// Escape a string for the Prometheus text format
+std::string escape(std::string const& s, bool quotes) {
+  std::string r;
+  r.reserve(s.size());
+  for (auto c : s) {
+    if (c == '\\') {
+      r += "\\\\";
+    } else if (c == '\n') {
+      r += "\\n";
+    } else if (quotes and c == '"') {
+      r += "\\\"";
+    } else {
+      r += c;
+    }
+  }
+  return r;
+}
+
+/// Format the labels and the braces around them, if any
+std::string with_braces(std::string const& labels) {
+  if (labels.empty()) {
+    return labels;
+  }
+  return "{" + labels + "}";
+}
+} // anonymous namespace
+
+namespace detail {
+shard_owner::shard_owner()
+    : value{shared_shard, false} {
+  std::lock_guard<std::mutex> guard(shards_mu);
+  for (std::size_t i = 0; i != shards_in_use.size(); ++i) {
+    if (not shards_in_use.test(i)) {
+      shards_in_use.set(i);
+      value = shard{i, true};
+      return;
+    }
+  }
+}
+
+shard_owner::~shard_owner() {
+  if (not value.exclusive) {
+    return;
+  }
+  // ... the counts in the shard are preserved, the next thread that
+  // gets the shard continues from them ...
+  std::lock_guard<std::mutex> guard(shards_mu);
+  shards_in_use.reset(value.index);
+}
+
+void sharded_cells::fill(std::size_t i, std::int64_t v) {
+  for (std::size_t s = 0; s != shard_count; ++s) {
+    base_[s * stride_ + i].store(v, std::memory_order_relaxed);
+  }
+}
+
+std::int64_t sharded_cells::sum(std::size_t i) const {
+  std::int64_t r = 0;
+  for (std::size_t s = 0; s != shard_count; ++s) {
+    r += base_[s * stride_ + i].load(std::memory_order_relaxed);
+  }
+  return r;
+}
+
+std::int64_t sharded_cells::min(std::size_t i) const {
+  auto r = base_[i].load(std::memory_order_relaxed);
+  for (std::size_t s = 1; s != shard_count; ++s) {
+    r = std::min(r, base_[s * stride_ + i].load(std::memory_order_relaxed));
+  }
+  return r;
+}
+
+std::int64_t sharded_cells::max(std::size_t i) const {
+  auto r = base_[i].load(std::memory_order_relaxed);
+  for (std::size_t s = 1; s != shard_count; ++s) {
+    r = std::max(r, base_[s * stride_ + i].load(std::memory_order_relaxed));
+  }
+  return r;
+}
+
+std::string format_labels(labels const& l) {
+  std::string r;
+  for (auto const& kv : l) {
+    if (not r.empty()) {
+      r += ",";
+    }
+    r += kv.first + "=\"" + escape(kv.second, true) + "\"";
+  }
+  return r;
+}
+} // namespace detail
+
+metric::~metric() {
+}
+
+void counter::append_text(
+    std::ostream& os, std::string const& name,
+    std::string const& labels) const {
+  os << name << with_braces(labels) << " " << value() << "\n";
+}
+
+binary::record_type counter::append_binary(std::string& payload) const {
+  binary::put_zigzag(payload, value());
+  return binary::record_type::counter;
+}
+
+std::uint64_t counter::version() const {
+  return static_cast<std::uint64_t>(value());
+}
+
+void gauge::append_text(
+    std::ostream& os, std::string const& name,
+    std::string const& labels) const {
+  os << name << with_braces(labels) << " " << value() << "\n";
+}
+
+binary::record_type gauge::append_binary(std::string& payload) const {
+  binary::put_double(payload, value());
+  return binary::record_type::gauge;
+}
+
+std::uint64_t gauge::version() const {
+  double v = value();
+  std::uint64_t bits;
+  std::memcpy(&bits, &v, sizeof(bits));
+  return bits;
+}
+
+registry::registry()
+    : mu_()
+    , families_()
+    , sequence_(0)
+    , chunks_() {
+}
+
+registry::~registry() {
+}
+
+counter& registry::make_counter(
+    std::string const& name, std::string const& help, labels const& l) {
+  std::lock_guard<std::mutex> guard(mu_);
+  auto key = detail::format_labels(l);
+  auto existing = lookup(name, "counter", key);
+  if (existing != nullptr) {
+    return *static_cast<counter*>(existing);
+  }
+  auto c = new counter(allocate(1));
+  insert(name, help, "counter", key, std::unique_ptr<metric>(c));
+  return *c;
+}
+
+gauge& registry::make_gauge(
+    std::string const& name, std::string const& help, labels const& l) {
+  std::lock_guard<std::mutex> guard(mu_);
+  auto key = detail::format_labels(l);
+  auto existing = lookup(name, "gauge", key);
+  if (existing != nullptr) {
+    return *static_cast<gauge*>(existing);
+  }
+  auto g = new gauge;
+  insert(name, help, "gauge", key, std::unique_ptr<metric>(g));
+  return *g;
+}
+
+void registry::append_text(std::string& body) const {
+  std::ostringstream os;
+  {
+    std::lock_guard<std::mutex> guard(mu_);
+    for (auto const& f : families_) {
+      os << "# HELP " << f.first << " " << escape(f.second.help, false) << "\n"
+         << "# TYPE " << f.first << " " << f.second.type << "\n";
+      for (auto const& m : f.second.members) {
+        m.second.value->append_text(os, f.first, m.first);
+      }
+    }
+  }
+  body += os.str();
+}
+
+std::uint64_t
+registry::append_binary(std::string& body, std::uint64_t since) const {
+  std::lock_guard<std::mutex> guard(mu_);
+  auto sequence = ++sequence_;
+  std::string records;
+  std::string record;
+  std::uint64_t count = 0;
+  for (auto& f : families_) {
+    for (auto& m : f.second.members) {
+      auto& entry = m.second;
+      auto version = entry.value->version();
+      if (version != entry.last_version) {
+        entry.last_version = version;
+        entry.changed_at = sequence;
+      }
+      if (entry.changed_at <= since) {
+        continue;
+      }
+      // ... the type is only known after the payload is encoded,
+      // reserve a byte for it ...
+      record.assign(1, '\0');
+      binary::put_string(record, f.first);
+      binary::put_string(record, m.first);
+      record[0] = static_cast<char>(entry.value->append_binary(record));
+      binary::put_varint(records, record.size());
+      records += record;
+      ++count;
+    }
+  }
+  body.append(binary::magic, sizeof(binary::magic));
+  body.push_back(static_cast<char>(binary::version));
+  binary::put_varint(body, sequence);
+  binary::put_varint(body, since);
+  binary::put_varint(body, count);
+  body += records;
+  return sequence;
+}
+
+metric* registry::lookup(
+    std::string const& name, char const* type, std::string const& key) {
+  auto f = families_.find(name);
+  if (f == families_.end()) {
+    return nullptr;
+  }
+  if (std::string(f->second.type) != type) {
+    throw std::invalid_argument(
+        "metric " + name + " already exists as a " + f->second.type);
+  }
+  auto m = f->second.members.find(key);
+  if (m == f->second.members.end()) {
+    return nullptr;
+  }
+  return m->second.value.get();
+}
+
+void registry::insert(
+    std::string const& name, std::string const& help, char const* type,
+    std::string const& key, std::unique_ptr<metric> m) {
+  auto& f = families_[name];
+  if (f.members.empty()) {
+    f.help = help;
+    f.type = type;
+  }
+  // ... report new metrics in the next binary scrape, even if their
+  // value has not changed ...
+  f.members.emplace(key, member{std::move(m), 0, sequence_ + 1});
+}
+
+detail::sharded_cells registry::allocate(std::size_t n) {
+  if (chunks_.empty() or chunks_.back().size - chunks_.back().used < n) {
+    auto size = std::max(n, cells_per_chunk);
+    // ... value initialization sets all the cells to 0 ...
+    chunks_.push_back(chunk{
+        std::unique_ptr<detail::sharded_cells::cell[]>(
+            new detail::sharded_cells::cell[detail::shard_count * size]()),
+        size, 0});
+  }
+  auto& c = chunks_.back();
+  detail::sharded_cells cells(c.cells.get() + c.used, c.size);
+  c.used += n;
+  return cells;
+}
+
+registry& default_registry() {
+  static registry r;
+  return r;
+}
+
+} // namespace metrics
+} // namespace jb
@@ -0,0 +1,590 @@
+#ifndef jb_metrics_hpp
+#define jb_metrics_hpp
+
+#include <jb/histogram.hpp>
+#include <jb/metrics_binary.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace jb {
+/**
+ * Contains a registry of counters, gauges and histograms, and their
+ * exposition in the Prometheus text format.
+ *
+ * The metrics are updated from the critical data path, so updates
+ * must be cheap.  Counters and histograms are sharded: each thread
+ * updates its own copy of the metric, and the copies are only added
+ * up when the metrics are reported.  The first threads that update
+ * any metric get a shard of their own, where updates are plain loads
+ * and stores on an uncontended cache line.  If there are more threads
+ * than shards the remaining threads share one shard, and use atomic
+ * read-modify-write operations on it.
+ */
+namespace metrics {
+
+/// The labels for a metric, as (name, value) pairs
+using labels = std::vector<std::pair<std::string, std::string>>;
+
+namespace detail {
+/// The number of shards for each counter and histogram cell
+constexpr std::size_t shard_count = 16;
+
+/// The shard assigned to a thread
+struct shard {
+  /// The index of the shard, in [0, shard_count)
+  std::size_t index;
+  /// If true, no other thread uses this shard
+  bool exclusive;
+};
+
+/**
+ * Assign a shard to the current thread, and release it when the
+ * thread exits.
+ */
+class shard_owner {
+public:
+  shard_owner();
+  ~shard_owner();
+
+  shard_owner(shard_owner const&) = delete;
+  shard_owner& operator=(shard_owner const&) = delete;
+
+  /// The shard assigned to this thread
+  shard value;
+};
+
+/// Return the shard assigned to the calling thread
+inline shard const& current_shard() {
+  static thread_local shard_owner owner;
+  return owner.value;
+}
+
+/**
+ * A group of cells, each one sharded across threads.
+ *
+ * The cells for shard @a s start at base + s * stride, so the cells
+ * updated by different threads are in different cache lines.
+ */
+class sharded_cells {
+public:
+  /// The type stored in each cell
+  using cell = std::atomic<std::int64_t>;
+
+  sharded_cells(cell* base, std::size_t stride)
+      : base_(base)
+      , stride_(stride) {
+  }
+
+  /// Add @a n to the @a i-th cell for the current thread
+  void add(std::size_t i, std::int64_t n) {
+    auto const& s = current_shard();
+    auto& c = base_[s.index * stride_ + i];
+    if (s.exclusive) {
+      c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    } else {
+      c.fetch_add(n, std::memory_order_relaxed);
+    }
+  }
+
+  /// Set the @a i-th cell for the current thread to @a v if it is smaller
+  void update_min(std::size_t i, std::int64_t v) {
+    auto& c = base_[current_shard().index * stride_ + i];
+    auto current = c.load(std::memory_order_relaxed);
+    while (v < current and
+           not c.compare_exchange_weak(
+               current, v, std::memory_order_relaxed)) {
+    }
+  }
+
+  /// Set the @a i-th cell for the current thread to @a v if it is larger
+  void update_max(std::size_t i, std::int64_t v) {
+    auto& c = base_[current_shard().index * stride_ + i];
+    auto current = c.load(std::memory_order_relaxed);
+    while (current < v and
+           not c.compare_exchange_weak(
+               current, v, std::memory_order_relaxed)) {
+    }
+  }
+
+  /// Set the @a i-th cell to @a v in all the shards
+  void fill(std::size_t i, std::int64_t v);
+
+  /// Return the sum of the @a i-th cell across all shards
+  std::int64_t sum(std::size_t i) const;
+
+  /// Return the minimum of the @a i-th cell across all shards
+  std::int64_t min(std::size_t i) const;
+
+  /// Return the maximum of the @a i-th cell across all shards
+  std::int64_t max(std::size_t i) const;
+
+private:
+  cell* base_;
+  std::size_t stride_;
+};
+
+/// Format the labels as they appear in the Prometheus text format
+std::string format_labels(labels const& l);
+} // namespace detail
+
+/**
+ * The base class for all the metrics in a jb::metrics::registry.
+ */
+class metric {
+public:
+  virtual ~metric();
+
+  /**
+   * Append the samples in Prometheus text format.
+   *
+   * @param os where to append the samples
+   * @param name the name of the metric
+   * @param labels the labels for the metric, already formatted but
+   * without the braces, can be empty
+   */
+  virtual void append_text(
+      std::ostream& os, std::string const& name,
+      std::string const& labels) const = 0;
+
+  /**
+   * Append the record type and payload in the binary format.
+   *
+   * The caller encodes the record length, name and labels, see
+   * jb/metrics_binary.hpp.
+   */
+  virtual binary::record_type append_binary(std::string& payload) const = 0;
+
+  /**
+   * Return a value that changes every time the metric changes.
+   *
+   * Used to report only the metrics that changed since a previous
+   * scrape.
+   */
+  virtual std::uint64_t version() const = 0;
+};
+
+/**
+ * A monotonically increasing counter.
+ */
+class counter : public metric {
+public:
+  explicit counter(detail::sharded_cells cells)
+      : cells_(cells) {
+  }
+
+  /// Increment the counter
+  void inc(std::int64_t n = 1) {
+    cells_.add(0, n);
+  }
+
+  /// Return the current value
+  std::int64_t value() const {
+    return cells_.sum(0);
+  }
+
+  void append_text(
+      std::ostream& os, std::string const& name,
+      std::string const& labels) const override;
+  binary::record_type append_binary(std::string& payload) const override;
+  std::uint64_t version() const override;
+
+private:
+  detail::sharded_cells cells_;
+};
+
+/**
+ * A value that can go up and down, for example, a queue depth.
+ *
+ * Gauges are typically set from a single thread, they are not
+ * sharded.
+ */
+class gauge : public metric {
+public:
+  gauge()
+      : value_(0) {
+  }
+
+  /// Set the value
+  void set(double v) {
+    value_.store(v, std::memory_order_relaxed);
+  }
+
+  /// Add @a v to the value
+  void add(double v) {
+    auto current = value_.load(std::memory_order_relaxed);
+    while (not value_.compare_exchange_weak(
+        current, current + v, std::memory_order_relaxed)) {
+    }
+  }
+
+  /// Return the current value
+  double value() const {
+    return value_.load(std::memory_order_relaxed);
+  }
+
+  void append_text(
+      std::ostream& os, std::string const& name,
+      std::string const& labels) const override;
+  binary::record_type append_binary(std::string& payload) const override;
+  std::uint64_t version() const override;
+
+private:
+  std::atomic<double> value_;
+};
+
+/**
+ * A distribution of integer samples, typically latencies.
+ *
+ * The bins are defined by the binning strategy, as in jb::histogram,
+ * and reported as Prometheus histogram buckets.  The Prometheus "le"
+ * bounds are inclusive, so the bucket for bin [a,b) is reported with
+ * "le" set to b-1, the largest integer sample in the bin.
+ *
+ * @tparam binning_strategy_t see jb::histogram for details
+ */
+template <typename binning_strategy_t>
+class histogram : public metric {
+public:
+  using binning_strategy = binning_strategy_t;
+  using sample_type = typename binning_strategy::sample_type;
+
+  /// The type returned by snapshot()
+  using snapshot_type = jb::histogram<binning_strategy, std::uint64_t>;
+
+  /// The number of cells required for @a binning
+  static std::size_t cell_count(binning_strategy const& binning) {
+    return bin_count(binning) + extra_cells;
+  }
+
+  histogram(binning_strategy const& binning, detail::sharded_cells cells)
+      : binning_(binning)
+      , nbins_(bin_count(binning))
+      , cells_(cells) {
+    cells_.fill(nbins_ + min_cell, std::numeric_limits<std::int64_t>::max());
+    cells_.fill(nbins_ + max_cell, std::numeric_limits<std::int64_t>::min());
+  }
+
+  /// Record a new sample
+  void sample(sample_type t) {
+    if (binning_.histogram_min() <= t and t < binning_.histogram_max()) {
+      cells_.add(binning_.sample2bin(t), 1);
+    } else if (t < binning_.histogram_min()) {
+      cells_.add(nbins_ + underflow_cell, 1);
+    } else {
+      cells_.add(nbins_ + overflow_cell, 1);
+    }
+    cells_.add(nbins_ + count_cell, 1);
+    cells_.add(nbins_ + sum_cell, static_cast<std::int64_t>(t));
+    cells_.update_min(nbins_ + min_cell, static_cast<std::int64_t>(t));
+    cells_.update_max(nbins_ + max_cell, static_cast<std::int64_t>(t));
+  }
+
+  /// Return the number of samples
+  std::uint64_t nsamples() const {
+    return cells_.sum(nbins_ + count_cell);
+  }
+
+  /// Return the sum of all the samples
+  std::int64_t sum() const {
+    return cells_.sum(nbins_ + sum_cell);
+  }
+
+  /**
+   * Aggregate the shards into a jb::histogram.
+   *
+   * The result has the same bins, so the estimated quantiles are the
+   * same as if all the samples had been recorded in a single
+   * jb::histogram, the minimum and maximum are exact.
+   */
+  snapshot_type snapshot() const {
+    snapshot_type h(binning_);
+    // ... only the bins, the underflow and the overflow cells hold
+    // counts, the other cells hold the sum and extremes ...
+    std::vector<std::uint64_t> bins(nbins_ + overflow_cell + 1);
+    for (std::size_t i = 0; i != bins.size(); ++i) {
+      bins[i] = cells_.sum(i);
+    }
+    std::uint64_t const n = nsamples();
+    if (n == 0) {
+      return h;
+    }
+    // ... record the minimum and maximum as exact samples, and remove
+    // them from their bins.  Other threads may be recording samples,
+    // so the extremes may not be counted in the bins yet ...
+    auto take = [this, &h, &bins](sample_type t) {
+      auto& count = bins[cell_for(t)];
+      if (count != 0) {
+        --count;
+        h.sample(t);
+      }
+    };
+    auto smin = static_cast<sample_type>(cells_.min(nbins_ + min_cell));
+    auto smax = static_cast<sample_type>(cells_.max(nbins_ + max_cell));
+    take(smin);
+    if (n > 1) {
+      take(smax);
+    }
+    // ... the other samples are recorded at the start of their bin,
+    // clamped so they do not change the observed minimum or maximum ...
+    for (std::size_t i = 0; i != nbins_; ++i) {
+      auto t = binning_.bin2sample(i);
+      t = t < smin ? smin : t;
+      t = smax < t ? smax : t;
+      h.weighted_sample(t, bins[i]);
+    }
+    h.weighted_sample(smin, bins[nbins_ + underflow_cell]);
+    h.weighted_sample(smax, bins[nbins_ + overflow_cell]);
+    return h;
+  }
+
+  void append_text(
+      std::ostream& os, std::string const& name,
+      std::string const& labels) const override {
+    std::string prefix = labels.empty() ? "" : labels + ",";
+    std::uint64_t cumulative = cells_.sum(nbins_ + underflow_cell);
+    for (std::size_t i = 0; i != nbins_; ++i) {
+      cumulative += cells_.sum(i);
+      os << name << "_bucket{" << prefix << "le=\""
+         << binning_.bin2sample(i + 1) - 1 << "\"} " << cumulative << "\n";
+    }
+    cumulative += cells_.sum(nbins_ + overflow_cell);
+    os << name << "_bucket{" << prefix << "le=\"+Inf\"} " << cumulative
+       << "\n";
+    std::string braces = labels.empty() ? "" : "{" + labels + "}";
+    os << name << "_sum" << braces << " " << sum() << "\n"
+       << name << "_count" << braces << " " << cumulative << "\n";
+  }
+
+  binary::record_type append_binary(std::string& payload) const override {
+    using namespace binary;
+    auto count = nsamples();
+    put_varint(payload, count);
+    put_zigzag(payload, sum());
+    put_zigzag(payload, count == 0 ? 0 : cells_.min(nbins_ + min_cell));
+    put_zigzag(payload, count == 0 ? 0 : cells_.max(nbins_ + max_cell));
+    put_varint(payload, cells_.sum(nbins_ + underflow_cell));
+    put_varint(payload, cells_.sum(nbins_ + overflow_cell));
+    // ... only the non-empty buckets are encoded, typically a small
+    // fraction of the bins in a latency histogram ...
+    std::string buckets;
+    std::uint64_t nonempty = 0;
+    std::int64_t previous = 0;
+    for (std::size_t i = 0; i != nbins_; ++i) {
+      auto n = cells_.sum(i);
+      if (n == 0) {
+        continue;
+      }
+      auto upper = static_cast<std::int64_t>(binning_.bin2sample(i + 1));
+      put_zigzag(buckets, upper - previous);
+      put_varint(buckets, n);
+      previous = upper;
+      ++nonempty;
+    }
+    put_varint(payload, nonempty);
+    payload += buckets;
+    return record_type::histogram;
+  }
+
+  std::uint64_t version() const override {
+    return nsamples();
+  }
+
+private:
+  /// The number of bins in @a binning, computed as in jb::histogram
+  static std::size_t bin_count(binning_strategy const& binning) {
+    return binning.sample2bin(binning.histogram_max()) -
+           binning.sample2bin(binning.histogram_min());
+  }
+
+  /// Return the cell where @a t is counted
+  std::size_t cell_for(sample_type t) const {
+    if (binning_.histogram_min() <= t and t < binning_.histogram_max()) {
+      return binning_.sample2bin(t);
+    }
+    if (t < binning_.histogram_min()) {
+      return nbins_ + underflow_cell;
+    }
+    return nbins_ + overflow_cell;
+  }
+
+  //@{
+  /**
+   * @name The cells after the bins
+   */
+  static constexpr std::size_t underflow_cell = 0;
+  static constexpr std::size_t overflow_cell = 1;
+  static constexpr std::size_t sum_cell = 2;
+  static constexpr std::size_t min_cell = 3;
+  static constexpr std::size_t max_cell = 4;
+  static constexpr std::size_t count_cell = 5;
+  static constexpr std::size_t extra_cells = 6;
+  //@}
+
+private:
+  binning_strategy binning_;
+  std::size_t nbins_;
+  detail::sharded_cells cells_;
+};
+
+/**
+ * A collection of metrics, reported together.
+ *
+ * Creating metrics is relatively expensive (it takes a lock), the
+ * applications should create them during initialization and keep
+ * the references.  The metrics live as long as the registry.
+ * Creating a metric with the same name and labels as an existing one
+ * returns the existing metric.
+ */
+class registry {
+public:
+  registry();
+  ~registry();
+
+  registry(registry const&) = delete;
+  registry& operator=(registry const&) = delete;
+
+  /**
+   * Get or create a counter.
+   *
+   * @param name the name of the metric
+   * @param help a description of the metric
+   * @param l the labels for this counter
+   * @throw std::invalid_argument if a metric with the same name but
+   * a different type exists
+   */
+  counter& make_counter(
+      std::string const& name, std::string const& help,
+      labels const& l = labels());
+
+  /**
+   * Get or create a gauge.
+   *
+   * @param name the name of the metric
+   * @param help a description of the metric
+   * @param l the labels for this gauge
+   * @throw std::invalid_argument if a metric with the same name but
+   * a different type exists
+   */
+  gauge& make_gauge(
+      std::string const& name, std::string const& help,
+      labels const& l = labels());
+
+  /**
+   * Get or create a histogram.
+   *
+   * @param name the name of the metric
+   * @param help a description of the metric
+   * @param binning the bins for the histogram, ignored if the
+   * histogram already exists
+   * @param l the labels for this histogram
+   * @throw std::invalid_argument if a metric with the same name but
+   * a different type exists
+   */
+  template <typename binning_strategy>
+  histogram<binning_strategy>& make_histogram(
+      std::string const& name, std::string const& help,
+      binning_strategy const& binning, labels const& l = labels()) {
+    using histogram_type = histogram<binning_strategy>;
+    std::lock_guard<std::mutex> guard(mu_);
+    auto key = detail::format_labels(l);
+    auto existing = lookup(name, "histogram", key);
+    if (existing != nullptr) {
+      auto h = dynamic_cast<histogram_type*>(existing);
+      if (h == nullptr) {
+        throw std::invalid_argument(
+            "metric " + name + " already exists with a different binning");
+      }
+      return *h;
+    }
+    auto cells = allocate(histogram_type::cell_count(binning));
+    auto h = new histogram_type(binning, cells);
+    insert(name, help, "histogram", key, std::unique_ptr<metric>(h));
+    return *h;
+  }
+
+  /// Append all the metrics to @a body in Prometheus text format
+  void append_text(std::string& body) const;
+
+  /**
+   * Append the metrics to @a body in the binary format.
+   *
+   * Each call is a new scrape, with a new sequence number.  The
+   * clients scraping at a high rate pass the sequence number of their
+   * previous scrape, and only receive the metrics that changed since
+   * then.
+   *
+   * @param body where to append the encoded metrics
+   * @param since only include the metrics that changed after the
+   * scrape with this sequence number, 0 includes all the metrics
+   * @returns the sequence number of this scrape
+   */
+  std::uint64_t append_binary(std::string& body, std::uint64_t since) const;
+
+private:
+  /// Find an existing metric, the caller must hold mu_
+  metric* lookup(
+      std::string const& name, char const* type, std::string const& key);
+
+  /// Insert a new metric, the caller must hold mu_
+  void insert(
+      std::string const& name, std::string const& help, char const* type,
+      std::string const& key, std::unique_ptr<metric> m);
+
+  /// Allocate @a n cells in all the shards, the caller must hold mu_
+  detail::sharded_cells allocate(std::size_t n);
+
+private:
+  /// A metric and the information to detect changes between scrapes
+  struct member {
+    std::unique_ptr<metric> value;
+    /// The value of metric::version() in the last binary scrape
+    std::uint64_t last_version;
+    /// The sequence number of the last binary scrape where it changed
+    std::uint64_t changed_at;
+  };
+
+  /// All the metrics with the same name
+  struct family {
+    std::string help;
+    char const* type;
+    std::map<std::string, member> members;
+  };
+
+  /// A block of cells, cell i for shard s is at cells[s * size + i]
+  struct chunk {
+    std::unique_ptr<detail::sharded_cells::cell[]> cells;
+    std::size_t size;
+    std::size_t used;
+  };
+
+  mutable std::mutex mu_;
+  // ... the change tracking is updated by the binary scrapes, which
+  // are logically const ...
+  mutable std::map<std::string, family> families_;
+  mutable std::uint64_t sequence_;
+  std::vector<chunk> chunks_;
+};
+
+/**
+ * Return the registry used by default.
+ *
+ * Library components (e.g. the MoldUDP64 receivers) register their
+ * metrics here, the applications report them with the rest of their
+ * metrics.
+ */
+registry& default_registry();
+
+} // namespace metrics
+} // namespace jb
+
+#endif // jb_metrics_hpp
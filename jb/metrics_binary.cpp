@@ -0,0 +1,127 @@
+#include "jb/metrics_binary.hpp"
+
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace jb {
+namespace metrics {
+namespace binary {
+namespace {
+/// Print the name and the labels in braces, with an optional extra label
+void print_name(
+    std::ostream& os, std::string const& name, std::string const& labels,
+    std::string const& extra) {
+  os << name;
+  if (labels.empty() and extra.empty()) {
+    return;
+  }
+  os << "{" << labels;
+  if (not labels.empty() and not extra.empty()) {
+    os << ",";
+  }
+  os << extra << "}";
+}
+} // anonymous namespace
+
+decoded_metrics decode(char const* data, std::size_t size) {
+  reader r(data, size);
+  for (auto c : magic) {
+    if (static_cast<char>(r.byte()) != c) {
+      throw std::runtime_error("jb::metrics::binary - invalid magic");
+    }
+  }
+  auto v = r.byte();
+  if (v != version) {
+    std::ostringstream os;
+    os << "jb::metrics::binary - unsupported version " << int(v);
+    throw std::runtime_error(os.str());
+  }
+  decoded_metrics result;
+  result.sequence = r.varint();
+  result.since = r.varint();
+  auto count = r.varint();
+  for (std::uint64_t i = 0; i != count; ++i) {
+    auto length = r.varint();
+    auto end = r.offset() + length;
+    decoded_metric m{};
+    m.type = static_cast<record_type>(r.byte());
+    m.name = r.string();
+    m.labels = r.string();
+    switch (m.type) {
+    case record_type::counter:
+      m.counter_value = r.zigzag();
+      break;
+    case record_type::gauge:
+      m.gauge_value = r.ieee_double();
+      break;
+    case record_type::histogram: {
+      m.count = r.varint();
+      m.sum = r.zigzag();
+      m.min = r.zigzag();
+      m.max = r.zigzag();
+      m.underflow = r.varint();
+      m.overflow = r.varint();
+      auto nbuckets = r.varint();
+      std::int64_t upper = 0;
+      for (std::uint64_t b = 0; b != nbuckets; ++b) {
+        upper += r.zigzag();
+        m.buckets.push_back(decoded_bucket{upper, r.varint()});
+      }
+    } break;
+    default:
+      // ... a newer encoder, skip the rest of the record ...
+      if (end < r.offset()) {
+        throw std::runtime_error("jb::metrics::binary - invalid length");
+      }
+      r.skip(end - r.offset());
+      continue;
+    }
+    if (r.offset() != end) {
+      throw std::runtime_error(
+          "jb::metrics::binary - record length mismatch for " + m.name);
+    }
+    result.metrics.push_back(std::move(m));
+  }
+  return result;
+}
+
+void print_text(decoded_metrics const& m, std::ostream& os) {
+  os << "# sequence=" << m.sequence << " since=" << m.since << "\n";
+  for (auto const& metric : m.metrics) {
+    switch (metric.type) {
+    case record_type::counter:
+      print_name(os, metric.name, metric.labels, "");
+      os << " " << metric.counter_value << "\n";
+      break;
+    case record_type::gauge:
+      print_name(os, metric.name, metric.labels, "");
+      os << " " << metric.gauge_value << "\n";
+      break;
+    case record_type::histogram: {
+      std::uint64_t cumulative = metric.underflow;
+      for (auto const& b : metric.buckets) {
+        cumulative += b.count;
+        std::ostringstream le;
+        le << "le=\"" << b.upper_bound - 1 << "\"";
+        print_name(os, metric.name + "_bucket", metric.labels, le.str());
+        os << " " << cumulative << "\n";
+      }
+      print_name(os, metric.name + "_bucket", metric.labels, "le=\"+Inf\"");
+      os << " " << metric.count << "\n";
+      print_name(os, metric.name + "_sum", metric.labels, "");
+      os << " " << metric.sum << "\n";
+      print_name(os, metric.name + "_count", metric.labels, "");
+      os << " " << metric.count << "\n";
+      print_name(os, metric.name + "_min", metric.labels, "");
+      os << " " << metric.min << "\n";
+      print_name(os, metric.name + "_max", metric.labels, "");
+      os << " " << metric.max << "\n";
+    } break;
+    }
+  }
+}
+
+} // namespace binary
+} // namespace metrics
+} // namespace jb
@@ -0,0 +1,257 @@
+#ifndef jb_metrics_binary_hpp
+#define jb_metrics_binary_hpp
+
+#include <cstdint>
+#include <cstring>
+#include <iosfwd>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace jb {
+namespace metrics {
+/**
+ * A compact binary encoding for the metrics in a
+ * jb::metrics::registry.
+ *
+ * The Prometheus text format is expensive to generate and to parse
+ * when the metrics are scraped many times per second.  This encoding
+ * is designed for those cases:
+ *
+ * - Integers are encoded as base-128 varints, signed integers use
+ *   zigzag encoding first.  Most counters fit in a few bytes.
+ * - Histograms only include the non-empty buckets, the upper bound
+ *   of each bucket is encoded as a delta from the previous one.
+ * - Each scrape has a sequence number, and a scrape can request only
+ *   the metrics that changed since a previous sequence number.
+ * - Each record is prefixed by its length, so decoders can skip the
+ *   record types they do not understand.
+ *
+ * The layout of a message is:
+ *
+ * @code
+ * message := magic[3] version[1] varint(sequence) varint(since)
+ *            varint(record_count) record*
+ * record := varint(length) type[1] string(name) string(labels) payload
+ * string := varint(size) bytes
+ * counter payload := zigzag(value)
+ * gauge payload := IEEE-754 double, 8 bytes little endian
+ * histogram payload := varint(count) zigzag(sum) zigzag(min)
+ *                      zigzag(max) varint(underflow) varint(overflow)
+ *                      varint(bucket_count) bucket*
+ * bucket := zigzag(upper_bound - previous_upper_bound) varint(count)
+ * @endcode
+ *
+ * The labels are in the same format used by the text encoding, without
+ * the braces.
+ */
+namespace binary {
+
+/// The first bytes in any message
+constexpr char magic[] = {'J', 'B', 'M'};
+
+/// The version of the encoding
+constexpr std::uint8_t version = 1;
+
+/// The record types
+enum class record_type : std::uint8_t {
+  counter = 1,
+  gauge = 2,
+  histogram = 3,
+};
+
+//@{
+/**
+ * @name Encoding functions
+ *
+ * Append the encoded value to @a buffer.
+ */
+inline void put_varint(std::string& buffer, std::uint64_t v) {
+  while (v >= 0x80) {
+    buffer.push_back(static_cast<char>((v & 0x7F) | 0x80));
+    v >>= 7;
+  }
+  buffer.push_back(static_cast<char>(v));
+}
+
+inline void put_zigzag(std::string& buffer, std::int64_t v) {
+  put_varint(
+      buffer, (static_cast<std::uint64_t>(v) << 1) ^
+                  static_cast<std::uint64_t>(v >> 63));
+}
+
+inline void put_string(std::string& buffer, std::string const& s) {
+  put_varint(buffer, s.size());
+  buffer.append(s);
+}
+
+inline void put_double(std::string& buffer, double v) {
+  std::uint64_t bits;
+  std::memcpy(&bits, &v, sizeof(bits));
+  for (int i = 0; i != 8; ++i) {
+    buffer.push_back(static_cast<char>(bits & 0xFF));
+    bits >>= 8;
+  }
+}
+//@}
+
+/**
+ * Read values from an encoded message, checking for truncation.
+ *
+ * Other components reuse the same primitives for their own compact
+ * encodings, for example, jb::histogram::merge_encoded().
+ */
+class reader {
+public:
+  reader(char const* data, std::size_t size)
+      : data_(data)
+      , size_(size)
+      , offset_(0) {
+  }
+
+  std::size_t offset() const {
+    return offset_;
+  }
+
+  /// Return true if all the data has been read
+  bool done() const {
+    return offset_ == size_;
+  }
+
+  std::uint8_t byte() {
+    check(1);
+    return static_cast<std::uint8_t>(data_[offset_++]);
+  }
+
+  std::uint64_t varint() {
+    std::uint64_t v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      auto b = byte();
+      v |= static_cast<std::uint64_t>(b & 0x7F) << shift;
+      if ((b & 0x80) == 0) {
+        return v;
+      }
+    }
+    throw std::runtime_error("jb::metrics::binary - varint too long");
+  }
+
+  std::int64_t zigzag() {
+    auto v = varint();
+    return static_cast<std::int64_t>(v >> 1) ^
+           -static_cast<std::int64_t>(v & 1);
+  }
+
+  std::string string() {
+    auto size = varint();
+    check(size);
+    std::string s(data_ + offset_, size);
+    offset_ += size;
+    return s;
+  }
+
+  double ieee_double() {
+    check(8);
+    std::uint64_t bits = 0;
+    for (int i = 0; i != 8; ++i) {
+      bits |= static_cast<std::uint64_t>(
+                  static_cast<std::uint8_t>(data_[offset_ + i]))
+              << (8 * i);
+    }
+    offset_ += 8;
+    double v;
+    std::memcpy(&v, &bits, sizeof(v));
+    return v;
+  }
+
+  void skip(std::size_t n) {
+    check(n);
+    offset_ += n;
+  }
+
+private:
+  void check(std::size_t n) const {
+    if (n > size_ - offset_) {
+      std::ostringstream os;
+      os << "jb::metrics::binary - truncated message, offset=" << offset_
+         << ", size=" << size_ << ", needed=" << n;
+      throw std::runtime_error(os.str());
+    }
+  }
+
+private:
+  char const* data_;
+  std::size_t size_;
+  std::size_t offset_;
+};
+
+/// A histogram bucket in a decoded message
+struct decoded_bucket {
+  /// The exclusive upper bound of the bin, i.e., b for the bin [a,b)
+  std::int64_t upper_bound;
+  std::uint64_t count;
+};
+
+/// A metric in a decoded message
+struct decoded_metric {
+  record_type type;
+  std::string name;
+  std::string labels;
+
+  /// The value of a counter
+  std::int64_t counter_value;
+  /// The value of a gauge
+  double gauge_value;
+
+  //@{
+  /**
+   * @name The histogram data
+   */
+  std::uint64_t count;
+  std::int64_t sum;
+  std::int64_t min;
+  std::int64_t max;
+  std::uint64_t underflow;
+  std::uint64_t overflow;
+  std::vector<decoded_bucket> buckets;
+  //@}
+};
+
+/// A decoded message
+struct decoded_metrics {
+  /// The sequence number of the scrape
+  std::uint64_t sequence;
+  /// Only metrics changed after this sequence number are included
+  std::uint64_t since;
+  std::vector<decoded_metric> metrics;
+};
+
+/**
+ * Decode a message.
+ *
+ * Records of unknown types are skipped.
+ *
+ * @throw std::runtime_error if the message is malformed or uses an
+ * unsupported version of the encoding
+ */
+decoded_metrics decode(char const* data, std::size_t size);
+
+/// Decode a message stored in a string
+inline decoded_metrics decode(std::string const& data) {
+  return decode(data.data(), data.size());
+}
+
+/**
+ * Print the decoded metrics in Prometheus text format.
+ *
+ * Histograms are printed with cumulative buckets, only the non-empty
+ * buckets are included.  As in jb::metrics::histogram the "le" label
+ * is the largest integer sample in the bucket, i.e., upper_bound-1.
+ */
+void print_text(decoded_metrics const& m, std::ostream& os);
+
+} // namespace binary
+} // namespace metrics
+} // namespace jb
+
+#endif // jb_metrics_binary_hpp
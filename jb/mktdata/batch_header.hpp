@@ -0,0 +1,33 @@
+#ifndef jb_mktdata_batch_header_hpp
+#define jb_mktdata_batch_header_hpp
+
+#include <boost/endian/buffers.hpp>
+
+namespace jb {
+namespace mktdata {
+
+/**
+ * The header for datagrams carrying multiple JayBeams messages.
+ *
+ * To reduce the number of packets (and system calls) the feed
+ * handlers pack many messages in each datagram.  The datagram starts
+ * with this header, followed by @a message_count messages.  Every
+ * JayBeams message starts with its type and size, so the receiver can
+ * walk the messages without knowing their types.
+ */
+struct batch_header {
+  /// The total size of the datagram, including this header
+  boost::endian::little_uint16_buf_t batch_size;
+
+  /// The number of messages in the datagram
+  boost::endian::little_uint16_buf_t message_count;
+
+  /// The sequence number of the datagram, created by the sender, can
+  /// be used to detect lost datagrams
+  boost::endian::little_uint32_buf_t sequence_number;
+};
+
+} // namespace mktdata
+} // namespace jb
+
+#endif // jb_mktdata_batch_header_hpp
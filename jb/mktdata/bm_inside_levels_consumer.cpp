@@ -0,0 +1,340 @@
+/**
+ * @file
+ *
+ * This is a benchmark for jb::mktdata::inside_levels_consumer.  It
+ * measures how many inside updates per second a receiver can process
+ * over the loopback interface.
+ *
+ * Before each iteration a separate thread starts sending pre-built
+ * datagrams, in the same format sent by the feed handlers, as fast
+ * as it can.  The iteration receives the datagrams and processes
+ * them, until all the messages are received or lost.  The benchmark
+ * reports the time to process each iteration and the number of lost
+ * messages.  The sender never waits for the receiver, on a busy (or
+ * single core) host many messages will be lost, and the results are
+ * meaningless.
+ *
+ * Compare the results for the two test cases to estimate the cost of
+ * the consumer itself:
+ *
+ *   bm_inside_levels_consumer --microbenchmark.test-case=consumer
+ *   bm_inside_levels_consumer --microbenchmark.test-case=receive-only
+ */
+#include <jb/itch5/make_socket_udp_recv.hpp>
+#include <jb/itch5/udp_receiver_config.hpp>
+#include <jb/mktdata/batch_header.hpp>
+#include <jb/mktdata/inside_levels_consumer.hpp>
+#include <jb/mktdata/message_header.hpp>
+#include <jb/testing/microbenchmark.hpp>
+#include <jb/testing/microbenchmark_group_main.hpp>
+#include <jb/log.hpp>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/ip/udp.hpp>
+
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include <poll.h>
+
+/**
+ * Define types and functions used in this program.
+ */
+namespace {
+/// Configuration parameters for bm_inside_levels_consumer
+class config : public jb::config_object {
+public:
+  config();
+  config_object_constructors(config);
+
+  void validate() const override;
+
+  jb::config_attribute<config, jb::log::config> log;
+  jb::config_attribute<config, jb::testing::microbenchmark_config>
+      microbenchmark;
+  jb::config_attribute<config, std::string> address;
+  jb::config_attribute<config, int> port;
+  jb::config_attribute<config, int> max_packet_size;
+  jb::config_attribute<config, int> securities;
+  jb::config_attribute<config, int> receive_buffer_size;
+};
+
+jb::testing::microbenchmark_group<config> create_testcases();
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  auto testcases = create_testcases();
+  return jb::testing::microbenchmark_group_main(argc, argv, testcases);
+}
+
+namespace {
+namespace defaults {
+
+#ifndef JB_MKTDATA_DEFAULTS_bm_inside_levels_consumer_size
+#define JB_MKTDATA_DEFAULTS_bm_inside_levels_consumer_size 10000
+#endif // JB_MKTDATA_DEFAULTS_bm_inside_levels_consumer_size
+
+#ifndef JB_MKTDATA_DEFAULTS_bm_inside_levels_consumer_port
+#define JB_MKTDATA_DEFAULTS_bm_inside_levels_consumer_port 40140
+#endif // JB_MKTDATA_DEFAULTS_bm_inside_levels_consumer_port
+
+#ifndef JB_MKTDATA_DEFAULTS_max_packet_size
+#define JB_MKTDATA_DEFAULTS_max_packet_size 1400
+#endif // JB_MKTDATA_DEFAULTS_max_packet_size
+
+#ifndef JB_MKTDATA_DEFAULTS_securities
+#define JB_MKTDATA_DEFAULTS_securities 8000
+#endif // JB_MKTDATA_DEFAULTS_securities
+
+#ifndef JB_MKTDATA_DEFAULTS_receive_buffer_size
+#define JB_MKTDATA_DEFAULTS_receive_buffer_size (1 << 22)
+#endif // JB_MKTDATA_DEFAULTS_receive_buffer_size
+
+int const size = JB_MKTDATA_DEFAULTS_bm_inside_levels_consumer_size;
+int const port = JB_MKTDATA_DEFAULTS_bm_inside_levels_consumer_port;
+int const max_packet_size = JB_MKTDATA_DEFAULTS_max_packet_size;
+int const securities = JB_MKTDATA_DEFAULTS_securities;
+int const receive_buffer_size = JB_MKTDATA_DEFAULTS_receive_buffer_size;
+
+} // namespace defaults
+
+/// The message type used in the benchmark
+using message_type = jb::mktdata::inside_levels_update<1>;
+
+/// Create the receiving socket
+boost::asio::ip::udp::socket
+make_receiver(boost::asio::io_service& io, config const& cfg) {
+  jb::itch5::udp_receiver_config rcfg;
+  rcfg.address(cfg.address()).port(cfg.port());
+  rcfg.receive_buffer_size(cfg.receive_buffer_size());
+  return jb::itch5::make_socket_udp_recv(io, rcfg);
+}
+
+/// Accumulate the receiver counters across all the iterations
+struct receiver_counters {
+  std::uint64_t messages = 0;
+  std::uint64_t lost = 0;
+  std::uint64_t updates = 0;
+};
+
+/**
+ * Send datagrams over the loopback interface and process them.
+ */
+class fixture {
+public:
+  /// Constructor with the default size
+  fixture(config const& cfg, bool consume, receiver_counters& counters)
+      : fixture(defaults::size, cfg, consume, counters) {
+  }
+
+  /**
+   * Construct a new fixture.
+   *
+   * @param size the number of messages sent in each iteration
+   * @param cfg the benchmark configuration
+   * @param consume if true, process the datagrams with a
+   * jb::mktdata::inside_levels_consumer, otherwise just receive them
+   * @param counters where to accumulate the receiver counters
+   */
+  fixture(
+      int size, config const& cfg, bool consume, receiver_counters& counters)
+      : size_(size)
+      , consume_(consume)
+      , counters_(counters)
+      , io_()
+      , receiver_(make_receiver(io_, cfg))
+      , sender_(io_)
+      , datagrams_()
+      , sequence_number_(0)
+      , consumer_(
+            [this](jb::mktdata::inside_levels_view const& v) {
+              updates_ += v.levels();
+            },
+            [](std::uint32_t, std::uint32_t) {})
+      , updates_(0)
+      , send_thread_() {
+    boost::asio::ip::udp::endpoint ep(
+        boost::asio::ip::address::from_string(cfg.address()), cfg.port());
+    sender_.open(ep.protocol());
+    sender_.connect(ep);
+    build_datagrams(cfg);
+  }
+
+  /// Start sending the datagrams, this is not included in the
+  /// measurements
+  void iteration_setup() {
+    // ... the sequence numbers must continue across iterations, or
+    // the consumer would discard the messages ...
+    auto first = sequence_number_;
+    sequence_number_ += size_;
+    send_thread_ = std::thread([this, first]() { send_all(first); });
+  }
+
+  /// Wait for the sender
+  void iteration_teardown() {
+    send_thread_.join();
+  }
+
+  /// Receive and process the messages for one iteration
+  int run() {
+    std::uint64_t received = 0;
+    auto lost = consumer_.lost_messages();
+    char buffer[1 << 16];
+    while (received + (consumer_.lost_messages() - lost) < std::size_t(size_)) {
+      // ... stop when the sender is done and there is no more data,
+      // anything not received by then was lost ...
+      ::pollfd pfd;
+      pfd.fd = receiver_.native_handle();
+      pfd.events = POLLIN;
+      pfd.revents = 0;
+      if (::poll(&pfd, 1, 50) <= 0) {
+        break;
+      }
+      boost::system::error_code ec;
+      auto n = receiver_.receive(boost::asio::buffer(buffer), 0, ec);
+      if (ec or n < sizeof(jb::mktdata::batch_header)) {
+        continue;
+      }
+      auto h = reinterpret_cast<jb::mktdata::batch_header const*>(buffer);
+      received += h->message_count.value();
+      if (consume_) {
+        consumer_.process_batch(buffer, n);
+      }
+    }
+    counters_.messages += received;
+    counters_.lost += size_ - received;
+    counters_.updates += updates_;
+    updates_ = 0;
+    return size_;
+  }
+
+private:
+  /// Pre-build the datagrams sent in each iteration
+  void build_datagrams(config const& cfg) {
+    message_type msg;
+    std::memset(&msg, ' ', sizeof(msg));
+    msg.message_type = message_type::mtype;
+    msg.message_size = sizeof(msg);
+    std::size_t const per_datagram =
+        (cfg.max_packet_size() - sizeof(jb::mktdata::batch_header)) /
+        sizeof(msg);
+    for (int i = 0; i != size_; ++i) {
+      if (datagrams_.empty() or datagrams_.back().second == per_datagram) {
+        datagrams_.emplace_back(
+            std::vector<char>(sizeof(jb::mktdata::batch_header)), 0);
+      }
+      msg.security.id = i % cfg.securities();
+      msg.bid_px[0] = 1000 + i % 100;
+      msg.offer_px[0] = 1001 + i % 100;
+      auto& d = datagrams_.back();
+      auto p = reinterpret_cast<char const*>(&msg);
+      d.first.insert(d.first.end(), p, p + sizeof(msg));
+      ++d.second;
+    }
+    for (auto& d : datagrams_) {
+      auto h = reinterpret_cast<jb::mktdata::batch_header*>(d.first.data());
+      h->batch_size = d.first.size();
+      h->message_count = d.second;
+      h->sequence_number = 0;
+    }
+  }
+
+  /// Send all the datagrams, numbering the messages from @a first
+  void send_all(std::uint32_t first) {
+    auto seqno = first;
+    for (auto& d : datagrams_) {
+      std::size_t offset = sizeof(jb::mktdata::batch_header);
+      for (std::size_t i = 0; i != d.second; ++i) {
+        auto h = reinterpret_cast<jb::mktdata::message_header*>(
+            d.first.data() + offset);
+        h->sequence_number = ++seqno;
+        offset += h->message_size.value();
+      }
+      boost::system::error_code ec;
+      sender_.send(boost::asio::buffer(d.first), 0, ec);
+    }
+  }
+
+private:
+  int size_;
+  bool consume_;
+  receiver_counters& counters_;
+  boost::asio::io_service io_;
+  boost::asio::ip::udp::socket receiver_;
+  boost::asio::ip::udp::socket sender_;
+  std::vector<std::pair<std::vector<char>, std::size_t>> datagrams_;
+  std::uint32_t sequence_number_;
+  jb::mktdata::inside_levels_consumer consumer_;
+  std::uint64_t updates_;
+  std::thread send_thread_;
+};
+
+/**
+ * Run the benchmark.
+ *
+ * @param cfg the configuration for the benchmark
+ * @param consume if true, process the messages with the consumer
+ */
+void run_benchmark(config const& cfg, bool consume) {
+  receiver_counters counters;
+  jb::testing::microbenchmark<fixture> bm(cfg.microbenchmark());
+  auto r = bm.run(cfg, consume, counters);
+  bm.typical_output(r);
+
+  std::cerr << cfg.microbenchmark().test_case()
+            << " messages=" << counters.messages << ", lost=" << counters.lost
+            << ", updates=" << counters.updates << std::endl;
+}
+
+jb::testing::microbenchmark_group<config> create_testcases() {
+  return jb::testing::microbenchmark_group<config>{
+      {"consumer", [](config const& cfg) { run_benchmark(cfg, true); }},
+      {"receive-only", [](config const& cfg) { run_benchmark(cfg, false); }},
+  };
+}
+
+config::config()
+    : log(desc("log", "logging"), this)
+    , microbenchmark(
+          desc("microbenchmark", "microbenchmark"), this,
+          jb::testing::microbenchmark_config().test_case("consumer"))
+    , address(
+          desc("address").help("The address to send the datagrams to."), this,
+          "127.0.0.1")
+    , port(
+          desc("port").help("The port to send the datagrams to."), this,
+          defaults::port)
+    , max_packet_size(
+          desc("max-packet-size")
+              .help("The maximum size of the datagrams, the messages are "
+                    "packed up to this size."),
+          this, defaults::max_packet_size)
+    , securities(
+          desc("securities")
+              .help("The number of distinct securities in the messages."),
+          this, defaults::securities)
+    , receive_buffer_size(
+          desc("receive-buffer-size")
+              .help("The receive buffer size for the socket, the kernel "
+                    "may cap this value (see net.core.rmem_max)."),
+          this, defaults::receive_buffer_size) {
+}
+
+void config::validate() const {
+  log().validate();
+  microbenchmark().validate();
+  if (max_packet_size() < int(
+          sizeof(jb::mktdata::batch_header) + sizeof(message_type)) or
+      max_packet_size() > 65507) {
+    throw jb::usage("--max-packet-size is out of range", 1);
+  }
+  if (securities() <= 0) {
+    throw jb::usage("--securities must be positive", 1);
+  }
+  if (receive_buffer_size() <= 0) {
+    throw jb::usage("--receive-buffer-size must be positive", 1);
+  }
+}
+
+} // anonymous namespace
@@ -0,0 +1,335 @@
+/**
+ * @file
+ *
+ * This is a benchmark for jb::mktdata::shm_ring_writer and
+ * jb::mktdata::shm_ring_reader.  It measures the latency from the
+ * moment a message is published to the moment it is read by each of
+ * several reader processes.
+ *
+ * The benchmark forks the reader processes, each one attaches to the
+ * ring and spins on it, recording the latency of each message in a
+ * histogram.  The main process publishes jb::mktdata::inside_levels_update
+ * messages, with an optional delay between them to simulate the
+ * message rate of a real feed.  Each reader reports its latency
+ * distribution, and the number of lost messages, when the benchmark
+ * finishes.
+ *
+ * The readers and the writer spin, each one needs its own core for
+ * meaningful results, e.g.:
+ *
+ *   bm_shm_ring --readers=3 --interarrival-nanoseconds=500
+ *
+ * On hosts with fewer cores use --reader-yield, otherwise the readers
+ * can starve the writer.
+ */
+#include <jb/mktdata/inside_levels_update.hpp>
+#include <jb/mktdata/message_header.hpp>
+#include <jb/mktdata/shm_ring_reader.hpp>
+#include <jb/mktdata/shm_ring_writer.hpp>
+#include <jb/testing/microbenchmark.hpp>
+#include <jb/testing/microbenchmark_group_main.hpp>
+#include <jb/histogram.hpp>
+#include <jb/integer_range_binning.hpp>
+#include <jb/log.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <system_error>
+#include <thread>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * Define types and functions used in this program.
+ */
+namespace {
+/// Configuration parameters for bm_shm_ring
+class config : public jb::config_object {
+public:
+  config();
+  config_object_constructors(config);
+
+  void validate() const override;
+
+  jb::config_attribute<config, jb::log::config> log;
+  jb::config_attribute<config, jb::testing::microbenchmark_config>
+      microbenchmark;
+  jb::config_attribute<config, jb::mktdata::shm_ring_config> ring;
+  jb::config_attribute<config, int> readers;
+  jb::config_attribute<config, bool> reader_yield;
+  jb::config_attribute<config, int> interarrival_nanoseconds;
+  jb::config_attribute<config, int> max_latency_nanoseconds;
+};
+
+jb::testing::microbenchmark_group<config> create_testcases();
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  auto testcases = create_testcases();
+  return jb::testing::microbenchmark_group_main(argc, argv, testcases);
+}
+
+namespace {
+namespace defaults {
+
+#ifndef JB_MKTDATA_DEFAULTS_bm_shm_ring_size
+#define JB_MKTDATA_DEFAULTS_bm_shm_ring_size 10000
+#endif // JB_MKTDATA_DEFAULTS_bm_shm_ring_size
+
+#ifndef JB_MKTDATA_DEFAULTS_bm_shm_ring_name
+#define JB_MKTDATA_DEFAULTS_bm_shm_ring_name "/jb-bm-shm-ring"
+#endif // JB_MKTDATA_DEFAULTS_bm_shm_ring_name
+
+#ifndef JB_MKTDATA_DEFAULTS_bm_shm_ring_readers
+#define JB_MKTDATA_DEFAULTS_bm_shm_ring_readers 2
+#endif // JB_MKTDATA_DEFAULTS_bm_shm_ring_readers
+
+#ifndef JB_MKTDATA_DEFAULTS_interarrival_nanoseconds
+#define JB_MKTDATA_DEFAULTS_interarrival_nanoseconds 1000
+#endif // JB_MKTDATA_DEFAULTS_interarrival_nanoseconds
+
+#ifndef JB_MKTDATA_DEFAULTS_max_latency_nanoseconds
+#define JB_MKTDATA_DEFAULTS_max_latency_nanoseconds 100000
+#endif // JB_MKTDATA_DEFAULTS_max_latency_nanoseconds
+
+int const size = JB_MKTDATA_DEFAULTS_bm_shm_ring_size;
+std::string const name = JB_MKTDATA_DEFAULTS_bm_shm_ring_name;
+int const readers = JB_MKTDATA_DEFAULTS_bm_shm_ring_readers;
+int const interarrival_nanoseconds =
+    JB_MKTDATA_DEFAULTS_interarrival_nanoseconds;
+int const max_latency_nanoseconds =
+    JB_MKTDATA_DEFAULTS_max_latency_nanoseconds;
+
+} // namespace defaults
+
+/// The histogram type used to capture the latencies
+using latency_histogram =
+    jb::histogram<jb::integer_range_binning<std::int64_t>>;
+
+/// The message type used in the benchmark
+using message_type = jb::mktdata::inside_levels_update<1>;
+
+/// The readers exit when they receive a message of this type
+std::uint16_t const stop_message_type = 0;
+
+/// Return the current time, in the same units as the messages
+std::int64_t now_nanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+/**
+ * The main function for each reader process.
+ *
+ * std::chrono::steady_clock uses CLOCK_MONOTONIC on Linux, which is
+ * shared by all the processes in the host, so the latency can be
+ * computed from the timestamp set by the writer.
+ *
+ * @param cfg the benchmark configuration
+ * @param id the reader number, only used in the report
+ * @param ready a pipe to signal the parent once the reader is
+ * attached
+ */
+void reader_main(config const& cfg, int id, int ready) {
+  jb::mktdata::shm_ring_reader reader(cfg.ring().name());
+  latency_histogram latency(
+      jb::integer_range_binning<std::int64_t>(
+          0, cfg.max_latency_nanoseconds()));
+  char c = 'r';
+  if (::write(ready, &c, 1) != 1) {
+    throw std::system_error(
+        errno, std::generic_category(), "reader - signaling parent");
+  }
+  ::close(ready);
+
+  bool stopped = false;
+  while (not stopped) {
+    auto count = reader.poll([&](char const* buf, std::size_t len) {
+      auto now = now_nanos();
+      if (len < sizeof(message_type)) {
+        stopped = true;
+        return;
+      }
+      auto msg = reinterpret_cast<message_type const*>(buf);
+      if (msg->message_type.value() == stop_message_type) {
+        stopped = true;
+        return;
+      }
+      latency.sample(now - std::int64_t(msg->feedhandler_ts.nanos.value()));
+    });
+    if (count == 0 and cfg.reader_yield()) {
+      std::this_thread::yield();
+    }
+  }
+  std::ostringstream os;
+  os << cfg.microbenchmark().test_case() << " reader[" << id
+     << "] received=" << reader.messages_received()
+     << ", lost=" << reader.lost_messages()
+     << ", overruns=" << reader.overruns() << "\n"
+     << cfg.microbenchmark().test_case() << " reader[" << id
+     << "] latency(ns) summary: " << latency.summary() << "\n";
+  std::cerr << os.str() << std::flush;
+}
+
+/**
+ * Publish messages to a shared memory ring read by several processes.
+ */
+class fixture {
+public:
+  /// Constructor with the default size
+  explicit fixture(config const& cfg)
+      : fixture(defaults::size, cfg) {
+  }
+
+  /**
+   * Construct a new fixture, fork the readers.
+   *
+   * @param size the number of messages published in each iteration
+   * @param cfg the benchmark configuration
+   */
+  fixture(int size, config const& cfg)
+      : size_(size)
+      , interarrival_(cfg.interarrival_nanoseconds())
+      , writer_(cfg.ring())
+      , readers_() {
+    std::memset(&msg_, 0, sizeof(msg_));
+    msg_.message_type = message_type::mtype;
+    msg_.message_size = sizeof(msg_);
+
+    int fds[2];
+    if (::pipe(fds) == -1) {
+      throw std::system_error(errno, std::generic_category(), "pipe()");
+    }
+    for (int i = 0; i != cfg.readers(); ++i) {
+      auto pid = ::fork();
+      if (pid == -1) {
+        throw std::system_error(errno, std::generic_category(), "fork()");
+      }
+      if (pid == 0) {
+        // ... the child must not run any destructors, in particular
+        // the writer destructor would remove the segment ...
+        ::close(fds[0]);
+        int status = 0;
+        try {
+          reader_main(cfg, i, fds[1]);
+        } catch (std::exception const& ex) {
+          std::cerr << "reader[" << i << "] exception: " << ex.what()
+                    << std::endl;
+          status = 1;
+        }
+        ::_exit(status);
+      }
+      readers_.push_back(pid);
+    }
+    ::close(fds[1]);
+    // ... wait until all the readers are attached, otherwise they
+    // would miss the first messages ...
+    for (int i = 0; i != cfg.readers(); ++i) {
+      char c;
+      if (::read(fds[0], &c, 1) != 1) {
+        break;
+      }
+    }
+    ::close(fds[0]);
+  }
+
+  ~fixture() {
+    jb::mktdata::message_header stop;
+    stop.message_type = stop_message_type;
+    stop.message_size = sizeof(stop);
+    stop.sequence_number = 0;
+    writer_.publish(&stop, sizeof(stop));
+    for (auto pid : readers_) {
+      int status;
+      (void)::waitpid(pid, &status, 0);
+    }
+  }
+
+  /// Publish size_ messages
+  int run() {
+    using std::chrono::steady_clock;
+    auto next = steady_clock::now();
+    for (int i = 0; i != size_; ++i) {
+      // ... spin until it is time for the next message, sleeping is
+      // far too coarse for the typical interarrival times ...
+      while (steady_clock::now() < next) {
+      }
+      msg_.security.id = i;
+      msg_.feedhandler_ts.nanos = now_nanos();
+      writer_.publish(&msg_, sizeof(msg_));
+      next += interarrival_;
+    }
+    return size_;
+  }
+
+private:
+  int size_;
+  std::chrono::nanoseconds interarrival_;
+  jb::mktdata::shm_ring_writer writer_;
+  message_type msg_;
+  std::vector<pid_t> readers_;
+};
+
+jb::testing::microbenchmark_group<config> create_testcases() {
+  return jb::testing::microbenchmark_group<config>{
+      {"publish",
+       [](config const& cfg) {
+         jb::testing::microbenchmark<fixture> bm(cfg.microbenchmark());
+         auto r = bm.run(cfg);
+         bm.typical_output(r);
+       }},
+  };
+}
+
+config::config()
+    : log(desc("log", "logging"), this)
+    , microbenchmark(
+          desc("microbenchmark", "microbenchmark"), this,
+          jb::testing::microbenchmark_config().test_case("publish"))
+    , ring(
+          desc("ring", "shm-ring"), this,
+          jb::mktdata::shm_ring_config().name(defaults::name))
+    , readers(
+          desc("readers").help("The number of reader processes."), this,
+          defaults::readers)
+    , reader_yield(
+          desc("reader-yield")
+              .help("If set, the readers yield the CPU when there are no new "
+                    "messages, instead of spinning.  Use on hosts with fewer "
+                    "cores than readers."),
+          this, false)
+    , interarrival_nanoseconds(
+          desc("interarrival-nanoseconds")
+              .help("The time between consecutive messages, use 0 to "
+                    "publish as fast as possible."),
+          this, defaults::interarrival_nanoseconds)
+    , max_latency_nanoseconds(
+          desc("max-latency-nanoseconds")
+              .help("The maximum latency tracked in the histogram, larger "
+                    "values are counted as overflows."),
+          this, defaults::max_latency_nanoseconds) {
+}
+
+void config::validate() const {
+  log().validate();
+  microbenchmark().validate();
+  ring().validate();
+  if (ring().name() == "") {
+    throw jb::usage("--ring.name must be set", 1);
+  }
+  if (readers() < 0) {
+    throw jb::usage("--readers must be >= 0", 1);
+  }
+  if (interarrival_nanoseconds() < 0) {
+    throw jb::usage("--interarrival-nanoseconds must be >= 0", 1);
+  }
+  if (max_latency_nanoseconds() <= 0) {
+    throw jb::usage("--max-latency-nanoseconds must be positive", 1);
+  }
+}
+
+} // anonymous namespace
@@ -0,0 +1,73 @@
+#ifndef jb_mktdata_detail_shm_ring_layout_hpp
+#define jb_mktdata_detail_shm_ring_layout_hpp
+
+#include <atomic>
+#include <cstdint>
+
+namespace jb {
+namespace mktdata {
+namespace detail {
+
+/**
+ * The layout of the shared memory segment used by
+ * jb::mktdata::shm_ring_writer and jb::mktdata::shm_ring_reader.
+ *
+ * The segment starts with this header, followed by slot_count slots
+ * of slot_size bytes each.  Message number n (starting at 1) is
+ * stored in slot (n % slot_count).  Each slot starts with a
+ * shm_ring_slot, followed by the message contents.
+ *
+ * The writer and the readers are in different processes, the
+ * synchronization relies on lock-free atomics, which work across
+ * processes when mapped in shared memory.
+ */
+struct shm_ring_header {
+  /// Set (last) by the writer once the header is initialized
+  std::atomic<std::uint64_t> magic;
+  /// The layout version
+  std::uint32_t version;
+  /// The size of each slot, including the shm_ring_slot
+  std::uint32_t slot_size;
+  /// The number of slots, a power of 2
+  std::uint64_t slot_count;
+  /// The last message published, in its own cache line as it is
+  /// read by every reader
+  alignas(64) std::atomic<std::uint64_t> published;
+};
+
+/// The header for each slot
+struct shm_ring_slot {
+  /**
+   * The number of the message in the slot.
+   *
+   * The writer sets it to 0 while the slot is modified, readers check
+   * it before and after copying the message, if it changed the
+   * message was overwritten.
+   */
+  std::atomic<std::uint64_t> sequence_number;
+  /// The size of the message
+  std::uint32_t size;
+  /// Reserved, keeps the message 8-byte aligned
+  std::uint32_t reserved;
+};
+
+/// The value of shm_ring_header::magic
+constexpr std::uint64_t shm_ring_magic = 0x474e4952534d424aULL;
+
+/// The current layout version
+constexpr std::uint32_t shm_ring_version = 1;
+
+/// The slots start after the header, aligned to a cache line
+constexpr std::size_t shm_ring_header_size = 128;
+
+static_assert(
+    sizeof(shm_ring_header) <= shm_ring_header_size,
+    "shm_ring_header does not fit in the reserved space");
+static_assert(
+    sizeof(shm_ring_slot) == 16, "unexpected size for shm_ring_slot");
+
+} // namespace detail
+} // namespace mktdata
+} // namespace jb
+
+#endif // jb_mktdata_detail_shm_ring_layout_hpp
@@ -0,0 +1,141 @@
+#include "jb/mktdata/inside_levels_consumer.hpp"
+
+#include <jb/mktdata/batch_header.hpp>
+#include <jb/mktdata/message_header.hpp>
+#include <jb/log.hpp>
+
+#include <cstring>
+
+namespace jb {
+namespace mktdata {
+
+inside_levels_consumer::inside_levels_consumer(
+    update_handler&& on_update, gap_handler&& on_gap)
+    : on_update_(std::move(on_update))
+    , on_gap_(std::move(on_gap))
+    , cache_()
+    , started_(false)
+    , expected_(0)
+    , batches_received_(0)
+    , invalid_batches_(0)
+    , messages_received_(0)
+    , invalid_messages_(0)
+    , unknown_messages_(0)
+    , stale_messages_(0)
+    , gaps_(0)
+    , lost_messages_(0) {
+}
+
+void inside_levels_consumer::process_batch(char const* buf, std::size_t len) {
+  ++batches_received_;
+  if (len < sizeof(batch_header)) {
+    ++invalid_batches_;
+    return;
+  }
+  auto batch = reinterpret_cast<batch_header const*>(buf);
+  if (batch->batch_size.value() != len) {
+    ++invalid_batches_;
+    return;
+  }
+  std::size_t offset = sizeof(batch_header);
+  for (int i = 0; i != batch->message_count.value(); ++i) {
+    // ... a message with an invalid size makes the rest of the
+    // datagram unusable, we cannot find the next message ...
+    if (offset + sizeof(message_header) > len) {
+      ++invalid_batches_;
+      return;
+    }
+    char const* msg = buf + offset;
+    auto header = reinterpret_cast<message_header const*>(msg);
+    std::size_t msglen = header->message_size.value();
+    if (msglen < sizeof(message_header) or offset + msglen > len) {
+      ++invalid_batches_;
+      return;
+    }
+    offset += msglen;
+    dispatch(msg, msglen);
+  }
+}
+
+void inside_levels_consumer::process_message(
+    char const* buf, std::size_t len) {
+  if (len < sizeof(message_header)) {
+    ++invalid_messages_;
+    return;
+  }
+  auto header = reinterpret_cast<message_header const*>(buf);
+  if (header->message_size.value() != len) {
+    ++invalid_messages_;
+    return;
+  }
+  dispatch(buf, len);
+}
+
+inside_levels_view const*
+inside_levels_consumer::last_inside(std::uint32_t security_id) const {
+  auto i = cache_.find(security_id);
+  if (i == cache_.end()) {
+    return nullptr;
+  }
+  return &i->second.view;
+}
+
+bool inside_levels_consumer::check_sequence_number(std::uint32_t seqno) {
+  if (not started_) {
+    started_ = true;
+    expected_ = seqno + 1;
+    return true;
+  }
+  // ... the sequence numbers wrap around, compare them using modular
+  // arithmetic ...
+  auto distance = static_cast<std::int32_t>(seqno - expected_);
+  if (distance < 0) {
+    ++stale_messages_;
+    return false;
+  }
+  if (distance > 0) {
+    ++gaps_;
+    lost_messages_ += distance;
+    if (on_gap_) {
+      on_gap_(expected_, seqno);
+    } else {
+      JB_LOG(info) << "gap in inside_levels stream, expected=" << expected_
+                   << ", received=" << seqno;
+    }
+  }
+  expected_ = seqno + 1;
+  return true;
+}
+
+void inside_levels_consumer::dispatch(char const* msg, std::size_t msglen) {
+  ++messages_received_;
+  auto header = reinterpret_cast<message_header const*>(msg);
+  if (not check_sequence_number(header->sequence_number.value())) {
+    return;
+  }
+  if (not inside_levels_view::is_inside_levels_update(
+          header->message_type.value())) {
+    ++unknown_messages_;
+    return;
+  }
+  process_inside(msg, msglen);
+}
+
+void inside_levels_consumer::process_inside(
+    char const* msg, std::size_t msglen) {
+  inside_levels_view view;
+  if (not inside_levels_view::parse(msg, msglen, view)) {
+    ++invalid_messages_;
+    return;
+  }
+  // ... copy the message into the cache, the buffer is large enough
+  // for any inside_levels_update message that parse() accepts ...
+  auto& entry = cache_[view.security_id()];
+  std::memcpy(entry.buffer.data(), msg, view.message_size());
+  inside_levels_view::parse(
+      entry.buffer.data(), view.message_size(), entry.view);
+  on_update_(view);
+}
+
+} // namespace mktdata
+} // namespace jb
@@ -0,0 +1,166 @@
+#ifndef jb_mktdata_inside_levels_consumer_hpp
+#define jb_mktdata_inside_levels_consumer_hpp
+
+#include <jb/mktdata/inside_levels_view.hpp>
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+
+namespace jb {
+namespace mktdata {
+
+/**
+ * Process the datagrams sent by a JayBeams feed handler.
+ *
+ * Feed handlers configured to batch their output pack many messages
+ * in each datagram (see jb::mktdata::batch_header), otherwise each
+ * datagram contains a single, bare, message.  This class walks the
+ * messages in each datagram, validates them, detects lost messages
+ * using the sequence numbers, and keeps the last inside for each
+ * security.  The application receives a
+ * jb::mktdata::inside_levels_view for each inside update, the
+ * messages are never copied, except into the cache.
+ *
+ * Messages with a sequence number lower than expected (duplicates,
+ * or messages reordered by the network) are older than the data
+ * already received, they are counted and discarded.
+ *
+ * This class is not thread-safe, typically each receiving thread
+ * has its own instance.
+ */
+class inside_levels_consumer {
+public:
+  /// Called for each inside update
+  typedef std::function<void(inside_levels_view const&)> update_handler;
+
+  /// Called for each gap in the sequence numbers, with the expected
+  /// and the received sequence numbers
+  typedef std::function<void(std::uint32_t, std::uint32_t)> gap_handler;
+
+  /**
+   * Constructor.
+   *
+   * @param on_update called for each inside update
+   * @param on_gap called when messages are lost, can be empty
+   */
+  explicit inside_levels_consumer(
+      update_handler&& on_update, gap_handler&& on_gap = gap_handler());
+
+  inside_levels_consumer(inside_levels_consumer const&) = delete;
+  inside_levels_consumer& operator=(inside_levels_consumer const&) = delete;
+
+  /**
+   * Process a datagram.
+   *
+   * Invalid datagrams and messages are counted and discarded, the
+   * contents of a datagram are untrusted data from the network.
+   *
+   * @param buf the datagram contents
+   * @param len the size of the datagram
+   */
+  void process_batch(char const* buf, std::size_t len);
+
+  /**
+   * Process a datagram containing a single message, without a batch
+   * header.
+   *
+   * This is the format sent by feed handlers that do not batch their
+   * output.  Invalid messages are counted and discarded.
+   *
+   * @param buf the datagram contents
+   * @param len the size of the datagram
+   */
+  void process_message(char const* buf, std::size_t len);
+
+  /**
+   * Return the last inside received for a security.
+   *
+   * @returns nullptr if no message was received for the security
+   */
+  inside_levels_view const* last_inside(std::uint32_t security_id) const;
+
+  /// The number of securities in the cache
+  std::size_t security_count() const {
+    return cache_.size();
+  }
+
+  /// The next expected sequence number, 0 before any message is
+  /// received
+  std::uint32_t expected_sequence_number() const {
+    return expected_;
+  }
+
+  //@{
+  /**
+   * @name Counters
+   */
+  std::uint64_t batches_received() const {
+    return batches_received_;
+  }
+  std::uint64_t invalid_batches() const {
+    return invalid_batches_;
+  }
+  std::uint64_t messages_received() const {
+    return messages_received_;
+  }
+  std::uint64_t invalid_messages() const {
+    return invalid_messages_;
+  }
+  std::uint64_t unknown_messages() const {
+    return unknown_messages_;
+  }
+  std::uint64_t stale_messages() const {
+    return stale_messages_;
+  }
+  std::uint64_t gaps() const {
+    return gaps_;
+  }
+  std::uint64_t lost_messages() const {
+    return lost_messages_;
+  }
+  //@}
+
+private:
+  /**
+   * Check the sequence number of a message.
+   *
+   * @returns false if the message is older than the data already
+   * received and should be discarded
+   */
+  bool check_sequence_number(std::uint32_t seqno);
+
+  /// Process a message whose size has been validated
+  void dispatch(char const* msg, std::size_t msglen);
+
+  /// Process an inside update
+  void process_inside(char const* msg, std::size_t msglen);
+
+private:
+  /// Each cache entry keeps a copy of the last message
+  struct cache_entry {
+    std::array<char, sizeof(inside_levels_update<8>)> buffer;
+    inside_levels_view view;
+  };
+
+  update_handler on_update_;
+  gap_handler on_gap_;
+  std::unordered_map<std::uint32_t, cache_entry> cache_;
+  bool started_;
+  std::uint32_t expected_;
+
+  std::uint64_t batches_received_;
+  std::uint64_t invalid_batches_;
+  std::uint64_t messages_received_;
+  std::uint64_t invalid_messages_;
+  std::uint64_t unknown_messages_;
+  std::uint64_t stale_messages_;
+  std::uint64_t gaps_;
+  std::uint64_t lost_messages_;
+};
+
+} // namespace mktdata
+} // namespace jb
+
+#endif // jb_mktdata_inside_levels_consumer_hpp
@@ -0,0 +1,99 @@
+#include "jb/mktdata/inside_levels_view.hpp"
+
+#include <jb/mktdata/message_header.hpp>
+
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+namespace jb {
+namespace mktdata {
+
+inside_levels_view::inside_levels_view()
+    : buf_(nullptr)
+    , levels_(0)
+    , bid_qty_(nullptr)
+    , bid_px_(nullptr)
+    , offer_qty_(nullptr)
+    , offer_px_(nullptr)
+    , annotations_(nullptr) {
+}
+
+inside_levels_view::inside_levels_view(char const* buf, std::size_t len)
+    : inside_levels_view() {
+  if (parse(buf, len, *this)) {
+    return;
+  }
+  std::ostringstream os;
+  os << "inside_levels_view - invalid message in buffer of size " << len;
+  if (len >= sizeof(message_header)) {
+    auto h = reinterpret_cast<message_header const*>(buf);
+    os << ", message_type=" << std::hex << h->message_type.value()
+       << std::dec << ", message_size=" << h->message_size.value();
+  }
+  throw std::runtime_error(os.str());
+}
+
+bool inside_levels_view::parse(
+    char const* buf, std::size_t len, inside_levels_view& view) {
+  if (len < sizeof(message_header)) {
+    return false;
+  }
+  switch (reinterpret_cast<message_header const*>(buf)->message_type.value()) {
+  case inside_levels_update<1>::mtype:
+    return view.bind<1>(buf, len);
+  case inside_levels_update<4>::mtype:
+    return view.bind<4>(buf, len);
+  case inside_levels_update<8>::mtype:
+    return view.bind<8>(buf, len);
+  }
+  return false;
+}
+
+bool inside_levels_view::is_inside_levels_update(std::uint16_t mtype) {
+  return mtype == inside_levels_update<1>::mtype or
+         mtype == inside_levels_update<4>::mtype or
+         mtype == inside_levels_update<8>::mtype;
+}
+
+std::string inside_levels_view::security_feed() const {
+  if (annotations_ == nullptr) {
+    return std::string();
+  }
+  auto s = reinterpret_cast<char const*>(annotations_->security_feed);
+  std::size_t len = sizeof(annotations_->security_feed);
+  // ... the field is padded with spaces or NUL characters ...
+  while (len != 0 and (s[len - 1] == ' ' or s[len - 1] == '\0')) {
+    --len;
+  }
+  return std::string(s, len);
+}
+
+template <std::size_t N>
+bool inside_levels_view::bind(char const* buf, std::size_t len) {
+  using message_type = inside_levels_update<N>;
+  // ... the annotations are optional, the message must contain at
+  // least the price levels, and cannot be larger than the buffer ...
+  std::size_t const min_size =
+      sizeof(message_type) - sizeof(typename message_type::annotations_type);
+  std::size_t msgsize =
+      reinterpret_cast<message_header const*>(buf)->message_size.value();
+  if (msgsize < min_size or msgsize > sizeof(message_type) or msgsize > len) {
+    return false;
+  }
+  auto msg = reinterpret_cast<message_type const*>(buf);
+  buf_ = buf;
+  levels_ = N;
+  bid_qty_ = msg->bid_qty;
+  bid_px_ = msg->bid_px;
+  offer_qty_ = msg->offer_qty;
+  offer_px_ = msg->offer_px;
+  annotations_ = msgsize >= sizeof(message_type)
+                     ? reinterpret_cast<annotations_type const*>(
+                           &msg->annotations)
+                     : nullptr;
+  return true;
+}
+
+} // namespace mktdata
+} // namespace jb
@@ -0,0 +1,154 @@
+#ifndef jb_mktdata_inside_levels_view_hpp
+#define jb_mktdata_inside_levels_view_hpp
+
+#include <jb/mktdata/inside_levels_update.hpp>
+
+#include <cstdint>
+#include <string>
+
+namespace jb {
+namespace mktdata {
+
+/**
+ * A read-only view of a jb::mktdata::inside_levels_update message.
+ *
+ * The inside_levels_update messages are templates on the number of
+ * levels, but a receiver does not know which one it got until it
+ * looks at the message type.  This class validates the message type
+ * and size, and then provides accessors for the fields, without
+ * copying the message.  The fields are converted from their
+ * boost::endian representation on each access, which is cheap for
+ * the common case where only a few fields are used.
+ *
+ * The view does not own the buffer, the application must keep the
+ * buffer alive (and unmodified) while the view is in use.
+ */
+class inside_levels_view {
+public:
+  /// Create an empty view, only useful as the target for parse()
+  inside_levels_view();
+
+  /**
+   * Create a view for a buffer.
+   *
+   * @param buf the message contents
+   * @param len the size of the buffer, can be larger than the message
+   * @throws std::runtime_error if the buffer does not contain a valid
+   * inside_levels_update message
+   */
+  inside_levels_view(char const* buf, std::size_t len);
+
+  /**
+   * Initialize @a view from @a buf if it contains a valid message.
+   *
+   * Receivers process untrusted data from the network, this function
+   * can be used to validate it without the cost of exceptions.
+   *
+   * @returns true if @a view was initialized, false if the buffer
+   * does not contain a valid inside_levels_update message
+   */
+  static bool parse(char const* buf, std::size_t len, inside_levels_view& view);
+
+  /// Return true if @a mtype is the type of an inside_levels_update
+  static bool is_inside_levels_update(std::uint16_t mtype);
+
+  /// The number of levels in the message
+  std::size_t levels() const {
+    return levels_;
+  }
+
+  /// The beginning of the message
+  char const* data() const {
+    return buf_;
+  }
+
+  //@{
+  /**
+   * @name Accessors for the message fields.
+   *
+   * See jb::mktdata::inside_levels_update for their meaning.
+   */
+  std::uint16_t message_type() const {
+    return header()->message_type.value();
+  }
+  std::uint16_t message_size() const {
+    return header()->message_size.value();
+  }
+  std::uint32_t sequence_number() const {
+    return header()->sequence_number.value();
+  }
+  std::uint32_t market_id() const {
+    return header()->market.id.value();
+  }
+  std::uint32_t feed_id() const {
+    return header()->feed.id.value();
+  }
+  std::uint64_t feedhandler_ts() const {
+    return header()->feedhandler_ts.nanos.value();
+  }
+  std::uint32_t source_id() const {
+    return header()->source.id.value();
+  }
+  std::uint64_t exchange_ts() const {
+    return header()->exchange_ts.nanos.value();
+  }
+  std::uint64_t feed_ts() const {
+    return header()->feed_ts.nanos.value();
+  }
+  std::uint32_t security_id() const {
+    return header()->security.id.value();
+  }
+  std::uint32_t bid_qty(std::size_t level) const {
+    return bid_qty_[level].value();
+  }
+  std::uint32_t bid_px(std::size_t level) const {
+    return bid_px_[level].value();
+  }
+  std::uint32_t offer_qty(std::size_t level) const {
+    return offer_qty_[level].value();
+  }
+  std::uint32_t offer_px(std::size_t level) const {
+    return offer_px_[level].value();
+  }
+  //@}
+
+  /// Return true if the message includes the annotations
+  bool has_annotations() const {
+    return annotations_ != nullptr;
+  }
+
+  /// The security name as it appears in the feed, empty if the
+  /// message has no annotations
+  std::string security_feed() const;
+
+private:
+  /// All the inside_levels_update<N> messages have the same fields
+  /// before the price levels, use the single level one to access them
+  using level1 = inside_levels_update<1>;
+  /// The type of the price and quantity fields
+  using field = boost::endian::little_uint32_buf_t;
+  /// The annotations, all the messages share the same layout
+  using annotations_type = level1::annotations_type;
+
+  level1 const* header() const {
+    return reinterpret_cast<level1 const*>(buf_);
+  }
+
+  /// Initialize the view for a message with N levels
+  template <std::size_t N>
+  bool bind(char const* buf, std::size_t len);
+
+private:
+  char const* buf_;
+  std::size_t levels_;
+  field const* bid_qty_;
+  field const* bid_px_;
+  field const* offer_qty_;
+  field const* offer_px_;
+  annotations_type const* annotations_;
+};
+
+} // namespace mktdata
+} // namespace jb
+
+#endif // jb_mktdata_inside_levels_view_hpp
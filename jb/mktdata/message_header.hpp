@@ -0,0 +1,33 @@
+#ifndef jb_mktdata_message_header_hpp
+#define jb_mktdata_message_header_hpp
+
+#include <boost/endian/buffers.hpp>
+
+namespace jb {
+namespace mktdata {
+
+/**
+ * The fields at the beginning of every JayBeams message.
+ *
+ * Receivers can use these fields to skip messages they do not
+ * understand, and to detect lost messages, without knowing the
+ * layout of the rest of the message.
+ */
+struct message_header {
+  /// The message type, each message in JayBeams receives a unique
+  /// identifier
+  boost::endian::little_uint16_buf_t message_type;
+
+  /// The message size, including this header
+  boost::endian::little_uint16_buf_t message_size;
+
+  /// The sequence number, assigned by the sender.  Each output stream
+  /// starts at 1 and increments the sequence number by one for each
+  /// message, wrapping around after 2^32 messages.
+  boost::endian::little_uint32_buf_t sequence_number;
+};
+
+} // namespace mktdata
+} // namespace jb
+
+#endif // jb_mktdata_message_header_hpp
@@ -0,0 +1,68 @@
+#include "jb/mktdata/shm_ring_config.hpp"
+#include <jb/usage.hpp>
+
+#include <sstream>
+
+namespace jb {
+namespace mktdata {
+namespace defaults {
+
+#ifndef JB_MKTDATA_DEFAULTS_shm_ring_slot_count
+#define JB_MKTDATA_DEFAULTS_shm_ring_slot_count 65536
+#endif // JB_MKTDATA_DEFAULTS_shm_ring_slot_count
+
+#ifndef JB_MKTDATA_DEFAULTS_shm_ring_slot_size
+#define JB_MKTDATA_DEFAULTS_shm_ring_slot_size 256
+#endif // JB_MKTDATA_DEFAULTS_shm_ring_slot_size
+
+int shm_ring_slot_count = JB_MKTDATA_DEFAULTS_shm_ring_slot_count;
+int shm_ring_slot_size = JB_MKTDATA_DEFAULTS_shm_ring_slot_size;
+
+} // namespace defaults
+
+shm_ring_config::shm_ring_config()
+    : name(
+          desc("name").help(
+              "The name of the POSIX shared memory segment, for example "
+              "'/jb-inside'.  If empty, the ring is disabled."),
+          this, "")
+    , slot_count(
+          desc("slot-count")
+              .help("The number of messages kept in the ring, must be a power "
+                    "of 2.  Readers that fall behind by more than this many "
+                    "messages lose data."),
+          this, defaults::shm_ring_slot_count)
+    , slot_size(
+          desc("slot-size")
+              .help("The size of each slot in the ring, including a 16 byte "
+                    "header.  Must be a multiple of 64 (the cache line size)."),
+          this, defaults::shm_ring_slot_size) {
+}
+
+void shm_ring_config::validate() const {
+  if (name() == "") {
+    return;
+  }
+  // ... portable shared memory names start with a slash, and contain
+  // no other slashes ...
+  if (name().size() < 2 or name()[0] != '/' or
+      name().find('/', 1) != std::string::npos) {
+    std::ostringstream os;
+    os << "--name must be of the form '/name', value=" << name();
+    throw jb::usage(os.str(), 1);
+  }
+  if (slot_count() < 2 or (slot_count() & (slot_count() - 1)) != 0) {
+    std::ostringstream os;
+    os << "--slot-count must be a power of 2, value=" << slot_count();
+    throw jb::usage(os.str(), 1);
+  }
+  if (slot_size() < 64 or slot_size() > 65536 or slot_size() % 64 != 0) {
+    std::ostringstream os;
+    os << "--slot-size must be a multiple of 64 in the [64,65536] range"
+       << ", value=" << slot_size();
+    throw jb::usage(os.str(), 1);
+  }
+}
+
+} // namespace mktdata
+} // namespace jb
@@ -0,0 +1,31 @@
+#ifndef jb_mktdata_shm_ring_config_hpp
+#define jb_mktdata_shm_ring_config_hpp
+
+#include <jb/config_object.hpp>
+
+namespace jb {
+namespace mktdata {
+
+/**
+ * Configure a jb::mktdata::shm_ring_writer.
+ *
+ * The ring lives in a POSIX shared memory segment, named by
+ * @a name.  Readers attach to the segment using the same name.  An
+ * empty name disables the ring.
+ */
+class shm_ring_config : public jb::config_object {
+public:
+  shm_ring_config();
+  config_object_constructors(shm_ring_config);
+
+  void validate() const override;
+
+  jb::config_attribute<shm_ring_config, std::string> name;
+  jb::config_attribute<shm_ring_config, int> slot_count;
+  jb::config_attribute<shm_ring_config, int> slot_size;
+};
+
+} // namespace mktdata
+} // namespace jb
+
+#endif // jb_mktdata_shm_ring_config_hpp
@@ -0,0 +1,135 @@
+#include "jb/mktdata/shm_ring_reader.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace jb {
+namespace mktdata {
+
+shm_ring_reader::shm_ring_reader(std::string const& name)
+    : name_(name)
+    , mapped_size_(0)
+    , base_(nullptr)
+    , header_(nullptr)
+    , slots_(nullptr)
+    , slot_count_(0)
+    , slot_size_(0)
+    , next_(0)
+    , buffer_()
+    , messages_received_(0)
+    , overruns_(0)
+    , lost_messages_(0) {
+  int fd = ::shm_open(name_.c_str(), O_RDONLY, 0);
+  if (fd == -1) {
+    throw std::system_error(
+        errno, std::generic_category(),
+        "shm_ring_reader - opening segment " + name_);
+  }
+  struct ::stat st;
+  if (::fstat(fd, &st) == -1) {
+    int err = errno;
+    ::close(fd);
+    throw std::system_error(
+        err, std::generic_category(), "shm_ring_reader - fstat " + name_);
+  }
+  mapped_size_ = st.st_size;
+  if (mapped_size_ < detail::shm_ring_header_size) {
+    ::close(fd);
+    throw std::runtime_error(
+        "shm_ring_reader - segment " + name_ + " is too small");
+  }
+  void* base = ::mmap(nullptr, mapped_size_, PROT_READ, MAP_SHARED, fd, 0);
+  int err = errno;
+  ::close(fd);
+  if (base == MAP_FAILED) {
+    throw std::system_error(
+        err, std::generic_category(), "shm_ring_reader - mapping " + name_);
+  }
+  base_ = static_cast<char const*>(base);
+  header_ = reinterpret_cast<detail::shm_ring_header const*>(base_);
+  slots_ = base_ + detail::shm_ring_header_size;
+
+  std::ostringstream os;
+  if (header_->magic.load(std::memory_order_acquire) !=
+      detail::shm_ring_magic) {
+    os << "shm_ring_reader - segment " << name_ << " is not initialized";
+  } else if (header_->version != detail::shm_ring_version) {
+    os << "shm_ring_reader - segment " << name_ << " has version "
+       << header_->version << ", expected " << detail::shm_ring_version;
+  } else if (
+      header_->slot_count == 0 or
+      (header_->slot_count & (header_->slot_count - 1)) != 0 or
+      header_->slot_size <= sizeof(detail::shm_ring_slot) or
+      detail::shm_ring_header_size +
+              header_->slot_count * header_->slot_size >
+          mapped_size_) {
+    os << "shm_ring_reader - segment " << name_ << " has invalid geometry";
+  }
+  if (not os.str().empty()) {
+    ::munmap(const_cast<char*>(base_), mapped_size_);
+    throw std::runtime_error(os.str());
+  }
+  slot_count_ = header_->slot_count;
+  slot_size_ = header_->slot_size;
+  buffer_.resize(slot_size_ - sizeof(detail::shm_ring_slot));
+  next_ = header_->published.load(std::memory_order_acquire) + 1;
+}
+
+shm_ring_reader::~shm_ring_reader() {
+  ::munmap(const_cast<char*>(base_), mapped_size_);
+}
+
+char const* shm_ring_reader::read(std::size_t& msglen) {
+  while (true) {
+    auto published = header_->published.load(std::memory_order_acquire);
+    if (next_ > published) {
+      return nullptr;
+    }
+    if (published - next_ >= slot_count_) {
+      resync(published);
+    }
+    auto slot = reinterpret_cast<detail::shm_ring_slot const*>(
+        slots_ + (next_ & (slot_count_ - 1)) * slot_size_);
+    // ... the other half of the sequence lock in
+    // shm_ring_writer::publish() ...
+    auto before = slot->sequence_number.load(std::memory_order_acquire);
+    std::size_t size = slot->size;
+    if (before == next_ and size <= buffer_.size()) {
+      std::memcpy(buffer_.data(), slot + 1, size);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    auto after = slot->sequence_number.load(std::memory_order_relaxed);
+    if (before == next_ and after == next_ and size <= buffer_.size()) {
+      ++next_;
+      ++messages_received_;
+      msglen = size;
+      return buffer_.data();
+    }
+    // ... the writer overwrote the slot, the reader is too slow ...
+    resync(header_->published.load(std::memory_order_acquire));
+  }
+}
+
+void shm_ring_reader::resync(std::uint64_t published) {
+  // ... skip to the oldest message that is not being overwritten,
+  // leave a slot of margin, the writer may be modifying it right now
+  // ...
+  auto oldest = published < slot_count_ ? 1 : published - slot_count_ + 2;
+  if (oldest <= next_) {
+    oldest = next_ + 1;
+  }
+  ++overruns_;
+  lost_messages_ += oldest - next_;
+  next_ = oldest;
+}
+
+} // namespace mktdata
+} // namespace jb
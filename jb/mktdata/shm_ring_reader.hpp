@@ -0,0 +1,116 @@
+#ifndef jb_mktdata_shm_ring_reader_hpp
+#define jb_mktdata_shm_ring_reader_hpp
+
+#include <jb/mktdata/detail/shm_ring_layout.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace jb {
+namespace mktdata {
+
+/**
+ * Receive the messages published by a jb::mktdata::shm_ring_writer.
+ *
+ * The reader maps the shared memory segment read-only, and polls it
+ * for new messages.  Polling is cheap, a single load from a cache
+ * line shared with the writer, so applications typically spin on
+ * poll() in a dedicated thread.
+ *
+ * The writer never waits for the readers, a reader that falls behind
+ * by more than the size of the ring skips to the oldest message still
+ * in the ring, and counts the messages it lost.
+ *
+ * Each instance must be used by a single thread, use multiple
+ * instances to read the same ring from multiple threads.
+ */
+class shm_ring_reader {
+public:
+  /**
+   * Attach to the ring in the shared memory segment @a name.
+   *
+   * The reader starts with the next message published, messages
+   * published before the reader attached are not received.
+   *
+   * @throws std::system_error if the segment cannot be mapped
+   * @throws std::runtime_error if the segment does not contain a ring
+   */
+  explicit shm_ring_reader(std::string const& name);
+
+  /// Destructor, unmaps the segment
+  ~shm_ring_reader();
+
+  shm_ring_reader(shm_ring_reader const&) = delete;
+  shm_ring_reader& operator=(shm_ring_reader const&) = delete;
+
+  /**
+   * Read the next message.
+   *
+   * @returns a pointer to a copy of the message, valid until the next
+   * call, or nullptr if there are no new messages
+   * @param msglen set to the size of the message
+   */
+  char const* read(std::size_t& msglen);
+
+  /**
+   * Process up to @a max new messages.
+   *
+   * @param handler called with the message contents and size for each
+   * message
+   * @returns the number of messages processed
+   */
+  template <typename handler_t>
+  std::size_t poll(handler_t&& handler, std::size_t max = 64) {
+    std::size_t count = 0;
+    std::size_t msglen;
+    char const* msg;
+    while (count != max and (msg = read(msglen)) != nullptr) {
+      handler(msg, msglen);
+      ++count;
+    }
+    return count;
+  }
+
+  //@{
+  /**
+   * @name Accessors
+   */
+  std::uint64_t next_sequence_number() const {
+    return next_;
+  }
+  std::uint64_t messages_received() const {
+    return messages_received_;
+  }
+  std::uint64_t overruns() const {
+    return overruns_;
+  }
+  std::uint64_t lost_messages() const {
+    return lost_messages_;
+  }
+  //@}
+
+private:
+  /// Skip the messages already overwritten by the writer
+  void resync(std::uint64_t published);
+
+private:
+  std::string name_;
+  std::size_t mapped_size_;
+  char const* base_;
+  detail::shm_ring_header const* header_;
+  char const* slots_;
+  std::size_t slot_count_;
+  std::size_t slot_size_;
+  std::uint64_t next_;
+  std::vector<char> buffer_;
+
+  std::uint64_t messages_received_;
+  std::uint64_t overruns_;
+  std::uint64_t lost_messages_;
+};
+
+} // namespace mktdata
+} // namespace jb
+
+#endif // jb_mktdata_shm_ring_reader_hpp
@@ -0,0 +1,116 @@
+#include "jb/mktdata/shm_ring_writer.hpp"
+
+#include <jb/mktdata/message_header.hpp>
+#include <jb/log.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace jb {
+namespace mktdata {
+
+shm_ring_writer::shm_ring_writer(shm_ring_config const& cfg)
+    : name_(cfg.name())
+    , slot_count_(cfg.slot_count())
+    , slot_size_(cfg.slot_size())
+    , mapped_size_(detail::shm_ring_header_size + slot_count_ * slot_size_)
+    , base_(nullptr)
+    , header_(nullptr)
+    , slots_(nullptr)
+    , last_(0) {
+  cfg.validate();
+  if (name_ == "") {
+    throw std::invalid_argument("shm_ring_writer - empty segment name");
+  }
+  // ... always start with a new segment, readers attached to a stale
+  // segment (say from a previous run) would misinterpret the data
+  // otherwise ...
+  (void)::shm_unlink(name_.c_str());
+  int fd = ::shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd == -1) {
+    throw std::system_error(
+        errno, std::generic_category(),
+        "shm_ring_writer - creating segment " + name_);
+  }
+  if (::ftruncate(fd, mapped_size_) == -1) {
+    int err = errno;
+    ::close(fd);
+    (void)::shm_unlink(name_.c_str());
+    throw std::system_error(
+        err, std::generic_category(),
+        "shm_ring_writer - setting the size of " + name_);
+  }
+  void* base =
+      ::mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  int err = errno;
+  ::close(fd);
+  if (base == MAP_FAILED) {
+    (void)::shm_unlink(name_.c_str());
+    throw std::system_error(
+        err, std::generic_category(), "shm_ring_writer - mapping " + name_);
+  }
+  base_ = static_cast<char*>(base);
+  header_ = reinterpret_cast<detail::shm_ring_header*>(base_);
+  slots_ = base_ + detail::shm_ring_header_size;
+
+  // ... the segment is zero-filled by ftruncate(2), which is a valid
+  // initial state for the slots, only the header needs to be set,
+  // and the magic number must be the last field ...
+  header_->version = detail::shm_ring_version;
+  header_->slot_size = slot_size_;
+  header_->slot_count = slot_count_;
+  header_->published.store(0, std::memory_order_relaxed);
+  header_->magic.store(detail::shm_ring_magic, std::memory_order_release);
+  JB_LOG(info) << "shm_ring_writer: created " << name_
+               << ", slot_count=" << slot_count_
+               << ", slot_size=" << slot_size_;
+}
+
+shm_ring_writer::~shm_ring_writer() {
+  close();
+}
+
+std::uint64_t shm_ring_writer::publish(void const* msg, std::size_t msglen) {
+  if (msglen > max_message_size()) {
+    std::ostringstream os;
+    os << "shm_ring_writer::publish - message too large (" << msglen
+       << " bytes) for --slot-size=" << slot_size_;
+    throw std::invalid_argument(os.str());
+  }
+  auto n = ++last_;
+  auto slot = reinterpret_cast<detail::shm_ring_slot*>(
+      slots_ + (n & (slot_count_ - 1)) * slot_size_);
+  char* data = reinterpret_cast<char*>(slot + 1);
+  // ... this is a sequence lock, readers that observe the slot
+  // sequence number change while they copy the data discard the copy
+  // ...
+  slot->sequence_number.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot->size = static_cast<std::uint32_t>(msglen);
+  std::memcpy(data, msg, msglen);
+  if (msglen >= sizeof(message_header)) {
+    reinterpret_cast<message_header*>(data)->sequence_number =
+        static_cast<std::uint32_t>(n);
+  }
+  slot->sequence_number.store(n, std::memory_order_release);
+  header_->published.store(n, std::memory_order_release);
+  return n;
+}
+
+void shm_ring_writer::close() {
+  if (base_ != nullptr) {
+    ::munmap(base_, mapped_size_);
+    base_ = nullptr;
+    (void)::shm_unlink(name_.c_str());
+  }
+}
+
+} // namespace mktdata
+} // namespace jb
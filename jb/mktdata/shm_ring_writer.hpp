@@ -0,0 +1,95 @@
+#ifndef jb_mktdata_shm_ring_writer_hpp
+#define jb_mktdata_shm_ring_writer_hpp
+
+#include <jb/mktdata/detail/shm_ring_layout.hpp>
+#include <jb/mktdata/shm_ring_config.hpp>
+
+#include <cstdint>
+#include <string>
+
+namespace jb {
+namespace mktdata {
+
+/**
+ * Publish messages to co-located readers using a shared memory ring.
+ *
+ * Sending market data over UDP to processes in the same host goes
+ * through the kernel network stack for each message, and for each
+ * receiver.  This class stores the messages in a ring in a POSIX
+ * shared memory segment instead, any number of readers (see
+ * jb::mktdata::shm_ring_reader) can map the segment and poll it.
+ *
+ * The ring is a broadcast ring: the writer never waits for the
+ * readers.  Readers that fall behind by more than the size of the
+ * ring lose messages, and can detect the loss using the sequence
+ * numbers.
+ *
+ * There must be a single writer for each ring, the class is not
+ * thread-safe.  The writer creates a new segment, if a segment with
+ * the same name exists it is unlinked first, readers attached to the
+ * old segment must reattach.
+ */
+class shm_ring_writer {
+public:
+  /**
+   * Create the shared memory segment and initialize the ring.
+   *
+   * @throws std::system_error if the segment cannot be created
+   */
+  explicit shm_ring_writer(shm_ring_config const& cfg);
+
+  /// Destructor, unmaps and unlinks the segment
+  ~shm_ring_writer();
+
+  shm_ring_writer(shm_ring_writer const&) = delete;
+  shm_ring_writer& operator=(shm_ring_writer const&) = delete;
+
+  /**
+   * Publish a message.
+   *
+   * If the message starts with a jb::mktdata::message_header its
+   * sequence number is set in the copy stored in the ring, to the
+   * (truncated) number of the message in the ring.
+   *
+   * @param msg the message contents
+   * @param msglen the size of the message
+   * @returns the number of the message in the ring
+   * @throws std::invalid_argument if the message does not fit in a
+   * slot
+   */
+  std::uint64_t publish(void const* msg, std::size_t msglen);
+
+  /// The name of the shared memory segment
+  std::string const& name() const {
+    return name_;
+  }
+
+  /// The largest message that fits in a slot
+  std::size_t max_message_size() const {
+    return slot_size_ - sizeof(detail::shm_ring_slot);
+  }
+
+  /// The number of messages published
+  std::uint64_t published() const {
+    return last_;
+  }
+
+private:
+  /// Release the resources
+  void close();
+
+private:
+  std::string name_;
+  std::size_t slot_count_;
+  std::size_t slot_size_;
+  std::size_t mapped_size_;
+  char* base_;
+  detail::shm_ring_header* header_;
+  char* slots_;
+  std::uint64_t last_;
+};
+
+} // namespace mktdata
+} // namespace jb
+
+#endif // jb_mktdata_shm_ring_writer_hpp
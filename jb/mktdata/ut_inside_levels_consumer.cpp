@@ -0,0 +1,236 @@
+#include <jb/mktdata/inside_levels_consumer.hpp>
+#include <jb/itch5/make_socket_udp_recv.hpp>
+#include <jb/itch5/udp_batch_sender.hpp>
+#include <jb/itch5/udp_receiver_config.hpp>
+#include <jb/mktdata/batch_header.hpp>
+#include <jb/mktdata/message_header.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstring>
+#include <vector>
+
+namespace {
+/// Build datagrams in the format sent by the feed handlers
+class batch_builder {
+public:
+  batch_builder()
+      : buffer_(sizeof(jb::mktdata::batch_header))
+      , count_(0) {
+  }
+
+  /// Append an inside update
+  void add_inside(
+      std::uint32_t seqno, std::uint32_t security, std::uint32_t bid_px) {
+    jb::mktdata::inside_levels_update<1> msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.message_type = jb::mktdata::inside_levels_update<1>::mtype;
+    msg.message_size = sizeof(msg);
+    msg.sequence_number = seqno;
+    msg.security.id = security;
+    msg.bid_px[0] = bid_px;
+    add(&msg, sizeof(msg));
+  }
+
+  /// Append a raw message
+  void add(void const* msg, std::size_t msglen) {
+    auto p = static_cast<char const*>(msg);
+    buffer_.insert(buffer_.end(), p, p + msglen);
+    ++count_;
+  }
+
+  /// Finish the datagram and return it
+  std::vector<char> const& build() {
+    auto h = reinterpret_cast<jb::mktdata::batch_header*>(buffer_.data());
+    h->batch_size = buffer_.size();
+    h->message_count = count_;
+    h->sequence_number = 0;
+    return buffer_;
+  }
+
+private:
+  std::vector<char> buffer_;
+  std::uint16_t count_;
+};
+} // anonymous namespace
+
+/**
+ * @test Verify that jb::mktdata::inside_levels_consumer works as
+ * expected.
+ */
+BOOST_AUTO_TEST_CASE(mktdata_inside_levels_consumer_basic) {
+  std::vector<std::uint32_t> received;
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> gaps;
+  jb::mktdata::inside_levels_consumer consumer(
+      [&received](jb::mktdata::inside_levels_view const& v) {
+        received.push_back(v.sequence_number());
+      },
+      [&gaps](std::uint32_t expected, std::uint32_t seqno) {
+        gaps.emplace_back(expected, seqno);
+      });
+  BOOST_CHECK(consumer.last_inside(10) == nullptr);
+
+  batch_builder b0;
+  b0.add_inside(1, 10, 1000);
+  b0.add_inside(2, 20, 2000);
+  b0.add_inside(3, 10, 1001);
+  auto const& d0 = b0.build();
+  consumer.process_batch(d0.data(), d0.size());
+  BOOST_CHECK_EQUAL(received.size(), 3);
+  BOOST_CHECK_EQUAL(consumer.messages_received(), 3);
+  BOOST_CHECK_EQUAL(consumer.security_count(), 2);
+  BOOST_CHECK_EQUAL(consumer.expected_sequence_number(), 4);
+  BOOST_CHECK(gaps.empty());
+
+  // ... the cache has the last update for each security, and it is
+  // a copy of the message ...
+  auto const* last = consumer.last_inside(10);
+  BOOST_REQUIRE(last != nullptr);
+  BOOST_CHECK_EQUAL(last->bid_px(0), 1001);
+  BOOST_CHECK(last->data() != d0.data());
+
+  // ... a gap is reported, and the stale messages are discarded ...
+  batch_builder b1;
+  b1.add_inside(6, 10, 1002);
+  b1.add_inside(5, 10, 999);
+  b1.add_inside(7, 30, 3000);
+  auto const& d1 = b1.build();
+  consumer.process_batch(d1.data(), d1.size());
+  BOOST_REQUIRE_EQUAL(gaps.size(), 1);
+  BOOST_CHECK_EQUAL(gaps[0].first, 4);
+  BOOST_CHECK_EQUAL(gaps[0].second, 6);
+  BOOST_CHECK_EQUAL(consumer.gaps(), 1);
+  BOOST_CHECK_EQUAL(consumer.lost_messages(), 2);
+  BOOST_CHECK_EQUAL(consumer.stale_messages(), 1);
+  BOOST_CHECK_EQUAL(consumer.last_inside(10)->bid_px(0), 1002);
+  BOOST_CHECK_EQUAL(consumer.security_count(), 3);
+  std::vector<std::uint32_t> expected{1, 2, 3, 6, 7};
+  BOOST_CHECK_EQUAL_COLLECTIONS(
+      received.begin(), received.end(), expected.begin(), expected.end());
+}
+
+/**
+ * @test Verify that jb::mktdata::inside_levels_consumer handles the
+ * sequence number wrapping around.
+ */
+BOOST_AUTO_TEST_CASE(mktdata_inside_levels_consumer_wrap) {
+  int count = 0;
+  jb::mktdata::inside_levels_consumer consumer(
+      [&count](jb::mktdata::inside_levels_view const&) { ++count; });
+  batch_builder b;
+  b.add_inside(0xFFFFFFFE, 1, 1);
+  b.add_inside(0xFFFFFFFF, 1, 2);
+  b.add_inside(0, 1, 3);
+  b.add_inside(1, 1, 4);
+  auto const& d = b.build();
+  consumer.process_batch(d.data(), d.size());
+  BOOST_CHECK_EQUAL(count, 4);
+  BOOST_CHECK_EQUAL(consumer.gaps(), 0);
+  BOOST_CHECK_EQUAL(consumer.stale_messages(), 0);
+  BOOST_CHECK_EQUAL(consumer.last_inside(1)->bid_px(0), 4);
+}
+
+/**
+ * @test Verify that jb::mktdata::inside_levels_consumer discards
+ * invalid data.
+ */
+BOOST_AUTO_TEST_CASE(mktdata_inside_levels_consumer_errors) {
+  int count = 0;
+  jb::mktdata::inside_levels_consumer consumer(
+      [&count](jb::mktdata::inside_levels_view const&) { ++count; });
+
+  // ... too short for a header ...
+  char tiny[4] = {0};
+  consumer.process_batch(tiny, sizeof(tiny));
+  BOOST_CHECK_EQUAL(consumer.invalid_batches(), 1);
+
+  // ... the batch size does not match ...
+  batch_builder b0;
+  b0.add_inside(1, 1, 1);
+  auto d0 = b0.build();
+  consumer.process_batch(d0.data(), d0.size() - 1);
+  BOOST_CHECK_EQUAL(consumer.invalid_batches(), 2);
+
+  // ... unknown messages are skipped, invalid inside updates are
+  // counted ...
+  batch_builder b1;
+  jb::mktdata::message_header unknown;
+  unknown.message_type = 0x4242;
+  unknown.message_size = sizeof(unknown);
+  unknown.sequence_number = 1;
+  b1.add(&unknown, sizeof(unknown));
+  jb::mktdata::message_header bad;
+  bad.message_type = jb::mktdata::inside_levels_update<1>::mtype;
+  bad.message_size = sizeof(bad);
+  bad.sequence_number = 2;
+  b1.add(&bad, sizeof(bad));
+  b1.add_inside(3, 1, 1);
+  auto const& d1 = b1.build();
+  consumer.process_batch(d1.data(), d1.size());
+  BOOST_CHECK_EQUAL(consumer.unknown_messages(), 1);
+  BOOST_CHECK_EQUAL(consumer.invalid_messages(), 1);
+  BOOST_CHECK_EQUAL(count, 1);
+
+  // ... a message that overflows the datagram invalidates the rest
+  // of it ...
+  batch_builder b2;
+  jb::mktdata::message_header overflow;
+  overflow.message_type = 0x4242;
+  overflow.message_size = 200;
+  overflow.sequence_number = 4;
+  b2.add(&overflow, sizeof(overflow));
+  b2.add_inside(5, 1, 1);
+  auto const& d2 = b2.build();
+  consumer.process_batch(d2.data(), d2.size());
+  BOOST_CHECK_EQUAL(consumer.invalid_batches(), 3);
+  BOOST_CHECK_EQUAL(count, 1);
+  BOOST_CHECK_EQUAL(consumer.batches_received(), 4);
+}
+
+/**
+ * @test Verify that jb::mktdata::inside_levels_consumer processes the
+ * bare messages sent by a feed handler that does not batch its
+ * output.
+ */
+BOOST_AUTO_TEST_CASE(mktdata_inside_levels_consumer_unbatched) {
+  std::vector<std::uint32_t> received;
+  jb::mktdata::inside_levels_consumer consumer(
+      [&received](jb::mktdata::inside_levels_view const& v) {
+        received.push_back(v.bid_px(0));
+      });
+
+  boost::asio::io_service io;
+  auto socket = jb::itch5::make_socket_udp_recv(
+      io, jb::itch5::udp_receiver_config().address("127.0.0.1").port(50110));
+  jb::itch5::udp_batch_sender sender(
+      io, {jb::itch5::udp_sender_config().address("127.0.0.1").port(50110)},
+      jb::itch5::udp_batch_sender_config().flush_deadline_microseconds(0));
+
+  jb::mktdata::inside_levels_update<1> msg;
+  std::memset(&msg, 0, sizeof(msg));
+  msg.message_type = jb::mktdata::inside_levels_update<1>::mtype;
+  msg.message_size = sizeof(msg);
+  msg.security.id = 10;
+  for (std::uint32_t px : {1000, 1001}) {
+    msg.bid_px[0] = px;
+    sender.append(&msg, sizeof(msg));
+  }
+
+  char buffer[1 << 16];
+  for (int i = 0; i != 2; ++i) {
+    auto n = socket.receive(boost::asio::buffer(buffer, sizeof(buffer)));
+    BOOST_CHECK_EQUAL(n, sizeof(msg));
+    consumer.process_message(buffer, n);
+  }
+  std::vector<std::uint32_t> expected{1000, 1001};
+  BOOST_CHECK_EQUAL_COLLECTIONS(
+      received.begin(), received.end(), expected.begin(), expected.end());
+  BOOST_CHECK_EQUAL(consumer.expected_sequence_number(), 3);
+  BOOST_CHECK_EQUAL(consumer.last_inside(10)->bid_px(0), 1001);
+
+  // ... truncated datagrams are invalid messages ...
+  consumer.process_message(buffer, sizeof(msg) - 1);
+  consumer.process_message(buffer, 4);
+  BOOST_CHECK_EQUAL(consumer.invalid_messages(), 2);
+  BOOST_CHECK_EQUAL(received.size(), 2);
+}
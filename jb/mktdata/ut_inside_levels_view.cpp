@@ -0,0 +1,128 @@
+#include <jb/mktdata/inside_levels_view.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+/// Create a message with N levels and distinct values in each field
+template <std::size_t N>
+jb::mktdata::inside_levels_update<N> create_message() {
+  jb::mktdata::inside_levels_update<N> msg;
+  std::memset(&msg, ' ', sizeof(msg));
+  msg.message_type = jb::mktdata::inside_levels_update<N>::mtype;
+  msg.message_size = sizeof(msg);
+  msg.sequence_number = 7;
+  msg.market.id = 1;
+  msg.feed.id = 2;
+  msg.feedhandler_ts.nanos = 3;
+  msg.source.id = 4;
+  msg.exchange_ts.nanos = 5;
+  msg.feed_ts.nanos = 6;
+  msg.security.id = 42;
+  for (std::size_t i = 0; i != N; ++i) {
+    msg.bid_qty[i] = 100 * (i + 1);
+    msg.bid_px[i] = 1000 - i;
+    msg.offer_qty[i] = 200 * (i + 1);
+    msg.offer_px[i] = 1001 + i;
+  }
+  std::memcpy(msg.annotations.security_feed, "HSART", 5);
+  return msg;
+}
+} // anonymous namespace
+
+/**
+ * @test Verify that jb::mktdata::inside_levels_view works as expected.
+ */
+BOOST_AUTO_TEST_CASE(mktdata_inside_levels_view_basic) {
+  auto msg = create_message<4>();
+  char const* buf = reinterpret_cast<char const*>(&msg);
+  jb::mktdata::inside_levels_view view(buf, sizeof(msg));
+  BOOST_CHECK_EQUAL(view.data(), buf);
+  BOOST_CHECK_EQUAL(view.levels(), 4);
+  BOOST_CHECK_EQUAL(view.message_type(), msg.message_type.value());
+  BOOST_CHECK_EQUAL(view.message_size(), sizeof(msg));
+  BOOST_CHECK_EQUAL(view.sequence_number(), 7);
+  BOOST_CHECK_EQUAL(view.market_id(), 1);
+  BOOST_CHECK_EQUAL(view.feed_id(), 2);
+  BOOST_CHECK_EQUAL(view.feedhandler_ts(), 3);
+  BOOST_CHECK_EQUAL(view.source_id(), 4);
+  BOOST_CHECK_EQUAL(view.exchange_ts(), 5);
+  BOOST_CHECK_EQUAL(view.feed_ts(), 6);
+  BOOST_CHECK_EQUAL(view.security_id(), 42);
+  for (std::size_t i = 0; i != 4; ++i) {
+    BOOST_CHECK_EQUAL(view.bid_qty(i), 100 * (i + 1));
+    BOOST_CHECK_EQUAL(view.bid_px(i), 1000 - i);
+    BOOST_CHECK_EQUAL(view.offer_qty(i), 200 * (i + 1));
+    BOOST_CHECK_EQUAL(view.offer_px(i), 1001 + i);
+  }
+  BOOST_CHECK(view.has_annotations());
+  BOOST_CHECK_EQUAL(view.security_feed(), "HSART");
+
+  // ... the view does not copy the message ...
+  msg.bid_px[3] = 1;
+  BOOST_CHECK_EQUAL(view.bid_px(3), 1);
+}
+
+/**
+ * @test Verify that jb::mktdata::inside_levels_view handles all the
+ * supported levels and messages without annotations.
+ */
+BOOST_AUTO_TEST_CASE(mktdata_inside_levels_view_levels) {
+  auto m1 = create_message<1>();
+  jb::mktdata::inside_levels_view v1(
+      reinterpret_cast<char const*>(&m1), sizeof(m1));
+  BOOST_CHECK_EQUAL(v1.levels(), 1);
+  BOOST_CHECK_EQUAL(v1.offer_px(0), 1001);
+
+  auto m8 = create_message<8>();
+  jb::mktdata::inside_levels_view v8(
+      reinterpret_cast<char const*>(&m8), sizeof(m8));
+  BOOST_CHECK_EQUAL(v8.levels(), 8);
+  BOOST_CHECK_EQUAL(v8.offer_px(7), 1008);
+  BOOST_CHECK_EQUAL(v8.security_feed(), "HSART");
+
+  // ... without annotations ...
+  std::size_t const short_size = sizeof(m8) - sizeof(m8.annotations);
+  m8.message_size = short_size;
+  jb::mktdata::inside_levels_view s8(
+      reinterpret_cast<char const*>(&m8), short_size);
+  BOOST_CHECK(not s8.has_annotations());
+  BOOST_CHECK_EQUAL(s8.security_feed(), "");
+  BOOST_CHECK_EQUAL(s8.bid_qty(7), 800);
+}
+
+/**
+ * @test Verify that jb::mktdata::inside_levels_view rejects invalid
+ * messages.
+ */
+BOOST_AUTO_TEST_CASE(mktdata_inside_levels_view_errors) {
+  auto msg = create_message<4>();
+  char const* buf = reinterpret_cast<char const*>(&msg);
+  jb::mktdata::inside_levels_view view;
+
+  BOOST_CHECK(not jb::mktdata::inside_levels_view::parse(buf, 4, view));
+  BOOST_CHECK_THROW(
+      jb::mktdata::inside_levels_view(buf, sizeof(msg) - 1),
+      std::runtime_error);
+
+  msg.message_size = sizeof(msg) - sizeof(msg.annotations) - 1;
+  BOOST_CHECK(
+      not jb::mktdata::inside_levels_view::parse(buf, sizeof(msg), view));
+  msg.message_size = sizeof(msg) + 1;
+  BOOST_CHECK(
+      not jb::mktdata::inside_levels_view::parse(buf, sizeof(msg) + 1, view));
+
+  msg.message_size = sizeof(msg);
+  msg.message_type = 0x4242;
+  BOOST_CHECK(
+      not jb::mktdata::inside_levels_view::parse(buf, sizeof(msg), view));
+  BOOST_CHECK_THROW(
+      jb::mktdata::inside_levels_view(buf, sizeof(msg)), std::runtime_error);
+
+  BOOST_CHECK(jb::mktdata::inside_levels_view::is_inside_levels_update(
+      jb::mktdata::inside_levels_update<8>::mtype));
+  BOOST_CHECK(not jb::mktdata::inside_levels_view::is_inside_levels_update(
+      0x4242));
+}
@@ -0,0 +1,143 @@
+#include <jb/mktdata/message_header.hpp>
+#include <jb/mktdata/shm_ring_reader.hpp>
+#include <jb/mktdata/shm_ring_writer.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+/// Use a different segment name for each test process
+std::string segment_name() {
+  return "/jb-ut-shm-ring-" + std::to_string(::getpid());
+}
+
+/// A small message with the JayBeams header
+struct test_message {
+  jb::mktdata::message_header header;
+  boost::endian::little_uint32_buf_t value;
+};
+
+test_message create_message(std::uint32_t value) {
+  test_message msg;
+  msg.header.message_type = 0x4242;
+  msg.header.message_size = sizeof(msg);
+  msg.header.sequence_number = 0;
+  msg.value = value;
+  return msg;
+}
+
+/// Read all the available messages and return their values
+std::vector<std::uint32_t> read_all(jb::mktdata::shm_ring_reader& reader) {
+  std::vector<std::uint32_t> values;
+  reader.poll(
+      [&values](char const* buf, std::size_t len) {
+        BOOST_REQUIRE_EQUAL(len, sizeof(test_message));
+        test_message msg;
+        std::memcpy(&msg, buf, sizeof(msg));
+        // ... the tests use the message number minus one as value ...
+        BOOST_CHECK_EQUAL(
+            msg.header.sequence_number.value(), msg.value.value() + 1);
+        values.push_back(msg.value.value());
+      },
+      1000);
+  return values;
+}
+} // anonymous namespace
+
+/**
+ * @test Verify that jb::mktdata::shm_ring_writer and
+ * jb::mktdata::shm_ring_reader work as expected.
+ */
+BOOST_AUTO_TEST_CASE(mktdata_shm_ring_basic) {
+  auto cfg = jb::mktdata::shm_ring_config()
+                 .name(segment_name())
+                 .slot_count(8)
+                 .slot_size(64);
+  jb::mktdata::shm_ring_writer writer(cfg);
+  BOOST_CHECK_EQUAL(writer.max_message_size(), 48);
+
+  // ... messages published before the reader attached are not
+  // received ...
+  auto msg = create_message(0);
+  BOOST_CHECK_EQUAL(writer.publish(&msg, sizeof(msg)), 1);
+
+  jb::mktdata::shm_ring_reader r0(cfg.name());
+  jb::mktdata::shm_ring_reader r1(cfg.name());
+  std::size_t len;
+  BOOST_CHECK(r0.read(len) == nullptr);
+  BOOST_CHECK_EQUAL(r0.next_sequence_number(), 2);
+
+  for (std::uint32_t i = 1; i != 4; ++i) {
+    msg = create_message(i);
+    writer.publish(&msg, sizeof(msg));
+  }
+
+  // ... each reader receives all the messages ...
+  std::vector<std::uint32_t> expected{1, 2, 3};
+  for (auto* r : {&r0, &r1}) {
+    auto values = read_all(*r);
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        values.begin(), values.end(), expected.begin(), expected.end());
+    BOOST_CHECK_EQUAL(r->messages_received(), 3);
+    BOOST_CHECK_EQUAL(r->lost_messages(), 0);
+    BOOST_CHECK(r->read(len) == nullptr);
+  }
+
+  char large[64] = {0};
+  BOOST_CHECK_THROW(
+      writer.publish(large, sizeof(large)), std::invalid_argument);
+}
+
+/**
+ * @test Verify that jb::mktdata::shm_ring_reader detects overruns.
+ */
+BOOST_AUTO_TEST_CASE(mktdata_shm_ring_overrun) {
+  auto cfg = jb::mktdata::shm_ring_config()
+                 .name(segment_name())
+                 .slot_count(8)
+                 .slot_size(64);
+  jb::mktdata::shm_ring_writer writer(cfg);
+  jb::mktdata::shm_ring_reader reader(cfg.name());
+
+  for (std::uint32_t i = 0; i != 20; ++i) {
+    auto msg = create_message(i);
+    writer.publish(&msg, sizeof(msg));
+  }
+  auto values = read_all(reader);
+  // ... the reader skips to the oldest message that is safe to read
+  // ...
+  BOOST_CHECK_EQUAL(reader.overruns(), 1);
+  BOOST_CHECK_EQUAL(reader.lost_messages(), 13);
+  BOOST_CHECK_EQUAL(reader.messages_received(), 7);
+  BOOST_REQUIRE(not values.empty());
+  BOOST_CHECK_EQUAL(values.front(), 13);
+  BOOST_CHECK_EQUAL(values.back(), 19);
+}
+
+/**
+ * @test Verify that jb::mktdata::shm_ring_reader reports errors.
+ */
+BOOST_AUTO_TEST_CASE(mktdata_shm_ring_errors) {
+  BOOST_CHECK_THROW(
+      jb::mktdata::shm_ring_reader("/jb-ut-shm-ring-does-not-exist"),
+      std::system_error);
+  BOOST_CHECK_THROW(
+      jb::mktdata::shm_ring_writer(jb::mktdata::shm_ring_config()),
+      std::invalid_argument);
+
+  // ... the segment is removed when the writer is destroyed ...
+  auto cfg = jb::mktdata::shm_ring_config().name(segment_name());
+  {
+    jb::mktdata::shm_ring_writer writer(cfg);
+    BOOST_CHECK_NO_THROW(jb::mktdata::shm_ring_reader r(cfg.name()));
+  }
+  BOOST_CHECK_THROW(
+      jb::mktdata::shm_ring_reader(cfg.name()), std::system_error);
+}
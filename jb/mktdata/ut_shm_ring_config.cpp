@@ -0,0 +1,28 @@
+#include <jb/mktdata/shm_ring_config.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+/**
+ * @test Verify that jb::mktdata::shm_ring_config validation works as
+ * expected.
+ */
+BOOST_AUTO_TEST_CASE(mktdata_shm_ring_config_validate) {
+  using config = jb::mktdata::shm_ring_config;
+
+  BOOST_CHECK_NO_THROW(config().validate());
+  BOOST_CHECK_NO_THROW(config().name("/jb-test").validate());
+  // ... a disabled ring is not validated ...
+  BOOST_CHECK_NO_THROW(config().slot_count(3).validate());
+
+  BOOST_CHECK_THROW(config().name("jb-test").validate(), jb::usage);
+  BOOST_CHECK_THROW(config().name("/").validate(), jb::usage);
+  BOOST_CHECK_THROW(config().name("/jb/test").validate(), jb::usage);
+
+  config c = config().name("/jb-test");
+  BOOST_CHECK_THROW(config(c).slot_count(1000).validate(), jb::usage);
+  BOOST_CHECK_THROW(config(c).slot_count(1).validate(), jb::usage);
+  BOOST_CHECK_THROW(config(c).slot_size(100).validate(), jb::usage);
+  BOOST_CHECK_THROW(config(c).slot_size(0).validate(), jb::usage);
+  BOOST_CHECK_THROW(config(c).slot_size(1 << 17).validate(), jb::usage);
+  BOOST_CHECK_NO_THROW(config(c).slot_count(16).slot_size(64).validate());
+}
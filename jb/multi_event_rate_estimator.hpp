@@ -0,0 +1,207 @@
+#ifndef jb_multi_event_rate_estimator_hpp
+#define jb_multi_event_rate_estimator_hpp
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace jb {
+
+/**
+ * Estimate event rates over several trailing measurement periods.
+ *
+ * This class computes the same estimates as a jb::event_rate_estimator
+ * for each one of several (measurement period, sampling period)
+ * pairs, for example, events per second sampled every millisecond,
+ * and events per microsecond sampled every nanosecond.  All the
+ * resolutions share a single pass over the events and a single event
+ * counter.
+ *
+ * jb::event_rate_estimator keeps one counter per sampling period in
+ * the measurement period, and when an event arrives after a gap it
+ * rotates the counters once per elapsed sampling period until the
+ * buffer is empty.  With a fine sampling period (say 1 nanosecond)
+ * that is hundreds of iterations for every event in a burst.
+ *
+ * Instead, each resolution keeps only the sampling periods that have
+ * events, together with the value of the (shared) event counter when
+ * the sampling period started, that is, a prefix sum.  The number of
+ * events in the measurement period is the difference between the
+ * current counter and the prefix sum of the oldest sampling period
+ * still in the window.  That estimate only changes when a sampling
+ * period with events leaves the window, so after a gap the class
+ * emits one update for each run of identical estimates.  Each
+ * sampling period with events is added and removed once, so the cost
+ * is O(1) amortized per event, regardless of the length of the gap.
+ *
+ * The @a update() functor receives the index of the resolution, the
+ * estimated rate, and how many consecutive sampling periods had that
+ * estimate.  Consecutive updates may repeat the same rate, a
+ * histogram of the estimates is identical to the histogram built with
+ * jb::event_rate_estimator.
+ *
+ * @tparam duration_t Defines class used to measure time, this
+ *   class must be compatible with std::chrono::duration_type.  See
+ *   jb::event_rate_estimator for details.
+ */
+template <typename duration_t = std::chrono::microseconds>
+class multi_event_rate_estimator {
+public:
+  //@{
+  /**
+   * @name Type traits.
+   */
+  typedef duration_t duration_type;
+  typedef std::pair<duration_type, duration_type> resolution;
+  //@}
+
+  /**
+   * Build an accumulator to estimate event rates at several
+   * resolutions.
+   *
+   * @param resolutions the measurement period and sampling period for
+   *   each estimate
+   * @throw std::invalid_argument if any measurement period is not a
+   *   multiple of its sampling period.
+   */
+  explicit multi_event_rate_estimator(
+      std::vector<resolution> const& resolutions)
+      : levels_()
+      , count_(0) {
+    levels_.reserve(resolutions.size());
+    for (auto const& r : resolutions) {
+      levels_.emplace_back(r.first, r.second);
+    }
+  }
+
+  /// The number of resolutions
+  std::size_t size() const {
+    return levels_.size();
+  }
+
+  /**
+   * Record a sample.
+   *
+   * @param ts the timestamp of the sample.
+   * @param update a functor to update when an event rate is
+   *   estimated, the signature must be compatible with
+   *   void(std::size_t index, std::uint64_t rate, std::uint64_t repeats)
+   */
+  template <typename functor>
+  void sample(duration_type ts, functor&& update) {
+    if (count_ == 0) {
+      // ... this is the first event sample, there is no rate with a
+      // single sample ...
+      for (auto& l : levels_) {
+        l.last_bucket = ts / l.sampling_period;
+        l.window.push_back(bucket{l.last_bucket, count_});
+      }
+      ++count_;
+      return;
+    }
+    for (std::size_t i = 0; i != levels_.size(); ++i) {
+      auto& l = levels_[i];
+      auto b = ts / l.sampling_period;
+      if (b <= l.last_bucket) {
+        // ... a new sample in the same sampling period, the shared
+        // counter is all we need to update ...
+        continue;
+      }
+      advance(i, l, b, update);
+      l.window.push_back(bucket{b, count_});
+    }
+    ++count_;
+  }
+
+private:
+  typedef typename duration_type::rep rep;
+
+  /// A sampling period with at least one event
+  struct bucket {
+    rep id;
+    std::uint64_t start;
+  };
+
+  /// The state for each resolution
+  struct level {
+    level(duration_type measurement, duration_type sampling)
+        : sampling_period(sampling)
+        , bucket_count(bucket_count_for(measurement, sampling))
+        , last_bucket(0)
+        , window() {
+    }
+
+    duration_type sampling_period;
+    rep bucket_count;
+    rep last_bucket;
+    std::deque<bucket> window;
+  };
+
+  /**
+   * Emit the estimates for all the sampling periods before @a b.
+   */
+  template <typename functor>
+  void advance(std::size_t index, level& l, rep b, functor& update) {
+    auto current = l.last_bucket;
+    while (current < b) {
+      // ... discard the sampling periods that have left the window ...
+      while (not l.window.empty() and
+             l.window.front().id + l.bucket_count <= current) {
+        l.window.pop_front();
+      }
+      if (l.window.empty()) {
+        update(index, std::uint64_t(0), std::uint64_t(b - current));
+        break;
+      }
+      // ... the estimate does not change until the oldest sampling
+      // period with events leaves the window ...
+      auto const& oldest = l.window.front();
+      auto next = std::min(b, oldest.id + l.bucket_count);
+      update(index, count_ - oldest.start, std::uint64_t(next - current));
+      current = next;
+    }
+    l.last_bucket = b;
+  }
+
+  /// Validate a resolution and return the number of sampling periods
+  static rep bucket_count_for(
+      duration_type measurement_period, duration_type sampling_period) {
+    if (sampling_period <= duration_type(0)) {
+      std::ostringstream os;
+      os << "jb::multi_event_rate_estimator - sampling period ("
+         << sampling_period.count() << ") must be a positive number";
+      throw std::invalid_argument(os.str());
+    }
+    if (sampling_period > measurement_period) {
+      std::ostringstream os;
+      os << "jb::multi_event_rate_estimator - measurement period ("
+         << measurement_period.count() << ") is smaller than sampling period ("
+         << sampling_period.count() << ")";
+      throw std::invalid_argument(os.str());
+    }
+    if ((measurement_period % sampling_period).count() != 0) {
+      std::ostringstream os;
+      os << "jb::multi_event_rate_estimator - measurement period ("
+         << measurement_period.count()
+         << ") must be a multiple of the sampling period ("
+         << sampling_period.count() << ")";
+      throw std::invalid_argument(os.str());
+    }
+    return measurement_period / sampling_period;
+  }
+
+private:
+  std::vector<level> levels_;
+
+  /// The number of events, the prefix sums are relative to this counter
+  std::uint64_t count_;
+};
+
+} // namespace jb
+
+#endif // jb_multi_event_rate_estimator_hpp
@@ -0,0 +1,145 @@
+#ifndef jb_observed_rate_histogram_hpp
+#define jb_observed_rate_histogram_hpp
+
+#include <jb/histogram.hpp>
+#include <jb/log_linear_binning.hpp>
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+namespace jb {
+
+/**
+ * Keep a histogram of event rates estimated elsewhere.
+ *
+ * This class keeps the tally of observed event rates and the last
+ * rate reported, but not the estimator that computes them.  It is
+ * used by jb::event_rate_histogram, which owns its own estimator, and
+ * by components that estimate the rates at several resolutions with a
+ * single jb::multi_event_rate_estimator.
+ *
+ * @tparam counter_type The type used in the histogram counters.
+ */
+template <typename counter_type = int>
+class observed_rate_histogram
+    : private histogram<log_linear_binning<std::uint64_t>, counter_type> {
+public:
+  //@{
+  /**
+   * @name Type traits.
+   */
+  typedef log_linear_binning<std::uint64_t> binning_strategy;
+  typedef histogram<binning_strategy, counter_type> rate_histogram;
+  //@}
+
+  /**
+   * Constructor.
+   *
+   * @param max_expected_rate The histogram is kept at full resolution
+   *   up to this rate, any periods with more events are counted only
+   *   in the overflow bin.
+   * @param significant_digits the precision of the histogram, 0 means
+   *   one bin for each rate value.
+   */
+  explicit observed_rate_histogram(
+      std::uint64_t max_expected_rate, int significant_digits = 0)
+      : rate_histogram(binning_strategy(
+            0, max_expected_rate,
+            significant_digits != 0
+                ? significant_digits
+                : binning_strategy::linear_digits(0, max_expected_rate)))
+      , last_rate_(0) {
+  }
+
+  /**
+   * Record an estimated rate.
+   *
+   * @param rate the number of events in the measurement period
+   * @param repeats the number of consecutive sampling periods where
+   *   the estimate had this value
+   */
+  void record(std::uint64_t rate, std::uint64_t repeats = 1) {
+    last_rate_ = rate;
+    rate_histogram::weighted_sample(rate, repeats);
+  }
+
+  /// Get the last sample, if any.
+  std::uint64_t last_rate() const {
+    if (nsamples() == 0) {
+      throw std::invalid_argument("No sample recorded yet");
+    }
+    return last_rate_;
+  }
+
+  /**
+   * Add the rates observed by another histogram.
+   *
+   * Use this to combine the statistics for disjoint streams of
+   * events, for example, one per input file or per day.  Both objects
+   * should measure rates over the same periods.
+   *
+   * @throw std::invalid_argument if the histograms have different bins
+   */
+  void merge(observed_rate_histogram const& rhs) {
+    if (nsamples() == 0) {
+      last_rate_ = rhs.last_rate_;
+    }
+    rate_histogram::merge(rhs);
+  }
+
+  /// Add the rates observed by another object, see merge()
+  observed_rate_histogram& operator+=(observed_rate_histogram const& rhs) {
+    merge(rhs);
+    return *this;
+  }
+
+  /**
+   * Append a compact binary representation of the rate histogram.
+   *
+   * @code
+   * observed_rate_histogram := histogram varint(last_rate)
+   * @endcode
+   *
+   * See jb::histogram::encode() for details.
+   */
+  void encode(std::string& buffer) const {
+    rate_histogram::encode(buffer);
+    metrics::binary::put_varint(buffer, last_rate_);
+  }
+
+  /**
+   * Decode an object created by encode() and merge its rates.
+   *
+   * @throw std::runtime_error if the encoded data is malformed or
+   * has different bins
+   */
+  void merge_encoded(metrics::binary::reader& r) {
+    bool const empty = nsamples() == 0;
+    rate_histogram::merge_encoded(r);
+    auto last_rate = r.varint();
+    if (empty) {
+      last_rate_ = last_rate;
+    }
+  }
+
+  //@{
+  /**
+   * @name Histogram accessors.
+   */
+  using rate_histogram::nsamples;
+  using rate_histogram::observed_min;
+  using rate_histogram::observed_max;
+  using rate_histogram::estimated_mean;
+  using rate_histogram::estimated_quantile;
+  using rate_histogram::overflow_count;
+  using rate_histogram::underflow_count;
+  //@}
+
+private:
+  std::uint64_t last_rate_;
+};
+
+} // namespace jb
+
+#endif // jb_observed_rate_histogram_hpp
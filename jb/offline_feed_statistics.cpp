@@ -3,6 +3,7 @@
 #include <jb/as_hhmmss.hpp>
 #include <jb/log.hpp>
 
+#include <algorithm>
 #include <iostream>
 
 namespace {
@@ -143,40 +144,48 @@ void report_latency(
 }
 
 /**
- * Print a summary of latency measurements in CSV form
+ * Compute the number of significant digits for a latency histogram.
  *
- * @param os the output stream where the CSV line is printed
- * @param histo the histogram that has captured the latencies
+ * @param digits the configured number of significant digits, 0 means
+ * one bin per nanosecond
+ * @param h_max the maximum value for the histogram
  *
- * @tparam the type of histogram used, typical an instantiation of
- * jb::histogram<> where the samples are nanoseconds
+ * @tparam histogram_t the type of histogram, typically an
+ * instantiation of jb::histogram<jb::log_linear_binning<>>
  */
-template <typename latency_histogram_t>
-void csv_latency(std::ostream& os, latency_histogram_t const& histo) {
-  os << "," << histo.observed_min() << "," << histo.estimated_quantile(0.10)
-     << "," << histo.estimated_quantile(0.25) << ","
-     << histo.estimated_quantile(0.50) << "," << histo.estimated_quantile(0.75)
-     << "," << histo.estimated_quantile(0.90) << ","
-     << histo.estimated_quantile(0.99) << "," << histo.estimated_quantile(0.999)
-     << "," << histo.estimated_quantile(0.9999) << "," << histo.observed_max();
+template <typename histogram_t>
+int latency_digits(int digits, typename histogram_t::sample_type h_max) {
+  if (digits != 0) {
+    return digits;
+  }
+  return histogram_t::binning_strategy::linear_digits(0, h_max);
 }
 
 } // anonymous namespace
 
 jb::offline_feed_statistics::offline_feed_statistics(config const& cfg)
-    : per_sec_rate_(
-          cfg.max_messages_per_second(), std::chrono::seconds(1),
-          std::chrono::milliseconds(1))
+    : per_sec_rate_(cfg.max_messages_per_second(), cfg.significant_digits())
     , per_msec_rate_(
-          cfg.max_messages_per_millisecond(), std::chrono::milliseconds(1),
-          std::chrono::microseconds(1))
+          cfg.max_messages_per_millisecond(), cfg.significant_digits())
     , per_usec_rate_(
-          cfg.max_messages_per_microsecond(), std::chrono::microseconds(1),
-          std::chrono::nanoseconds(1))
-    , interarrival_(interarrival_histogram_t::binning_strategy(
-          0, cfg.max_interarrival_time_nanoseconds()))
-    , processing_latency_(processing_latency_histogram_t::binning_strategy(
-          0, cfg.max_processing_latency_nanoseconds()))
+          cfg.max_messages_per_microsecond(), cfg.significant_digits())
+    , rates_({{std::chrono::seconds(1), std::chrono::milliseconds(1)},
+              {std::chrono::milliseconds(1), std::chrono::microseconds(1)},
+              {std::chrono::microseconds(1), std::chrono::nanoseconds(1)}})
+    , interarrival_(
+          cfg.interarrival_sketch_k(),
+          interarrival_histogram_t::binning_strategy(
+              0, cfg.max_interarrival_time_nanoseconds(),
+              latency_digits<interarrival_histogram_t>(
+                  cfg.significant_digits(),
+                  cfg.max_interarrival_time_nanoseconds())))
+    , processing_latency_(
+          cfg.processing_latency_sketch_k(),
+          processing_latency_histogram_t::binning_strategy(
+              0, cfg.max_processing_latency_nanoseconds(),
+              latency_digits<processing_latency_histogram_t>(
+                  cfg.significant_digits(),
+                  cfg.max_processing_latency_nanoseconds())))
     , reporting_interval_(
           std::chrono::seconds(cfg.reporting_interval_seconds()))
     , last_ts_(0)
@@ -224,10 +233,21 @@ void jb::offline_feed_statistics::log_progress(
 void jb::offline_feed_statistics::record_sample(
     std::chrono::nanoseconds ts, std::chrono::nanoseconds pl) {
   // ... first record the sample in the per-second, per-millisecond,
-  // and per-microsecond histograms ...
-  per_sec_rate_.sample(ts);
-  per_msec_rate_.sample(ts);
-  per_usec_rate_.sample(ts);
+  // and per-microsecond histograms, the estimator computes all of
+  // them in a single pass ...
+  rates_.sample(
+      ts, [this](std::size_t index, std::uint64_t rate, std::uint64_t n) {
+        switch (index) {
+        case 0:
+          per_sec_rate_.record(rate, n);
+          break;
+        case 1:
+          per_msec_rate_.record(rate, n);
+          break;
+        default:
+          per_usec_rate_.record(rate, n);
+        }
+      });
 
   // ... we need at least two samples to start recording interrival
   // times, check if there was a previous sample
@@ -270,10 +290,54 @@ void jb::offline_feed_statistics::print_csv(
   csv_rate(os, per_msec_rate_);
   csv_rate(os, per_usec_rate_);
   csv_arrival(os, interarrival_);
-  csv_latency(os, processing_latency_);
+  jb::detail::csv_latency(os, processing_latency_);
   os << std::endl;
 }
 
+void jb::offline_feed_statistics::merge(offline_feed_statistics const& rhs) {
+  // ... merge into a copy, if any metric is incompatible (e.g. a
+  // histogram and a sketch) this object is left unchanged ...
+  offline_feed_statistics merged(*this);
+  merged.per_sec_rate_.merge(rhs.per_sec_rate_);
+  merged.per_msec_rate_.merge(rhs.per_msec_rate_);
+  merged.per_usec_rate_.merge(rhs.per_usec_rate_);
+  merged.interarrival_.merge(rhs.interarrival_);
+  merged.processing_latency_.merge(rhs.processing_latency_);
+  merged.last_ts_ = std::max(last_ts_, rhs.last_ts_);
+  merged.last_report_ts_ = std::max(last_report_ts_, rhs.last_report_ts_);
+  *this = std::move(merged);
+}
+
+void jb::offline_feed_statistics::encode(std::string& buffer) const {
+  buffer.push_back(static_cast<char>(encoding_version));
+  per_sec_rate_.encode(buffer);
+  per_msec_rate_.encode(buffer);
+  per_usec_rate_.encode(buffer);
+  interarrival_.encode(buffer);
+  processing_latency_.encode(buffer);
+  metrics::binary::put_zigzag(buffer, last_ts_.count());
+}
+
+void jb::offline_feed_statistics::merge_encoded(metrics::binary::reader& r) {
+  auto v = r.byte();
+  if (v != encoding_version) {
+    std::ostringstream os;
+    os << "jb::offline_feed_statistics - unsupported encoding version "
+       << int(v);
+    throw std::runtime_error(os.str());
+  }
+  // ... decode into a copy, if the data is malformed or incompatible
+  // this object is left unchanged ...
+  offline_feed_statistics merged(*this);
+  merged.per_sec_rate_.merge_encoded(r);
+  merged.per_msec_rate_.merge_encoded(r);
+  merged.per_usec_rate_.merge_encoded(r);
+  merged.interarrival_.merge_encoded(r);
+  merged.processing_latency_.merge_encoded(r);
+  merged.last_ts_ = std::max(last_ts_, std::chrono::nanoseconds(r.zigzag()));
+  *this = std::move(merged);
+}
+
 namespace jb {
 namespace defaults {
 
@@ -292,6 +356,15 @@ namespace defaults {
 #ifndef JB_OFS_DEFAULTS_max_processing_latency_nanoseconds
 #define JB_OFS_DEFAULTS_max_processing_latency_nanoseconds 1000000
 #endif
+#ifndef JB_OFS_DEFAULTS_significant_digits
+#define JB_OFS_DEFAULTS_significant_digits 0
+#endif
+#ifndef JB_OFS_DEFAULTS_interarrival_sketch_k
+#define JB_OFS_DEFAULTS_interarrival_sketch_k 0
+#endif
+#ifndef JB_OFS_DEFAULTS_processing_latency_sketch_k
+#define JB_OFS_DEFAULTS_processing_latency_sketch_k 0
+#endif
 #ifndef JB_OFS_DEFAULTS_reporting_interval_seconds
 #define JB_OFS_DEFAULTS_reporting_interval_seconds 600
 #endif
@@ -301,8 +374,11 @@ int max_messages_per_millisecond = JB_OFS_DEFAULTS_max_messages_per_millisecond;
 int max_messages_per_microsecond = JB_OFS_DEFAULTS_max_messages_per_microsecond;
 std::int64_t max_interarrival_time_nanoseconds =
     JB_OFS_DEFAULTS_max_interarrival_time_nanoseconds;
-int max_processing_latency_nanoseconds =
+std::int64_t max_processing_latency_nanoseconds =
     JB_OFS_DEFAULTS_max_processing_latency_nanoseconds;
+int latency_significant_digits = JB_OFS_DEFAULTS_significant_digits;
+int interarrival_sketch_k = JB_OFS_DEFAULTS_interarrival_sketch_k;
+int processing_latency_sketch_k = JB_OFS_DEFAULTS_processing_latency_sketch_k;
 int reporting_interval_seconds = JB_OFS_DEFAULTS_reporting_interval_seconds;
 
 } // namespace defaults
@@ -351,6 +427,34 @@ jb::offline_feed_statistics::config::config()
                   "   Higher values consume more memory, but give more accurate"
                   " results for high percentiles."),
           this, defaults::max_processing_latency_nanoseconds)
+    , significant_digits(
+          desc("significant-digits")
+              .help(
+                  "Configure the message rate, interarrival time, and"
+                  " processing latency histograms to preserve this many"
+                  " significant digits.  The histograms use a log-linear"
+                  " binning, with constant relative error, so they can cover"
+                  " large ranges with little memory.  Use 0 to have one bin"
+                  " for each value."),
+          this, defaults::latency_significant_digits)
+    , interarrival_sketch_k(
+          desc("interarrival-sketch-k")
+              .help(
+                  "If not zero, record the interarrival times in a KLL"
+                  " quantile sketch with this accuracy parameter instead of"
+                  " a histogram.  The sketch accepts any value in bounded"
+                  " memory, its rank error is about 1.65% for k=200, and"
+                  " halves when k doubles."),
+          this, defaults::interarrival_sketch_k)
+    , processing_latency_sketch_k(
+          desc("processing-latency-sketch-k")
+              .help(
+                  "If not zero, record the processing latencies in a KLL"
+                  " quantile sketch with this accuracy parameter instead of"
+                  " a histogram.  The sketch accepts any value in bounded"
+                  " memory, its rank error is about 1.65% for k=200, and"
+                  " halves when k doubles."),
+          this, defaults::processing_latency_sketch_k)
     , reporting_interval_seconds(
           desc("reporting-interval-seconds")
               .help("Configure how often the statistics are logged."
@@ -397,6 +501,36 @@ void jb::offline_feed_statistics::config::validate() const {
     throw jb::usage(os.str(), 1);
   }
 
+  if (significant_digits() < 0 or
+      significant_digits() >
+          interarrival_histogram_t::binning_strategy::max_significant_digits) {
+    std::ostringstream os;
+    os << "significant-digits must be in the [0,"
+       << interarrival_histogram_t::binning_strategy::max_significant_digits
+       << "] range, value=" << significant_digits();
+    throw jb::usage(os.str(), 1);
+  }
+
+  typedef kll_sketch<std::int64_t> sketch;
+  if (interarrival_sketch_k() != 0 and
+      (interarrival_sketch_k() < sketch::min_k or
+       interarrival_sketch_k() > sketch::max_k)) {
+    std::ostringstream os;
+    os << "interarrival-sketch-k must be 0 or in the [" << sketch::min_k << ","
+       << sketch::max_k << "] range, value=" << interarrival_sketch_k();
+    throw jb::usage(os.str(), 1);
+  }
+
+  if (processing_latency_sketch_k() != 0 and
+      (processing_latency_sketch_k() < sketch::min_k or
+       processing_latency_sketch_k() > sketch::max_k)) {
+    std::ostringstream os;
+    os << "processing-latency-sketch-k must be 0 or in the [" << sketch::min_k
+       << "," << sketch::max_k
+       << "] range, value=" << processing_latency_sketch_k();
+    throw jb::usage(os.str(), 1);
+  }
+
   if (reporting_interval_seconds() < 0) {
     std::ostringstream os;
     os << "reporting-interval-seconds must be > 1, value="
@@ -2,14 +2,39 @@
 #define jb_offline_feed_stats_hpp
 
 #include <jb/config_object.hpp>
-#include <jb/event_rate_histogram.hpp>
 #include <jb/histogram.hpp>
-#include <jb/integer_range_binning.hpp>
+#include <jb/log_linear_binning.hpp>
+#include <jb/multi_event_rate_estimator.hpp>
+#include <jb/observed_rate_histogram.hpp>
+#include <jb/selectable_histogram.hpp>
 
-#include <iosfwd>
+#include <ostream>
+#include <string>
 
 namespace jb {
 
+namespace detail {
+/**
+ * Print the processing latency columns of the
+ * jb::offline_feed_statistics CSV format.
+ *
+ * @param os the output stream where the CSV line is printed
+ * @param histo the histogram that has captured the latencies
+ *
+ * @tparam the type of histogram used, typical an instantiation of
+ * jb::histogram<> where the samples are nanoseconds
+ */
+template <typename latency_histogram_t>
+void csv_latency(std::ostream& os, latency_histogram_t const& histo) {
+  os << "," << histo.observed_min() << "," << histo.estimated_quantile(0.10)
+     << "," << histo.estimated_quantile(0.25) << ","
+     << histo.estimated_quantile(0.50) << "," << histo.estimated_quantile(0.75)
+     << "," << histo.estimated_quantile(0.90) << ","
+     << histo.estimated_quantile(0.99) << "," << histo.estimated_quantile(0.999)
+     << "," << histo.estimated_quantile(0.9999) << "," << histo.observed_max();
+}
+} // namespace detail
+
 /**
  * Keep statistics about a feed and its offline processor.
  *
@@ -36,6 +61,14 @@ namespace jb {
  * interrupts, or CPU cycles vs. elapsed time).  The only requirement
  * is for the measurements to be compatible with
  * std::chono::duration<>.
+ *
+ * All the histograms use jb::log_linear_binning.  By default they
+ * have one bin per value, configure the number of significant digits
+ * to cover long tails (e.g. latencies up to an hour) with a few
+ * thousand bins.  When the range of the interarrival times or
+ * processing latencies is not known in advance, they can be recorded
+ * in a jb::kll_sketch instead, which accepts any value in bounded
+ * memory.
  */
 class offline_feed_statistics {
 public:
@@ -113,11 +146,88 @@ public:
    */
   void print_csv(std::string const& name, std::ostream& os) const;
 
+  /**
+   * Print a latency histogram as a row in the CSV format.
+   *
+   * Some components measure latencies with their own histograms, for
+   * example, the latency of each stage in a pipeline.  This function
+   * prints them in the same format, so they can be reported in the
+   * same table.  Only the NSamples and processing latency columns are
+   * filled, the rate and interarrival columns are empty.
+   *
+   * @param name the name for the row
+   * @param histo the histogram, the samples must be in nanoseconds
+   * @param os the output stream
+   */
+  template <typename latency_histogram_t>
+  static void print_latency_csv(
+      std::string const& name, latency_histogram_t const& histo,
+      std::ostream& os) {
+    os << name << "," << histo.nsamples();
+    os << ",,,,,,,,,";    // per-second rate
+    os << ",,,,,,,,,";    // per-millisecond rate
+    os << ",,,,,,,,,";    // per-microsecond rate
+    os << ",,,,,,,,,,,,"; // interarrival
+    if (histo.nsamples() == 0) {
+      os << ",,,,,,,,,,\n";
+      return;
+    }
+    detail::csv_latency(os, histo);
+    os << "\n";
+  }
+
   /**
    * Final progress report at the end of the input.
    */
   void log_final_progress() const;
 
+  /**
+   * Add the statistics collected by another object.
+   *
+   * Use this to combine the statistics computed in parallel, for
+   * example, one object per input file, or per day.  All the
+   * histograms are merged exactly, but the interarrival time between
+   * the last event in one object and the first event in the other is
+   * not recorded, and neither are the event rates for sampling
+   * periods that span both.  Both objects must use the same
+   * configuration.
+   *
+   * @throw std::invalid_argument if the histograms have different
+   * bins, some of the histograms may have been merged already
+   */
+  void merge(offline_feed_statistics const& rhs);
+
+  /// Add the statistics collected by another object, see merge()
+  offline_feed_statistics& operator+=(offline_feed_statistics const& rhs) {
+    merge(rhs);
+    return *this;
+  }
+
+  /**
+   * Append a compact binary representation of the statistics.
+   *
+   * @code
+   * offline_feed_statistics := version[1] observed_rate_histogram{3}
+   *                            selectable_histogram{2} zigzag(last_ts)
+   * @endcode
+   *
+   * The rate histograms are in per-second, per-millisecond, and
+   * per-microsecond order, followed by the interarrival and
+   * processing latency histograms (or sketches).  See
+   * jb::histogram::encode() and jb::kll_sketch::encode() for their
+   * formats.  The partial statistics from different
+   * threads, processes or days can be saved and combined later.
+   */
+  void encode(std::string& buffer) const;
+
+  /**
+   * Decode statistics created by encode() and merge them.
+   *
+   * @throw std::runtime_error if the data is malformed, uses an
+   * unsupported version, or the histograms have different bins
+   */
+  void merge_encoded(metrics::binary::reader& r);
+
 private:
   /**
    * Report progress up to a certain point in the input
@@ -136,18 +246,20 @@ private:
       std::chrono::nanoseconds ts, std::chrono::nanoseconds processing_latency);
 
 private:
-  typedef event_rate_histogram<std::chrono::nanoseconds, std::int64_t>
-      rate_histogram;
+  /// The version of the encoding used in encode()
+  static constexpr std::uint8_t encoding_version = 2;
+
+  typedef observed_rate_histogram<std::int64_t> rate_histogram;
   rate_histogram per_sec_rate_;
   rate_histogram per_msec_rate_;
   rate_histogram per_usec_rate_;
-  typedef histogram<integer_range_binning<std::int64_t>>
-      interarrival_histogram_t;
-  interarrival_histogram_t interarrival_;
+  multi_event_rate_estimator<std::chrono::nanoseconds> rates_;
+  typedef histogram<log_linear_binning<std::int64_t>> interarrival_histogram_t;
+  selectable_histogram<interarrival_histogram_t> interarrival_;
 
-  typedef histogram<integer_range_binning<std::uint64_t>>
+  typedef histogram<log_linear_binning<std::uint64_t>>
       processing_latency_histogram_t;
-  processing_latency_histogram_t processing_latency_;
+  selectable_histogram<processing_latency_histogram_t> processing_latency_;
 
   std::chrono::seconds reporting_interval_;
   std::chrono::nanoseconds last_ts_;
@@ -169,7 +281,10 @@ public:
   jb::config_attribute<config, int> max_messages_per_millisecond;
   jb::config_attribute<config, int> max_messages_per_microsecond;
   jb::config_attribute<config, std::int64_t> max_interarrival_time_nanoseconds;
-  jb::config_attribute<config, int> max_processing_latency_nanoseconds;
+  jb::config_attribute<config, std::int64_t> max_processing_latency_nanoseconds;
+  jb::config_attribute<config, int> significant_digits;
+  jb::config_attribute<config, int> interarrival_sketch_k;
+  jb::config_attribute<config, int> processing_latency_sketch_k;
   jb::config_attribute<config, int> reporting_interval_seconds;
 };
 
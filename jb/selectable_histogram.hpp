@@ -0,0 +1,182 @@
+#ifndef jb_selectable_histogram_hpp
+#define jb_selectable_histogram_hpp
+
+#include <jb/histogram_summary.hpp>
+#include <jb/kll_sketch.hpp>
+#include <jb/metrics_binary.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace jb {
+
+/**
+ * Record samples in a jb::histogram or a jb::kll_sketch, chosen at
+ * run-time.
+ *
+ * Histograms are exact within their range, and fast, but values
+ * outside the range are only counted.  Sketches accept any value, in
+ * bounded memory, at the cost of an approximation in the quantiles.
+ * This class lets the configuration of each metric choose.
+ *
+ * @tparam histogram_t an instantiation of jb::histogram<>
+ */
+template <typename histogram_t>
+class selectable_histogram {
+public:
+  //@{
+  /**
+   * @name type traits
+   */
+  typedef histogram_t histogram_type;
+  typedef typename histogram_t::binning_strategy binning_strategy;
+  typedef typename histogram_t::sample_type sample_type;
+  typedef kll_sketch<sample_type> sketch_type;
+  //@}
+
+  /**
+   * Constructor.
+   *
+   * @param sketch_k if not 0, use a jb::kll_sketch with this accuracy
+   *   parameter, otherwise use a histogram
+   * @param mapping the binning for the histogram, ignored if a sketch
+   *   is used
+   */
+  selectable_histogram(int sketch_k, binning_strategy const& mapping)
+      : histogram_()
+      , sketch_() {
+    if (sketch_k != 0) {
+      sketch_ = std::make_unique<sketch_type>(sketch_k);
+    } else {
+      histogram_ = std::make_unique<histogram_type>(mapping);
+    }
+  }
+
+  /// Copy constructor, copies the histogram or the sketch
+  selectable_histogram(selectable_histogram const& rhs)
+      : histogram_(copy(rhs.histogram_))
+      , sketch_(copy(rhs.sketch_)) {
+  }
+  selectable_histogram(selectable_histogram&& rhs) = default;
+
+  /// Assignment operator
+  selectable_histogram& operator=(selectable_histogram const& rhs) {
+    selectable_histogram tmp(rhs);
+    *this = std::move(tmp);
+    return *this;
+  }
+  selectable_histogram& operator=(selectable_histogram&& rhs) = default;
+
+  /// Return true if the samples are recorded in a sketch
+  bool uses_sketch() const {
+    return static_cast<bool>(sketch_);
+  }
+
+  //@{
+  /**
+   * @name Forward to the histogram or the sketch.
+   */
+  std::uint64_t nsamples() const {
+    return histogram_ ? histogram_->nsamples() : sketch_->nsamples();
+  }
+  sample_type observed_min() const {
+    return histogram_ ? histogram_->observed_min() : sketch_->observed_min();
+  }
+  sample_type observed_max() const {
+    return histogram_ ? histogram_->observed_max() : sketch_->observed_max();
+  }
+  sample_type estimated_mean() const {
+    return histogram_ ? histogram_->estimated_mean()
+                      : sketch_->estimated_mean();
+  }
+  sample_type estimated_quantile(double q) const {
+    return histogram_ ? histogram_->estimated_quantile(q)
+                      : sketch_->estimated_quantile(q);
+  }
+  histogram_summary summary() const {
+    return histogram_ ? histogram_->summary() : sketch_->summary();
+  }
+  void sample(sample_type const& t) {
+    if (histogram_) {
+      histogram_->sample(t);
+    } else {
+      sketch_->sample(t);
+    }
+  }
+  //@}
+
+  /**
+   * Add the samples recorded by another object.
+   *
+   * @throw std::invalid_argument if one object uses a histogram and
+   * the other a sketch, or if they are not compatible
+   */
+  void merge(selectable_histogram const& rhs) {
+    if (uses_sketch() != rhs.uses_sketch()) {
+      throw std::invalid_argument(
+          "Cannot merge a histogram with a quantile sketch");
+    }
+    if (histogram_) {
+      histogram_->merge(*rhs.histogram_);
+    } else {
+      sketch_->merge(*rhs.sketch_);
+    }
+  }
+
+  /**
+   * Append a compact binary representation.
+   *
+   * @code
+   * selectable_histogram := kind[1] (histogram | kll_sketch)
+   * @endcode
+   *
+   * where kind is 0 for a histogram and 1 for a sketch.
+   */
+  void encode(std::string& buffer) const {
+    buffer.push_back(static_cast<char>(uses_sketch() ? 1 : 0));
+    if (histogram_) {
+      histogram_->encode(buffer);
+    } else {
+      sketch_->encode(buffer);
+    }
+  }
+
+  /**
+   * Decode an object created by encode() and merge its samples.
+   *
+   * @throw std::runtime_error if the data is malformed or not
+   * compatible with this object
+   */
+  void merge_encoded(metrics::binary::reader& r) {
+    auto kind = r.byte();
+    if (kind != (uses_sketch() ? 1 : 0)) {
+      throw std::runtime_error(
+          "Cannot merge an encoded histogram with a quantile sketch");
+    }
+    if (histogram_) {
+      histogram_->merge_encoded(r);
+    } else {
+      sketch_->merge_encoded(r);
+    }
+  }
+
+private:
+  /// Copy the object owned by @a p, if any
+  template <typename T>
+  static std::unique_ptr<T> copy(std::unique_ptr<T> const& p) {
+    if (not p) {
+      return std::unique_ptr<T>();
+    }
+    return std::make_unique<T>(*p);
+  }
+
+private:
+  std::unique_ptr<histogram_type> histogram_;
+  std::unique_ptr<sketch_type> sketch_;
+};
+
+} // namespace jb
+
+#endif // jb_selectable_histogram_hpp
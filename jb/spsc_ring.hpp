@@ -0,0 +1,131 @@
+#ifndef jb_spsc_ring_hpp
+#define jb_spsc_ring_hpp
+
+#include <jb/p2ceil.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace jb {
+
+/**
+ * A bounded, lock-free, single producer single consumer queue.
+ *
+ * This is the queue to move data from a latency sensitive thread to
+ * a background thread.  The producer never blocks, if the queue is
+ * full try_push() fails, and the application decides what to do,
+ * typically it counts and discards the value.
+ *
+ * The storage is preallocated, pushing and consuming values never
+ * allocates memory.  The producer and consumer indices are kept in
+ * separate cache lines, and each side caches the index of the other,
+ * so in steady state each operation touches a shared cache line only
+ * when it has to.
+ *
+ * @tparam value_t the type of the values, it must be default
+ * constructible and copy assignable.
+ */
+template <typename value_t>
+class spsc_ring {
+public:
+  /// The type of the values in the queue
+  typedef value_t value_type;
+
+  /**
+   * Constructor.
+   *
+   * @param min_capacity the minimum number of values the queue can
+   * hold, it is rounded up to a power of 2
+   */
+  explicit spsc_ring(std::size_t min_capacity)
+      : buffer_(
+            min_capacity < 2 ? 2 : jb::p2ceil(std::uint64_t(min_capacity - 1)))
+      , mask_(buffer_.size() - 1)
+      , head_(0)
+      , cached_tail_(0)
+      , tail_(0)
+      , cached_head_(0) {
+  }
+
+  spsc_ring(spsc_ring const&) = delete;
+  spsc_ring& operator=(spsc_ring const&) = delete;
+
+  /// The maximum number of values in the queue
+  std::size_t capacity() const {
+    return buffer_.size();
+  }
+
+  /// An estimate of the number of values in the queue
+  std::size_t size() const {
+    return tail_.load(std::memory_order_acquire) -
+           head_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * Insert a value, must only be called from the producer thread.
+   *
+   * @returns false if the queue is full, the value is not inserted
+   */
+  bool try_push(value_type const& value) {
+    auto tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ == buffer_.size()) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (tail - cached_head_ == buffer_.size()) {
+        return false;
+      }
+    }
+    buffer_[tail & mask_] = value;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Remove up to @a max values, must only be called from the consumer
+   * thread.
+   *
+   * @param f called with each value, in the order they were inserted
+   * @param max the maximum number of values to remove
+   * @returns the number of values removed
+   */
+  template <typename functor>
+  std::size_t consume(functor&& f, std::size_t max) {
+    auto head = head_.load(std::memory_order_relaxed);
+    if (cached_tail_ - head < max) {
+      // ... refresh the cached value only if it cannot satisfy the
+      // request ...
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+    }
+    std::size_t count = 0;
+    while (head != cached_tail_ and count != max) {
+      f(buffer_[head & mask_]);
+      ++head;
+      ++count;
+    }
+    head_.store(head, std::memory_order_release);
+    return count;
+  }
+
+private:
+  /// The size of a cache line, to avoid false sharing
+  static constexpr std::size_t cache_line_size = 64;
+  typedef std::atomic<std::uint64_t> index_type;
+
+  std::vector<value_type> buffer_;
+  std::size_t const mask_;
+
+  // ... owned by the consumer ...
+  char pad0_[cache_line_size];
+  index_type head_;
+  std::uint64_t cached_tail_;
+  char pad1_[cache_line_size - sizeof(index_type) - sizeof(std::uint64_t)];
+
+  // ... owned by the producer ...
+  index_type tail_;
+  std::uint64_t cached_head_;
+  char pad2_[cache_line_size - sizeof(index_type) - sizeof(std::uint64_t)];
+};
+
+} // namespace jb
+
+#endif // jb_spsc_ring_hpp
@@ -0,0 +1,178 @@
+#include "jb/tsc_clock.hpp"
+
+#include <mutex>
+
+#if defined(JB_TSC_CLOCK_HAS_TSC)
+#include <cpuid.h>
+#endif // defined(JB_TSC_CLOCK_HAS_TSC)
+
+namespace jb {
+namespace detail {
+tsc_clock_state tsc_clock_global_state;
+} // namespace detail
+
+namespace {
+using detail::tsc_clock_mode;
+
+std::once_flag initialize_once;
+
+#if defined(JB_TSC_CLOCK_HAS_TSC)
+/// How long (in nanoseconds) the initial calibration takes
+std::int64_t const initial_calibration_nanos = 2 * 1000000;
+
+/// Larger calibration errors are corrected by stepping the clock
+std::int64_t const max_slew_nanos = 1000000;
+
+/// A timestamp counter value and the matching CLOCK_MONOTONIC time
+struct sample {
+  std::uint64_t tsc;
+  std::int64_t nanos;
+};
+
+/// The first sample, used to estimate the long term tick rate
+sample reference;
+
+/// Only one thread at a time can refresh the calibration
+std::atomic<bool> recalibrating(false);
+
+/**
+ * Read the timestamp counter and steady_clock at (nearly) the same
+ * time.
+ *
+ * The steady clock (CLOCK_MONOTONIC on Linux) is bracketed by two
+ * reads of the timestamp counter, and the sample with the smallest
+ * bracket is used.
+ */
+sample take_sample() {
+  sample best{0, 0};
+  std::uint64_t best_width = ~std::uint64_t(0);
+  for (int i = 0; i != 5; ++i) {
+    auto t0 = tsc_clock::read_tscp();
+    auto n = std::chrono::steady_clock::now().time_since_epoch();
+    auto t1 = tsc_clock::read_tscp();
+    if (t1 - t0 < best_width) {
+      best_width = t1 - t0;
+      best.tsc = t0 + (t1 - t0) / 2;
+      best.nanos =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(n).count();
+    }
+  }
+  return best;
+}
+
+/// Compute the nanoseconds per tick between two samples, in 32.32
+std::uint64_t compute_scale(sample const& a, sample const& b) {
+  auto nanos = static_cast<unsigned __int128>(b.nanos - a.nanos);
+  return static_cast<std::uint64_t>((nanos << 32) / (b.tsc - a.tsc));
+}
+
+/// Publish new calibration parameters
+void publish(
+    std::uint64_t base_tsc, std::int64_t base_nanos, std::uint64_t scale) {
+  auto& s = detail::tsc_clock_global_state;
+  auto seq = s.sequence.load(std::memory_order_relaxed);
+  s.sequence.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  s.base_tsc.store(base_tsc, std::memory_order_relaxed);
+  s.base_nanos.store(base_nanos, std::memory_order_relaxed);
+  s.scale.store(scale, std::memory_order_relaxed);
+  s.sequence.store(seq + 2, std::memory_order_release);
+}
+#endif // defined(JB_TSC_CLOCK_HAS_TSC)
+
+/// Calibrate the clock, or select the fallback mode
+void initialize() {
+  auto& s = detail::tsc_clock_global_state;
+#if defined(JB_TSC_CLOCK_HAS_TSC)
+  if (tsc_clock::invariant_tsc()) {
+    auto first = take_sample();
+    sample last;
+    do {
+      last = take_sample();
+    } while (last.nanos - first.nanos < initial_calibration_nanos);
+    reference = first;
+    publish(last.tsc, last.nanos, compute_scale(first, last));
+    s.mode.store(tsc_clock_mode::tsc, std::memory_order_release);
+    return;
+  }
+#endif // defined(JB_TSC_CLOCK_HAS_TSC)
+  s.mode.store(tsc_clock_mode::fallback, std::memory_order_release);
+}
+} // anonymous namespace
+
+constexpr bool tsc_clock::is_steady;
+
+void tsc_clock::calibrate() {
+  std::call_once(initialize_once, initialize);
+}
+
+void tsc_clock::recalibrate(std::chrono::nanoseconds period) {
+#if defined(JB_TSC_CLOCK_HAS_TSC)
+  if (detail::tsc_clock_global_state.mode.load(std::memory_order_acquire) !=
+      tsc_clock_mode::tsc) {
+    return;
+  }
+  if (recalibrating.exchange(true, std::memory_order_acquire)) {
+    // ... another thread is already doing the work ...
+    return;
+  }
+  auto& s = detail::tsc_clock_global_state;
+  auto now = take_sample();
+  auto base_tsc = s.base_tsc.load(std::memory_order_relaxed);
+  auto base_nanos = s.base_nanos.load(std::memory_order_relaxed);
+  auto scale = s.scale.load(std::memory_order_relaxed);
+  auto estimate = base_nanos + to_nanos(now.tsc - base_tsc, scale);
+  auto error = now.nanos - estimate;
+  auto long_term = compute_scale(reference, now);
+  if (error > max_slew_nanos or error < -max_slew_nanos) {
+    // ... something unusual happened, e.g., the machine was
+    // suspended, just step the clock ...
+    publish(now.tsc, now.nanos, long_term);
+  } else {
+    // ... continue from the current estimate, so the clock does not
+    // jump, but adjust the rate so the error is corrected over the
+    // next period ...
+    auto nanos = period.count() > 0 ? period.count() : 1;
+    auto ticks = (static_cast<unsigned __int128>(nanos) << 32) / long_term;
+    ticks = ticks == 0 ? 1 : ticks;
+    auto correction = static_cast<std::int64_t>(
+        (static_cast<__int128>(error) << 32) / static_cast<__int128>(ticks));
+    auto corrected = static_cast<std::int64_t>(long_term) + correction;
+    auto lo = static_cast<std::int64_t>(long_term / 2);
+    auto hi = static_cast<std::int64_t>(long_term * 2);
+    corrected = corrected < lo ? lo : corrected > hi ? hi : corrected;
+    publish(now.tsc, estimate, static_cast<std::uint64_t>(corrected));
+  }
+  recalibrating.store(false, std::memory_order_release);
+#endif // defined(JB_TSC_CLOCK_HAS_TSC)
+}
+
+bool tsc_clock::invariant_tsc() {
+#if defined(JB_TSC_CLOCK_HAS_TSC)
+  unsigned int eax, ebx, ecx, edx;
+  // ... the "Advanced Power Management" leaf reports if the counter
+  // is invariant in bit 8 of EDX, see the Intel and AMD manuals ...
+  if (__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) == 0) {
+    return false;
+  }
+  return (edx & (1U << 8)) != 0;
+#else
+  return false;
+#endif // defined(JB_TSC_CLOCK_HAS_TSC)
+}
+
+bool tsc_clock::uses_tsc() {
+  calibrate();
+  return detail::tsc_clock_global_state.mode.load(
+             std::memory_order_acquire) == tsc_clock_mode::tsc;
+}
+
+double tsc_clock::frequency() {
+  if (not uses_tsc()) {
+    return 0.0;
+  }
+  auto scale = detail::tsc_clock_global_state.scale.load();
+  return 1e9 * 4294967296.0 / scale;
+}
+
+} // namespace jb
@@ -0,0 +1,163 @@
+#ifndef jb_tsc_clock_hpp
+#define jb_tsc_clock_hpp
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define JB_TSC_CLOCK_HAS_TSC 1
+#endif // defined(__x86_64__) || defined(__i386__)
+
+namespace jb {
+
+namespace detail {
+/// The modes for jb::tsc_clock
+enum class tsc_clock_mode : int { uninitialized, tsc, fallback };
+
+/**
+ * The shared state for jb::tsc_clock.
+ *
+ * The calibration parameters are updated using a sequence lock, the
+ * readers never block, they retry if the parameters changed while
+ * they were reading them.
+ */
+struct tsc_clock_state {
+  std::atomic<tsc_clock_mode> mode;
+  std::atomic<std::uint32_t> sequence;
+  std::atomic<std::uint64_t> base_tsc;
+  std::atomic<std::int64_t> base_nanos;
+  std::atomic<std::uint64_t> scale;
+};
+
+/// The global state for jb::tsc_clock, zero initialized
+extern tsc_clock_state tsc_clock_global_state;
+} // namespace detail
+
+/**
+ * A clock based on the CPU timestamp counter.
+ *
+ * Reading the timestamp counter is several times faster than
+ * std::chrono::steady_clock::now(), even when the latter is
+ * implemented using the vDSO.  That matters when the application
+ * timestamps every message.
+ *
+ * The application calibrates the clock against CLOCK_MONOTONIC
+ * once, by calling calibrate() when it starts, so now() only reads
+ * the counter and applies the scale.  Until the clock is calibrated
+ * it simply returns std::chrono::steady_clock::now().  Long running
+ * applications call recalibrate() periodically to correct the
+ * drift, see jb::itch5::clock_recalibrator, the rate is slewed so
+ * the clock converges to CLOCK_MONOTONIC without jumping backwards.
+ * The clock shares the epoch with std::chrono::steady_clock, and
+ * uses the same time_point type, so the values from both clocks can
+ * be mixed.
+ *
+ * If the CPU does not have an invariant timestamp counter, i.e., one
+ * that runs at a constant rate and does not stop in deep sleep
+ * states, the clock simply calls std::chrono::steady_clock::now().
+ */
+class tsc_clock {
+public:
+  //@{
+  /**
+   * @name Type traits
+   */
+  typedef std::chrono::nanoseconds duration;
+  typedef duration::rep rep;
+  typedef duration::period period;
+  typedef std::chrono::steady_clock::time_point time_point;
+  static constexpr bool is_steady = true;
+  //@}
+
+  /// Return the current time
+  static time_point now() noexcept {
+#if defined(JB_TSC_CLOCK_HAS_TSC)
+    auto& s = detail::tsc_clock_global_state;
+    if (s.mode.load(std::memory_order_acquire) !=
+        detail::tsc_clock_mode::tsc) {
+      return std::chrono::steady_clock::now();
+    }
+    std::uint32_t seq;
+    std::uint64_t base_tsc;
+    std::int64_t base_nanos;
+    std::uint64_t scale;
+    std::uint64_t tsc;
+    do {
+      seq = s.sequence.load(std::memory_order_acquire);
+      base_tsc = s.base_tsc.load(std::memory_order_relaxed);
+      base_nanos = s.base_nanos.load(std::memory_order_relaxed);
+      scale = s.scale.load(std::memory_order_relaxed);
+      tsc = read_tsc();
+      std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((seq & 1) != 0 or
+             seq != s.sequence.load(std::memory_order_relaxed));
+    std::uint64_t ticks = tsc - base_tsc;
+    // ... the counters in different cores may be slightly out of
+    // sync, treat small negative values as 0 ...
+    if (static_cast<std::int64_t>(ticks) < 0) {
+      ticks = 0;
+    }
+    return time_point(duration(base_nanos + to_nanos(ticks, scale)));
+#else
+    return std::chrono::steady_clock::now();
+#endif // defined(JB_TSC_CLOCK_HAS_TSC)
+  }
+
+  /// Return true if the CPU has an invariant timestamp counter
+  static bool invariant_tsc();
+
+  /**
+   * Calibrate the clock, if it was not calibrated already.
+   *
+   * The first call busy-waits for about 2 milliseconds.
+   */
+  static void calibrate();
+
+  /**
+   * Return true if the clock uses the timestamp counter.
+   *
+   * Calibrates the clock if it has not been calibrated yet.
+   */
+  static bool uses_tsc();
+
+  /// Return the estimated frequency of the timestamp counter, in Hz
+  static double frequency();
+
+  /**
+   * Correct the drift in the calibration parameters.
+   *
+   * Only one thread refreshes the calibration at a time, concurrent
+   * calls return immediately.  Does nothing if the clock is not
+   * calibrated or does not use the timestamp counter.
+   *
+   * @param period the expected time until the next call, small
+   * errors are corrected by slewing the rate over this period
+   */
+  static void recalibrate(
+      std::chrono::nanoseconds period = std::chrono::milliseconds(100));
+
+#if defined(JB_TSC_CLOCK_HAS_TSC)
+  /// Read the timestamp counter, not ordered with other instructions
+  static std::uint64_t read_tsc() noexcept {
+    return __rdtsc();
+  }
+
+  /// Read the timestamp counter after all previous instructions
+  static std::uint64_t read_tscp() noexcept {
+    unsigned int aux;
+    return __rdtscp(&aux);
+  }
+
+  /// Convert @a ticks to nanoseconds, @a scale is a 32.32 fixed point
+  static std::int64_t to_nanos(std::uint64_t ticks, std::uint64_t scale) {
+    return static_cast<std::int64_t>(
+        (static_cast<unsigned __int128>(ticks) * scale) >> 32);
+  }
+#endif // defined(JB_TSC_CLOCK_HAS_TSC)
+};
+
+} // namespace jb
+
+#endif // jb_tsc_clock_hpp
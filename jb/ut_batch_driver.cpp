@@ -0,0 +1,130 @@
+#include <jb/batch_driver.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <thread>
+
+/**
+ * @test Verify that jb::batch_driver processes each file exactly once.
+ */
+BOOST_AUTO_TEST_CASE(batch_driver_basic) {
+  jb::batch_driver tested(jb::batch_driver::config().workers(4));
+  BOOST_CHECK_EQUAL(tested.workers(), 4);
+
+  std::vector<std::string> files;
+  for (int i = 0; i != 100; ++i) {
+    files.push_back("file-" + std::to_string(i));
+  }
+
+  std::mutex mu;
+  std::map<std::string, int> processed;
+  std::vector<int> per_worker(tested.workers());
+  int failures =
+      tested.run(files, [&](int worker, std::string const& filename) {
+        std::lock_guard<std::mutex> lk(mu);
+        processed[filename]++;
+        per_worker.at(worker)++;
+      });
+  BOOST_CHECK_EQUAL(failures, 0);
+  BOOST_CHECK_EQUAL(processed.size(), files.size());
+  for (auto const& i : processed) {
+    BOOST_CHECK_MESSAGE(i.second == 1, i.first << " processed " << i.second);
+  }
+  int total = 0;
+  for (auto c : per_worker) {
+    total += c;
+  }
+  BOOST_CHECK_EQUAL(total, 100);
+
+  // ... the driver can be reused ...
+  processed.clear();
+  failures = tested.run(files, [&](int, std::string const& filename) {
+    std::lock_guard<std::mutex> lk(mu);
+    processed[filename]++;
+  });
+  BOOST_CHECK_EQUAL(failures, 0);
+  BOOST_CHECK_EQUAL(processed.size(), files.size());
+
+  BOOST_CHECK_THROW(
+      jb::batch_driver::config().workers(-1).validate(), jb::usage);
+  BOOST_CHECK_THROW(
+      jb::batch_driver::config().max_decompressors(-1).validate(), jb::usage);
+  BOOST_CHECK_GE(jb::batch_driver(jb::batch_driver::config()).workers(), 1);
+}
+
+/**
+ * @test Verify that jb::batch_driver limits the number of compressed
+ * files processed at the same time, and counts the failures.
+ */
+BOOST_AUTO_TEST_CASE(batch_driver_max_decompressors) {
+  jb::batch_driver tested(
+      jb::batch_driver::config().workers(4).max_decompressors(1));
+
+  std::vector<std::string> files;
+  for (int i = 0; i != 20; ++i) {
+    files.push_back("file-" + std::to_string(i) + ".itch");
+    files.push_back("file-" + std::to_string(i) + ".itch.gz");
+  }
+
+  std::atomic<int> active(0);
+  std::atomic<int> max_active(0);
+  std::atomic<int> count(0);
+  int failures = tested.run(files, [&](int, std::string const& filename) {
+    ++count;
+    if (filename.find(".gz") == std::string::npos) {
+      if (filename == "file-7.itch") {
+        throw std::runtime_error("cannot open file-7.itch");
+      }
+      return;
+    }
+    int current = ++active;
+    int expected = max_active.load();
+    while (current > expected and
+           not max_active.compare_exchange_weak(expected, current)) {
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    --active;
+  });
+  BOOST_CHECK_EQUAL(failures, 1);
+  BOOST_CHECK_EQUAL(count.load(), 40);
+  BOOST_CHECK_EQUAL(max_active.load(), 1);
+}
+
+/**
+ * @test Verify that jb::batch_driver::expand works as expected.
+ */
+BOOST_AUTO_TEST_CASE(batch_driver_expand) {
+  namespace fs = boost::filesystem;
+  fs::path dir = fs::temp_directory_path() / fs::unique_path();
+  fs::create_directories(dir);
+  for (auto name : {"20171003.itch.gz", "20171002.itch.gz", "20171101.itch"}) {
+    std::ofstream os((dir / name).string());
+    os << "test data" << std::endl;
+  }
+
+  auto actual = jb::batch_driver::expand(
+      {(dir / "2017100*.itch.gz").string(), (dir / "20171101.itch").string()});
+  std::vector<std::string> expected{(dir / "20171002.itch.gz").string(),
+                                    (dir / "20171003.itch.gz").string(),
+                                    (dir / "20171101.itch").string()};
+  BOOST_CHECK_EQUAL_COLLECTIONS(
+      actual.begin(), actual.end(), expected.begin(), expected.end());
+
+  // ... overlapping patterns do not produce duplicates ...
+  actual = jb::batch_driver::expand(
+      {(dir / "2017100*.itch.gz").string(), (dir / "2017*").string()});
+  BOOST_CHECK_EQUAL_COLLECTIONS(
+      actual.begin(), actual.end(), expected.begin(), expected.end());
+
+  BOOST_CHECK_THROW(
+      jb::batch_driver::expand({(dir / "2018*.itch").string()}),
+      std::runtime_error);
+
+  fs::remove_all(dir);
+}
@@ -74,4 +74,52 @@ BOOST_AUTO_TEST_CASE(book_depth_statististics_config_simple) {
 
   BOOST_CHECK_NO_THROW(config().validate());
   BOOST_CHECK_THROW(config().max_book_depth(0).validate(), jb::usage);
+  BOOST_CHECK_THROW(config().significant_digits(-1).validate(), jb::usage);
+  BOOST_CHECK_THROW(config().significant_digits(16).validate(), jb::usage);
+  BOOST_CHECK_NO_THROW(config().significant_digits(2).validate());
+}
+
+/**
+ * @test Verify that jb::book_depth_statistics can be merged and
+ * encoded, and the results match a single-pass run.
+ */
+BOOST_AUTO_TEST_CASE(book_depth_statistics_merge) {
+  auto cfg = jb::book_depth_statistics::config().significant_digits(2);
+  jb::book_depth_statistics single(cfg);
+  jb::book_depth_statistics a(cfg);
+  jb::book_depth_statistics b(cfg);
+  for (jb::book_depth_t i = 0; i != 5000; ++i) {
+    auto depth = (i * 7919) % 10000;
+    single.sample(depth);
+    if (i % 2 == 0) {
+      a.sample(depth);
+    } else {
+      b.sample(depth);
+    }
+  }
+  std::ostringstream expected;
+  single.print_csv("testing", expected);
+
+  jb::book_depth_statistics merged(cfg);
+  merged += a;
+  merged += b;
+  std::ostringstream actual;
+  merged.print_csv("testing", actual);
+  BOOST_CHECK_EQUAL(actual.str(), expected.str());
+
+  std::string buffer;
+  a.encode(buffer);
+  b.encode(buffer);
+  jb::book_depth_statistics decoded(cfg);
+  jb::metrics::binary::reader r(buffer.data(), buffer.size());
+  decoded.merge_encoded(r);
+  decoded.merge_encoded(r);
+  BOOST_CHECK(r.done());
+  actual.str("");
+  decoded.print_csv("testing", actual);
+  BOOST_CHECK_EQUAL(actual.str(), expected.str());
+
+  jb::book_depth_statistics::config linear;
+  jb::book_depth_statistics other(linear);
+  BOOST_CHECK_THROW(other.merge(a), std::invalid_argument);
 }
@@ -0,0 +1,112 @@
+#include <jb/conflation_queue.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <thread>
+
+/**
+ * @test Verify that jb::conflation_queue works as expected.
+ */
+BOOST_AUTO_TEST_CASE(conflation_queue_basic) {
+  using queue_type = jb::conflation_queue<std::string>;
+  queue_type queue(8);
+  BOOST_CHECK_EQUAL(queue.dirty_count(), 0);
+
+  BOOST_CHECK_EQUAL(queue.push(3, "a"), false);
+  BOOST_CHECK_EQUAL(queue.push(1, "b"), false);
+  BOOST_CHECK_EQUAL(queue.push(3, "c"), true);
+  BOOST_CHECK_EQUAL(queue.push(5, "d"), false);
+  BOOST_CHECK_EQUAL(queue.dirty_count(), 3);
+
+  // ... the keys are delivered in the order they became dirty, with
+  // the latest value ...
+  std::vector<queue_type::entry_type> out;
+  BOOST_CHECK_EQUAL(queue.try_pop(out, 2), 2);
+  BOOST_REQUIRE_EQUAL(out.size(), 2);
+  BOOST_CHECK_EQUAL(out[0].first, 3);
+  BOOST_CHECK_EQUAL(out[0].second, "c");
+  BOOST_CHECK_EQUAL(out[1].first, 1);
+  BOOST_CHECK_EQUAL(out[1].second, "b");
+
+  // ... a key that was popped can become dirty again ...
+  queue.push(3, "e");
+  out.clear();
+  BOOST_CHECK_EQUAL(queue.try_pop(out, 10), 2);
+  BOOST_REQUIRE_EQUAL(out.size(), 2);
+  BOOST_CHECK_EQUAL(out[0].first, 5);
+  BOOST_CHECK_EQUAL(out[1].first, 3);
+  BOOST_CHECK_EQUAL(out[1].second, "e");
+  BOOST_CHECK_EQUAL(queue.dirty_count(), 0);
+
+  out.clear();
+  BOOST_CHECK_EQUAL(queue.try_pop(out, 10), 0);
+
+  auto s = queue.stats(3);
+  BOOST_CHECK_EQUAL(s.pushed, 3);
+  BOOST_CHECK_EQUAL(s.popped, 2);
+
+  int count = 0;
+  queue.for_each_stats(
+      [&count](
+          queue_type::key_type, queue_type::key_stats const&,
+          std::string const&) { ++count; });
+  BOOST_CHECK_EQUAL(count, 3);
+
+  // ... the function is called without the lock, it can use the queue ...
+  queue.for_each_stats([&queue](
+      queue_type::key_type key, queue_type::key_stats const& s,
+      std::string const&) {
+    BOOST_CHECK_EQUAL(queue.stats(key).pushed, s.pushed);
+  });
+
+  BOOST_CHECK_THROW(queue.push(8, "x"), std::out_of_range);
+  BOOST_CHECK_THROW(queue.stats(8), std::out_of_range);
+}
+
+/**
+ * @test Verify that jb::conflation_queue works across threads.
+ */
+BOOST_AUTO_TEST_CASE(conflation_queue_threads) {
+  using queue_type = jb::conflation_queue<int>;
+  queue_type queue(4);
+
+  int const count = 10000;
+  std::thread producer([&queue]() {
+    for (int i = 1; i <= count; ++i) {
+      queue.push(i % 4, i);
+    }
+  });
+
+  // ... the consumer must eventually see the last value for each key,
+  // and the values for each key must be increasing ...
+  std::vector<int> last(4, 0);
+  std::vector<queue_type::entry_type> out;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (std::chrono::steady_clock::now() < deadline) {
+    out.clear();
+    queue.pop_wait(out, 16, std::chrono::milliseconds(10));
+    for (auto const& e : out) {
+      BOOST_CHECK_GT(e.second, last[e.first]);
+      last[e.first] = e.second;
+    }
+    if (last[0] == count) {
+      break;
+    }
+  }
+  producer.join();
+  out.clear();
+  queue.try_pop(out, 16);
+  for (auto const& e : out) {
+    last[e.first] = e.second;
+  }
+  BOOST_CHECK_EQUAL(last[0], count);
+  BOOST_CHECK_EQUAL(last[1], count - 3);
+  BOOST_CHECK_EQUAL(last[2], count - 2);
+  BOOST_CHECK_EQUAL(last[3], count - 1);
+
+  queue.stop();
+  out.clear();
+  BOOST_CHECK_EQUAL(queue.pop_wait(out, 16, std::chrono::seconds(10)), 0);
+  BOOST_CHECK(queue.stopped());
+}
@@ -47,3 +47,49 @@ BOOST_AUTO_TEST_CASE(event_rate_histogram_repeats) {
   BOOST_CHECK_EQUAL(t.last_rate(), 0);
   BOOST_CHECK_EQUAL(t.observed_max(), 3);
 }
+
+/**
+ * @test Verify that event rate histograms can be merged and encoded.
+ */
+BOOST_AUTO_TEST_CASE(event_rate_histogram_merge) {
+  typedef jb::event_rate_histogram<> tested_class;
+
+  auto fill = [](tested_class& t) {
+    for (int i = 0; i != 1000; ++i) {
+      t.sample(std::chrono::microseconds(i * 5 + i % 3));
+    }
+  };
+  tested_class a(1000, std::chrono::microseconds(100));
+  tested_class b(1000, std::chrono::microseconds(100));
+  fill(a);
+  fill(b);
+
+  tested_class merged(1000, std::chrono::microseconds(100));
+  merged += a;
+  merged += b;
+  BOOST_CHECK_EQUAL(merged.nsamples(), 2 * a.nsamples());
+  BOOST_CHECK_EQUAL(merged.last_rate(), a.last_rate());
+  BOOST_CHECK_EQUAL(merged.observed_min(), a.observed_min());
+  BOOST_CHECK_EQUAL(merged.observed_max(), a.observed_max());
+  for (double q : {0.1, 0.5, 0.9, 0.99}) {
+    BOOST_CHECK_EQUAL(merged.estimated_quantile(q), a.estimated_quantile(q));
+  }
+
+  std::string buffer;
+  a.encode(buffer);
+  b.encode(buffer);
+  tested_class decoded(1000, std::chrono::microseconds(100));
+  jb::metrics::binary::reader r(buffer.data(), buffer.size());
+  decoded.merge_encoded(r);
+  decoded.merge_encoded(r);
+  BOOST_CHECK(r.done());
+  BOOST_CHECK_EQUAL(decoded.nsamples(), merged.nsamples());
+  BOOST_CHECK_EQUAL(decoded.last_rate(), merged.last_rate());
+  for (double q : {0.1, 0.5, 0.9, 0.99}) {
+    BOOST_CHECK_EQUAL(
+        decoded.estimated_quantile(q), merged.estimated_quantile(q));
+  }
+
+  tested_class other(2000, std::chrono::microseconds(100));
+  BOOST_CHECK_THROW(other.merge(a), std::invalid_argument);
+}
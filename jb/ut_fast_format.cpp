@@ -0,0 +1,83 @@
+#include <jb/fast_format.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <limits>
+#include <sstream>
+
+namespace {
+/// Format @a value using jb::format_integer() and return the result
+template <typename integer_t>
+std::string formatted(integer_t value) {
+  char buf[jb::max_formatted_integer_size + 1];
+  return std::string(buf, jb::format_integer(buf, value));
+}
+} // anonymous namespace
+
+/**
+ * @test Verify that jb::format_integer() works as expected.
+ */
+BOOST_AUTO_TEST_CASE(fast_format_integer) {
+  BOOST_CHECK_EQUAL(formatted(0), "0");
+  BOOST_CHECK_EQUAL(formatted(7U), "7");
+  BOOST_CHECK_EQUAL(formatted(10), "10");
+  BOOST_CHECK_EQUAL(formatted(99), "99");
+  BOOST_CHECK_EQUAL(formatted(100), "100");
+  BOOST_CHECK_EQUAL(formatted(-1), "-1");
+  BOOST_CHECK_EQUAL(formatted(-1234567), "-1234567");
+  BOOST_CHECK_EQUAL(formatted(std::uint16_t(65535)), "65535");
+
+  // ... compare against the iostream operators for the extremes, and
+  // for a few numbers with each digit count ...
+  auto check = [](auto value) {
+    std::ostringstream os;
+    os << value;
+    BOOST_CHECK_EQUAL(formatted(value), os.str());
+  };
+  check(std::numeric_limits<std::int64_t>::min());
+  check(std::numeric_limits<std::int64_t>::max());
+  check(std::numeric_limits<std::uint64_t>::max());
+  check(std::numeric_limits<std::int32_t>::min());
+  check(std::numeric_limits<std::uint32_t>::max());
+  for (std::uint64_t v = 1; v < std::uint64_t(1) << 62; v = v * 10 + 3) {
+    check(v);
+    check(-std::int64_t(v));
+  }
+}
+
+/**
+ * @test Verify that jb::format_fixed() works as expected.
+ */
+BOOST_AUTO_TEST_CASE(fast_format_fixed) {
+  auto fixed = [](std::uint32_t value) {
+    char buf[jb::max_formatted_integer_size + 2];
+    return std::string(buf, jb::format_fixed(buf, value, 10000U, 4));
+  };
+  BOOST_CHECK_EQUAL(fixed(0), "0.0000");
+  BOOST_CHECK_EQUAL(fixed(1), "0.0001");
+  BOOST_CHECK_EQUAL(fixed(10000), "1.0000");
+  BOOST_CHECK_EQUAL(fixed(12340123), "1234.0123");
+}
+
+/**
+ * @test Verify that jb::fast_format buffers the data and writes it
+ * to the stream.
+ */
+BOOST_AUTO_TEST_CASE(fast_format_buffer) {
+  std::ostringstream os;
+  {
+    jb::fast_format out(os, 64);
+    out << "abc" << ' ' << 42 << ' ' << std::string("def") << '\n';
+    BOOST_CHECK_EQUAL(out.pending(), 11);
+    BOOST_CHECK_EQUAL(os.str(), "");
+    out.flush();
+    BOOST_CHECK_EQUAL(out.pending(), 0);
+    BOOST_CHECK_EQUAL(os.str(), "abc 42 def\n");
+
+    // ... data larger than the buffer is written in pieces ...
+    std::string large(200, 'x');
+    out << large << -7;
+    BOOST_CHECK_LT(out.pending(), 64);
+  }
+  BOOST_CHECK_EQUAL(os.str(), "abc 42 def\n" + std::string(200, 'x') + "-7");
+}
@@ -1,4 +1,6 @@
 #include <jb/histogram.hpp>
+#include <jb/integer_range_binning.hpp>
+#include <jb/log_linear_binning.hpp>
 
 #include <boost/test/unit_test.hpp>
 
@@ -312,3 +314,130 @@ BOOST_AUTO_TEST_CASE(histogram_quantile_complex) {
   BOOST_CHECK_CLOSE(h.estimated_quantile(0.95), 35.0, eps);
   BOOST_CHECK_CLOSE(h.estimated_quantile(1.00), 40.0, eps);
 }
+
+namespace {
+/// Verify that two histograms have identical contents
+template <typename histogram_t>
+void check_same_histogram(histogram_t const& a, histogram_t const& b) {
+  BOOST_CHECK_EQUAL(a.nsamples(), b.nsamples());
+  BOOST_CHECK_EQUAL(a.underflow_count(), b.underflow_count());
+  BOOST_CHECK_EQUAL(a.overflow_count(), b.overflow_count());
+  BOOST_CHECK_EQUAL(a.observed_min(), b.observed_min());
+  BOOST_CHECK_EQUAL(a.observed_max(), b.observed_max());
+  BOOST_CHECK_EQUAL(a.estimated_mean(), b.estimated_mean());
+  for (double q : {0.0, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99, 0.999, 1.0}) {
+    BOOST_CHECK_EQUAL(a.estimated_quantile(q), b.estimated_quantile(q));
+  }
+}
+} // anonymous namespace
+
+/**
+ * @test Verify that merging histograms produces the same results as
+ * recording all the samples in a single histogram.
+ */
+BOOST_AUTO_TEST_CASE(histogram_merge) {
+  typedef jb::histogram<jb::log_linear_binning<std::int64_t>> histogram;
+  histogram::binning_strategy binning(0, 1000000, 2);
+  histogram single(binning);
+  histogram a(binning);
+  histogram b(binning);
+  histogram c(binning);
+  for (std::int64_t i = 0; i != 10000; ++i) {
+    // ... include some overflow samples ...
+    std::int64_t v = (i * 7919) % 1200000;
+    single.sample(v);
+    if (i % 3 == 0) {
+      a.sample(v);
+    } else {
+      b.sample(v);
+    }
+  }
+  a += b;
+  check_same_histogram(a, single);
+
+  // ... merging an empty histogram has no effect, in either direction ...
+  a.merge(histogram(binning));
+  check_same_histogram(a, single);
+  c.merge(a);
+  check_same_histogram(c, single);
+}
+
+/**
+ * @test Verify that merging histograms with different bins fails.
+ */
+BOOST_AUTO_TEST_CASE(histogram_merge_incompatible) {
+  typedef jb::histogram<jb::log_linear_binning<std::int64_t>> histogram;
+  typedef histogram::binning_strategy binning;
+  histogram h(binning(0, 1000000, 2));
+  BOOST_CHECK_THROW(h.merge(histogram(binning(0, 1000000, 3))), std::exception);
+  BOOST_CHECK_THROW(h.merge(histogram(binning(1, 1000000, 2))), std::exception);
+  BOOST_CHECK_THROW(h.merge(histogram(binning(0, 2000000, 2))), std::exception);
+  BOOST_CHECK_NO_THROW(h.merge(histogram(binning(0, 1000000, 2))));
+}
+
+/**
+ * @test Verify that histograms can be encoded and merged back.
+ */
+BOOST_AUTO_TEST_CASE(histogram_encode) {
+  typedef jb::histogram<jb::integer_range_binning<std::uint64_t>> histogram;
+  histogram::binning_strategy binning(100, 10000);
+  histogram single(binning);
+  histogram a(binning);
+  histogram b(binning);
+  for (std::uint64_t i = 0; i != 5000; ++i) {
+    std::uint64_t v = (i * 104729) % 12000;
+    single.sample(v);
+    (i < 2000 ? a : b).sample(v);
+  }
+
+  std::string buffer;
+  a.encode(buffer);
+  b.encode(buffer);
+  histogram(binning).encode(buffer);
+  // ... only the non-empty bins are encoded ...
+  BOOST_CHECK_LT(buffer.size(), 4 * 5000);
+
+  histogram merged(binning);
+  jb::metrics::binary::reader r(buffer.data(), buffer.size());
+  merged.merge_encoded(r);
+  merged.merge_encoded(r);
+  merged.merge_encoded(r);
+  BOOST_CHECK(r.done());
+  check_same_histogram(merged, single);
+
+  // ... a histogram with different bins is rejected ...
+  histogram other(histogram::binning_strategy(100, 20000));
+  jb::metrics::binary::reader r2(buffer.data(), buffer.size());
+  BOOST_CHECK_THROW(other.merge_encoded(r2), std::exception);
+
+  // ... and so is a truncated buffer ...
+  jb::metrics::binary::reader r3(buffer.data(), buffer.size() / 4);
+  histogram h(binning);
+  BOOST_CHECK_THROW(h.merge_encoded(r3), std::exception);
+
+  // ... a malformed histogram does not change the counters ...
+  std::string one;
+  a.encode(one);
+  jb::metrics::binary::reader r4(one.data(), one.size() - 1);
+  BOOST_CHECK_THROW(merged.merge_encoded(r4), std::exception);
+  check_same_histogram(merged, single);
+
+  std::string bad;
+  using namespace jb::metrics::binary;
+  put_zigzag(bad, 100);
+  put_zigzag(bad, 10000);
+  put_varint(bad, 9900);
+  put_varint(bad, 2);
+  put_zigzag(bad, 150);
+  put_zigzag(bad, 150);
+  put_varint(bad, 0);
+  put_varint(bad, 0);
+  put_varint(bad, 2);
+  put_varint(bad, 50);
+  put_varint(bad, 1);
+  put_varint(bad, ~std::uint64_t(0));
+  put_varint(bad, 1);
+  reader r5(bad.data(), bad.size());
+  BOOST_CHECK_THROW(merged.merge_encoded(r5), std::runtime_error);
+  check_same_histogram(merged, single);
+}
@@ -0,0 +1,149 @@
+#include <jb/kll_sketch.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+/// Return the fraction of samples smaller than or equal to @a value
+double rank(std::vector<std::int64_t> const& sorted, std::int64_t value) {
+  auto i = std::upper_bound(sorted.begin(), sorted.end(), value);
+  return double(i - sorted.begin()) / sorted.size();
+}
+
+/// Generate samples with a long tail, like most latencies
+std::vector<std::int64_t> latencies(int n, unsigned int seed) {
+  std::mt19937_64 generator(seed);
+  std::lognormal_distribution<double> latency(8.0, 2.0);
+  std::vector<std::int64_t> samples;
+  for (int i = 0; i != n; ++i) {
+    samples.push_back(static_cast<std::int64_t>(latency(generator)));
+  }
+  return samples;
+}
+} // anonymous namespace
+
+/**
+ * @test Verify that jb::kll_sketch works as expected for small inputs.
+ */
+BOOST_AUTO_TEST_CASE(kll_sketch_basic) {
+  jb::kll_sketch<std::int64_t> tested;
+  BOOST_CHECK_EQUAL(tested.k(), 200);
+  BOOST_CHECK_EQUAL(tested.nsamples(), 0);
+  BOOST_CHECK_THROW(tested.estimated_mean(), std::invalid_argument);
+  BOOST_CHECK_THROW(tested.estimated_quantile(0.5), std::invalid_argument);
+  BOOST_CHECK_EQUAL(tested.summary().nsamples, 0);
+
+  for (int i = 1; i != 101; ++i) {
+    tested.sample(i);
+  }
+  // ... no compaction with so few samples, the results are exact ...
+  BOOST_CHECK_EQUAL(tested.retained(), 100);
+  BOOST_CHECK_EQUAL(tested.nsamples(), 100);
+  BOOST_CHECK_EQUAL(tested.observed_min(), 1);
+  BOOST_CHECK_EQUAL(tested.observed_max(), 100);
+  BOOST_CHECK_EQUAL(tested.estimated_mean(), 50);
+  BOOST_CHECK_EQUAL(tested.estimated_quantile(0), 1);
+  BOOST_CHECK_EQUAL(tested.estimated_quantile(0.25), 25);
+  BOOST_CHECK_EQUAL(tested.estimated_quantile(0.5), 50);
+  BOOST_CHECK_EQUAL(tested.estimated_quantile(1.0), 100);
+  BOOST_CHECK_THROW(tested.estimated_quantile(-0.1), std::invalid_argument);
+  BOOST_CHECK_THROW(tested.estimated_quantile(1.1), std::invalid_argument);
+  BOOST_CHECK_EQUAL(tested.summary().p90, 90);
+
+  tested.weighted_sample(1000, 100);
+  BOOST_CHECK_EQUAL(tested.nsamples(), 200);
+  BOOST_CHECK_EQUAL(tested.estimated_quantile(0.75), 1000);
+  BOOST_CHECK_EQUAL(tested.observed_max(), 1000);
+
+  tested.reset();
+  BOOST_CHECK_EQUAL(tested.nsamples(), 0);
+  BOOST_CHECK_EQUAL(tested.retained(), 0);
+
+  BOOST_CHECK_THROW(jb::kll_sketch<int>(4), std::invalid_argument);
+  BOOST_CHECK_THROW(jb::kll_sketch<int>(100000), std::invalid_argument);
+}
+
+/**
+ * @test Verify that jb::kll_sketch uses bounded memory and meets its
+ * rank error guarantees.
+ */
+BOOST_AUTO_TEST_CASE(kll_sketch_accuracy) {
+  auto samples = latencies(200000, 20171101);
+  jb::kll_sketch<std::int64_t> tested;
+  for (auto s : samples) {
+    tested.sample(s);
+  }
+  BOOST_CHECK_EQUAL(tested.nsamples(), samples.size());
+  BOOST_CHECK_LE(tested.retained(), 3 * 200 + 8 * 16);
+
+  std::sort(samples.begin(), samples.end());
+  BOOST_CHECK_EQUAL(tested.observed_min(), samples.front());
+  BOOST_CHECK_EQUAL(tested.observed_max(), samples.back());
+  for (double q : {0.01, 0.10, 0.25, 0.50, 0.75, 0.90, 0.99, 0.999}) {
+    auto estimate = tested.estimated_quantile(q);
+    BOOST_TEST_MESSAGE("q=" << q << ", estimate=" << estimate);
+    BOOST_CHECK_SMALL(rank(samples, estimate) - q, 0.02);
+  }
+}
+
+/**
+ * @test Verify that jb::kll_sketch can be merged and encoded.
+ */
+BOOST_AUTO_TEST_CASE(kll_sketch_merge) {
+  auto a_samples = latencies(50000, 1);
+  auto b_samples = latencies(50000, 2);
+  jb::kll_sketch<std::int64_t> a;
+  jb::kll_sketch<std::int64_t> b;
+  for (auto s : a_samples) {
+    a.sample(s);
+  }
+  for (auto s : b_samples) {
+    b.sample(s);
+  }
+
+  jb::kll_sketch<std::int64_t> merged;
+  merged.merge(a);
+  merged.merge(b);
+  BOOST_CHECK_EQUAL(merged.nsamples(), a.nsamples() + b.nsamples());
+  BOOST_CHECK_EQUAL(
+      merged.observed_max(), std::max(a.observed_max(), b.observed_max()));
+  BOOST_CHECK_LE(merged.retained(), 3 * 200 + 8 * 16);
+
+  std::vector<std::int64_t> all(a_samples);
+  all.insert(all.end(), b_samples.begin(), b_samples.end());
+  std::sort(all.begin(), all.end());
+  for (double q : {0.10, 0.50, 0.90, 0.99}) {
+    BOOST_CHECK_SMALL(rank(all, merged.estimated_quantile(q)) - q, 0.02);
+  }
+
+  std::string buffer;
+  a.encode(buffer);
+  b.encode(buffer);
+  jb::kll_sketch<std::int64_t> decoded;
+  jb::metrics::binary::reader r(buffer.data(), buffer.size());
+  decoded.merge_encoded(r);
+  decoded.merge_encoded(r);
+  BOOST_CHECK(r.done());
+  BOOST_CHECK_EQUAL(decoded.nsamples(), merged.nsamples());
+  BOOST_CHECK_EQUAL(decoded.observed_min(), merged.observed_min());
+  BOOST_CHECK_EQUAL(decoded.estimated_mean(), merged.estimated_mean());
+  for (double q : {0.10, 0.50, 0.90, 0.99}) {
+    BOOST_CHECK_SMALL(rank(all, decoded.estimated_quantile(q)) - q, 0.02);
+  }
+
+  // ... a truncated buffer leaves the sketch unchanged ...
+  auto retained = decoded.retained();
+  jb::metrics::binary::reader truncated(buffer.data(), buffer.size() / 4);
+  BOOST_CHECK_THROW(decoded.merge_encoded(truncated), std::runtime_error);
+  BOOST_CHECK_EQUAL(decoded.retained(), retained);
+  BOOST_CHECK_EQUAL(decoded.nsamples(), merged.nsamples());
+
+  jb::kll_sketch<std::int64_t> other(400);
+  BOOST_CHECK_THROW(other.merge(a), std::invalid_argument);
+  jb::metrics::binary::reader r2(buffer.data(), buffer.size());
+  BOOST_CHECK_THROW(other.merge_encoded(r2), std::runtime_error);
+}
@@ -0,0 +1,160 @@
+#include <jb/histogram.hpp>
+#include <jb/log_linear_binning.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+
+namespace {
+
+template <typename sample_type_t>
+void check_constructor() {
+  using binning = jb::log_linear_binning<sample_type_t>;
+  BOOST_CHECK_THROW(binning(10, 10, 2), std::exception);
+  BOOST_CHECK_THROW(binning(20, 10, 2), std::exception);
+  BOOST_CHECK_THROW(binning(0, 1000, 0), std::exception);
+  BOOST_CHECK_THROW(
+      binning(0, 1000, binning::max_significant_digits + 1), std::exception);
+  BOOST_CHECK_NO_THROW(binning(1, 2, 1));
+  BOOST_CHECK_NO_THROW(binning(1000, 2000, 3));
+}
+
+template <typename sample_type_t>
+void check_basic() {
+  // ... with 2 digits there are 256 bins with width 1, followed by
+  // buckets of 128 bins ...
+  jb::log_linear_binning<sample_type_t> bin(0, 1000, 2);
+  BOOST_CHECK_EQUAL(bin.histogram_min(), 0);
+  BOOST_CHECK_EQUAL(bin.histogram_max(), 1000);
+  BOOST_CHECK_EQUAL(
+      bin.theoretical_min(), std::numeric_limits<sample_type_t>::min());
+  BOOST_CHECK_EQUAL(
+      bin.theoretical_max(), std::numeric_limits<sample_type_t>::max());
+  BOOST_CHECK_EQUAL(bin.sample2bin(0), 0);
+  BOOST_CHECK_EQUAL(bin.sample2bin(5), 5);
+  BOOST_CHECK_EQUAL(bin.sample2bin(255), 255);
+  BOOST_CHECK_EQUAL(bin.sample2bin(256), 256);
+  BOOST_CHECK_EQUAL(bin.sample2bin(257), 256);
+  BOOST_CHECK_EQUAL(bin.sample2bin(258), 257);
+  BOOST_CHECK_EQUAL(bin.sample2bin(511), 383);
+  BOOST_CHECK_EQUAL(bin.sample2bin(512), 384);
+  BOOST_CHECK_EQUAL(bin.sample2bin(515), 384);
+  BOOST_CHECK_EQUAL(bin.bin2sample(0), 0);
+  BOOST_CHECK_EQUAL(bin.bin2sample(10), 10);
+  BOOST_CHECK_EQUAL(bin.bin2sample(256), 256);
+  BOOST_CHECK_EQUAL(bin.bin2sample(257), 258);
+  BOOST_CHECK_EQUAL(bin.bin2sample(384), 512);
+  BOOST_CHECK_EQUAL(bin.bin2sample(385), 516);
+}
+
+} // anonymous namespace
+
+/**
+ * @test Verify the constructor in jb::log_linear_binning works as expected.
+ */
+BOOST_AUTO_TEST_CASE(log_linear_binning_constructor_int) {
+  check_constructor<int>();
+}
+
+/**
+ * @test Verify that jb::log_linear_binning works as expected.
+ */
+BOOST_AUTO_TEST_CASE(log_linear_binning_basic_int) {
+  check_basic<int>();
+}
+
+/**
+ * @test Verify the constructor in jb::log_linear_binning works as expected.
+ */
+BOOST_AUTO_TEST_CASE(log_linear_binning_constructor_std_uint64) {
+  check_constructor<std::uint64_t>();
+}
+
+/**
+ * @test Verify that jb::log_linear_binning works as expected.
+ */
+BOOST_AUTO_TEST_CASE(log_linear_binning_basic_std_uint64) {
+  check_basic<std::uint64_t>();
+}
+
+/**
+ * @test Verify that jb::log_linear_binning preserves the requested
+ * number of significant digits.
+ */
+BOOST_AUTO_TEST_CASE(log_linear_binning_relative_error) {
+  for (int digits = 1; digits != 5; ++digits) {
+    jb::log_linear_binning<std::int64_t> bin(0, 1000000000, digits);
+    double const max_error = std::pow(10.0, -digits);
+    for (std::int64_t v = 1; v < bin.histogram_max(); v = v * 3 / 2 + 1) {
+      auto i = bin.sample2bin(v);
+      auto lo = bin.bin2sample(i);
+      auto hi = bin.bin2sample(i + 1);
+      BOOST_CHECK_LE(lo, v);
+      BOOST_CHECK_LT(v, hi);
+      // ... integer samples in bins of width 1 are exact ...
+      if (hi - lo > 1) {
+        BOOST_CHECK_LE(double(hi - lo) / v, max_error);
+      }
+      // ... the bin boundaries map back to the same bin ...
+      BOOST_CHECK_EQUAL(bin.sample2bin(lo), i);
+      BOOST_CHECK_EQUAL(bin.sample2bin(hi - 1), i);
+    }
+  }
+}
+
+/**
+ * @test Verify that jb::log_linear_binning uses a small number of
+ * bins for wide ranges.
+ */
+BOOST_AUTO_TEST_CASE(log_linear_binning_wide_range) {
+  // ... one nanosecond to one hour, in nanoseconds ...
+  std::int64_t const one_hour = 3600LL * 1000 * 1000 * 1000;
+  jb::log_linear_binning<std::int64_t> bin(0, one_hour, 2);
+  BOOST_CHECK_GE(bin.histogram_max(), one_hour);
+  BOOST_CHECK_LT(bin.sample2bin(bin.histogram_max()), 5000);
+
+  jb::log_linear_binning<std::int64_t> precise(0, one_hour, 3);
+  BOOST_CHECK_LT(precise.sample2bin(precise.histogram_max()), 40000);
+}
+
+/**
+ * @test Verify that jb::log_linear_binning is linear when the number
+ * of significant digits covers the range.
+ */
+BOOST_AUTO_TEST_CASE(log_linear_binning_linear) {
+  using binning = jb::log_linear_binning<std::int64_t>;
+  BOOST_CHECK_EQUAL(binning::linear_digits(0, 10), 1);
+  BOOST_CHECK_EQUAL(binning::linear_digits(0, 11), 2);
+  BOOST_CHECK_EQUAL(binning::linear_digits(0, 1000000), 6);
+  BOOST_CHECK_EQUAL(binning::linear_digits(0, 1000001), 7);
+
+  binning bin(100, 1100, binning::linear_digits(100, 1100));
+  BOOST_CHECK_EQUAL(bin.histogram_min(), 100);
+  BOOST_CHECK_EQUAL(bin.histogram_max(), 1100);
+  for (std::int64_t v = 100; v != 1100; ++v) {
+    BOOST_CHECK_EQUAL(bin.sample2bin(v), v - 100);
+    BOOST_CHECK_EQUAL(bin.bin2sample(v - 100), v);
+  }
+}
+
+/**
+ * @test Verify that jb::log_linear_binning works with jb::histogram.
+ */
+BOOST_AUTO_TEST_CASE(log_linear_binning_histogram) {
+  typedef jb::histogram<jb::log_linear_binning<std::int64_t>> histogram;
+  histogram h(histogram::binning_strategy(0, 1000000, 2));
+  for (std::int64_t v = 1; v <= 1000; ++v) {
+    h.sample(v * 1000);
+  }
+  BOOST_CHECK_EQUAL(h.nsamples(), 1000);
+  BOOST_CHECK_EQUAL(h.observed_min(), 1000);
+  BOOST_CHECK_EQUAL(h.observed_max(), 1000000);
+  BOOST_CHECK_EQUAL(h.underflow_count(), 0);
+  BOOST_CHECK_EQUAL(h.overflow_count(), 0);
+  auto p50 = h.estimated_quantile(0.5);
+  BOOST_CHECK_GE(p50, 500000 * 0.99);
+  BOOST_CHECK_LE(p50, 500000 * 1.01);
+  auto p90 = h.estimated_quantile(0.9);
+  BOOST_CHECK_GE(p90, 900000 * 0.99);
+  BOOST_CHECK_LE(p90, 900000 * 1.01);
+}
@@ -0,0 +1,135 @@
+#include <jb/explicit_cuts_binning.hpp>
+#include <jb/integer_range_binning.hpp>
+#include <jb/metrics.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <thread>
+#include <vector>
+
+/**
+ * @test Verify that jb::metrics::counter and jb::metrics::gauge work
+ * as expected.
+ */
+BOOST_AUTO_TEST_CASE(metrics_counter_and_gauge) {
+  jb::metrics::registry tested;
+  auto& c = tested.make_counter("messages_total", "the number of messages");
+  c.inc();
+  c.inc(41);
+  BOOST_CHECK_EQUAL(c.value(), 42);
+
+  // ... the same name and labels return the same counter ...
+  BOOST_CHECK_EQUAL(&tested.make_counter("messages_total", "ignored"), &c);
+  auto& a = tested.make_counter(
+      "messages_total", "ignored", {{"session", "A\"1"}});
+  BOOST_CHECK_NE(&a, &c);
+  a.inc(7);
+
+  auto& g = tested.make_gauge("queue_depth", "the depth of the queue");
+  g.set(10);
+  g.add(-2.5);
+  BOOST_CHECK_EQUAL(g.value(), 7.5);
+
+  // ... a name cannot be reused for a different type ...
+  BOOST_CHECK_THROW(
+      tested.make_gauge("messages_total", "oops"), std::invalid_argument);
+
+  std::string body;
+  tested.append_text(body);
+  BOOST_TEST_MESSAGE("body=\n" << body);
+  BOOST_CHECK_EQUAL(
+      body, "# HELP messages_total the number of messages\n"
+            "# TYPE messages_total counter\n"
+            "messages_total 42\n"
+            "messages_total{session=\"A\\\"1\"} 7\n"
+            "# HELP queue_depth the depth of the queue\n"
+            "# TYPE queue_depth gauge\n"
+            "queue_depth 7.5\n");
+}
+
+/**
+ * @test Verify that jb::metrics::histogram works as expected.
+ */
+BOOST_AUTO_TEST_CASE(metrics_histogram) {
+  using binning = jb::explicit_cuts_binning<std::int64_t>;
+  jb::metrics::registry tested;
+  auto& h = tested.make_histogram(
+      "latency_nanoseconds", "the latency", binning({0, 10, 100, 1000}),
+      {{"stage", "book"}});
+  BOOST_CHECK_EQUAL(
+      &tested.make_histogram(
+          "latency_nanoseconds", "ignored", binning({0, 10}),
+          {{"stage", "book"}}),
+      &h);
+  // ... a different binning strategy is a different type ...
+  BOOST_CHECK_THROW(
+      tested.make_histogram(
+          "latency_nanoseconds", "ignored",
+          jb::integer_range_binning<std::int64_t>(0, 10), {{"stage", "book"}}),
+      std::invalid_argument);
+
+  // ... an empty histogram has an empty snapshot ...
+  BOOST_CHECK_EQUAL(h.snapshot().nsamples(), 0);
+
+  jb::histogram<binning, std::uint64_t> expected(binning({0, 10, 100, 1000}));
+  for (auto s : {5, 7, 50, 500, 5000}) {
+    h.sample(s);
+    expected.sample(s);
+  }
+  BOOST_CHECK_EQUAL(h.nsamples(), 5);
+  BOOST_CHECK_EQUAL(h.sum(), 5562);
+
+  auto snapshot = h.snapshot();
+  BOOST_CHECK_EQUAL(snapshot.nsamples(), 5);
+  BOOST_CHECK_EQUAL(snapshot.observed_min(), 5);
+  BOOST_CHECK_EQUAL(snapshot.observed_max(), 5000);
+  BOOST_CHECK_EQUAL(snapshot.overflow_count(), 1);
+  for (auto q : {0.0, 0.25, 0.5, 0.75, 0.9, 1.0}) {
+    BOOST_CHECK_EQUAL(
+        snapshot.estimated_quantile(q), expected.estimated_quantile(q));
+  }
+
+  std::string body;
+  tested.append_text(body);
+  BOOST_TEST_MESSAGE("body=\n" << body);
+  BOOST_CHECK_EQUAL(
+      body, "# HELP latency_nanoseconds the latency\n"
+            "# TYPE latency_nanoseconds histogram\n"
+            "latency_nanoseconds_bucket{stage=\"book\",le=\"9\"} 2\n"
+            "latency_nanoseconds_bucket{stage=\"book\",le=\"99\"} 3\n"
+            "latency_nanoseconds_bucket{stage=\"book\",le=\"999\"} 4\n"
+            "latency_nanoseconds_bucket{stage=\"book\",le=\"+Inf\"} 5\n"
+            "latency_nanoseconds_sum{stage=\"book\"} 5562\n"
+            "latency_nanoseconds_count{stage=\"book\"} 5\n");
+}
+
+/**
+ * @test Verify that jb::metrics aggregates the updates from many
+ * threads, including more threads than shards.
+ */
+BOOST_AUTO_TEST_CASE(metrics_threads) {
+  using binning = jb::integer_range_binning<std::int64_t>;
+  jb::metrics::registry tested;
+  auto& c = tested.make_counter("count", "a counter");
+  auto& h = tested.make_histogram("histo", "a histogram", binning(0, 100));
+
+  int const nthreads = 2 * jb::metrics::detail::shard_count;
+  int const iterations = 10000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t != nthreads; ++t) {
+    threads.emplace_back([&c, &h, t]() {
+      for (int i = 0; i != iterations; ++i) {
+        c.inc();
+        h.sample(t);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  BOOST_CHECK_EQUAL(c.value(), nthreads * iterations);
+  auto s = h.snapshot();
+  BOOST_CHECK_EQUAL(s.nsamples(), nthreads * iterations);
+  BOOST_CHECK_EQUAL(s.observed_min(), 0);
+  BOOST_CHECK_EQUAL(s.observed_max(), nthreads - 1);
+}
@@ -0,0 +1,168 @@
+#include <jb/integer_range_binning.hpp>
+#include <jb/metrics.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <limits>
+#include <sstream>
+
+namespace {
+/// Find a decoded metric by name and labels, return null if not found
+jb::metrics::binary::decoded_metric const* find(
+    jb::metrics::binary::decoded_metrics const& m, std::string const& name,
+    std::string const& labels = "") {
+  for (auto const& i : m.metrics) {
+    if (i.name == name and i.labels == labels) {
+      return &i;
+    }
+  }
+  return nullptr;
+}
+} // anonymous namespace
+
+/**
+ * @test Verify that the varint and zigzag encodings round trip.
+ */
+BOOST_AUTO_TEST_CASE(metrics_binary_varint) {
+  using namespace jb::metrics::binary;
+  std::string buffer;
+  put_varint(buffer, 1);
+  BOOST_CHECK_EQUAL(buffer.size(), 1);
+  put_varint(buffer, 300);
+  BOOST_CHECK_EQUAL(buffer.size(), 3);
+  put_zigzag(buffer, -1);
+  BOOST_CHECK_EQUAL(buffer.size(), 4);
+
+  // ... use counter records to decode arbitrary values ...
+  std::int64_t const values[] = {0, 1, -1, 63, -64, 64, 1000000,
+                                 std::numeric_limits<std::int64_t>::max(),
+                                 std::numeric_limits<std::int64_t>::min()};
+  std::string payload;
+  payload.push_back(static_cast<char>(record_type::counter));
+  put_string(payload, "c");
+  put_string(payload, "");
+  put_zigzag(payload, 0);
+  std::string msg(magic, sizeof(magic));
+  msg.push_back(static_cast<char>(version));
+  put_varint(msg, 7);
+  put_varint(msg, 0);
+  put_varint(msg, sizeof(values) / sizeof(values[0]));
+  for (auto v : values) {
+    std::string record(payload, 0, payload.size() - 1);
+    put_zigzag(record, v);
+    put_varint(msg, record.size());
+    msg += record;
+  }
+  auto decoded = decode(msg);
+  BOOST_CHECK_EQUAL(decoded.sequence, 7);
+  BOOST_REQUIRE_EQUAL(decoded.metrics.size(), 9);
+  for (std::size_t i = 0; i != decoded.metrics.size(); ++i) {
+    BOOST_CHECK_EQUAL(decoded.metrics[i].counter_value, values[i]);
+  }
+
+  // ... truncated and invalid messages are detected ...
+  BOOST_CHECK_THROW(decode(msg.data(), msg.size() - 1), std::runtime_error);
+  BOOST_CHECK_THROW(decode(std::string("JBX")), std::runtime_error);
+  std::string v2 = msg;
+  v2[3] = 2;
+  BOOST_CHECK_THROW(decode(v2), std::runtime_error);
+}
+
+/**
+ * @test Verify that jb::metrics::registry encodes all the metric
+ * types in the binary format.
+ */
+BOOST_AUTO_TEST_CASE(metrics_binary_registry) {
+  using binning = jb::integer_range_binning<std::int64_t>;
+  jb::metrics::registry tested;
+  tested.make_counter("count", "a counter", {{"side", "buy"}}).inc(-5);
+  tested.make_gauge("depth", "a gauge").set(2.5);
+  auto& h = tested.make_histogram("latency", "a histogram", binning(0, 100));
+  for (auto s : {-3, 10, 10, 90, 200}) {
+    h.sample(s);
+  }
+
+  std::string body;
+  auto sequence = tested.append_binary(body, 0);
+  BOOST_CHECK_EQUAL(sequence, 1);
+  auto decoded = jb::metrics::binary::decode(body);
+  BOOST_CHECK_EQUAL(decoded.sequence, 1);
+  BOOST_CHECK_EQUAL(decoded.since, 0);
+  BOOST_REQUIRE_EQUAL(decoded.metrics.size(), 3);
+
+  auto c = find(decoded, "count", "side=\"buy\"");
+  BOOST_REQUIRE(c != nullptr);
+  BOOST_CHECK_EQUAL(c->counter_value, -5);
+  auto g = find(decoded, "depth");
+  BOOST_REQUIRE(g != nullptr);
+  BOOST_CHECK_EQUAL(g->gauge_value, 2.5);
+  auto l = find(decoded, "latency");
+  BOOST_REQUIRE(l != nullptr);
+  BOOST_CHECK_EQUAL(l->count, 5);
+  BOOST_CHECK_EQUAL(l->sum, 307);
+  BOOST_CHECK_EQUAL(l->min, -3);
+  BOOST_CHECK_EQUAL(l->max, 200);
+  BOOST_CHECK_EQUAL(l->underflow, 1);
+  BOOST_CHECK_EQUAL(l->overflow, 1);
+  BOOST_REQUIRE_EQUAL(l->buckets.size(), 2);
+  BOOST_CHECK_EQUAL(l->buckets[0].upper_bound, 11);
+  BOOST_CHECK_EQUAL(l->buckets[0].count, 2);
+  BOOST_CHECK_EQUAL(l->buckets[1].upper_bound, 91);
+  BOOST_CHECK_EQUAL(l->buckets[1].count, 1);
+
+  std::ostringstream os;
+  jb::metrics::binary::print_text(decoded, os);
+  BOOST_TEST_MESSAGE("text=\n" << os.str());
+  auto text = os.str();
+  BOOST_CHECK_NE(text.find("latency_bucket{le=\"90\"} 4\n"), std::string::npos);
+  BOOST_CHECK_NE(text.find("count{side=\"buy\"} -5\n"), std::string::npos);
+}
+
+/**
+ * @test Verify that jb::metrics::registry only encodes the metrics
+ * changed since a previous scrape.
+ */
+BOOST_AUTO_TEST_CASE(metrics_binary_changed) {
+  jb::metrics::registry tested;
+  auto& a = tested.make_counter("a", "a counter");
+  auto& b = tested.make_counter("b", "another counter");
+  auto& g = tested.make_gauge("g", "a gauge");
+
+  std::string body;
+  auto s1 = tested.append_binary(body, 0);
+  BOOST_CHECK_EQUAL(jb::metrics::binary::decode(body).metrics.size(), 3);
+
+  // ... nothing changed ...
+  body.clear();
+  auto s2 = tested.append_binary(body, s1);
+  BOOST_CHECK_GT(s2, s1);
+  BOOST_CHECK_EQUAL(jb::metrics::binary::decode(body).metrics.size(), 0);
+
+  // ... only the changes are included ...
+  a.inc();
+  g.set(1);
+  body.clear();
+  auto s3 = tested.append_binary(body, s2);
+  auto decoded = jb::metrics::binary::decode(body);
+  BOOST_CHECK_EQUAL(decoded.metrics.size(), 2);
+  BOOST_CHECK(find(decoded, "a") != nullptr);
+  BOOST_CHECK(find(decoded, "g") != nullptr);
+
+  // ... another client, which last scraped at s1, sees the same
+  // changes even though they were reported to somebody else ...
+  b.inc();
+  tested.make_counter("new", "a new counter");
+  body.clear();
+  tested.append_binary(body, s1);
+  decoded = jb::metrics::binary::decode(body);
+  BOOST_CHECK_EQUAL(decoded.metrics.size(), 4);
+
+  // ... while the client that scraped at s3 only sees the new changes,
+  // including the new metric ...
+  body.clear();
+  tested.append_binary(body, s3);
+  decoded = jb::metrics::binary::decode(body);
+  BOOST_CHECK_EQUAL(decoded.metrics.size(), 2);
+  BOOST_CHECK(find(decoded, "b") != nullptr);
+  BOOST_CHECK(find(decoded, "new") != nullptr);
+}
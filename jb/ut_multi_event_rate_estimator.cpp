@@ -0,0 +1,130 @@
+#include <jb/multi_event_rate_estimator.hpp>
+#include <jb/event_rate_estimator.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+typedef std::vector<std::pair<std::uint64_t, std::uint64_t>> runs;
+
+/// Append an update, combining consecutive updates with the same rate
+void append(runs& r, std::uint64_t rate, std::uint64_t repeats) {
+  if (not r.empty() and r.back().first == rate) {
+    r.back().second += repeats;
+    return;
+  }
+  r.emplace_back(rate, repeats);
+}
+} // anonymous namespace
+
+/**
+ * @test Verify that jb::multi_event_rate_estimator generates the same
+ * estimates as one jb::event_rate_estimator per resolution.
+ */
+BOOST_AUTO_TEST_CASE(multi_event_rate_estimator_vs_single) {
+  using std::chrono::nanoseconds;
+  using std::chrono::microseconds;
+  using std::chrono::milliseconds;
+  typedef jb::multi_event_rate_estimator<nanoseconds> tested_type;
+  typedef jb::event_rate_estimator<nanoseconds, std::int64_t> single;
+
+  std::vector<tested_type::resolution> resolutions{
+      {milliseconds(1), microseconds(1)},
+      {microseconds(1), nanoseconds(1)},
+      {microseconds(10), microseconds(10)}};
+  tested_type tested(resolutions);
+  BOOST_CHECK_EQUAL(tested.size(), 3);
+  std::vector<single> expected_estimators;
+  for (auto const& r : resolutions) {
+    expected_estimators.emplace_back(r.first, r.second);
+  }
+
+  // ... generate bursts of events separated by gaps of different
+  // lengths, including a few events with the same timestamp and a
+  // couple of timestamps out of order ...
+  std::mt19937_64 generator(20171023);
+  std::uniform_int_distribution<int> burst(1, 50);
+  std::uniform_int_distribution<std::int64_t> within(0, 700);
+  std::uniform_int_distribution<std::int64_t> gap(0, 3000000);
+  std::vector<nanoseconds> timestamps;
+  std::int64_t ts = 34200000000000;
+  for (int i = 0; i != 200; ++i) {
+    for (int j = burst(generator); j != 0; --j) {
+      ts += within(generator);
+      timestamps.emplace_back(ts);
+    }
+    timestamps.emplace_back(ts - 5);
+    ts += gap(generator);
+  }
+
+  std::vector<runs> actual(resolutions.size());
+  std::vector<runs> expected(resolutions.size());
+  for (auto t : timestamps) {
+    tested.sample(
+        t, [&actual](std::size_t i, std::uint64_t rate, std::uint64_t n) {
+          append(actual.at(i), rate, n);
+        });
+    for (std::size_t i = 0; i != expected_estimators.size(); ++i) {
+      auto& e = expected[i];
+      expected_estimators[i].sample(
+          t, [&e](std::uint64_t rate, std::uint64_t n) { append(e, rate, n); });
+    }
+  }
+
+  for (std::size_t i = 0; i != resolutions.size(); ++i) {
+    BOOST_TEST_MESSAGE("checking resolution " << i);
+    BOOST_REQUIRE_EQUAL(actual[i].size(), expected[i].size());
+    for (std::size_t j = 0; j != actual[i].size(); ++j) {
+      BOOST_CHECK_EQUAL(actual[i][j].first, expected[i][j].first);
+      BOOST_CHECK_EQUAL(actual[i][j].second, expected[i][j].second);
+    }
+  }
+}
+
+/**
+ * @test Verify that jb::multi_event_rate_estimator skips long gaps
+ * with a few updates.
+ */
+BOOST_AUTO_TEST_CASE(multi_event_rate_estimator_jump) {
+  using std::chrono::microseconds;
+  typedef jb::multi_event_rate_estimator<microseconds> tested_type;
+  tested_type tested({{microseconds(1000), microseconds(1)}});
+
+  int calls = 0;
+  runs r;
+  auto update = [&](std::size_t, std::uint64_t rate, std::uint64_t n) {
+    ++calls;
+    append(r, rate, n);
+  };
+  tested.sample(microseconds(10), update);
+  tested.sample(microseconds(11), update);
+  tested.sample(microseconds(12), update);
+  BOOST_CHECK_EQUAL(calls, 2);
+
+  calls = 0;
+  r.clear();
+  tested.sample(microseconds(5012), update);
+  BOOST_CHECK_EQUAL(calls, 4);
+  runs expected{{3, 998}, {2, 1}, {1, 1}, {0, 4000}};
+  BOOST_REQUIRE_EQUAL(r.size(), expected.size());
+  for (std::size_t j = 0; j != r.size(); ++j) {
+    BOOST_CHECK_EQUAL(r[j].first, expected[j].first);
+    BOOST_CHECK_EQUAL(r[j].second, expected[j].second);
+  }
+}
+
+/**
+ * @test Verify that jb::multi_event_rate_estimator validates its
+ * arguments.
+ */
+BOOST_AUTO_TEST_CASE(multi_event_rate_estimator_errors) {
+  using std::chrono::seconds;
+  typedef jb::multi_event_rate_estimator<seconds> tested;
+  BOOST_CHECK_THROW(tested({{seconds(2), seconds(0)}}), std::invalid_argument);
+  BOOST_CHECK_THROW(tested({{seconds(2), seconds(3)}}), std::invalid_argument);
+  BOOST_CHECK_THROW(tested({{seconds(3), seconds(2)}}), std::invalid_argument);
+  BOOST_CHECK_NO_THROW(tested({{seconds(4), seconds(2)}}));
+}
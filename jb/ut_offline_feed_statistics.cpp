@@ -76,6 +76,8 @@ BOOST_AUTO_TEST_CASE(offline_feed_statististics_config_simple) {
       config().max_interarrival_time_nanoseconds(-7).validate(), jb::usage);
   BOOST_CHECK_THROW(
       config().max_processing_latency_nanoseconds(-7).validate(), jb::usage);
+  BOOST_CHECK_THROW(config().significant_digits(-1).validate(), jb::usage);
+  BOOST_CHECK_THROW(config().significant_digits(16).validate(), jb::usage);
   BOOST_CHECK_THROW(
       config().reporting_interval_seconds(-1).validate(), jb::usage);
   BOOST_CHECK_NO_THROW(config().reporting_interval_seconds(0).validate());
@@ -112,3 +114,144 @@ BOOST_AUTO_TEST_CASE(offline_feed_statististics_coverage) {
       std::chrono::microseconds(5));
   BOOST_CHECK_NO_THROW(stats.log_final_progress());
 }
+
+/**
+ * @test Verify that jb::offline_feed_statistics can use log-linear
+ * histograms to cover large latencies.
+ */
+BOOST_AUTO_TEST_CASE(offline_feed_statististics_significant_digits) {
+  std::int64_t const one_hour = 3600LL * 1000 * 1000 * 1000;
+  auto cfg = jb::offline_feed_statistics::config()
+                 .max_processing_latency_nanoseconds(one_hour)
+                 .max_interarrival_time_nanoseconds(one_hour)
+                 .significant_digits(2);
+  BOOST_CHECK_NO_THROW(cfg.validate());
+  jb::offline_feed_statistics stats(cfg);
+  stats.sample(std::chrono::seconds(1), std::chrono::microseconds(1));
+  stats.sample(std::chrono::seconds(2), std::chrono::minutes(10));
+  stats.sample(std::chrono::seconds(3), std::chrono::milliseconds(1));
+
+  std::ostringstream body;
+  stats.print_csv("testing", body);
+  BOOST_CHECK_EQUAL(body.str().substr(0, 10), std::string("testing,3,"));
+  // ... the maximum is not in the overflow bucket, it is preserved
+  // exactly in any case ...
+  std::string b = body.str();
+  BOOST_CHECK_NE(b.find(",600000000000\n"), std::string::npos);
+}
+
+namespace {
+/// Generate a deterministic stream of events for the merge tests
+void fill_stats(jb::offline_feed_statistics& stats, int n) {
+  auto ts = std::chrono::nanoseconds(std::chrono::seconds(34200));
+  for (int i = 0; i != n; ++i) {
+    ts += std::chrono::nanoseconds((i * 7919) % 100000);
+    stats.sample(ts, std::chrono::nanoseconds(100 + (i * 104729) % 5000));
+  }
+}
+} // anonymous namespace
+
+/**
+ * @test Verify that jb::offline_feed_statistics can be merged and
+ * encoded.
+ */
+BOOST_AUTO_TEST_CASE(offline_feed_statististics_merge) {
+  auto cfg = jb::offline_feed_statistics::config().significant_digits(2);
+  jb::offline_feed_statistics a(cfg);
+  jb::offline_feed_statistics b(cfg);
+  fill_stats(a, 20000);
+  fill_stats(b, 20000);
+
+  // ... both inputs are identical, so the merged quantiles are the
+  // same, only the number of samples changes ...
+  std::ostringstream os;
+  a.print_csv("testing", os);
+  auto expected = os.str();
+  expected.replace(0, expected.find(',', 8), "testing,40000");
+
+  jb::offline_feed_statistics merged(cfg);
+  merged += a;
+  merged += b;
+  os.str("");
+  merged.print_csv("testing", os);
+  BOOST_CHECK_EQUAL(os.str(), expected);
+
+  std::string buffer;
+  a.encode(buffer);
+  b.encode(buffer);
+  jb::offline_feed_statistics decoded(cfg);
+  jb::metrics::binary::reader r(buffer.data(), buffer.size());
+  decoded.merge_encoded(r);
+  decoded.merge_encoded(r);
+  BOOST_CHECK(r.done());
+  os.str("");
+  decoded.print_csv("testing", os);
+  BOOST_CHECK_EQUAL(os.str(), expected);
+
+  // ... the encoding is versioned ...
+  buffer[0] = 42;
+  jb::metrics::binary::reader bad(buffer.data(), buffer.size());
+  BOOST_CHECK_THROW(decoded.merge_encoded(bad), std::runtime_error);
+
+  // ... and the configurations must match ...
+  jb::offline_feed_statistics::config linear;
+  jb::offline_feed_statistics other(linear);
+  BOOST_CHECK_THROW(other.merge(a), std::invalid_argument);
+}
+
+/**
+ * @test Verify that jb::offline_feed_statistics can record latencies
+ * in quantile sketches.
+ */
+BOOST_AUTO_TEST_CASE(offline_feed_statististics_sketch) {
+  auto cfg = jb::offline_feed_statistics::config()
+                 .max_processing_latency_nanoseconds(1000)
+                 .processing_latency_sketch_k(200)
+                 .interarrival_sketch_k(200);
+  BOOST_CHECK_NO_THROW(cfg.validate());
+  jb::offline_feed_statistics a(cfg);
+  jb::offline_feed_statistics b(cfg);
+  fill_stats(a, 20000);
+  fill_stats(b, 20000);
+  // ... the sketch has no range, a large value is not an overflow ...
+  a.sample(std::chrono::seconds(40000), std::chrono::minutes(10));
+
+  std::ostringstream os;
+  a.print_csv("testing", os);
+  BOOST_CHECK_NE(os.str().find(",600000000000\n"), std::string::npos);
+
+  std::string buffer;
+  a.encode(buffer);
+  b.encode(buffer);
+  jb::offline_feed_statistics decoded(cfg);
+  jb::metrics::binary::reader r(buffer.data(), buffer.size());
+  decoded.merge_encoded(r);
+  decoded.merge_encoded(r);
+  BOOST_CHECK(r.done());
+  os.str("");
+  decoded.print_csv("testing", os);
+  BOOST_CHECK_EQUAL(os.str().substr(0, 14), std::string("testing,40001,"));
+
+  // ... a sketch cannot be merged with a histogram ...
+  jb::offline_feed_statistics::config histograms;
+  jb::offline_feed_statistics other(histograms);
+  fill_stats(other, 100);
+  std::ostringstream before;
+  other.print_csv("testing", before);
+  BOOST_CHECK_THROW(other.merge(a), std::invalid_argument);
+  jb::metrics::binary::reader r2(buffer.data(), buffer.size());
+  BOOST_CHECK_THROW(other.merge_encoded(r2), std::runtime_error);
+  // ... and a failed merge leaves the statistics unchanged ...
+  std::ostringstream after;
+  other.print_csv("testing", after);
+  BOOST_CHECK_EQUAL(before.str(), after.str());
+
+  BOOST_CHECK_THROW(
+      jb::offline_feed_statistics::config().interarrival_sketch_k(4).validate(),
+      jb::usage);
+  BOOST_CHECK_THROW(
+      jb::offline_feed_statistics::config()
+          .processing_latency_sketch_k(-1)
+          .validate(),
+      jb::usage);
+}
@@ -0,0 +1,63 @@
+#include <jb/spsc_ring.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <thread>
+
+/**
+ * @test Verify that jb::spsc_ring works as expected.
+ */
+BOOST_AUTO_TEST_CASE(spsc_ring_basic) {
+  jb::spsc_ring<int> ring(3);
+  BOOST_CHECK_EQUAL(ring.capacity(), 4);
+  BOOST_CHECK_EQUAL(jb::spsc_ring<int>(4).capacity(), 4);
+  BOOST_CHECK_EQUAL(jb::spsc_ring<int>(0).capacity(), 2);
+
+  for (int i = 0; i != 4; ++i) {
+    BOOST_CHECK(ring.try_push(i));
+  }
+  BOOST_CHECK(not ring.try_push(4));
+  BOOST_CHECK_EQUAL(ring.size(), 4);
+
+  std::vector<int> values;
+  auto f = [&values](int x) { values.push_back(x); };
+  BOOST_CHECK_EQUAL(ring.consume(f, 3), 3);
+  BOOST_CHECK(ring.try_push(5));
+  BOOST_CHECK_EQUAL(ring.consume(f, 10), 2);
+  BOOST_CHECK_EQUAL(ring.consume(f, 10), 0);
+  std::vector<int> expected{0, 1, 2, 3, 5};
+  BOOST_CHECK_EQUAL_COLLECTIONS(
+      values.begin(), values.end(), expected.begin(), expected.end());
+  BOOST_CHECK_EQUAL(ring.size(), 0);
+}
+
+/**
+ * @test Verify that jb::spsc_ring works across threads.
+ */
+BOOST_AUTO_TEST_CASE(spsc_ring_threads) {
+  jb::spsc_ring<int> ring(16);
+  int const count = 100000;
+  std::thread producer([&ring]() {
+    for (int i = 0; i != count; ++i) {
+      while (not ring.try_push(i)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  int expected = 0;
+  bool in_order = true;
+  while (expected != count) {
+    auto n = ring.consume(
+        [&](int x) {
+          in_order = in_order and x == expected;
+          ++expected;
+        },
+        8);
+    if (n == 0) {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  BOOST_CHECK(in_order);
+  BOOST_CHECK_EQUAL(expected, count);
+}
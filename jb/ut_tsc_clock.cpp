@@ -0,0 +1,69 @@
+#include <jb/tsc_clock.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <thread>
+
+namespace {
+/// The absolute difference between jb::tsc_clock and steady_clock, in ns
+std::int64_t clock_difference() {
+  auto a = std::chrono::steady_clock::now();
+  auto t = jb::tsc_clock::now();
+  auto b = std::chrono::steady_clock::now();
+  auto midpoint = a + (b - a) / 2;
+  auto d = t < midpoint ? midpoint - t : t - midpoint;
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+}
+
+/// The tolerance for the difference between the clocks, in ns
+std::int64_t const tolerance = 1000000;
+} // anonymous namespace
+
+/**
+ * @test Verify that jb::tsc_clock is calibrated as expected.
+ */
+BOOST_AUTO_TEST_CASE(tsc_clock_calibration) {
+  // ... now() never calibrates the clock, it uses the steady clock
+  // until the application calibrates it ...
+  BOOST_CHECK(
+      jb::detail::tsc_clock_global_state.mode.load() ==
+      jb::detail::tsc_clock_mode::uninitialized);
+  BOOST_CHECK_LT(clock_difference(), tolerance);
+  jb::tsc_clock::calibrate();
+  BOOST_CHECK(
+      jb::detail::tsc_clock_global_state.mode.load() !=
+      jb::detail::tsc_clock_mode::uninitialized);
+  BOOST_CHECK_EQUAL(jb::tsc_clock::invariant_tsc(), jb::tsc_clock::uses_tsc());
+  if (jb::tsc_clock::uses_tsc()) {
+    BOOST_CHECK_GT(jb::tsc_clock::frequency(), 1e8);
+    BOOST_CHECK_LT(jb::tsc_clock::frequency(), 1e10);
+  } else {
+    BOOST_CHECK_EQUAL(jb::tsc_clock::frequency(), 0.0);
+  }
+
+  // ... the clocks share the epoch, the difference is mostly
+  // calibration error, the tolerance is generous because the tests
+  // often run in virtual machines ...
+  BOOST_CHECK_LT(clock_difference(), tolerance);
+}
+
+/**
+ * @test Verify that jb::tsc_clock is monotonic and tracks the steady
+ * clock after the calibration is refreshed.
+ */
+BOOST_AUTO_TEST_CASE(tsc_clock_drift) {
+  auto previous = jb::tsc_clock::now();
+  int backwards = 0;
+  for (int i = 0; i != 6; ++i) {
+    // ... sleep for about the recalibration period ...
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    jb::tsc_clock::recalibrate();
+    for (int j = 0; j != 1000; ++j) {
+      auto t = jb::tsc_clock::now();
+      backwards += t < previous;
+      previous = t;
+    }
+    BOOST_CHECK_LT(clock_difference(), tolerance);
+  }
+  BOOST_CHECK_EQUAL(backwards, 0);
+}
@@ -0,0 +1,498 @@
+/**
+ * @file
+ *
+ * Run the ITCH-5.0 analytics over many input files in parallel.
+ *
+ * Research runs process months of daily files with itch5stats,
+ * itch5inside or itch5bookdepth.  This program processes a list of
+ * files (or glob patterns) on a pool of worker threads, see
+ * jb::batch_driver for details.  For each input file it writes the
+ * same statistics the single file programs generate, and once all
+ * the files are processed it writes the statistics aggregated over
+ * all the files.
+ *
+ * The output for an input file called 20171002.NASDAQ_ITCH50.gz is
+ * stored in the output directory:
+ *   - 20171002.NASDAQ_ITCH50.stats.csv in stats mode,
+ *   - 20171002.NASDAQ_ITCH50.inside.csv and
+ *     20171002.NASDAQ_ITCH50.inside.gz in inside mode,
+ *   - 20171002.NASDAQ_ITCH50.bookdepth.csv in bookdepth mode.
+ * The aggregated statistics are stored in aggregate.<mode>.csv.
+ */
+#include <jb/itch5/array_based_order_book.hpp>
+#include <jb/itch5/clock_type.hpp>
+#include <jb/itch5/compute_book.hpp>
+#include <jb/itch5/generate_inside.hpp>
+#include <jb/itch5/per_symbol_statistics.hpp>
+#include <jb/itch5/price_levels.hpp>
+#include <jb/itch5/process_iostream.hpp>
+#include <jb/batch_driver.hpp>
+#include <jb/book_depth_statistics.hpp>
+#include <jb/fast_format.hpp>
+#include <jb/fileio.hpp>
+#include <jb/log.hpp>
+#include <jb/offline_feed_statistics.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+
+/**
+ * Define types and functions used in this program.
+ */
+namespace {
+
+/// Configuration parameters for itch5batch
+class config : public jb::config_object {
+public:
+  config();
+  config_object_constructors(config);
+
+  void validate() const override;
+
+  jb::config_attribute<config, std::vector<std::string>> input_files;
+  jb::config_attribute<config, std::string> output_directory;
+  jb::config_attribute<config, std::string> mode;
+  jb::config_attribute<config, jb::batch_driver::config> batch;
+  jb::config_attribute<config, jb::log::config> log;
+  jb::config_attribute<config, jb::offline_feed_statistics::config> stats;
+  jb::config_attribute<config, jb::offline_feed_statistics::config>
+      symbol_stats;
+  jb::config_attribute<config, jb::book_depth_statistics::config> depth_stats;
+  jb::config_attribute<config, jb::book_depth_statistics::config>
+      depth_symbol_stats;
+  jb::config_attribute<config, bool> enable_symbol_stats;
+  jb::config_attribute<config, bool> enable_array_based;
+  using book_config = typename jb::itch5::array_based_order_book::config;
+  jb::config_attribute<config, book_config> book_cfg;
+};
+
+/**
+ * Compute the name of an output file.
+ *
+ * @param cfg the program configuration
+ * @param input_file the name of the input file
+ * @param suffix the suffix for the output file, e.g. "stats.csv"
+ */
+std::string output_file(
+    config const& cfg, std::string const& input_file,
+    std::string const& suffix) {
+  boost::filesystem::path input(input_file);
+  // ... drop the .gz extension of the input file, the suffix
+  // determines if the output file is compressed ...
+  auto basename = input.extension() == ".gz" ? input.stem() : input.filename();
+  auto output = boost::filesystem::path(cfg.output_directory()) /
+                (basename.string() + "." + suffix);
+  return output.string();
+}
+
+/**
+ * Verify that no two input files write to the same output files.
+ *
+ * The output files only use the basename of the input files, so
+ * files with the same name in different directories (or the same
+ * file compressed and uncompressed) would overwrite each other.
+ *
+ * @throw jb::usage if two input files have the same output files
+ */
+void check_output_names(
+    config const& cfg, std::vector<std::string> const& files) {
+  std::string const suffix = cfg.mode() + ".csv";
+  std::map<std::string, std::string> outputs;
+  outputs.emplace(output_file(cfg, "aggregate", suffix), "the aggregate");
+  for (auto const& f : files) {
+    auto r = outputs.emplace(output_file(cfg, f, suffix), f);
+    if (not r.second) {
+      throw jb::usage(
+          "Input file " + f + " has the same output files as " +
+              r.first->second + ", rename one of them.",
+          1);
+    }
+  }
+}
+
+/**
+ * Write the statistics for one file.
+ *
+ * @param filename the name of the output file
+ * @param per_symbol the statistics for each symbol
+ * @param stats the statistics for all the symbols
+ */
+template <typename statistics, typename per_symbol_type>
+void write_statistics(
+    std::string const& filename, per_symbol_type const& per_symbol,
+    statistics const& stats) {
+  boost::iostreams::filtering_ostream out;
+  jb::open_output_file(out, filename);
+  statistics::print_csv_header(out);
+  per_symbol.for_each([&out](auto const& stock, auto const& s) {
+    s.print_csv(stock.c_str(), out);
+  });
+  stats.print_csv("__aggregate__", out);
+}
+
+/**
+ * An implementation of jb::message_handler_concept to capture
+ * ITCH-5.0 statistics.
+ */
+class itch5_stats_handler {
+public:
+  explicit itch5_stats_handler(jb::offline_feed_statistics& stats)
+      : stats_(stats) {
+  }
+
+  typedef jb::itch5::time_point time_point;
+
+  time_point now() const {
+    return jb::itch5::clock_type::now();
+  }
+
+  template <typename message_type>
+  void handle_message(
+      time_point recv_ts, long msgcnt, std::size_t msgoffset,
+      message_type const& msg) {
+    auto pl = now() - recv_ts;
+    stats_.sample(msg.header.timestamp.ts, pl);
+  }
+
+  void
+  handle_unknown(time_point recv_ts, jb::itch5::unknown_message const& msg) {
+    char msgtype = *static_cast<char const*>(msg.buf());
+    JB_LOG(error) << "Unknown message type '" << msgtype << "'(" << int(msgtype)
+                  << ") in msgcnt=" << msg.count()
+                  << ", msgoffset=" << msg.offset();
+  }
+
+private:
+  jb::offline_feed_statistics& stats_;
+};
+
+/// Compute the feed statistics, as in itch5stats
+struct stats_mode {
+  typedef jb::offline_feed_statistics statistics;
+
+  static statistics::config const& statistics_config(config const& cfg) {
+    return cfg.stats();
+  }
+
+  static void process(
+      config const& cfg, std::string const& filename, statistics& aggregate) {
+    boost::iostreams::filtering_istream in;
+    jb::open_input_file(in, filename);
+
+    statistics stats(cfg.stats());
+    itch5_stats_handler handler(stats);
+    jb::itch5::process_iostream(in, handler);
+    stats.log_final_progress();
+
+    // ... there are no per-symbol statistics in this mode ...
+    boost::iostreams::filtering_ostream out;
+    jb::open_output_file(out, output_file(cfg, filename, "stats.csv"));
+    statistics::print_csv_header(out);
+    stats.print_csv("__aggregate__", out);
+    aggregate.merge(stats);
+  }
+};
+
+/**
+ * Process a file with the order book type selected in the
+ * configuration, as in itch5inside.
+ *
+ * @tparam mode the analysis, it must define a process_book<>()
+ *   template
+ */
+template <typename mode>
+void run_with_book(
+    config const& cfg, std::string const& filename,
+    typename mode::statistics& aggregate) {
+  if (cfg.enable_array_based()) {
+    mode::template process_book<jb::itch5::array_based_order_book>(
+        cfg, filename, aggregate, cfg.book_cfg());
+  } else {
+    // ... the map based book uses a default config ...
+    typename jb::itch5::map_based_order_book::config cfg_bk;
+    mode::template process_book<jb::itch5::map_based_order_book>(
+        cfg, filename, aggregate, cfg_bk);
+  }
+}
+
+/// Compute the inside and its statistics, as in itch5inside
+struct inside_mode {
+  typedef jb::offline_feed_statistics statistics;
+
+  static statistics::config const& statistics_config(config const& cfg) {
+    return cfg.stats();
+  }
+
+  static void process(
+      config const& cfg, std::string const& filename, statistics& aggregate) {
+    run_with_book<inside_mode>(cfg, filename, aggregate);
+  }
+
+  template <typename book_type, typename cfg_book_t>
+  static void process_book(
+      config const& cfg, std::string const& filename, statistics& aggregate,
+      cfg_book_t const& cfg_book) {
+    boost::iostreams::filtering_istream in;
+    jb::open_input_file(in, filename);
+
+    boost::iostreams::filtering_ostream out;
+    jb::open_output_file(out, output_file(cfg, filename, "inside.gz"));
+    jb::fast_format fmt(out);
+
+    jb::itch5::per_symbol_statistics<statistics> per_symbol(
+        cfg.symbol_stats());
+    statistics stats(cfg.stats());
+    bool const enable_symbol_stats = cfg.enable_symbol_stats();
+
+    typename jb::itch5::compute_book<book_type>::callback_type cb =
+        [&stats, &fmt, &per_symbol, enable_symbol_stats](
+            jb::itch5::message_header const& header,
+            jb::itch5::order_book<book_type> const& updated_book,
+            jb::itch5::book_update const& update) {
+          auto pl = jb::itch5::clock_type::now() - update.recvts;
+          if (not jb::itch5::generate_inside(
+                  stats, fmt, header, updated_book, update, pl)) {
+            return;
+          }
+          if (enable_symbol_stats) {
+            per_symbol.get(header.stock_locate, update.stock)
+                .sample(header.timestamp.ts, pl);
+          }
+        };
+
+    jb::itch5::compute_book<book_type> handler(std::move(cb), cfg_book);
+    jb::itch5::process_iostream(in, handler);
+    fmt.flush();
+    stats.log_final_progress();
+
+    write_statistics(
+        output_file(cfg, filename, "inside.csv"), per_symbol, stats);
+    aggregate.merge(stats);
+  }
+};
+
+/// Compute the book depth statistics, as in itch5bookdepth
+struct bookdepth_mode {
+  typedef jb::book_depth_statistics statistics;
+
+  static statistics::config const& statistics_config(config const& cfg) {
+    return cfg.depth_stats();
+  }
+
+  static void process(
+      config const& cfg, std::string const& filename, statistics& aggregate) {
+    run_with_book<bookdepth_mode>(cfg, filename, aggregate);
+  }
+
+  template <typename book_type, typename cfg_book_t>
+  static void process_book(
+      config const& cfg, std::string const& filename, statistics& aggregate,
+      cfg_book_t const& cfg_book) {
+    boost::iostreams::filtering_istream in;
+    jb::open_input_file(in, filename);
+
+    jb::itch5::per_symbol_statistics<statistics> per_symbol(
+        cfg.depth_symbol_stats());
+    statistics stats(cfg.depth_stats());
+    bool const enable_symbol_stats = cfg.enable_symbol_stats();
+
+    typename jb::itch5::compute_book<book_type>::callback_type cb =
+        [&stats, &per_symbol, enable_symbol_stats](
+            jb::itch5::message_header const& header,
+            jb::itch5::order_book<book_type> const& book,
+            jb::itch5::book_update const& update) {
+          auto depth =
+              jb::itch5::price_levels(
+                  book.worst_bid().first, book.best_bid().first) +
+              jb::itch5::price_levels(
+                  book.best_offer().first, book.worst_offer().first);
+          stats.sample(depth);
+          if (enable_symbol_stats) {
+            per_symbol.get(header.stock_locate, update.stock).sample(depth);
+          }
+        };
+
+    jb::itch5::compute_book<book_type> handler(std::move(cb), cfg_book);
+    jb::itch5::process_iostream(in, handler);
+
+    write_statistics(
+        output_file(cfg, filename, "bookdepth.csv"), per_symbol, stats);
+    aggregate.merge(stats);
+  }
+};
+
+/**
+ * Process all the files in a given mode.
+ *
+ * Each worker merges the statistics of the files it processes into
+ * its own aggregate, the aggregates for all the workers are merged
+ * at the end.
+ *
+ * @return the number of files that could not be processed
+ */
+template <typename mode>
+int run_batch(config const& cfg, std::vector<std::string> const& files) {
+  typedef typename mode::statistics statistics;
+
+  jb::batch_driver driver(cfg.batch());
+  std::vector<std::unique_ptr<statistics>> aggregates;
+  for (int i = 0; i != driver.workers(); ++i) {
+    aggregates.push_back(
+        std::make_unique<statistics>(mode::statistics_config(cfg)));
+  }
+
+  JB_LOG(info) << "processing " << files.size() << " files with "
+               << driver.workers() << " workers";
+  int failures =
+      driver.run(files, [&cfg, &aggregates](int worker, std::string const& f) {
+        mode::process(cfg, f, *aggregates[worker]);
+      });
+
+  statistics& total = *aggregates.front();
+  for (std::size_t i = 1; i != aggregates.size(); ++i) {
+    total.merge(*aggregates[i]);
+  }
+  boost::iostreams::filtering_ostream out;
+  jb::open_output_file(
+      out, output_file(cfg, "aggregate", cfg.mode() + ".csv"));
+  statistics::print_csv_header(out);
+  total.print_csv("__aggregate__", out);
+  return failures;
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) try {
+  config cfg;
+  cfg.load_overrides(argc, argv, std::string("itch5batch.yaml"), "JB_ROOT");
+  jb::log::init(cfg.log());
+  jb::itch5::calibrate_clock();
+
+  auto files = jb::batch_driver::expand(cfg.input_files());
+  check_output_names(cfg, files);
+  boost::filesystem::create_directories(cfg.output_directory());
+
+  int failures = 0;
+  if (cfg.mode() == "stats") {
+    failures = run_batch<stats_mode>(cfg, files);
+  } else if (cfg.mode() == "inside") {
+    failures = run_batch<inside_mode>(cfg, files);
+  } else {
+    failures = run_batch<bookdepth_mode>(cfg, files);
+  }
+  if (failures != 0) {
+    std::cerr << failures << " input files could not be processed"
+              << std::endl;
+    return 1;
+  }
+  return 0;
+} catch (jb::usage const& u) {
+  std::cerr << u.what() << std::endl;
+  return u.exit_status();
+} catch (std::exception const& ex) {
+  std::cerr << "Standard exception raised: " << ex.what() << std::endl;
+  return 1;
+} catch (...) {
+  std::cerr << "Unknown exception raised" << std::endl;
+  return 1;
+}
+
+namespace {
+
+/// Limit the amount of memory used on each per-symbol depth statistics
+#ifndef JB_ITCH5BATCH_DEFAULT_per_symbol_max_book_depth
+#define JB_ITCH5BATCH_DEFAULT_per_symbol_max_book_depth 5000
+#endif // JB_ITCH5BATCH_DEFAULT_per_symbol_max_book_depth
+#ifndef JB_ITCH5BATCH_DEFAULT_per_symbol_significant_digits
+#define JB_ITCH5BATCH_DEFAULT_per_symbol_significant_digits 2
+#endif // JB_ITCH5BATCH_DEFAULT_per_symbol_significant_digits
+
+// Define the default per-symbol depth stats
+jb::book_depth_statistics::config default_per_symbol_depth_stats() {
+  return jb::book_depth_statistics::config()
+      .max_book_depth(JB_ITCH5BATCH_DEFAULT_per_symbol_max_book_depth)
+      .significant_digits(JB_ITCH5BATCH_DEFAULT_per_symbol_significant_digits);
+}
+
+config::config()
+    : input_files(
+          desc("input-files")
+              .help(
+                  "The input files with ITCH-5.0 messages.  Each value can be"
+                  " a file name or a glob pattern, for example"
+                  " 'data/201710*.NASDAQ_ITCH50.gz'."),
+          this)
+    , output_directory(
+          desc("output-directory")
+              .help(
+                  "The directory where to store the results for each input"
+                  " file and the aggregated statistics."),
+          this, ".")
+    , mode(
+          desc("mode").help(
+              "The analysis to run for each file, one of 'stats' (as in"
+              " itch5stats), 'inside' (as in itch5inside) or 'bookdepth'"
+              " (as in itch5bookdepth)."),
+          this, "stats")
+    , batch(desc("batch", "batch-driver"), this)
+    , log(desc("log", "logging"), this)
+    , stats(desc("stats", "offline-feed-statistics"), this)
+    , symbol_stats(
+          desc("symbol-stats", "offline-feed-statistics"), this,
+          jb::itch5::default_per_symbol_feed_statistics())
+    , depth_stats(desc("depth-stats", "book-depth-statistics"), this)
+    , depth_symbol_stats(
+          desc("depth-symbol-stats", "book-depth-statistics-per-symbol"), this,
+          default_per_symbol_depth_stats())
+    , enable_symbol_stats(
+          desc("enable-symbol-stats")
+              .help(
+                  "If set, enable per-symbol statistics in the inside and"
+                  " bookdepth modes.  The statistics for each symbol are"
+                  " allocated when the symbol is first seen, configure their"
+                  " size and precision using --symbol-stats and"
+                  " --depth-symbol-stats."),
+          this, true)
+    , enable_array_based(
+          desc("enable-array-based")
+              .help(
+                  "If set, use array_based_order_book in the inside and"
+                  " bookdepth modes, as in itch5inside."
+                  "  It is disabled by default."),
+          this, false)
+    , book_cfg(desc("book-config", "order-book-config"), this) {
+}
+
+void config::validate() const {
+  if (input_files().empty()) {
+    throw jb::usage(
+        "Missing input-files setting."
+        "  You must specify at least one input file.",
+        1);
+  }
+  if (output_directory() == "") {
+    throw jb::usage(
+        "Missing output-directory setting."
+        "  Use '.' to store the results in the current directory.",
+        1);
+  }
+  if (mode() != "stats" and mode() != "inside" and mode() != "bookdepth") {
+    throw jb::usage(
+        "Invalid mode setting (" + mode() +
+            ").  The mode must be 'stats', 'inside' or 'bookdepth'.",
+        1);
+  }
+  batch().validate();
+  log().validate();
+  stats().validate();
+  symbol_stats().validate();
+  depth_stats().validate();
+  depth_symbol_stats().validate();
+  book_cfg().validate();
+}
+
+} // anonymous namespace
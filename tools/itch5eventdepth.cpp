@@ -10,6 +10,7 @@
  * the change".
  */
 #include <jb/itch5/compute_book.hpp>
+#include <jb/itch5/per_symbol_statistics.hpp>
 #include <jb/itch5/price_levels.hpp>
 #include <jb/itch5/process_iostream.hpp>
 #include <jb/book_depth_statistics.hpp>
@@ -83,7 +84,8 @@ int main(int argc, char* argv[]) try {
   boost::iostreams::filtering_ostream out;
   jb::open_output_file(out, cfg.output_file());
 
-  std::map<jb::itch5::stock_t, jb::book_depth_statistics> per_symbol;
+  jb::itch5::per_symbol_statistics<jb::book_depth_statistics> per_symbol(
+      cfg.symbol_stats());
   jb::book_depth_statistics aggregate_stats(cfg.stats());
 
   jb::itch5::compute_book<jb::itch5::map_based_order_book>::callback_type cb =
@@ -96,20 +98,15 @@ int main(int argc, char* argv[]) try {
       };
 
   if (cfg.enable_symbol_stats()) {
-    jb::book_depth_statistics::config symcfg(cfg.symbol_stats());
     jb::itch5::compute_book<jb::itch5::map_based_order_book>::callback_type
-        chain = [&per_symbol, symcfg, cb](
+        chain = [&per_symbol, cb](
             jb::itch5::message_header const& header,
             jb::itch5::order_book<jb::itch5::map_based_order_book> const& book,
             jb::itch5::book_update const& update) {
           cb(header, book, update);
-          auto location = per_symbol.find(update.stock);
-          if (location == per_symbol.end()) {
-            auto p = per_symbol.emplace(
-                update.stock, jb::book_depth_statistics(symcfg));
-            location = p.first;
-          }
-          record_event_depth(location->second, header, book, update);
+          record_event_depth(
+              per_symbol.get(header.stock_locate, update.stock), header, book,
+              update);
         };
     cb = std::move(chain);
   }
@@ -120,9 +117,9 @@ int main(int argc, char* argv[]) try {
   jb::itch5::process_iostream(in, handler);
 
   jb::book_depth_statistics::print_csv_header(out);
-  for (auto const& i : per_symbol) {
-    i.second.print_csv(i.first.c_str(), out);
-  }
+  per_symbol.for_each([&out](auto const& stock, auto const& s) {
+    s.print_csv(stock.c_str(), out);
+  });
   aggregate_stats.print_csv("__aggregate__", out);
   return 0;
 
@@ -143,11 +140,16 @@ namespace {
 #ifndef JB_ITCH5EVENTDEPTH_DEFAULT_per_symbol_max_book_depth
 #define JB_ITCH5EVENTDEPTH_DEFAULT_per_symbol_max_book_depth 5000
 #endif // JB_ITCH5EVENTDEPTH_DEFAULT_per_symbol_max_book_depth
+#ifndef JB_ITCH5EVENTDEPTH_DEFAULT_per_symbol_significant_digits
+#define JB_ITCH5EVENTDEPTH_DEFAULT_per_symbol_significant_digits 2
+#endif // JB_ITCH5EVENTDEPTH_DEFAULT_per_symbol_significant_digits
 
 /// Create a different default configuration for the per-symbol stats
 jb::book_depth_statistics::config default_per_symbol_stats() {
-  return jb::book_depth_statistics::config().max_book_depth(
-      JB_ITCH5EVENTDEPTH_DEFAULT_per_symbol_max_book_depth);
+  return jb::book_depth_statistics::config()
+      .max_book_depth(JB_ITCH5EVENTDEPTH_DEFAULT_per_symbol_max_book_depth)
+      .significant_digits(
+          JB_ITCH5EVENTDEPTH_DEFAULT_per_symbol_significant_digits);
 }
 
 config::config()
@@ -168,8 +170,9 @@ config::config()
     , enable_symbol_stats(
           desc("enable-symbol-stats")
               .help("If set, enable per-symbol statistics."
-                    "  Collecting per-symbol statistics is expensive in both"
-                    " memory and execution time, enable only if needed."),
+                    "  The statistics for each symbol are allocated when the"
+                    " symbol is first seen, configure their size and"
+                    " precision using --symbol-stats."),
           this, true) {
 }
 
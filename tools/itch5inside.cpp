@@ -10,11 +10,16 @@
  * long did it take to process the event, and what was the elapsed
  * time since the last change to the inside".
  */
+#include <jb/itch5/clock_type.hpp>
 #include <jb/itch5/generate_inside.hpp>
+#include <jb/itch5/per_symbol_statistics.hpp>
+#include <jb/itch5/pipeline_latency.hpp>
 #include <jb/itch5/process_iostream.hpp>
+#include <jb/fast_format.hpp>
 #include <jb/fileio.hpp>
 #include <jb/log.hpp>
 
+#include <memory>
 #include <stdexcept>
 #include <type_traits>
 #include <unordered_map>
@@ -39,6 +44,9 @@ public:
   jb::config_attribute<config, jb::offline_feed_statistics::config>
       symbol_stats;
   jb::config_attribute<config, bool> enable_symbol_stats;
+  jb::config_attribute<config, jb::itch5::pipeline_latency::config>
+      stage_latency;
+  jb::config_attribute<config, bool> enable_stage_latency;
   jb::config_attribute<config, bool> enable_array_based;
   using book_config = typename jb::itch5::array_based_order_book::config;
   jb::config_attribute<config, book_config> book_cfg;
@@ -70,15 +78,19 @@ void run_inside(config const& cfg, cfg_book_t const& cfg_book) {
 
   boost::iostreams::filtering_ostream out;
   jb::open_output_file(out, cfg.output_file());
+  // ... format the inside into a large buffer, much faster than
+  // formatting each field with the iostream operators ...
+  jb::fast_format fmt(out);
 
-  std::map<jb::itch5::stock_t, jb::offline_feed_statistics> per_symbol;
+  jb::itch5::per_symbol_statistics<jb::offline_feed_statistics> per_symbol(
+      cfg.symbol_stats());
   jb::offline_feed_statistics stats(cfg.stats());
 
   std::chrono::seconds stop_after(cfg.stop_after_seconds());
 
   using callback_type =
       typename jb::itch5::compute_book<book_type_t>::callback_type;
-  callback_type cb = std::move([&stats, &out, stop_after](
+  callback_type cb = std::move([&stats, &fmt, stop_after](
       jb::itch5::message_header const& header,
       jb::itch5::order_book<book_type_t> const& updated_book,
       jb::itch5::book_update const& update) {
@@ -86,16 +98,15 @@ void run_inside(config const& cfg, cfg_book_t const& cfg_book) {
         stop_after <= header.timestamp.ts) {
       throw abort_process_iostream{};
     }
-    auto pl = std::chrono::steady_clock::now() - update.recvts;
+    auto pl = jb::itch5::clock_type::now() - update.recvts;
     (void)jb::itch5::generate_inside(
-        stats, out, header, updated_book, update, pl);
+        stats, fmt, header, updated_book, update, pl);
   });
 
   if (cfg.enable_symbol_stats()) {
     // ... replace the calback with one that also records the stats
     // for each symbol ...
-    jb::offline_feed_statistics::config symcfg(cfg.symbol_stats());
-    cb = std::move([&stats, &out, &per_symbol, symcfg, stop_after](
+    cb = std::move([&stats, &fmt, &per_symbol, stop_after](
         jb::itch5::message_header const& header,
         jb::itch5::order_book<book_type_t> const& updated_book,
         jb::itch5::book_update const& update) {
@@ -103,22 +114,26 @@ void run_inside(config const& cfg, cfg_book_t const& cfg_book) {
           stop_after <= header.timestamp.ts) {
         throw abort_process_iostream{};
       }
-      auto pl = std::chrono::steady_clock::now() - update.recvts;
+      auto pl = jb::itch5::clock_type::now() - update.recvts;
       if (not jb::itch5::generate_inside(
-              stats, out, header, updated_book, update, pl)) {
+              stats, fmt, header, updated_book, update, pl)) {
         return;
       }
-      auto location = per_symbol.find(update.stock);
-      if (location == per_symbol.end()) {
-        auto p = per_symbol.emplace(
-            update.stock, jb::offline_feed_statistics(symcfg));
-        location = p.first;
-      }
-      location->second.sample(header.timestamp.ts, pl);
+      per_symbol.get(header.stock_locate, update.stock)
+          .sample(header.timestamp.ts, pl);
     });
   }
 
-  jb::itch5::compute_book<book_type_t> handler(std::move(cb), cfg_book);
+  // ... the per-stage latency histograms are only allocated and
+  // updated if requested ...
+  std::unique_ptr<jb::itch5::pipeline_latency> latency;
+  if (cfg.enable_stage_latency()) {
+    latency = std::make_unique<jb::itch5::pipeline_latency>(
+        cfg.stage_latency());
+  }
+
+  jb::itch5::compute_book<book_type_t> handler(
+      std::move(cb), cfg_book, latency.get());
   try {
     jb::itch5::process_iostream(in, handler);
   } catch (abort_process_iostream const&) {
@@ -127,18 +142,26 @@ void run_inside(config const& cfg, cfg_book_t const& cfg_book) {
     JB_LOG(info) << "process_iostream aborted, stop_after_seconds="
                  << cfg.stop_after_seconds();
   }
+  fmt.flush();
   stats.log_final_progress();
+  if (latency) {
+    latency->log_final_progress();
+  }
 
   jb::offline_feed_statistics::print_csv_header(std::cout);
-  for (auto const& i : per_symbol) {
-    i.second.print_csv(i.first.c_str(), std::cout);
-  }
+  per_symbol.for_each([](auto const& stock, auto const& s) {
+    s.print_csv(stock.c_str(), std::cout);
+  });
   stats.print_csv("__aggregate__", std::cout);
+  if (latency) {
+    latency->print_csv(std::cout);
+  }
 }
 
 int main(int argc, char* argv[]) try {
   config cfg;
   cfg.load_overrides(argc, argv, std::string("itch5inside.yaml"), "JB_ROOT");
+  jb::itch5::calibrate_clock();
 
   /// if enable_array_based uses array_based_order_book type
   /// and the config built by the call's arguments
@@ -164,18 +187,6 @@ int main(int argc, char* argv[]) try {
 
 namespace {
 
-// Define the default per-symbol stats
-jb::offline_feed_statistics::config default_per_symbol_stats() {
-  return jb::offline_feed_statistics::config()
-      .reporting_interval_seconds(24 * 3600)     // disable reporting
-      .max_processing_latency_nanoseconds(10000) // limit memory usage
-      .max_interarrival_time_nanoseconds(10000)  // limit memory usage
-      .max_messages_per_microsecond(1000)        // limit memory usage
-      .max_messages_per_millisecond(10000)       // limit memory usage
-      .max_messages_per_second(10000)            // limit memory usage
-      ;
-}
-
 config::config()
     : input_file(
           desc("input-file").help("An input file with ITCH-5.0 messages."),
@@ -189,13 +200,21 @@ config::config()
     , stats(desc("stats", "offline-feed-statistics"), this)
     , symbol_stats(
           desc("symbol-stats", "offline-feed-statistics"), this,
-          default_per_symbol_stats())
+          jb::itch5::default_per_symbol_feed_statistics())
     , enable_symbol_stats(
           desc("enable-symbol-stats")
               .help(
                   "If set, enable per-symbol statistics."
-                  "  Collecting per-symbol statistics is expensive in both"
-                  " memory and execution time, so it is disabled by default."),
+                  "  The statistics for each symbol are allocated when the"
+                  " symbol is first seen, configure their size and precision"
+                  " using --symbol-stats."),
+          this, true)
+    , stage_latency(desc("stage-latency", "pipeline-latency"), this)
+    , enable_stage_latency(
+          desc("enable-stage-latency")
+              .help("If set, measure the latency of each stage (decode, "
+                    "order table, book, and output) for each message type."
+                    "  The results are printed after the other statistics."),
           this, false)
     , enable_array_based(
           desc("enable-array-based")
@@ -233,6 +252,7 @@ void config::validate() const {
   log().validate();
   stats().validate();
   symbol_stats().validate();
+  stage_latency().validate();
   book_cfg().validate();
 }
 
@@ -1,5 +1,8 @@
 #include <jb/itch5/mold_udp_pacer.hpp>
+#include <jb/itch5/pacing_engine.hpp>
 #include <jb/itch5/process_iostream_mlist.hpp>
+#include <jb/itch5/process_store_mlist.hpp>
+#include <jb/itch5/replay_pacing_statistics.hpp>
 #include <jb/as_hhmmss.hpp>
 #include <jb/fileio.hpp>
 #include <jb/log.hpp>
@@ -11,7 +14,6 @@
 #include <chrono>
 #include <iostream>
 #include <stdexcept>
-#include <thread>
 
 namespace {
 
@@ -23,6 +25,7 @@ public:
   void validate() const override;
 
   jb::config_attribute<config, std::string> input_file;
+  jb::config_attribute<config, bool> preload;
   jb::config_attribute<config, std::string> destination;
   jb::config_attribute<config, int> port;
   jb::config_attribute<config, jb::log::config> log;
@@ -45,21 +48,39 @@ public:
       jb::itch5::mold_udp_pacer_config const& cfg)
       : socket_(std::move(s))
       , endpoint_(ep)
-      , pacer_(cfg, jb::itch5::mold_udp_pacer<>::session_id_type("ITCH/RPLY")) {
+      , pacer_(cfg, jb::itch5::mold_udp_pacer<>::session_id_type("ITCH/RPLY"))
+      , engine_(cfg)
+      , stats_(cfg) {
   }
 
   /// Handle all messages as blobs
   void handle_unknown(
       time_point const& recv_ts, jb::itch5::unknown_message const& msg) {
     auto sink = [this](auto buffers) { socket_.send_to(buffers, endpoint_); };
-    auto sleeper = [](jb::itch5::mold_udp_pacer<>::duration d) {
-      if (d > std::chrono::seconds(10)) {
-        JB_LOG(info) << "Sleep request for " << jb::as_hh_mm_ss_u(d);
-        d = std::chrono::seconds(10);
+    auto ts = msg.decode_header<false>().timestamp;
+    if (msg.count() == 0) {
+      engine_.start(recv_ts, ts);
+    }
+    auto sleeper = [this, ts](jb::itch5::mold_udp_pacer<>::duration) {
+      auto skipped = engine_.wait(ts);
+      if (skipped.count() > 0) {
+        JB_LOG(info) << "Skipping idle period of "
+                     << jb::as_hh_mm_ss_u(skipped);
+        stats_.skip(skipped);
       }
-      std::this_thread::sleep_for(d);
     };
     pacer_.handle_message(recv_ts, msg, sink, sleeper);
+    stats_.sample(now(), ts);
+  }
+
+  /// Return the histogram of send skews
+  jb::itch5::pacing_engine::skew_histogram const& skew() const {
+    return engine_.skew();
+  }
+
+  /// Return the replay statistics
+  jb::itch5::replay_pacing_statistics const& stats() const {
+    return stats_;
   }
 
   /// Return the current timestamp for delay measurements
@@ -71,6 +92,8 @@ private:
   boost::asio::ip::udp::socket socket_;
   boost::asio::ip::udp::endpoint endpoint_;
   jb::itch5::mold_udp_pacer<> pacer_;
+  jb::itch5::pacing_engine engine_;
+  jb::itch5::replay_pacing_statistics stats_;
 };
 
 } // anonymous namespace
@@ -92,7 +115,19 @@ int main(int argc, char* argv[]) try {
   jb::open_input_file(in, cfg.input_file());
 
   replayer rep(std::move(s), endpoint, cfg.pacer());
-  jb::itch5::process_iostream_mlist<replayer>(in, rep);
+  if (cfg.preload()) {
+    // ... load (and decompress) the full file before sending any
+    // messages, otherwise fast replays are limited by the I/O ...
+    jb::itch5::message_store store;
+    store.load(in);
+    JB_LOG(info) << "preloaded " << store.size() << " messages from "
+                 << cfg.input_file();
+    jb::itch5::process_store_mlist<replayer>(store, rep);
+  } else {
+    jb::itch5::process_iostream_mlist<replayer>(in, rep);
+  }
+  rep.stats().log_summary();
+  JB_LOG(info) << "send skew (ns): " << rep.skew().snapshot().summary();
 
   return 0;
 } catch (jb::usage const& u) {
@@ -120,6 +155,12 @@ config::config()
     : input_file(
           desc("input-file").help("An input file with ITCH-5.0 messages."),
           this)
+    , preload(
+          desc("preload")
+              .help("Load the complete input file into memory before the "
+                    "replay starts.  Use this option for fast replays, "
+                    "see --pacer.speed and --pacer.unthrottled."),
+          this, false)
     , destination(
           desc("destination")
               .help("The destination for the UDP messages. "
@@ -139,6 +180,9 @@ void config::validate() const {
         "  You must specify an input file.",
         1);
   }
+  if (pacer().zero_copy() and not preload()) {
+    throw jb::usage("--pacer.zero-copy requires --preload", 1);
+  }
   log().validate();
   pacer().validate();
 }
@@ -1,3 +1,4 @@
+#include <jb/itch5/clock_type.hpp>
 #include <jb/itch5/process_iostream.hpp>
 #include <jb/fileio.hpp>
 #include <jb/log.hpp>
@@ -29,10 +30,10 @@ public:
       : stats_(cfg.stats()) {
   }
 
-  typedef std::chrono::steady_clock::time_point time_point;
+  typedef jb::itch5::time_point time_point;
 
   time_point now() const {
-    return std::chrono::steady_clock::now();
+    return jb::itch5::clock_type::now();
   }
 
   template <typename message_type>
@@ -62,6 +63,7 @@ int main(int argc, char* argv[]) try {
   config cfg;
   cfg.load_overrides(argc, argv, std::string("itch5stats.yaml"), "JB_ROOT");
   jb::log::init();
+  jb::itch5::calibrate_clock();
 
   boost::iostreams::filtering_istream in;
   jb::open_input_file(in, cfg.input_file());
@@ -4,7 +4,9 @@
  * This program reads a raw ITCH-5.0 file and prints out the trade
  * messages into an ASCII (though potentially compressed) file.
  */
+#include <jb/itch5/clock_type.hpp>
 #include <jb/itch5/process_iostream.hpp>
+#include <jb/fast_format.hpp>
 #include <jb/fileio.hpp>
 #include <jb/log.hpp>
 
@@ -38,7 +40,7 @@ public:
    * @name Type traits
    */
   /// Define the clock used to measure processing delays
-  typedef std::chrono::steady_clock clock_type;
+  typedef jb::itch5::clock_type clock_type;
 
   /// A convenience typedef for clock_type::time_point
   typedef typename clock_type::time_point time_point;
@@ -49,6 +51,11 @@ public:
       : out_(out) {
   }
 
+  /// Write any buffered trades to the output stream
+  void flush() {
+    out_.flush();
+  }
+
   /**
    * Handle a trade message, print it out to the output stream.
    *
@@ -83,11 +90,13 @@ public:
 
   /// Return the current timestamp for delay measurements
   time_point now() const {
-    return std::chrono::steady_clock::now();
+    return jb::itch5::clock_type::now();
   }
 
 private:
-  std::ostream& out_;
+  // ... the trades are formatted into a large buffer, using the
+  // iostream operators for each field is much slower ...
+  jb::fast_format out_;
 };
 
 } // anonymous namespace
@@ -96,6 +105,7 @@ int main(int argc, char* argv[]) try {
   config cfg;
   cfg.load_overrides(argc, argv, std::string("itch5trades.yaml"), "JB_ROOT");
   jb::log::init(cfg.log());
+  jb::itch5::calibrate_clock();
 
   boost::iostreams::filtering_istream in;
   jb::open_input_file(in, cfg.input_file());
@@ -105,6 +115,7 @@ int main(int argc, char* argv[]) try {
 
   trades_handler handler(out);
   jb::itch5::process_iostream(in, handler);
+  handler.flush();
 
   return 0;
 } catch (jb::usage const& u) {
@@ -0,0 +1,99 @@
+/**
+ * @file
+ *
+ * This program decodes the binary metrics served by the feed handler
+ * and replay programs (in the /metrics-binary path), and prints them
+ * in Prometheus text format.  It is mostly useful to debug the
+ * clients of the binary encoding, e.g.:
+ *
+ *   curl -s http://localhost:23100/metrics-binary >metrics.bin
+ *   metricsdecode --input-file=metrics.bin
+ */
+#include <jb/config_object.hpp>
+#include <jb/fileio.hpp>
+#include <jb/log.hpp>
+#include <jb/metrics_binary.hpp>
+
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+
+/**
+ * Define types and functions used in this program.
+ */
+namespace {
+
+/// Configuration parameters for metricsdecode
+class config : public jb::config_object {
+public:
+  config();
+  config_object_constructors(config);
+
+  void validate() const override;
+
+  jb::config_attribute<config, std::string> input_file;
+  jb::config_attribute<config, std::string> output_file;
+  jb::config_attribute<config, jb::log::config> log;
+};
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) try {
+  config cfg;
+  cfg.load_overrides(argc, argv, std::string("metricsdecode.yaml"), "JB_ROOT");
+  jb::log::init(cfg.log());
+
+  boost::iostreams::filtering_istream in;
+  jb::open_input_file(in, cfg.input_file());
+  std::string body{std::istreambuf_iterator<char>(in),
+                   std::istreambuf_iterator<char>()};
+
+  boost::iostreams::filtering_ostream out;
+  jb::open_output_file(out, cfg.output_file());
+  jb::metrics::binary::print_text(jb::metrics::binary::decode(body), out);
+
+  return 0;
+} catch (jb::usage const& u) {
+  std::cerr << u.what() << std::endl;
+  return u.exit_status();
+} catch (std::exception const& ex) {
+  std::cerr << "Standard exception raised: " << ex.what() << std::endl;
+  return 1;
+} catch (...) {
+  std::cerr << "Unknown exception raised" << std::endl;
+  return 1;
+}
+
+namespace {
+
+config::config()
+    : input_file(
+          desc("input-file")
+              .help("A file with the binary metrics, as returned by the "
+                    "/metrics-binary path."),
+          this)
+    , output_file(
+          desc("output-file")
+              .help("Where to print the decoded metrics.  Files ending in "
+                    ".gz are automatically compressed."),
+          this, "stdout")
+    , log(desc("log", "logging"), this) {
+}
+
+void config::validate() const {
+  if (input_file() == "") {
+    throw jb::usage(
+        "Missing input-file setting."
+        "  You must specify an input file.",
+        1);
+  }
+  if (output_file() == "") {
+    throw jb::usage(
+        "Missing output-file setting."
+        "  You must specify an output file.",
+        1);
+  }
+  log().validate();
+}
+
+} // anonymous namespace